@@ -23,7 +23,6 @@ namespace UnrealBuildTool.Rules
 					"Core",
 					"CoreUObject",
 					"Engine",
-					"MediaIOCore",
 					"MediaUtils",
 					"Projects",
 					"TimeManagement",
@@ -47,7 +46,14 @@ namespace UnrealBuildTool.Rules
 			PublicDependencyModuleNames.AddRange(
 				new string[] {
 					"MediaAssets",
+					"MediaIOCore",
 				});
+
+			if (Target.Platform == UnrealTargetPlatform.Win64)
+			{
+				// Used to find the NUMA node of the cards
+				PublicAdditionalLibraries.Add("SetupAPI.lib");
+			}
 		}
 	}
 }
@@ -3,6 +3,11 @@
 #include "Aja.h"
 #include "AjaMediaPrivate.h"
 
+#include "AjaLoopbackDeviceBackend.h"
+#include "AjaMediaLog.h"
+#include "AjaSdkDeviceBackend.h"
+
+#include "MediaIOCoreDefinitions.h"
 #include "Misc/FrameRate.h"
 #include "Interfaces/IPluginManager.h"
 #include "HAL/PlatformProcess.h"
@@ -11,12 +16,19 @@
  //~ Static initialization
  //--------------------------------------------------------------------
 void* FAja::LibHandle = nullptr; 
+IAjaDeviceBackend* FAja::DeviceBackend = nullptr;
 bool FAja::bCanForceAJAUsage = false;
 
 //~ Initialization functions implementation
 //--------------------------------------------------------------------
 bool FAja::Initialize()
 {
+	check(DeviceBackend == nullptr);
+
+	//Check if command line argument to force AJA card usage is there
+	bCanForceAJAUsage = FParse::Param(FCommandLine::Get(), TEXT("forceajausage"));
+	const bool bUseLoopback = FParse::Param(FCommandLine::Get(), TEXT("AjaLoopback"));
+
 #if AJAMEDIA_DLL_PLATFORM
 	check(LibHandle == nullptr);
 
@@ -45,25 +57,43 @@ bool FAja::Initialize()
 		return false;
 	}
 
-	//Check if command line argument to force AJA card usage is there
-	bCanForceAJAUsage = FParse::Param(FCommandLine::Get(), TEXT("forceajausage"));
-
 #if !NO_LOGGING
 	AJA::SetLoggingCallbacks(&LogInfo, &LogWarning, &LogError);
 #endif // !NO_LOGGING
-	return true;
+
+	// The data types are still implemented by the dll when the loopback is used.
+	if (bUseLoopback)
+	{
+		DeviceBackend = new FAjaLoopbackDeviceBackend();
+	}
+	else
+	{
+		DeviceBackend = new FAjaSdkDeviceBackend();
+	}
 #else
-	return false;
+	if (!bUseLoopback)
+	{
+		UE_LOG(LogAjaMedia, Log, TEXT("The AJA SDK is not available on this platform. Launch with -AjaLoopback to use the loopback device backend."));
+		return false;
+	}
+
+	DeviceBackend = new FAjaLoopbackDeviceBackend();
 #endif // AJAMEDIA_DLL_PLATFORM
+
+	UE_LOG(LogAjaMedia, Log, TEXT("Using the %s device backend."), *DeviceBackend->GetName().ToString());
+	return true;
 }
 
 bool FAja::IsInitialized()
 {
-	return (LibHandle != nullptr);
+	return (DeviceBackend != nullptr);
 }
 
 void FAja::Shutdown()
 {
+	delete DeviceBackend;
+	DeviceBackend = nullptr;
+
 #if AJAMEDIA_DLL_PLATFORM
 	if (LibHandle != nullptr)
 	{
@@ -84,47 +114,79 @@ FTimecode FAja::ConvertAJATimecode2Timecode(const AJA::FTimecode& InTimecode, co
 	return FTimecode(InTimecode.Hours, InTimecode.Minutes, InTimecode.Seconds, InTimecode.Frames, FTimecode::IsDropFormatTimecodeSupported(InFPS));
 }
 
+uint32 FAja::GetStride(AJA::EPixelFormat InPixelFormat, uint32 InWidth)
+{
+	switch (InPixelFormat)
+	{
+	case AJA::EPixelFormat::PF_8BIT_YCBCR:
+		return InWidth * 2;
+	case AJA::EPixelFormat::PF_10BIT_YCBCR:
+		// v210, 48 pixels in 128 bytes
+		return ((InWidth + 47) / 48) * 128;
+	case AJA::EPixelFormat::PF_8BIT_ARGB:
+	case AJA::EPixelFormat::PF_10BIT_RGB:
+	default:
+		return InWidth * 4;
+	}
+}
+
+FMediaIOMode FAja::ConvertVideoFormat2MediaMode(const AJA::AJAVideoFormats::VideoFormatDescriptor& InDescriptor)
+{
+	FMediaIOMode MediaMode;
+	MediaMode.Resolution = FIntPoint(InDescriptor.ResolutionWidth, InDescriptor.ResolutionHeight);
+	MediaMode.Standard = EMediaIOStandardType::Progressive;
+	if (InDescriptor.bIsInterlacedStandard)
+	{
+		MediaMode.Standard = EMediaIOStandardType::Interlaced;
+	}
+	else if (InDescriptor.bIsPsfStandard)
+	{
+		MediaMode.Standard = EMediaIOStandardType::ProgressiveSegmentedFrame;
+	}
+	MediaMode.FrameRate = FFrameRate(InDescriptor.FrameRateNumerator, InDescriptor.FrameRateDenominator);
+	MediaMode.DeviceModeIdentifier = InDescriptor.VideoFormatIndex;
+
+	if (InDescriptor.bIsInterlacedStandard)
+	{
+		MediaMode.FrameRate.Numerator *= 2;
+	}
+
+	return MediaMode;
+}
+
 //~ Log functions implementation
 //--------------------------------------------------------------------
+// Called from the SDK threads. The messages are queued and rate limited, the SDK logs a lot when the signal is lost.
 void FAja::LogInfo(const TCHAR* InFormat, ...)
 {
 #if !NO_LOGGING
-	TCHAR TempString[1024];
 	va_list Args;
 
 	va_start(Args, InFormat );
-	FCString::GetVarArgs(TempString, UE_ARRAY_COUNT(TempString), InFormat, Args);
+	FAjaMediaLog::LogV(LogAjaMedia, ELogVerbosity::Log, InFormat, Args);
 	va_end(Args);
-
-	UE_LOG(LogAjaMedia, Log, TempString);
 #endif // !NO_LOGGING
 }
 
 void FAja::LogWarning(const TCHAR* InFormat, ...)
 {
 #if !NO_LOGGING
-	TCHAR TempString[1024];
 	va_list Args;
 
 	va_start(Args, InFormat );
-	FCString::GetVarArgs(TempString, UE_ARRAY_COUNT(TempString), InFormat, Args);
+	FAjaMediaLog::LogV(LogAjaMedia, ELogVerbosity::Warning, InFormat, Args);
 	va_end(Args);
-
-	UE_LOG(LogAjaMedia, Warning, TempString);
 #endif // !NO_LOGGING
 }
 
 void FAja::LogError(const TCHAR* InFormat, ...)
 {
 #if !NO_LOGGING
-	TCHAR TempString[1024];
 	va_list Args;
 
 	va_start(Args, InFormat );
-	FCString::GetVarArgs(TempString, UE_ARRAY_COUNT(TempString), InFormat, Args);
+	FAjaMediaLog::LogV(LogAjaMedia, ELogVerbosity::Error, InFormat, Args);
 	va_end(Args);
-
-	UE_LOG(LogAjaMedia, Error, TempString);
 #endif // !NO_LOGGING
 }
 
@@ -3,15 +3,14 @@
 #pragma once
 
 #include "CoreTypes.h"
+#include "AJALib.h"
 #include "Misc/App.h"
 #include "Misc/Timecode.h"
 #include "Misc/Timespan.h"
 
-namespace AJA
-{
-	struct FTimecode;
-}
 struct FFrameRate;
+struct FMediaIOMode;
+class IAjaDeviceBackend;
 
 class FAja
 {
@@ -20,8 +19,13 @@ public:
 	static bool IsInitialized();
 	static void Shutdown();
 
+	/** @return the backend used to talk to the devices. Valid only when the module is initialized. */
+	static IAjaDeviceBackend* GetDeviceBackend() { return DeviceBackend; }
+
 	// Helpers
 	static FTimecode ConvertAJATimecode2Timecode(const AJA::FTimecode& InTimecode, const FFrameRate& InFPS);
+	static uint32 GetStride(AJA::EPixelFormat InPixelFormat, uint32 InWidth);
+	static FMediaIOMode ConvertVideoFormat2MediaMode(const AJA::AJAVideoFormats::VideoFormatDescriptor& InDescriptor);
 
 	static bool CanUseAJACard() { return (FApp::CanEverRender() || bCanForceAJAUsage); }
 
@@ -32,5 +36,6 @@ private:
 
 private:
 	static void* LibHandle;
+	static IAjaDeviceBackend* DeviceBackend;
 	static bool bCanForceAJAUsage;
 };
@@ -0,0 +1,220 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaDeviceCatalog.h"
+
+#include "Aja.h"
+#include "AjaMediaPrivate.h"
+#include "IAjaDeviceBackend.h"
+
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+namespace AjaDeviceCatalog
+{
+	/** Guards the current snapshot. Only held to swap the pointer. */
+	FCriticalSection SnapshotCriticalSection;
+	TSharedPtr<const FAjaDeviceCatalog::FSnapshot, ESPMode::ThreadSafe> CurrentSnapshot;
+
+	/** Serializes the scans, so two threads don't scan the devices at the same time. */
+	FCriticalSection ScanCriticalSection;
+	uint32 LastGeneration = 0;
+
+	FAjaDeviceCatalog::FSnapshotRef Scan()
+	{
+		TSharedRef<FAjaDeviceCatalog::FSnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FAjaDeviceCatalog::FSnapshot, ESPMode::ThreadSafe>();
+		Snapshot->Generation = ++LastGeneration;
+
+		if (!FAja::IsInitialized() || !FAja::CanUseAJACard())
+		{
+			return Snapshot;
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		TUniquePtr<IAjaDeviceScanner> DeviceScanner = FAja::GetDeviceBackend()->CreateDeviceScanner();
+		const int32 NumDevices = DeviceScanner->GetNumDevices();
+		Snapshot->Devices.SetNum(NumDevices);
+		for (int32 DeviceIndex = 0; DeviceIndex < NumDevices; ++DeviceIndex)
+		{
+			FAjaDeviceCatalog::FDevice& Device = Snapshot->Devices[DeviceIndex];
+			Device.DeviceIndex = DeviceIndex;
+			FMemory::Memzero(Device.Info);
+
+			if (!DeviceScanner->GetDeviceInfo(DeviceIndex, Device.Info))
+			{
+				Device.Info.bIsSupported = false;
+				continue;
+			}
+
+			TCHAR DeviceNameBuffer[AJA::AJADeviceScanner::FormatedTextSize];
+			if (DeviceScanner->GetDeviceTextId(DeviceIndex, DeviceNameBuffer))
+			{
+				Device.DeviceName = FName(DeviceNameBuffer);
+			}
+
+			if (Device.Info.bIsSupported)
+			{
+				TUniquePtr<IAjaVideoFormats> FrameFormats = FAja::GetDeviceBackend()->CreateVideoFormats(DeviceIndex);
+				const int32 NumSupportedFormat = FrameFormats->GetNumSupportedFormat();
+				Device.Formats.Reserve(NumSupportedFormat);
+				for (int32 FormatIndex = 0; FormatIndex < NumSupportedFormat; ++FormatIndex)
+				{
+					Device.Formats.Add(FrameFormats->GetSupportedFormat(FormatIndex));
+				}
+			}
+		}
+
+		UE_LOG(LogAjaMedia, Log, TEXT("Scanned %d AJA device(s) in %.1f ms."), NumDevices, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+		return Snapshot;
+	}
+
+	bool IsSameDevice(const FAjaDeviceCatalog::FDevice& InDevice, const FName& InDeviceName, const AJA::AJADeviceScanner::DeviceInfo& InInfo)
+	{
+		return InDevice.DeviceName == InDeviceName && FMemory::Memcmp(&InDevice.Info, &InInfo, sizeof(InInfo)) == 0;
+	}
+
+	/** Changes found by the refreshes, waiting to be broadcast on the game thread */
+	FCriticalSection PendingChangesCriticalSection;
+	TArray<FAjaDeviceCatalog::FChange> PendingChanges;
+
+	FAjaDeviceCatalog::FOnChanged OnChanged;
+}
+
+/* FAjaDeviceCatalog implementation
+*****************************************************************************/
+FAjaDeviceCatalog::FSnapshotRef FAjaDeviceCatalog::Get()
+{
+	{
+		FScopeLock Lock(&AjaDeviceCatalog::SnapshotCriticalSection);
+		if (AjaDeviceCatalog::CurrentSnapshot.IsValid())
+		{
+			return AjaDeviceCatalog::CurrentSnapshot.ToSharedRef();
+		}
+	}
+
+	FScopeLock ScanLock(&AjaDeviceCatalog::ScanCriticalSection);
+	{
+		// Another thread may have scanned while this one was waiting
+		FScopeLock Lock(&AjaDeviceCatalog::SnapshotCriticalSection);
+		if (AjaDeviceCatalog::CurrentSnapshot.IsValid())
+		{
+			return AjaDeviceCatalog::CurrentSnapshot.ToSharedRef();
+		}
+	}
+
+	FSnapshotRef Snapshot = AjaDeviceCatalog::Scan();
+	FScopeLock Lock(&AjaDeviceCatalog::SnapshotCriticalSection);
+	AjaDeviceCatalog::CurrentSnapshot = Snapshot;
+	return Snapshot;
+}
+
+FAjaDeviceCatalog::FSnapshotRef FAjaDeviceCatalog::Refresh()
+{
+	FScopeLock ScanLock(&AjaDeviceCatalog::ScanCriticalSection);
+	FSnapshotRef Snapshot = AjaDeviceCatalog::Scan();
+
+	TSharedPtr<const FSnapshot, ESPMode::ThreadSafe> PreviousSnapshot;
+	{
+		FScopeLock Lock(&AjaDeviceCatalog::SnapshotCriticalSection);
+		PreviousSnapshot = AjaDeviceCatalog::CurrentSnapshot;
+		AjaDeviceCatalog::CurrentSnapshot = Snapshot;
+	}
+
+	if (PreviousSnapshot.IsValid())
+	{
+		FChange Change(PreviousSnapshot.ToSharedRef(), Snapshot);
+		const int32 NumDevices = FMath::Max(PreviousSnapshot->Devices.Num(), Snapshot->Devices.Num());
+		for (int32 DeviceIndex = 0; DeviceIndex < NumDevices; ++DeviceIndex)
+		{
+			const FDevice* Previous = PreviousSnapshot->FindDevice(DeviceIndex);
+			const FDevice* Current = Snapshot->FindDevice(DeviceIndex);
+			if (Previous == nullptr || Current == nullptr || !AjaDeviceCatalog::IsSameDevice(*Previous, Current->DeviceName, Current->Info))
+			{
+				Change.DeviceIndices.Add(DeviceIndex);
+			}
+		}
+
+		if (Change.DeviceIndices.Num() > 0)
+		{
+			UE_LOG(LogAjaMedia, Log, TEXT("%d AJA device(s) were added, removed or changed."), Change.DeviceIndices.Num());
+
+			FScopeLock Lock(&AjaDeviceCatalog::PendingChangesCriticalSection);
+			AjaDeviceCatalog::PendingChanges.Add(MoveTemp(Change));
+		}
+	}
+
+	return Snapshot;
+}
+
+void FAjaDeviceCatalog::Reset()
+{
+	FScopeLock ScanLock(&AjaDeviceCatalog::ScanCriticalSection);
+	FScopeLock Lock(&AjaDeviceCatalog::SnapshotCriticalSection);
+	AjaDeviceCatalog::CurrentSnapshot.Reset();
+
+	FScopeLock ChangesLock(&AjaDeviceCatalog::PendingChangesCriticalSection);
+	AjaDeviceCatalog::PendingChanges.Reset();
+}
+
+bool FAjaDeviceCatalog::IsUpToDate(const FSnapshot& InSnapshot)
+{
+	if (!FAja::IsInitialized() || !FAja::CanUseAJACard())
+	{
+		return true;
+	}
+
+	TUniquePtr<IAjaDeviceScanner> DeviceScanner = FAja::GetDeviceBackend()->CreateDeviceScanner();
+	const int32 NumDevices = DeviceScanner->GetNumDevices();
+	if (NumDevices != InSnapshot.Devices.Num())
+	{
+		return false;
+	}
+
+	for (int32 DeviceIndex = 0; DeviceIndex < NumDevices; ++DeviceIndex)
+	{
+		// Read the same way Scan does, so an unchanged device compares equal
+		AJA::AJADeviceScanner::DeviceInfo Info;
+		FMemory::Memzero(Info);
+		FName DeviceName;
+		if (!DeviceScanner->GetDeviceInfo(DeviceIndex, Info))
+		{
+			Info.bIsSupported = false;
+		}
+		else
+		{
+			TCHAR DeviceNameBuffer[AJA::AJADeviceScanner::FormatedTextSize];
+			if (DeviceScanner->GetDeviceTextId(DeviceIndex, DeviceNameBuffer))
+			{
+				DeviceName = FName(DeviceNameBuffer);
+			}
+		}
+
+		if (!AjaDeviceCatalog::IsSameDevice(InSnapshot.Devices[DeviceIndex], DeviceName, Info))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+FAjaDeviceCatalog::FOnChanged& FAjaDeviceCatalog::OnChanged()
+{
+	return AjaDeviceCatalog::OnChanged;
+}
+
+void FAjaDeviceCatalog::BroadcastChanges()
+{
+	check(IsInGameThread());
+
+	TArray<FChange> Changes;
+	{
+		FScopeLock Lock(&AjaDeviceCatalog::PendingChangesCriticalSection);
+		Swap(Changes, AjaDeviceCatalog::PendingChanges);
+	}
+
+	for (const FChange& Change : Changes)
+	{
+		AjaDeviceCatalog::OnChanged.Broadcast(Change);
+	}
+}
@@ -0,0 +1,134 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaDeviceMonitor.h"
+
+#include "AjaDeviceCatalog.h"
+#include "AjaMediaPrivate.h"
+
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformAtomics.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+
+namespace AjaDeviceMonitor
+{
+	FAjaDeviceMonitor* Instance = nullptr;
+
+	static TAutoConsoleVariable<float> CVarInterval(
+		TEXT("Aja.Devices.MonitorInterval"),
+		2.f,
+		TEXT("Seconds between two checks of the AJA devices by the device monitor. 0 to only refresh with Aja.Devices.Refresh."),
+		ECVF_Default);
+
+	static FAutoConsoleCommand RefreshCommand(
+		TEXT("Aja.Devices.Refresh"),
+		TEXT("Scan the AJA devices again, after a device was added or removed."),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			if (FAjaDeviceMonitor* Monitor = FAjaDeviceMonitor::Get())
+			{
+				Monitor->RequestRefresh();
+			}
+			else
+			{
+				FAjaDeviceCatalog::Refresh();
+				FAjaDeviceCatalog::BroadcastChanges();
+			}
+		})
+		);
+}
+
+/* FAjaDeviceMonitor implementation
+*****************************************************************************/
+FAjaDeviceMonitor::FAjaDeviceMonitor()
+	: bStopping(false)
+	, bRefreshRequested(false)
+	, WakeUpEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	, Thread(nullptr)
+{
+	check(IsInGameThread());
+	check(AjaDeviceMonitor::Instance == nullptr);
+	AjaDeviceMonitor::Instance = this;
+
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FAjaDeviceMonitor::Tick));
+	Thread = FRunnableThread::Create(this, TEXT("AjaDeviceMonitor"), 0, TPri_BelowNormal);
+}
+
+FAjaDeviceMonitor::~FAjaDeviceMonitor()
+{
+	Stop();
+	FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+	WakeUpEvent = nullptr;
+}
+
+FAjaDeviceMonitor* FAjaDeviceMonitor::Get()
+{
+	return AjaDeviceMonitor::Instance;
+}
+
+void FAjaDeviceMonitor::RequestRefresh()
+{
+	FPlatformAtomics::InterlockedExchange(&bRefreshRequested, true);
+	WakeUpEvent->Trigger();
+}
+
+void FAjaDeviceMonitor::Stop()
+{
+	if (Thread)
+	{
+		FPlatformAtomics::InterlockedExchange(&bStopping, true);
+		WakeUpEvent->Trigger();
+
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (TickerHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	if (AjaDeviceMonitor::Instance == this)
+	{
+		AjaDeviceMonitor::Instance = nullptr;
+	}
+}
+
+uint32 FAjaDeviceMonitor::Run()
+{
+	while (!bStopping)
+	{
+		// Sleep until the next check. Without interval, only wake up on request.
+		const float Interval = AjaDeviceMonitor::CVarInterval.GetValueOnAnyThread();
+		if (Interval > 0.f)
+		{
+			WakeUpEvent->Wait(FTimespan::FromSeconds(Interval));
+		}
+		else
+		{
+			WakeUpEvent->Wait();
+		}
+
+		if (bStopping)
+		{
+			break;
+		}
+
+		const bool bForceRefresh = FPlatformAtomics::InterlockedExchange(&bRefreshRequested, false) != 0;
+		if (bForceRefresh || !FAjaDeviceCatalog::IsUpToDate(*FAjaDeviceCatalog::Get()))
+		{
+			FAjaDeviceCatalog::Refresh();
+		}
+	}
+
+	return 0;
+}
+
+bool FAjaDeviceMonitor::Tick(float DeltaTime)
+{
+	FAjaDeviceCatalog::BroadcastChanges();
+	return true;
+}
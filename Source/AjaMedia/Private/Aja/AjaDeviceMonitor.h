@@ -0,0 +1,53 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Containers/Ticker.h"
+#include "HAL/Runnable.h"
+
+class FEvent;
+class FRunnableThread;
+
+/**
+ * Watches the AJA devices from a background thread.
+ *
+ * The monitor reads the device infos at a regular interval, and only refreshes the device catalog when they differ from the current snapshot.
+ * The scans never run on the game thread. The changes are broadcast by FAjaDeviceCatalog::OnChanged on the game thread.
+ */
+class FAjaDeviceMonitor
+	: private FRunnable
+{
+public:
+
+	/** Start the monitor thread. Called on the game thread when the module starts. */
+	FAjaDeviceMonitor();
+	virtual ~FAjaDeviceMonitor();
+
+	/** Refresh the catalog on the monitor thread as soon as possible, even if the devices look the same. */
+	void RequestRefresh();
+
+	/** Stop the thread. Waits for the scan in progress. */
+	void Stop();
+
+	/** @return the running monitor, nullptr if there's none. */
+	static FAjaDeviceMonitor* Get();
+
+private:
+
+	//~ FRunnable interface
+	virtual uint32 Run() override;
+
+	bool Tick(float DeltaTime);
+
+private:
+
+	volatile int32 bStopping;
+	volatile int32 bRefreshRequested;
+
+	FEvent* WakeUpEvent;
+	FRunnableThread* Thread;
+
+	FDelegateHandle TickerHandle;
+};
@@ -3,8 +3,11 @@
 #include "AjaDeviceProvider.h"
 
 #include "Aja.h"
+#include "AjaDeviceCatalog.h"
 #include "AjaMediaPrivate.h"
+#include "IAjaDeviceBackend.h"
 #include "CommonFrameRates.h"
+#include "Misc/ScopeLock.h"
 
 
 #define LOCTEXT_NAMESPACE "AjaDeviceProvider"
@@ -102,49 +105,394 @@ FText FAjaMediaTimecodeReference::ToText() const
 	return LOCTEXT("Invalid", "<Invalid>");
 }
 
+//~ FAjaMediaConfigurationQuery implementation
+//--------------------------------------------------------------------
+bool FAjaMediaConfigurationQuery::Matches(const FMediaIOConfiguration& InConfiguration) const
+{
+	return (!DeviceIdentifier.IsSet() || InConfiguration.MediaConnection.Device.DeviceIdentifier == DeviceIdentifier.GetValue())
+		&& (!bIsInput.IsSet() || InConfiguration.bIsInput == bIsInput.GetValue())
+		&& (!TransportType.IsSet() || InConfiguration.MediaConnection.TransportType == TransportType.GetValue())
+		&& (!Resolution.IsSet() || InConfiguration.MediaMode.Resolution == Resolution.GetValue())
+		&& (!FrameRate.IsSet() || InConfiguration.MediaMode.FrameRate == FrameRate.GetValue())
+		&& (!Standard.IsSet() || InConfiguration.MediaMode.Standard == Standard.GetValue());
+}
+
 //~ AjaDeviceProvider namespace
 //--------------------------------------------------------------------
 namespace AjaDeviceProvider
 {
-	FMediaIOMode ToMediaMode(const AJA::AJAVideoFormats::VideoFormatDescriptor& InDescriptor)
+	bool IsVideoFormatValid(const AJA::AJAVideoFormats::VideoFormatDescriptor& InDescriptor)
 	{
-		FMediaIOMode MediaMode;
-		MediaMode.Resolution = FIntPoint(InDescriptor.ResolutionWidth, InDescriptor.ResolutionHeight);
-		MediaMode.Standard = EMediaIOStandardType::Progressive;
-		if (InDescriptor.bIsInterlacedStandard)
+		if (!InDescriptor.bIsValid)
+		{
+			return false;
+		}
+		if (InDescriptor.bIsSD)
+		{
+			return false;
+		}
+		if (InDescriptor.bIsVideoFormatB && !InDescriptor.bIs372DualLink)
+		{
+			return false;
+		}
+		return true;
+	}
+
+	struct FConfigurationIndex;
+
+	/**
+	 * Results of the provider queries, for the snapshot of the device catalog they were built from.
+	 * The details panels query the provider for every property, the results are only built once per scan.
+	 */
+	struct FQueryCache
+	{
+		FQueryCache()
+			: Generation(0)
+		{ }
+
+		/** @return true if the results can be cached for this generation. Drops the results of an older generation. */
+		bool Validate(uint32 InGeneration)
 		{
-			MediaMode.Standard = EMediaIOStandardType::Interlaced;
+			if (InGeneration > Generation)
+			{
+				Generation = InGeneration;
+				Connections.Reset();
+				InputConfigurations.Reset();
+				OutputConfigurations.Reset();
+				InputOutputConfigurations.Reset();
+				InputOnlyConfigurations.Reset();
+				OutputOnlyConfigurations.Reset();
+				ConfigurationIndex.Reset();
+			}
+			return InGeneration == Generation;
 		}
-		else if (InDescriptor.bIsPsfStandard)
+
+		FCriticalSection CriticalSection;
+		uint32 Generation;
+
+		TOptional<TArray<FMediaIOConnection>> Connections;
+		TOptional<TArray<FMediaIOInputConfiguration>> InputConfigurations;
+		TOptional<TArray<FMediaIOOutputConfiguration>> OutputConfigurations;
+		TOptional<TArray<FMediaIOConfiguration>> InputOutputConfigurations;
+		TOptional<TArray<FMediaIOConfiguration>> InputOnlyConfigurations;
+		TOptional<TArray<FMediaIOConfiguration>> OutputOnlyConfigurations;
+		TSharedPtr<const FConfigurationIndex, ESPMode::ThreadSafe> ConfigurationIndex;
+	};
+
+	FQueryCache QueryCache;
+
+	/** @return the cached result of a query, or build it from the current snapshot of the catalog. */
+	template<typename ValueType, typename BuildFunctionType>
+	TArray<ValueType> FindOrBuild(TOptional<TArray<ValueType>>& InOutCachedResult, BuildFunctionType InBuild)
+	{
+		const FAjaDeviceCatalog::FSnapshotRef Snapshot = FAjaDeviceCatalog::Get();
 		{
-			MediaMode.Standard = EMediaIOStandardType::ProgressiveSegmentedFrame;
+			FScopeLock Lock(&QueryCache.CriticalSection);
+			if (QueryCache.Validate(Snapshot->Generation) && InOutCachedResult.IsSet())
+			{
+				return InOutCachedResult.GetValue();
+			}
 		}
-		MediaMode.FrameRate = FFrameRate(InDescriptor.FrameRateNumerator, InDescriptor.FrameRateDenominator);
-		MediaMode.DeviceModeIdentifier = InDescriptor.VideoFormatIndex;
 
-		if (InDescriptor.bIsInterlacedStandard)
+		// Built without the lock, a query may call the other queries
+		TArray<ValueType> Result = InBuild(*Snapshot);
+
+		FScopeLock Lock(&QueryCache.CriticalSection);
+		if (QueryCache.Validate(Snapshot->Generation))
 		{
-			MediaMode.FrameRate.Numerator *= 2;
+			InOutCachedResult = Result;
 		}
+		return Result;
+	}
+
+	TArray<FMediaIOConnection> BuildConnections(const FAjaDeviceCatalog::FSnapshot& InSnapshot);
+	TArray<FMediaIOConfiguration> BuildConfigurations(const FAjaDeviceCatalog::FSnapshot& InSnapshot, bool bAllowInput, bool bAllowOutput);
 
-		return MediaMode;
+	/** @return true if the port is another port of the device and transport of the configuration. */
+	bool IsOtherPort(const FMediaIOConfiguration& InConfiguration, const FMediaIOConnection& InPort)
+	{
+		return InPort.Device == InConfiguration.MediaConnection.Device
+			&& InPort.TransportType == InConfiguration.MediaConnection.TransportType
+			&& InPort.PortIdentifier != InConfiguration.MediaConnection.PortIdentifier
+			&& (InPort.TransportType != EMediaIOTransportType::QuadLink || InPort.QuadTransportType == InConfiguration.MediaConnection.QuadTransportType);
 	}
 
-	bool IsVideoFormatValid(const AJA::AJAVideoFormats::VideoFormatDescriptor& InDescriptor)
+	/** @return true if one of the connections is the port, and is another port of the configuration. */
+	bool IsOtherPort(const FMediaIOConfiguration& InConfiguration, const TArray<FMediaIOConnection>& InConnections, int32 InPortIdentifier)
 	{
-		if (!InDescriptor.bIsValid)
+		return InConnections.ContainsByPredicate([&](const FMediaIOConnection& InPort)
 		{
-			return false;
+			return InPort.PortIdentifier == InPortIdentifier && IsOtherPort(InConfiguration, InPort);
+		});
+	}
+
+	/** Add the fill and the fill and key combinations of a configuration. */
+	void AppendInputConfigurations(const FMediaIOConfiguration& InConfiguration, const TArray<FMediaIOConnection>& InConnections, bool bCanDoKeyAndFill, FMediaIOInputConfiguration& InOutConfiguration, TArray<FMediaIOInputConfiguration>& OutResults)
+	{
+		InOutConfiguration.MediaConfiguration = InConfiguration;
+
+		// Build the list for fill
+		InOutConfiguration.InputType = EMediaIOInputType::Fill;
+		OutResults.Add(InOutConfiguration);
+
+		// Add all output port for key
+		if (bCanDoKeyAndFill)
+		{
+			InOutConfiguration.InputType = EMediaIOInputType::FillAndKey;
+			for (const FMediaIOConnection& InputPort : InConnections)
+			{
+				if (IsOtherPort(InConfiguration, InputPort))
+				{
+					InOutConfiguration.KeyPortIdentifier = InputPort.PortIdentifier;
+					OutResults.Add(InOutConfiguration);
+				}
+			}
 		}
-		if (InDescriptor.bIsSD)
+	}
+
+	/** Add the fill and the fill and key combinations of a configuration, with every reference. */
+	void AppendOutputConfigurations(const FMediaIOConfiguration& InConfiguration, const TArray<FMediaIOConnection>& InConnections, bool bCanDoKeyAndFill, FMediaIOOutputConfiguration& InOutConfiguration, TArray<FMediaIOOutputConfiguration>& OutResults)
+	{
+		auto BuildList = [&]()
 		{
-			return false;
+			InOutConfiguration.MediaConfiguration = InConfiguration;
+
+			InOutConfiguration.OutputReference = EMediaIOReferenceType::FreeRun;
+			OutResults.Add(InOutConfiguration);
+
+			InOutConfiguration.OutputReference = EMediaIOReferenceType::External;
+			OutResults.Add(InOutConfiguration);
+
+			// Add all inputs for reference input
+			InOutConfiguration.OutputReference = EMediaIOReferenceType::Input;
+			for (const FMediaIOConnection& InputPort : InConnections)
+			{
+				if (IsOtherPort(InConfiguration, InputPort))
+				{
+					if (InOutConfiguration.OutputType != EMediaIOOutputType::FillAndKey || !(InputPort.PortIdentifier == InOutConfiguration.KeyPortIdentifier))
+					{
+						InOutConfiguration.ReferencePortIdentifier = InputPort.PortIdentifier;
+						OutResults.Add(InOutConfiguration);
+					}
+				}
+			}
+		};
+
+		// Build the list for fill only
+		InOutConfiguration.OutputType = EMediaIOOutputType::Fill;
+		BuildList();
+
+		// Add all output port for key
+		if (bCanDoKeyAndFill)
+		{
+			InOutConfiguration.OutputType = EMediaIOOutputType::FillAndKey;
+			for (const FMediaIOConnection& OutputPort : InConnections)
+			{
+				if (IsOtherPort(InConfiguration, OutputPort))
+				{
+					InOutConfiguration.KeyPortIdentifier = OutputPort.PortIdentifier;
+					BuildList();
+				}
+			}
 		}
-		if (InDescriptor.bIsVideoFormatB && !InDescriptor.bIs372DualLink)
+	}
+
+	/**
+	 * Every input and output configuration of a snapshot, indexed by device, by mode and by each of their keys.
+	 * Built once per scan. The key and reference combinations are not indexed, they are only built for the configurations a query returns.
+	 */
+	struct FConfigurationIndex
+	{
+		static uint64 GetDeviceKey(int32 InDeviceIdentifier, bool bIsInput, EMediaIOTransportType InTransportType)
 		{
+			return ((uint64)(uint32)InDeviceIdentifier << 32) | ((uint64)bIsInput << 8) | (uint64)InTransportType;
+		}
+
+		static uint32 GetModeKey(const FIntPoint& InResolution, const FFrameRate& InFrameRate, EMediaIOStandardType InStandard)
+		{
+			uint32 Hash = GetTypeHash(InResolution);
+			Hash = HashCombine(Hash, GetTypeHash(InFrameRate.Numerator));
+			Hash = HashCombine(Hash, GetTypeHash(InFrameRate.Denominator));
+			return HashCombine(Hash, GetTypeHash((uint8)InStandard));
+		}
+
+		static uint64 GetFrameRateKey(const FFrameRate& InFrameRate)
+		{
+			return ((uint64)(uint32)InFrameRate.Numerator << 32) | (uint64)(uint32)InFrameRate.Denominator;
+		}
+
+		static uint32 GetConfigurationKey(const FMediaIOConfiguration& InConfiguration)
+		{
+			const FMediaIOConnection& Connection = InConfiguration.MediaConnection;
+			uint32 Hash = GetTypeHash(GetDeviceKey(Connection.Device.DeviceIdentifier, InConfiguration.bIsInput, Connection.TransportType));
+			Hash = HashCombine(Hash, GetTypeHash(Connection.PortIdentifier));
+			return HashCombine(Hash, GetTypeHash(InConfiguration.MediaMode.DeviceModeIdentifier));
+		}
+
+		FConfigurationIndex(const FAjaDeviceCatalog::FSnapshotRef& InSnapshot)
+			: Snapshot(InSnapshot)
+		{
+			Configurations = BuildConfigurations(*Snapshot, true, false);
+			Configurations.Append(BuildConfigurations(*Snapshot, false, true));
+			Connections = BuildConnections(*Snapshot);
+
+			for (int32 Index = 0; Index < Configurations.Num(); ++Index)
+			{
+				const FMediaIOConfiguration& Configuration = Configurations[Index];
+				const FMediaIOConnection& Connection = Configuration.MediaConnection;
+				const FMediaIOMode& Mode = Configuration.MediaMode;
+				ByDevice.FindOrAdd(GetDeviceKey(Connection.Device.DeviceIdentifier, Configuration.bIsInput, Connection.TransportType)).Add(Index);
+				ByMode.FindOrAdd(GetModeKey(Mode.Resolution, Mode.FrameRate, Mode.Standard)).Add(Index);
+				ByConfiguration.Add(GetConfigurationKey(Configuration), Index);
+
+				ByDeviceIdentifier.FindOrAdd(Connection.Device.DeviceIdentifier).Add(Index);
+				ByDirection[Configuration.bIsInput ? 1 : 0].Add(Index);
+				ByTransportType.FindOrAdd((uint8)Connection.TransportType).Add(Index);
+				ByResolution.FindOrAdd(Mode.Resolution).Add(Index);
+				ByFrameRate.FindOrAdd(GetFrameRateKey(Mode.FrameRate)).Add(Index);
+				ByStandard.FindOrAdd((uint8)Mode.Standard).Add(Index);
+			}
+		}
+
+		/**
+		 * Call the function for every configuration that passes the filter, inputs first, in the order of the devices.
+		 * Only the shortest posting list of the keys set by the query is walked, Matches checks the other keys.
+		 */
+		template<typename FunctionType>
+		void Find(const FAjaMediaConfigurationQuery& InQuery, FunctionType InFunction) const
+		{
+			const TArray<int32>* Candidates = nullptr;
+			bool bNoCandidate = false;
+			auto Narrow = [&Candidates, &bNoCandidate](const TArray<int32>* InPostingList)
+			{
+				if (InPostingList == nullptr)
+				{
+					bNoCandidate = true;
+				}
+				else if (Candidates == nullptr || InPostingList->Num() < Candidates->Num())
+				{
+					Candidates = InPostingList;
+				}
+			};
+
+			if (InQuery.DeviceIdentifier.IsSet() && InQuery.bIsInput.IsSet() && InQuery.TransportType.IsSet())
+			{
+				Narrow(ByDevice.Find(GetDeviceKey(InQuery.DeviceIdentifier.GetValue(), InQuery.bIsInput.GetValue(), InQuery.TransportType.GetValue())));
+			}
+			if (InQuery.Resolution.IsSet() && InQuery.FrameRate.IsSet() && InQuery.Standard.IsSet())
+			{
+				Narrow(ByMode.Find(GetModeKey(InQuery.Resolution.GetValue(), InQuery.FrameRate.GetValue(), InQuery.Standard.GetValue())));
+			}
+			if (InQuery.DeviceIdentifier.IsSet())
+			{
+				Narrow(ByDeviceIdentifier.Find(InQuery.DeviceIdentifier.GetValue()));
+			}
+			if (InQuery.bIsInput.IsSet())
+			{
+				Narrow(&ByDirection[InQuery.bIsInput.GetValue() ? 1 : 0]);
+			}
+			if (InQuery.TransportType.IsSet())
+			{
+				Narrow(ByTransportType.Find((uint8)InQuery.TransportType.GetValue()));
+			}
+			if (InQuery.Resolution.IsSet())
+			{
+				Narrow(ByResolution.Find(InQuery.Resolution.GetValue()));
+			}
+			if (InQuery.FrameRate.IsSet())
+			{
+				Narrow(ByFrameRate.Find(GetFrameRateKey(InQuery.FrameRate.GetValue())));
+			}
+			if (InQuery.Standard.IsSet())
+			{
+				Narrow(ByStandard.Find((uint8)InQuery.Standard.GetValue()));
+			}
+
+			if (bNoCandidate)
+			{
+				return;
+			}
+
+			if (Candidates)
+			{
+				for (int32 Index : *Candidates)
+				{
+					if (InQuery.Matches(Configurations[Index]))
+					{
+						InFunction(Configurations[Index]);
+					}
+				}
+			}
+			else
+			{
+				for (const FMediaIOConfiguration& Configuration : Configurations)
+				{
+					if (InQuery.Matches(Configuration))
+					{
+						InFunction(Configuration);
+					}
+				}
+			}
+		}
+
+		bool Contains(const FMediaIOConfiguration& InConfiguration) const
+		{
+			TArray<int32, TInlineAllocator<4>> Candidates;
+			ByConfiguration.MultiFind(GetConfigurationKey(InConfiguration), Candidates);
+			for (int32 Index : Candidates)
+			{
+				if (Configurations[Index] == InConfiguration)
+				{
+					return true;
+				}
+			}
 			return false;
 		}
-		return true;
+
+		bool CanDeviceDoAlpha(const FMediaIOConfiguration& InConfiguration) const
+		{
+			const FAjaDeviceCatalog::FDevice* Device = Snapshot->FindDevice(InConfiguration.MediaConnection.Device.DeviceIdentifier);
+			return Device && Device->Info.bIsSupported && Device->Info.bCanDoAlpha;
+		}
+
+		FAjaDeviceCatalog::FSnapshotRef Snapshot;
+		TArray<FMediaIOConfiguration> Configurations;
+		TArray<FMediaIOConnection> Connections;
+
+		/** Posting lists of the device and of the mode keys, for the queries that set all of them. */
+		TMap<uint64, TArray<int32>> ByDevice;
+		TMap<uint32, TArray<int32>> ByMode;
+		TMultiMap<uint32, int32> ByConfiguration;
+
+		/** Posting lists of each key, for the queries that only set some of them. Sorted, like the configurations. */
+		TMap<int32, TArray<int32>> ByDeviceIdentifier;
+		TArray<int32> ByDirection[2];
+		TMap<uint8, TArray<int32>> ByTransportType;
+		TMap<FIntPoint, TArray<int32>> ByResolution;
+		TMap<uint64, TArray<int32>> ByFrameRate;
+		TMap<uint8, TArray<int32>> ByStandard;
+	};
+
+	/** @return the index of the current snapshot of the catalog. */
+	TSharedRef<const FConfigurationIndex, ESPMode::ThreadSafe> GetConfigurationIndex()
+	{
+		const FAjaDeviceCatalog::FSnapshotRef Snapshot = FAjaDeviceCatalog::Get();
+		{
+			FScopeLock Lock(&QueryCache.CriticalSection);
+			if (QueryCache.Validate(Snapshot->Generation) && QueryCache.ConfigurationIndex.IsValid())
+			{
+				return QueryCache.ConfigurationIndex.ToSharedRef();
+			}
+		}
+
+		TSharedRef<const FConfigurationIndex, ESPMode::ThreadSafe> Index = MakeShared<FConfigurationIndex, ESPMode::ThreadSafe>(Snapshot);
+
+		FScopeLock Lock(&QueryCache.CriticalSection);
+		if (QueryCache.Validate(Snapshot->Generation))
+		{
+			QueryCache.ConfigurationIndex = Index;
+		}
+		return Index;
 	}
 }
 
@@ -174,68 +522,55 @@ bool FAjaDeviceProvider::CanDeviceDoAlpha(const FMediaIODevice& InDevice) const
 		return false;
 	}
 
-	AJA::AJADeviceScanner DeviceScanner;
-	AJA::AJADeviceScanner::DeviceInfo DeviceInfo;
-	if (!DeviceScanner.GetDeviceInfo(InDevice.DeviceIdentifier, DeviceInfo))
-	{
-		return false;
-	}
-
-	if (!DeviceInfo.bIsSupported)
+	const FAjaDeviceCatalog::FSnapshotRef Snapshot = FAjaDeviceCatalog::Get();
+	const FAjaDeviceCatalog::FDevice* Device = Snapshot->FindDevice(InDevice.DeviceIdentifier);
+	if (Device == nullptr || !Device->Info.bIsSupported)
 	{
 		return false;
 	}
 
-	return DeviceInfo.bCanDoAlpha;
+	return Device->Info.bCanDoAlpha;
 }
 
 TArray<FMediaIOConnection> FAjaDeviceProvider::GetConnections() const
 {
-	TArray<FMediaIOConnection> Results;
 	if (!FAja::IsInitialized() || !FAja::CanUseAJACard())
 	{
-		return Results;
+		return TArray<FMediaIOConnection>();
 	}
 
-	AJA::AJADeviceScanner DeviceScanner;
-	const int32 NumDevices = DeviceScanner.GetNumDevices();
-	for (int32 DeviceIndex = 0; DeviceIndex < NumDevices; ++DeviceIndex)
+	return AjaDeviceProvider::FindOrBuild(AjaDeviceProvider::QueryCache.Connections, &AjaDeviceProvider::BuildConnections);
+}
+
+TArray<FMediaIOConnection> AjaDeviceProvider::BuildConnections(const FAjaDeviceCatalog::FSnapshot& InSnapshot)
+{
+	TArray<FMediaIOConnection> Results;
+	for (const FAjaDeviceCatalog::FDevice& Device : InSnapshot.Devices)
 	{
-		AJA::AJADeviceScanner::DeviceInfo DeviceInfo;
-		if (!DeviceScanner.GetDeviceInfo(DeviceIndex, DeviceInfo))
+		if (!Device.IsUsable())
 		{
 			continue;
 		}
 
-		if (!DeviceInfo.bIsSupported)
+		FMediaIOConnection Connection;
+		Connection.Device.DeviceName = Device.DeviceName;
+		Connection.Device.DeviceIdentifier = Device.DeviceIndex;
+		Connection.Protocol = FAjaDeviceProvider::GetProtocolName();
+
+		Connection.TransportType = EMediaIOTransportType::SingleLink;
+		for (int32 Input = 0; Input < Device.Info.NumSdiInput; ++Input)
 		{
-			continue;
+			Connection.PortIdentifier = Input + 1;
+			Results.Add(Connection);
 		}
 
-		TCHAR DeviceNameBuffer[AJA::AJADeviceScanner::FormatedTextSize];
-		if (DeviceScanner.GetDeviceTextId(DeviceIndex, DeviceNameBuffer))
+		Connection.TransportType = EMediaIOTransportType::HDMI;
+		for (int32 Input = 0; Input < Device.Info.NumHdmiInput; ++Input)
 		{
-			FMediaIOConnection Connection;
-			Connection.Device.DeviceName = DeviceNameBuffer;
-			Connection.Device.DeviceIdentifier = DeviceIndex;
-			Connection.Protocol = GetProtocolName();
-
-			Connection.TransportType = EMediaIOTransportType::SingleLink;
-			for (int32 Input = 0; Input < DeviceInfo.NumSdiInput; ++Input)
-			{
-				Connection.PortIdentifier = Input + 1;
-				Results.Add(Connection);
-			}
-
-			Connection.TransportType = EMediaIOTransportType::HDMI;
-			for (int32 Input = 0; Input < DeviceInfo.NumHdmiInput; ++Input)
-			{
-				Connection.PortIdentifier = Input + 1;
-				Results.Add(Connection);
-			}
+			Connection.PortIdentifier = Input + 1;
+			Results.Add(Connection);
 		}
 	}
-
 	return Results;
 }
 
@@ -245,166 +580,167 @@ TArray<FMediaIOConfiguration> FAjaDeviceProvider::GetConfigurations() const
 }
 
 TArray<FMediaIOConfiguration> FAjaDeviceProvider::GetConfigurations(bool bAllowInput, bool bAllowOutput) const
+{
+	if (!FAja::IsInitialized() || !FAja::CanUseAJACard() || (!bAllowInput && !bAllowOutput))
+	{
+		return TArray<FMediaIOConfiguration>();
+	}
+
+	TOptional<TArray<FMediaIOConfiguration>>& CachedResult = bAllowInput && bAllowOutput ? AjaDeviceProvider::QueryCache.InputOutputConfigurations
+		: bAllowInput ? AjaDeviceProvider::QueryCache.InputOnlyConfigurations
+		: AjaDeviceProvider::QueryCache.OutputOnlyConfigurations;
+
+	return AjaDeviceProvider::FindOrBuild(CachedResult, [bAllowInput, bAllowOutput](const FAjaDeviceCatalog::FSnapshot& InSnapshot)
+	{
+		return AjaDeviceProvider::BuildConfigurations(InSnapshot, bAllowInput, bAllowOutput);
+	});
+}
+
+TArray<FMediaIOConfiguration> AjaDeviceProvider::BuildConfigurations(const FAjaDeviceCatalog::FSnapshot& InSnapshot, bool bAllowInput, bool bAllowOutput)
 {
 	const int32 MaxNumberOfChannel = 8;
 
 	TArray<FMediaIOConfiguration> Results;
-	if (!FAja::IsInitialized() || !FAja::CanUseAJACard())
+	for (const FAjaDeviceCatalog::FDevice& Device : InSnapshot.Devices)
 	{
-		return Results;
-	}
+		const int32 DeviceIndex = Device.DeviceIndex;
+		const AJA::AJADeviceScanner::DeviceInfo& DeviceInfo = Device.Info;
+		if (!Device.IsUsable())
+		{
+			continue;
+		}
 
-	AJA::AJADeviceScanner DeviceScanner;
-	int32 NumDevices = DeviceScanner.GetNumDevices();
-	for (int32 DeviceIndex = 0; DeviceIndex < NumDevices; ++DeviceIndex)
-	{
-		TCHAR DeviceNameBuffer[AJA::AJADeviceScanner::FormatedTextSize];
-		if (DeviceScanner.GetDeviceTextId(DeviceIndex, DeviceNameBuffer))
+		const bool bDeviceHasInput = DeviceInfo.NumSdiInput > 0 || DeviceInfo.NumHdmiInput > 0;
+		if (bAllowInput && !bDeviceHasInput)
+		{
+			continue;
+		}
+
+		const bool bDeviceHasOutput = DeviceInfo.NumSdiOutput > 0 || DeviceInfo.NumHdmiOutput > 0;
+		if (bAllowOutput && !bDeviceHasOutput)
 		{
-			AJA::AJADeviceScanner::DeviceInfo DeviceInfo;
-			if (DeviceScanner.GetDeviceInfo(DeviceIndex, DeviceInfo))
+			continue;
+		}
+
+		const int32 SdiInputCount = FMath::Min(DeviceInfo.NumSdiInput, MaxNumberOfChannel);
+		const int32 SdiOutputCount = FMath::Min(DeviceInfo.NumSdiOutput, MaxNumberOfChannel);
+		const int32 HdmiInputCount = FMath::Min(DeviceInfo.NumHdmiInput, MaxNumberOfChannel);
+		const int32 HdmiOutputCount = FMath::Min(DeviceInfo.NumHdmiOutput, MaxNumberOfChannel);
+
+		FMediaIOConfiguration MediaConfiguration;
+		MediaConfiguration.MediaConnection.Device.DeviceIdentifier = DeviceIndex;
+		MediaConfiguration.MediaConnection.Device.DeviceName = Device.DeviceName;
+		MediaConfiguration.MediaConnection.Protocol = FAjaDeviceProvider::GetProtocolName();
+
+		for (int32 InputOutputLoop = 0; InputOutputLoop < 2; ++InputOutputLoop)
+		{
+			// Build input or output
+			MediaConfiguration.bIsInput = (InputOutputLoop == 0);
+			if (!bAllowInput && MediaConfiguration.bIsInput)
 			{
-				if (DeviceInfo.bIsSupported)
-				{
-					const bool bDeviceHasInput = DeviceInfo.NumSdiInput > 0 || DeviceInfo.NumHdmiInput > 0;
-					if (bAllowInput && !bDeviceHasInput)
-					{
-						continue;
-					}
+				continue;
+			}
+			if (!bAllowOutput && !MediaConfiguration.bIsInput)
+			{
+				continue;
+			}
 
-					const bool bDeviceHasOutput = DeviceInfo.NumSdiOutput > 0 || DeviceInfo.NumHdmiOutput > 0;
-					if (bAllowOutput && !bDeviceHasOutput)
+			const int32 SdiPortCount = MediaConfiguration.bIsInput ? SdiInputCount : SdiOutputCount;
+			if (SdiPortCount > 0)
+			{
+				for (const AJA::AJAVideoFormats::VideoFormatDescriptor& Descriptor : Device.Formats)
+				{
+					if (!AjaDeviceProvider::IsVideoFormatValid(Descriptor))
 					{
 						continue;
 					}
 
-					const int32 SdiInputCount = FMath::Min(DeviceInfo.NumSdiInput, MaxNumberOfChannel);
-					const int32 SdiOutputCount = FMath::Min(DeviceInfo.NumSdiOutput, MaxNumberOfChannel);
-					const int32 HdmiInputCount = FMath::Min(DeviceInfo.NumHdmiInput, MaxNumberOfChannel);
-					const int32 HdmiOutputCount = FMath::Min(DeviceInfo.NumHdmiOutput, MaxNumberOfChannel);
-
-					AJA::AJAVideoFormats FrameFormats(DeviceIndex);
-					const int32 NumSupportedFormat = FrameFormats.GetNumSupportedFormat();
+					MediaConfiguration.MediaMode = FAja::ConvertVideoFormat2MediaMode(Descriptor);
+					MediaConfiguration.MediaConnection.QuadTransportType = EMediaIOQuadLinkTransportType::SquareDivision;
 
-					FMediaIOConfiguration MediaConfiguration;
-					MediaConfiguration.MediaConnection.Device.DeviceIdentifier = DeviceIndex;
-					MediaConfiguration.MediaConnection.Device.DeviceName = FName(DeviceNameBuffer);
-					MediaConfiguration.MediaConnection.Protocol = FAjaDeviceProvider::GetProtocolName();
+					const bool bRequiredMoreThan3G = Descriptor.bIs4K || Descriptor.bIs2K;
 
-					for (int32 InputOutputLoop = 0; InputOutputLoop < 2; ++InputOutputLoop)
+					if (Descriptor.bIs372DualLink && DeviceInfo.bCanDoDualLink)
 					{
-						// Build input or output
-						MediaConfiguration.bIsInput = (InputOutputLoop == 0);
-						if (!bAllowInput && MediaConfiguration.bIsInput)
+						MediaConfiguration.MediaConnection.TransportType = EMediaIOTransportType::DualLink;
+						for (int32 SourceIndex = 0; SourceIndex < SdiPortCount/2; ++SourceIndex)
 						{
-							continue;
+							MediaConfiguration.MediaConnection.PortIdentifier = (SourceIndex*2) + 1;
+							Results.Add(MediaConfiguration);
 						}
-						if (!bAllowOutput && !MediaConfiguration.bIsInput)
+					}
+
+					if (Descriptor.bIs4K && SdiPortCount >= 4 && DeviceInfo.bCanDo4K)
+					{
+						MediaConfiguration.MediaConnection.TransportType = EMediaIOTransportType::QuadLink;
+						for (int32 SourceIndex = 0; SourceIndex < SdiPortCount/4; ++SourceIndex)
 						{
-							continue;
+							MediaConfiguration.MediaConnection.QuadTransportType = EMediaIOQuadLinkTransportType::SquareDivision;
+							MediaConfiguration.MediaConnection.PortIdentifier = (SourceIndex*4) + 1;
+							Results.Add(MediaConfiguration);
+
+							if (DeviceInfo.bCanDoTSI)
+							{
+								MediaConfiguration.MediaConnection.QuadTransportType = EMediaIOQuadLinkTransportType::TwoSampleInterleave;
+								Results.Add(MediaConfiguration);
+							}
 						}
+					}
 
-						const int32 SdiPortCount = MediaConfiguration.bIsInput ? SdiInputCount : SdiOutputCount;
-						if (SdiPortCount > 0)
+					if (!Descriptor.bIsVideoFormatB)
+					{
+						if ((DeviceInfo.bCanDo12GRouting && bRequiredMoreThan3G) || !bRequiredMoreThan3G)
 						{
-							for (int32 FormatIndex = 0; FormatIndex < NumSupportedFormat; ++FormatIndex)
+							MediaConfiguration.MediaConnection.TransportType = EMediaIOTransportType::SingleLink;
+							for (int32 SourceIndex = 0; SourceIndex < SdiPortCount; ++SourceIndex)
 							{
-								const AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = FrameFormats.GetSupportedFormat(FormatIndex);
-								if (!AjaDeviceProvider::IsVideoFormatValid(Descriptor))
-								{
-									continue;
-								}
-
-								MediaConfiguration.MediaMode = AjaDeviceProvider::ToMediaMode(Descriptor);
-								MediaConfiguration.MediaConnection.QuadTransportType = EMediaIOQuadLinkTransportType::SquareDivision;
-
-								const bool bRequiredMoreThan3G = Descriptor.bIs4K || Descriptor.bIs2K;
-
-								if (Descriptor.bIs372DualLink && DeviceInfo.bCanDoDualLink)
-								{
-									MediaConfiguration.MediaConnection.TransportType = EMediaIOTransportType::DualLink;
-									for (int32 SourceIndex = 0; SourceIndex < SdiPortCount/2; ++SourceIndex)
-									{
-										MediaConfiguration.MediaConnection.PortIdentifier = (SourceIndex*2) + 1;
-										Results.Add(MediaConfiguration);
-									}
-								}
-
-								if (Descriptor.bIs4K && SdiPortCount >= 4 && DeviceInfo.bCanDo4K)
-								{
-									MediaConfiguration.MediaConnection.TransportType = EMediaIOTransportType::QuadLink;
-									for (int32 SourceIndex = 0; SourceIndex < SdiPortCount/4; ++SourceIndex)
-									{
-										MediaConfiguration.MediaConnection.QuadTransportType = EMediaIOQuadLinkTransportType::SquareDivision;
-										MediaConfiguration.MediaConnection.PortIdentifier = (SourceIndex*4) + 1;
-										Results.Add(MediaConfiguration);
-
-										if (DeviceInfo.bCanDoTSI)
-										{
-											MediaConfiguration.MediaConnection.QuadTransportType = EMediaIOQuadLinkTransportType::TwoSampleInterleave;
-											Results.Add(MediaConfiguration);
-										}
-									}
-								}
-
-								if (!Descriptor.bIsVideoFormatB)
-								{
-									if ((DeviceInfo.bCanDo12GRouting && bRequiredMoreThan3G) || !bRequiredMoreThan3G)
-									{
-										MediaConfiguration.MediaConnection.TransportType = EMediaIOTransportType::SingleLink;
-										for (int32 SourceIndex = 0; SourceIndex < SdiPortCount; ++SourceIndex)
-										{
-											MediaConfiguration.MediaConnection.PortIdentifier = SourceIndex + 1;
-											Results.Add(MediaConfiguration);
-										}
-									}
-									else if (DeviceInfo.bCanDo12GSdi && bRequiredMoreThan3G && MediaConfiguration.bIsInput)
-									{
-										MediaConfiguration.MediaConnection.TransportType = EMediaIOTransportType::SingleLink;
-										// in single TSI, we only support input 1, 3, 5, 7
-										// otherwise it will be single-quad
-										const double MaximalFrameRateForUHD_6G = 30.01;
-										const int32 Increment = MediaConfiguration.MediaMode.FrameRate.AsDecimal() > MaximalFrameRateForUHD_6G ? 4 : 2;
-										for (int32 SourceIndex = 0; SourceIndex < SdiPortCount/ Increment; ++SourceIndex)
-										{
-											MediaConfiguration.MediaConnection.PortIdentifier = (SourceIndex*Increment) + 1;
-											Results.Add(MediaConfiguration);
-										}
-									}
-								}
+								MediaConfiguration.MediaConnection.PortIdentifier = SourceIndex + 1;
+								Results.Add(MediaConfiguration);
 							}
 						}
-
-						const int32 HdmiPortCount = MediaConfiguration.bIsInput ? HdmiInputCount : HdmiOutputCount;
-						if (HdmiPortCount > 0 && MediaConfiguration.bIsInput) // only support HDMI input
+						else if (DeviceInfo.bCanDo12GSdi && bRequiredMoreThan3G && MediaConfiguration.bIsInput)
 						{
-							for (int32 FormatIndex = 0; FormatIndex < NumSupportedFormat; ++FormatIndex)
+							MediaConfiguration.MediaConnection.TransportType = EMediaIOTransportType::SingleLink;
+							// in single TSI, we only support input 1, 3, 5, 7
+							// otherwise it will be single-quad
+							const double MaximalFrameRateForUHD_6G = 30.01;
+							const int32 Increment = MediaConfiguration.MediaMode.FrameRate.AsDecimal() > MaximalFrameRateForUHD_6G ? 4 : 2;
+							for (int32 SourceIndex = 0; SourceIndex < SdiPortCount/ Increment; ++SourceIndex)
 							{
-								const AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = FrameFormats.GetSupportedFormat(FormatIndex);
-								if (!AjaDeviceProvider::IsVideoFormatValid(Descriptor))
-								{
-									continue;
-								}
-
-								if (Descriptor.bIsVideoFormatB)
-								{
-									continue;
-								}
-
-								MediaConfiguration.MediaMode = AjaDeviceProvider::ToMediaMode(Descriptor);
-								MediaConfiguration.MediaConnection.QuadTransportType = EMediaIOQuadLinkTransportType::SquareDivision;
-
-								MediaConfiguration.MediaConnection.TransportType = EMediaIOTransportType::HDMI;
-								for (int32 SourceIndex = 0; SourceIndex < HdmiPortCount; ++SourceIndex)
-								{
-									MediaConfiguration.MediaConnection.PortIdentifier = SourceIndex + 1;
-									Results.Add(MediaConfiguration);
-								}
+								MediaConfiguration.MediaConnection.PortIdentifier = (SourceIndex*Increment) + 1;
+								Results.Add(MediaConfiguration);
 							}
 						}
 					}
 				}
 			}
+
+			const int32 HdmiPortCount = MediaConfiguration.bIsInput ? HdmiInputCount : HdmiOutputCount;
+			if (HdmiPortCount > 0 && MediaConfiguration.bIsInput) // only support HDMI input
+			{
+				for (const AJA::AJAVideoFormats::VideoFormatDescriptor& Descriptor : Device.Formats)
+				{
+					if (!AjaDeviceProvider::IsVideoFormatValid(Descriptor))
+					{
+						continue;
+					}
+
+					if (Descriptor.bIsVideoFormatB)
+					{
+						continue;
+					}
+
+					MediaConfiguration.MediaMode = FAja::ConvertVideoFormat2MediaMode(Descriptor);
+					MediaConfiguration.MediaConnection.QuadTransportType = EMediaIOQuadLinkTransportType::SquareDivision;
+
+					MediaConfiguration.MediaConnection.TransportType = EMediaIOTransportType::HDMI;
+					for (int32 SourceIndex = 0; SourceIndex < HdmiPortCount; ++SourceIndex)
+					{
+						MediaConfiguration.MediaConnection.PortIdentifier = SourceIndex + 1;
+						Results.Add(MediaConfiguration);
+					}
+				}
+			}
 		}
 	}
 
@@ -413,124 +749,174 @@ TArray<FMediaIOConfiguration> FAjaDeviceProvider::GetConfigurations(bool bAllowI
 
 TArray<FMediaIOInputConfiguration> FAjaDeviceProvider::GetInputConfigurations() const
 {
-	TArray<FMediaIOInputConfiguration> Results;
-	TArray<FMediaIOConfiguration> InputConfigurations = GetConfigurations(true, false);
-	TArray<FMediaIOConnection> OtherSources = GetConnections();
+	return AjaDeviceProvider::FindOrBuild(AjaDeviceProvider::QueryCache.InputConfigurations, [this](const FAjaDeviceCatalog::FSnapshot& InSnapshot)
+	{
+		TArray<FMediaIOInputConfiguration> Results;
+		TArray<FMediaIOConfiguration> InputConfigurations = GetConfigurations(true, false);
+		TArray<FMediaIOConnection> OtherSources = GetConnections();
 
-	FMediaIOInputConfiguration DefaultInputConfiguration = GetDefaultInputConfiguration();
-	Results.Reset(InputConfigurations.Num() * 2);
+		FMediaIOInputConfiguration DefaultInputConfiguration = GetDefaultInputConfiguration();
+		Results.Reset(InputConfigurations.Num() * 2);
 
-	int32 LastDeviceIndex = INDEX_NONE;
-	bool bCanDoKeyAndFill = false;
+		int32 LastDeviceIndex = INDEX_NONE;
+		bool bCanDoKeyAndFill = false;
 
-	for (const FMediaIOConfiguration& InputConfiguration : InputConfigurations)
-	{
-		// Update the Device Info
-		if (InputConfiguration.MediaConnection.Device.DeviceIdentifier != LastDeviceIndex)
+		for (const FMediaIOConfiguration& InputConfiguration : InputConfigurations)
 		{
-			LastDeviceIndex = InputConfiguration.MediaConnection.Device.DeviceIdentifier;
-			bCanDoKeyAndFill = CanDeviceDoAlpha(InputConfiguration.MediaConnection.Device);
+			// Update the Device Info
+			if (InputConfiguration.MediaConnection.Device.DeviceIdentifier != LastDeviceIndex)
+			{
+				LastDeviceIndex = InputConfiguration.MediaConnection.Device.DeviceIdentifier;
+				bCanDoKeyAndFill = CanDeviceDoAlpha(InputConfiguration.MediaConnection.Device);
+			}
+
+			AjaDeviceProvider::AppendInputConfigurations(InputConfiguration, OtherSources, bCanDoKeyAndFill, DefaultInputConfiguration, Results);
 		}
 
-		DefaultInputConfiguration.MediaConfiguration = InputConfiguration;
+		return Results;
+	});
+}
 
-		// Build the list for fill
-		DefaultInputConfiguration.InputType = EMediaIOInputType::Fill;
-		Results.Add(DefaultInputConfiguration);
+TArray<FMediaIOOutputConfiguration> FAjaDeviceProvider::GetOutputConfigurations() const
+{
+	return AjaDeviceProvider::FindOrBuild(AjaDeviceProvider::QueryCache.OutputConfigurations, [this](const FAjaDeviceCatalog::FSnapshot& InSnapshot)
+	{
+		TArray<FMediaIOOutputConfiguration> Results;
+		TArray<FMediaIOConfiguration> OutputConfigurations = GetConfigurations(false, true);
+		TArray<FMediaIOConnection> OtherSources = GetConnections();
 
-		// Add all output port for key
-		if (bCanDoKeyAndFill)
+		FMediaIOOutputConfiguration DefaultOutputConfiguration = GetDefaultOutputConfiguration();
+		Results.Reset(OutputConfigurations.Num() * 4);
+
+		int32 LastDeviceIndex = INDEX_NONE;
+		bool bCanDoKeyAndFill = false;
+
+		for (const FMediaIOConfiguration& OutputConfiguration : OutputConfigurations)
 		{
-			DefaultInputConfiguration.InputType = EMediaIOInputType::FillAndKey;
-			for (const FMediaIOConnection& InputPort : OtherSources)
+			// Update the Device Info
+			if (OutputConfiguration.MediaConnection.Device.DeviceIdentifier != LastDeviceIndex)
 			{
-				if (InputPort.Device == InputConfiguration.MediaConnection.Device && InputPort.TransportType == InputConfiguration.MediaConnection.TransportType && InputPort.PortIdentifier != InputConfiguration.MediaConnection.PortIdentifier)
-				{
-					if (InputPort.TransportType != EMediaIOTransportType::QuadLink || InputPort.QuadTransportType == InputConfiguration.MediaConnection.QuadTransportType)
-					{
-						DefaultInputConfiguration.KeyPortIdentifier = InputPort.PortIdentifier;
-						Results.Add(DefaultInputConfiguration);
-					}
-				}
+				LastDeviceIndex = OutputConfiguration.MediaConnection.Device.DeviceIdentifier;
+				bCanDoKeyAndFill = CanDeviceDoAlpha(OutputConfiguration.MediaConnection.Device);
 			}
+
+			AjaDeviceProvider::AppendOutputConfigurations(OutputConfiguration, OtherSources, bCanDoKeyAndFill, DefaultOutputConfiguration, Results);
 		}
+
+		return Results;
+	});
+}
+
+TArray<FMediaIOConfiguration> FAjaDeviceProvider::FindConfigurations(const FAjaMediaConfigurationQuery& InQuery) const
+{
+	TArray<FMediaIOConfiguration> Results;
+	if (!FAja::IsInitialized() || !FAja::CanUseAJACard())
+	{
+		return Results;
 	}
 
+	const TSharedRef<const AjaDeviceProvider::FConfigurationIndex, ESPMode::ThreadSafe> Index = AjaDeviceProvider::GetConfigurationIndex();
+	Index->Find(InQuery, [&Results](const FMediaIOConfiguration& InConfiguration)
+	{
+		Results.Add(InConfiguration);
+	});
 	return Results;
 }
 
-TArray<FMediaIOOutputConfiguration> FAjaDeviceProvider::GetOutputConfigurations() const
+TArray<FMediaIOInputConfiguration> FAjaDeviceProvider::FindInputConfigurations(const FAjaMediaConfigurationQuery& InQuery) const
+{
+	TArray<FMediaIOInputConfiguration> Results;
+	if (!FAja::IsInitialized() || !FAja::CanUseAJACard() || (InQuery.bIsInput.IsSet() && !InQuery.bIsInput.GetValue()))
+	{
+		return Results;
+	}
+
+	FAjaMediaConfigurationQuery InputQuery = InQuery;
+	InputQuery.bIsInput = true;
+
+	FMediaIOInputConfiguration DefaultInputConfiguration = GetDefaultInputConfiguration();
+	const TSharedRef<const AjaDeviceProvider::FConfigurationIndex, ESPMode::ThreadSafe> Index = AjaDeviceProvider::GetConfigurationIndex();
+	Index->Find(InputQuery, [&](const FMediaIOConfiguration& InConfiguration)
+	{
+		AjaDeviceProvider::AppendInputConfigurations(InConfiguration, Index->Connections, Index->CanDeviceDoAlpha(InConfiguration), DefaultInputConfiguration, Results);
+	});
+	return Results;
+}
+
+TArray<FMediaIOOutputConfiguration> FAjaDeviceProvider::FindOutputConfigurations(const FAjaMediaConfigurationQuery& InQuery) const
 {
 	TArray<FMediaIOOutputConfiguration> Results;
-	TArray<FMediaIOConfiguration> OutputConfigurations = GetConfigurations(false, true);
-	TArray<FMediaIOConnection> OtherSources = GetConnections();
+	if (!FAja::IsInitialized() || !FAja::CanUseAJACard() || (InQuery.bIsInput.IsSet() && InQuery.bIsInput.GetValue()))
+	{
+		return Results;
+	}
+
+	FAjaMediaConfigurationQuery OutputQuery = InQuery;
+	OutputQuery.bIsInput = false;
 
 	FMediaIOOutputConfiguration DefaultOutputConfiguration = GetDefaultOutputConfiguration();
-	Results.Reset(OutputConfigurations.Num() * 4);
+	const TSharedRef<const AjaDeviceProvider::FConfigurationIndex, ESPMode::ThreadSafe> Index = AjaDeviceProvider::GetConfigurationIndex();
+	Index->Find(OutputQuery, [&](const FMediaIOConfiguration& InConfiguration)
+	{
+		AjaDeviceProvider::AppendOutputConfigurations(InConfiguration, Index->Connections, Index->CanDeviceDoAlpha(InConfiguration), DefaultOutputConfiguration, Results);
+	});
+	return Results;
+}
 
-	int32 LastDeviceIndex = INDEX_NONE;
-	bool bCanDoKeyAndFill = false;
+bool FAjaDeviceProvider::IsConfigurationSupported(const FMediaIOConfiguration& InConfiguration) const
+{
+	if (!FAja::IsInitialized() || !FAja::CanUseAJACard())
+	{
+		return false;
+	}
+
+	return AjaDeviceProvider::GetConfigurationIndex()->Contains(InConfiguration);
+}
 
-	for (const FMediaIOConfiguration& OutputConfiguration : OutputConfigurations)
+bool FAjaDeviceProvider::IsInputConfigurationSupported(const FMediaIOInputConfiguration& InConfiguration) const
+{
+	if (!InConfiguration.MediaConfiguration.bIsInput || !IsConfigurationSupported(InConfiguration.MediaConfiguration))
 	{
-		auto BuildList = [&]()
-		{
-			DefaultOutputConfiguration.MediaConfiguration = OutputConfiguration;
+		return false;
+	}
 
-			DefaultOutputConfiguration.OutputReference = EMediaIOReferenceType::FreeRun;
-			Results.Add(DefaultOutputConfiguration);
+	if (InConfiguration.InputType == EMediaIOInputType::FillAndKey)
+	{
+		const TSharedRef<const AjaDeviceProvider::FConfigurationIndex, ESPMode::ThreadSafe> Index = AjaDeviceProvider::GetConfigurationIndex();
+		return Index->CanDeviceDoAlpha(InConfiguration.MediaConfiguration)
+			&& AjaDeviceProvider::IsOtherPort(InConfiguration.MediaConfiguration, Index->Connections, InConfiguration.KeyPortIdentifier);
+	}
 
-			DefaultOutputConfiguration.OutputReference = EMediaIOReferenceType::External;
-			Results.Add(DefaultOutputConfiguration);
+	return true;
+}
 
-			// Add all inputs for reference input
-			DefaultOutputConfiguration.OutputReference = EMediaIOReferenceType::Input;
-			for (const FMediaIOConnection& InputPort : OtherSources)
-			{
-				if (InputPort.Device == OutputConfiguration.MediaConnection.Device && InputPort.TransportType == OutputConfiguration.MediaConnection.TransportType && InputPort.PortIdentifier != OutputConfiguration.MediaConnection.PortIdentifier)
-				{
-					if (InputPort.TransportType != EMediaIOTransportType::QuadLink || InputPort.QuadTransportType == OutputConfiguration.MediaConnection.QuadTransportType)
-					{
-						if (DefaultOutputConfiguration.OutputType != EMediaIOOutputType::FillAndKey || !(InputPort.PortIdentifier == DefaultOutputConfiguration.KeyPortIdentifier))
-						{
-							DefaultOutputConfiguration.ReferencePortIdentifier = InputPort.PortIdentifier;
-							Results.Add(DefaultOutputConfiguration);
-						}
-					}
-				}
-			}
-		};
+bool FAjaDeviceProvider::IsOutputConfigurationSupported(const FMediaIOOutputConfiguration& InConfiguration) const
+{
+	if (InConfiguration.MediaConfiguration.bIsInput || !IsConfigurationSupported(InConfiguration.MediaConfiguration))
+	{
+		return false;
+	}
 
-		// Update the Device Info
-		if (OutputConfiguration.MediaConnection.Device.DeviceIdentifier != LastDeviceIndex)
+	const TSharedRef<const AjaDeviceProvider::FConfigurationIndex, ESPMode::ThreadSafe> Index = AjaDeviceProvider::GetConfigurationIndex();
+	const bool bIsFillAndKey = InConfiguration.OutputType == EMediaIOOutputType::FillAndKey;
+	if (bIsFillAndKey)
+	{
+		if (!Index->CanDeviceDoAlpha(InConfiguration.MediaConfiguration) || !AjaDeviceProvider::IsOtherPort(InConfiguration.MediaConfiguration, Index->Connections, InConfiguration.KeyPortIdentifier))
 		{
-			LastDeviceIndex = OutputConfiguration.MediaConnection.Device.DeviceIdentifier;
-			bCanDoKeyAndFill = CanDeviceDoAlpha(OutputConfiguration.MediaConnection.Device);
+			return false;
 		}
+	}
 
-		// Build the list for fill only
-		DefaultOutputConfiguration.OutputType = EMediaIOOutputType::Fill;
-		BuildList();
-
-		// Add all output port for key
-		if (bCanDoKeyAndFill)
+	if (InConfiguration.OutputReference == EMediaIOReferenceType::Input)
+	{
+		if (bIsFillAndKey && InConfiguration.ReferencePortIdentifier == InConfiguration.KeyPortIdentifier)
 		{
-			DefaultOutputConfiguration.OutputType = EMediaIOOutputType::FillAndKey;
-			for (const FMediaIOConnection& OutputPort : OtherSources)
-			{
-				if (OutputPort.Device == OutputConfiguration.MediaConnection.Device && OutputPort.TransportType == OutputConfiguration.MediaConnection.TransportType && OutputPort.PortIdentifier != OutputConfiguration.MediaConnection.PortIdentifier)
-				{
-					if (OutputPort.TransportType != EMediaIOTransportType::QuadLink || OutputPort.QuadTransportType == OutputConfiguration.MediaConnection.QuadTransportType)
-					{
-						DefaultOutputConfiguration.KeyPortIdentifier = OutputPort.PortIdentifier;
-						BuildList();
-					}
-				}
-			}
+			return false;
 		}
+		return AjaDeviceProvider::IsOtherPort(InConfiguration.MediaConfiguration, Index->Connections, InConfiguration.ReferencePortIdentifier);
 	}
 
-	return Results;
+	return true;
 }
 
 TArray<FMediaIODevice> FAjaDeviceProvider::GetDevices() const
@@ -541,30 +927,17 @@ TArray<FMediaIODevice> FAjaDeviceProvider::GetDevices() const
 		return Results;
 	}
 
-	AJA::AJADeviceScanner DeviceScanner;
-	int32 NumDevices = DeviceScanner.GetNumDevices();
-	for (int32 DeviceIndex = 0; DeviceIndex < NumDevices; ++DeviceIndex)
+	const FAjaDeviceCatalog::FSnapshotRef Snapshot = FAjaDeviceCatalog::Get();
+	for (const FAjaDeviceCatalog::FDevice& CatalogDevice : Snapshot->Devices)
 	{
-		AJA::AJADeviceScanner::DeviceInfo DeviceInfo;
-		if (!DeviceScanner.GetDeviceInfo(DeviceIndex, DeviceInfo))
-		{
-			continue;
-		}
-
-		if (!DeviceInfo.bIsSupported)
-		{
-			continue;
-		}
-
-		TCHAR DeviceNameBuffer[AJA::AJADeviceScanner::FormatedTextSize];
-		if (!DeviceScanner.GetDeviceTextId(DeviceIndex, DeviceNameBuffer))
+		if (!CatalogDevice.IsUsable())
 		{
 			continue;
 		}
 
 		FMediaIODevice Device;
-		Device.DeviceIdentifier = DeviceIndex;
-		Device.DeviceName = DeviceNameBuffer;
+		Device.DeviceIdentifier = CatalogDevice.DeviceIndex;
+		Device.DeviceName = CatalogDevice.DeviceName;
 		Results.Add(Device);
 	}
 
@@ -579,17 +952,14 @@ TArray<FMediaIOMode> FAjaDeviceProvider::GetModes(const FMediaIODevice& InDevice
 		return Results;
 	}
 
-	AJA::AJADeviceScanner DeviceScanner;
-	AJA::AJADeviceScanner::DeviceInfo DeviceInfo;
-	if (!DeviceScanner.GetDeviceInfo(InDevice.DeviceIdentifier, DeviceInfo))
+	const FAjaDeviceCatalog::FSnapshotRef Snapshot = FAjaDeviceCatalog::Get();
+	const FAjaDeviceCatalog::FDevice* Device = Snapshot->FindDevice(InDevice.DeviceIdentifier);
+	if (Device == nullptr || !Device->Info.bIsSupported)
 	{
 		return Results;
 	}
 
-	if (!DeviceInfo.bIsSupported)
-	{
-		return Results;
-	}
+	const AJA::AJADeviceScanner::DeviceInfo& DeviceInfo = Device->Info;
 
 	const bool bDeviceHasInput = DeviceInfo.NumSdiInput > 0 || DeviceInfo.NumHdmiInput > 0;
 	if (!bInOutput && !bDeviceHasInput)
@@ -603,17 +973,14 @@ TArray<FMediaIOMode> FAjaDeviceProvider::GetModes(const FMediaIODevice& InDevice
 		return Results;
 	}
 
-	AJA::AJAVideoFormats FrameFormats(InDevice.DeviceIdentifier);
-	const int32 NumSupportedFormat = FrameFormats.GetNumSupportedFormat();
-	Results.Reserve(NumSupportedFormat);
-	for (int32 Index = 0; Index < NumSupportedFormat; ++Index)
+	Results.Reserve(Device->Formats.Num());
+	for (const AJA::AJAVideoFormats::VideoFormatDescriptor& Descriptor : Device->Formats)
 	{
-		AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = FrameFormats.GetSupportedFormat(Index);
 		if (!AjaDeviceProvider::IsVideoFormatValid(Descriptor))
 		{
 			continue;
 		}
-		Results.Add(AjaDeviceProvider::ToMediaMode(Descriptor));
+		Results.Add(FAja::ConvertVideoFormat2MediaMode(Descriptor));
 	}
 
 	return Results;
@@ -653,31 +1020,19 @@ TArray<FAjaMediaTimecodeReference> FAjaDeviceProvider::GetTimecodeReferences() c
 
 	FAjaMediaTimecodeReference DefaultFAjaMediaTimecodeReference = FAjaMediaTimecodeReference();
 
-	AJA::AJADeviceScanner DeviceScanner;
-	int32 NumDevices = DeviceScanner.GetNumDevices();
-	for (int32 DeviceIndex = 0; DeviceIndex < NumDevices; ++DeviceIndex)
+	const FAjaDeviceCatalog::FSnapshotRef Snapshot = FAjaDeviceCatalog::Get();
+	for (const FAjaDeviceCatalog::FDevice& Device : Snapshot->Devices)
 	{
-		AJA::AJADeviceScanner::DeviceInfo DeviceInfo;
-		if (!DeviceScanner.GetDeviceInfo(DeviceIndex, DeviceInfo))
-		{
-			continue;
-		}
-
-		if (!DeviceInfo.bIsSupported)
+		if (!Device.IsUsable())
 		{
 			continue;
 		}
 
+		const AJA::AJADeviceScanner::DeviceInfo& DeviceInfo = Device.Info;
 		if (DeviceInfo.bCanDoLtcInRefPort && DeviceInfo.NumberOfLtcInput > 0)
 		{
-			TCHAR DeviceNameBuffer[AJA::AJADeviceScanner::FormatedTextSize];
-			if (!DeviceScanner.GetDeviceTextId(DeviceIndex, DeviceNameBuffer))
-			{
-				continue;
-			}
-
-			DefaultFAjaMediaTimecodeReference.Device.DeviceIdentifier = DeviceIndex;
-			DefaultFAjaMediaTimecodeReference.Device.DeviceName = DeviceNameBuffer;
+			DefaultFAjaMediaTimecodeReference.Device.DeviceIdentifier = Device.DeviceIndex;
+			DefaultFAjaMediaTimecodeReference.Device.DeviceName = Device.DeviceName;
 
 			for (uint32 LtcIndex = 0; LtcIndex < DeviceInfo.NumberOfLtcInput; ++LtcIndex)
 			{
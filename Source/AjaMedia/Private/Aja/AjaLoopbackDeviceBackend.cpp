@@ -0,0 +1,1603 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaLoopbackDeviceBackend.h"
+
+#include "Aja.h"
+#include "AjaMediaAncillary.h"
+#include "AjaMediaPrivate.h"
+
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformAtomics.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/ScopeExit.h"
+#include "Misc/ScopeLock.h"
+#include "Templates/Function.h"
+
+
+namespace AjaLoopbackDeviceBackend
+{
+	static const int32 MaxNumDevices = 8;
+	static const uint32 AudioSampleRate = 48000;
+	static const uint32 MaxNumAudioChannels = 16;
+	static const uint32 AncBufferSize = 2048;
+	static const uint32 MovingBoxSize = 32;
+
+	static TAutoConsoleVariable<int32> CVarSignalFormat(
+		TEXT("Aja.Loopback.SignalFormat"),
+		0,
+		TEXT("Video format of the signal on every loopback input. The inputs opened with another format stop, like a card does when its signal changes. 0 to accept every format."),
+		ECVF_Default);
+
+	/* Video formats
+	*****************************************************************************/
+	enum class EScan : uint8
+	{
+		Progressive,
+		Interlaced,
+		Psf,
+	};
+
+	struct FFormatEntry
+	{
+		AJA::FAJAVideoFormat VideoFormatIndex;
+		uint32 FrameRateNumerator;
+		uint32 FrameRateDenominator;
+		uint32 Width;
+		uint32 Height;
+		EScan Scan;
+		bool bIsVideoFormatA;
+	};
+
+	// The indices only need to be unique within this backend. The HD ones match the SDK, so the default format (9) is 1080p30 in both.
+	static const FFormatEntry Formats[] =
+	{
+		{  1,    25,    1, 1920, 1080, EScan::Interlaced,  false },
+		{  2, 30000, 1001, 1920, 1080, EScan::Interlaced,  false },
+		{  3,    30,    1, 1920, 1080, EScan::Interlaced,  false },
+		{  4, 60000, 1001, 1280,  720, EScan::Progressive, false },
+		{  5,    60,    1, 1280,  720, EScan::Progressive, false },
+		{  6, 24000, 1001, 1920, 1080, EScan::Psf,         false },
+		{  7,    24,    1, 1920, 1080, EScan::Psf,         false },
+		{  8, 30000, 1001, 1920, 1080, EScan::Progressive, false },
+		{  9,    30,    1, 1920, 1080, EScan::Progressive, false },
+		{ 10,    25,    1, 1920, 1080, EScan::Progressive, false },
+		{ 11, 24000, 1001, 1920, 1080, EScan::Progressive, false },
+		{ 12,    24,    1, 1920, 1080, EScan::Progressive, false },
+		{ 13,    50,    1, 1280,  720, EScan::Progressive, false },
+		{ 14,    50,    1, 1920, 1080, EScan::Progressive, true  },
+		{ 15, 60000, 1001, 1920, 1080, EScan::Progressive, true  },
+		{ 16,    60,    1, 1920, 1080, EScan::Progressive, true  },
+		{ 17, 24000, 1001, 3840, 2160, EScan::Progressive, false },
+		{ 18,    24,    1, 3840, 2160, EScan::Progressive, false },
+		{ 19,    25,    1, 3840, 2160, EScan::Progressive, false },
+		{ 20, 30000, 1001, 3840, 2160, EScan::Progressive, false },
+		{ 21,    30,    1, 3840, 2160, EScan::Progressive, false },
+		{ 22,    50,    1, 3840, 2160, EScan::Progressive, false },
+		{ 23, 60000, 1001, 3840, 2160, EScan::Progressive, false },
+		{ 24,    60,    1, 3840, 2160, EScan::Progressive, false },
+	};
+
+	AJA::AJAVideoFormats::VideoFormatDescriptor MakeDescriptor(const FFormatEntry& InEntry)
+	{
+		AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor;
+		Descriptor.VideoFormatIndex = InEntry.VideoFormatIndex;
+		Descriptor.FrameRateNumerator = InEntry.FrameRateNumerator;
+		Descriptor.FrameRateDenominator = InEntry.FrameRateDenominator;
+		Descriptor.ResolutionWidth = InEntry.Width;
+		Descriptor.ResolutionHeight = InEntry.Height;
+		Descriptor.bIsProgressiveStandard = InEntry.Scan != EScan::Interlaced;
+		Descriptor.bIsInterlacedStandard = InEntry.Scan == EScan::Interlaced;
+		Descriptor.bIsPsfStandard = InEntry.Scan == EScan::Psf;
+		Descriptor.bIsVideoFormatA = InEntry.bIsVideoFormatA;
+		Descriptor.bIsHD = InEntry.Height <= 1080;
+		Descriptor.bIs4K = InEntry.Height > 1080;
+		Descriptor.bIsValid = true;
+		return Descriptor;
+	}
+
+	bool FindVideoFormat(AJA::FAJAVideoFormat InVideoFormatIndex, AJA::AJAVideoFormats::VideoFormatDescriptor& OutDescriptor)
+	{
+		for (const FFormatEntry& Entry : Formats)
+		{
+			if (Entry.VideoFormatIndex == InVideoFormatIndex)
+			{
+				OutDescriptor = MakeDescriptor(Entry);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/* Helpers
+	*****************************************************************************/
+	bool ValidateChannel(const FAjaLoopbackDeviceBackend& InBackend, uint32 InDeviceIndex, uint32 InChannelIndex, const TCHAR* InChannelType)
+	{
+		if ((int32)InDeviceIndex >= InBackend.GetNumDevices())
+		{
+			UE_LOG(LogAjaMedia, Error, TEXT("Loopback: The device %d doesn't exist. Launch with -AjaLoopbackDevices=N to simulate more devices."), InDeviceIndex);
+			return false;
+		}
+		if (InChannelIndex < 1 || (int32)InChannelIndex > FAjaLoopbackDeviceBackend::NumChannelsPerDevice)
+		{
+			UE_LOG(LogAjaMedia, Error, TEXT("Loopback: The %s channel %d doesn't exist on device %d."), InChannelType, InChannelIndex, InDeviceIndex);
+			return false;
+		}
+		return true;
+	}
+
+	AJA::FTimecode MakeTimecode(uint64 InFrameNumber, uint32 InFramesPerSecond)
+	{
+		const uint64 TotalSeconds = InFrameNumber / InFramesPerSecond;
+
+		AJA::FTimecode Timecode;
+		Timecode.Frames = (uint32)(InFrameNumber % InFramesPerSecond);
+		Timecode.Seconds = (uint32)(TotalSeconds % 60);
+		Timecode.Minutes = (uint32)((TotalSeconds / 60) % 60);
+		Timecode.Hours = (uint32)((TotalSeconds / 3600) % 24);
+		return Timecode;
+	}
+
+	uint32 GetTimecodeFramesPerSecond(uint32 InNumerator, uint32 InDenominator)
+	{
+		return FMath::Max<uint32>((InNumerator + InDenominator / 2) / InDenominator, 1);
+	}
+
+	/* FFrameClockRunnable
+	 * Tick a channel at every frame boundary, measured from the backend epoch.
+	*****************************************************************************/
+	class FFrameClockRunnable : public FRunnable
+	{
+	public:
+		FFrameClockRunnable()
+			: Epoch(0.0)
+			, FrameDuration(0.0)
+			, Thread(nullptr)
+		{}
+
+		virtual ~FFrameClockRunnable()
+		{
+			check(Thread == nullptr);
+		}
+
+		bool StartClock(const TCHAR* InThreadName, double InEpoch, double InFrameDuration)
+		{
+			check(Thread == nullptr);
+			Epoch = InEpoch;
+			FrameDuration = InFrameDuration;
+			bStopping = false;
+			Thread = FRunnableThread::Create(this, InThreadName, 0, TPri_TimeCritical);
+			return Thread != nullptr;
+		}
+
+		void StopClock()
+		{
+			if (Thread)
+			{
+				Thread->Kill(true);
+				delete Thread;
+				Thread = nullptr;
+			}
+		}
+
+		uint64 GetFrameNumber(double InSeconds) const
+		{
+			return InSeconds > Epoch ? (uint64)((InSeconds - Epoch) / FrameDuration) : 0;
+		}
+
+	public:
+		//~ FRunnable interface
+		virtual uint32 Run() override
+		{
+			if (!OnClockStarted())
+			{
+				return 0;
+			}
+
+			uint64 LastFrameNumber = GetFrameNumber(FPlatformTime::Seconds());
+			while (!bStopping)
+			{
+				const uint64 NextFrameNumber = LastFrameNumber + 1;
+				const double Deadline = Epoch + NextFrameNumber * FrameDuration;
+
+				// Sleep most of the interval and spin the last millisecond. The scheduler is not precise enough to hit the deadline.
+				for (double Remaining = Deadline - FPlatformTime::Seconds(); Remaining > 0.0 && !bStopping; Remaining = Deadline - FPlatformTime::Seconds())
+				{
+					if (Remaining > 0.002)
+					{
+						FPlatformProcess::SleepNoStats((float)(Remaining - 0.001));
+					}
+					else
+					{
+						FPlatformProcess::YieldThread();
+					}
+				}
+
+				if (bStopping)
+				{
+					break;
+				}
+
+				// When the thread was not scheduled in time, the frames in between are lost.
+				const uint64 FrameNumber = FMath::Max(NextFrameNumber, GetFrameNumber(FPlatformTime::Seconds()));
+				if (!OnFrame(FrameNumber, (uint32)(FrameNumber - NextFrameNumber)))
+				{
+					break;
+				}
+				LastFrameNumber = FrameNumber;
+			}
+
+			return 0;
+		}
+
+		virtual void Stop() override
+		{
+			bStopping = true;
+		}
+
+	protected:
+		/** Called from the clock thread before the first frame. Return false to exit the thread. */
+		virtual bool OnClockStarted() { return true; }
+
+		/** Called from the clock thread at every frame boundary. Return false to exit the thread. */
+		virtual bool OnFrame(uint64 InFrameNumber, uint32 InNumSkippedFrames) = 0;
+
+	protected:
+		double Epoch;
+		double FrameDuration;
+		FThreadSafeBool bStopping;
+
+	private:
+		FRunnableThread* Thread;
+	};
+
+	/* Test pattern
+	*****************************************************************************/
+	/** Colour in 10 bits Rec.709 YCbCr and full range RGB. */
+	struct FPatternColor
+	{
+		uint16 Y, Cb, Cr;
+		uint16 R, G, B;
+	};
+
+	// 75% colour bars
+	static const FPatternColor ColorBars[] =
+	{
+		{ 720, 512, 512, 767, 767, 767 }, // White
+		{ 672, 176, 544, 767, 767,   0 }, // Yellow
+		{ 580, 588, 176,   0, 767, 767 }, // Cyan
+		{ 532, 252, 208,   0, 767,   0 }, // Green
+		{ 252, 772, 816, 767,   0, 767 }, // Magenta
+		{ 204, 436, 848, 767,   0,   0 }, // Red
+		{ 112, 848, 480,   0,   0, 767 }, // Blue
+	};
+	static const FPatternColor ColorWhite = { 940, 512, 512, 1023, 1023, 1023 };
+	static const FPatternColor ColorBlack = {  64, 512, 512,    0,    0,    0 };
+
+	void WriteRow(AJA::EPixelFormat InPixelFormat, uint8* OutRow, uint32 InWidth, TFunctionRef<const FPatternColor&(uint32)> InColorAt)
+	{
+		switch (InPixelFormat)
+		{
+		case AJA::EPixelFormat::PF_8BIT_YCBCR:
+			for (uint32 X = 0; X < InWidth; X += 2, OutRow += 4)
+			{
+				const FPatternColor& Color0 = InColorAt(X);
+				const FPatternColor& Color1 = InColorAt(FMath::Min(X + 1, InWidth - 1));
+				OutRow[0] = (uint8)(Color0.Cb >> 2);
+				OutRow[1] = (uint8)(Color0.Y >> 2);
+				OutRow[2] = (uint8)(Color0.Cr >> 2);
+				OutRow[3] = (uint8)(Color1.Y >> 2);
+			}
+			break;
+		case AJA::EPixelFormat::PF_8BIT_ARGB:
+			for (uint32 X = 0; X < InWidth; ++X, OutRow += 4)
+			{
+				const FPatternColor& Color = InColorAt(X);
+				OutRow[0] = (uint8)(Color.B >> 2);
+				OutRow[1] = (uint8)(Color.G >> 2);
+				OutRow[2] = (uint8)(Color.R >> 2);
+				OutRow[3] = 0xFF;
+			}
+			break;
+		case AJA::EPixelFormat::PF_10BIT_RGB:
+			for (uint32 X = 0; X < InWidth; ++X, OutRow += 4)
+			{
+				const FPatternColor& Color = InColorAt(X);
+				const uint32 Value = (3u << 30) | ((uint32)Color.B << 20) | ((uint32)Color.G << 10) | (uint32)Color.R;
+				FMemory::Memcpy(OutRow, &Value, sizeof(uint32));
+			}
+			break;
+		case AJA::EPixelFormat::PF_10BIT_YCBCR:
+			// v210, 6 pixels in 4 words
+			for (uint32 X = 0; X < InWidth; X += 6, OutRow += 16)
+			{
+				const FPatternColor* Color[6];
+				for (uint32 Index = 0; Index < 6; ++Index)
+				{
+					Color[Index] = &InColorAt(FMath::Min(X + Index, InWidth - 1));
+				}
+				const uint32 Words[4] =
+				{
+					(uint32)Color[0]->Cb | ((uint32)Color[0]->Y << 10) | ((uint32)Color[0]->Cr << 20),
+					(uint32)Color[1]->Y  | ((uint32)Color[2]->Cb << 10) | ((uint32)Color[2]->Y << 20),
+					(uint32)Color[2]->Cr | ((uint32)Color[3]->Y << 10) | ((uint32)Color[4]->Cb << 20),
+					(uint32)Color[4]->Y  | ((uint32)Color[4]->Cr << 10) | ((uint32)Color[5]->Y << 20),
+				};
+				FMemory::Memcpy(OutRow, Words, sizeof(Words));
+			}
+			break;
+		}
+	}
+
+	/* Ancillary packets, see AjaMediaAncillary for the layout
+	*****************************************************************************/
+	struct FAncWriter
+	{
+		FAncWriter(uint8* InBuffer, uint32 InCapacity)
+			: Buffer(InBuffer)
+			, Capacity(InCapacity)
+			, Size(0)
+		{}
+
+		~FAncWriter()
+		{
+			FMemory::Memzero(Buffer + Size, Capacity - Size);
+		}
+
+		bool Write(bool bInField2, uint16 InLine, uint8 InDid, uint8 InSdid, const uint8* InUserData, uint8 InDataCount)
+		{
+			FAjaMediaAncillaryPacket Packet;
+			Packet.DID = InDid;
+			Packet.SDID = InSdid;
+			Packet.Line = InLine;
+			Packet.bField2 = bInField2;
+			Packet.UserData = TArrayView<const uint8>(InUserData, InDataCount);
+
+			const uint32 PacketSize = AjaMediaAncillary::WritePacket(Packet, Buffer + Size, Capacity - Size);
+			Size += PacketSize;
+			return PacketSize > 0;
+		}
+
+		uint8* Buffer;
+		uint32 Capacity;
+		uint32 Size;
+	};
+
+	void WriteAncillaryPackets(FAncWriter& InWriter, bool bInField2, uint16 InLine, const AJA::FTimecode& InTimecode, uint32 InFrameCounter)
+	{
+		// SMPTE 12M-2 ATC, the BCD digits are in the high nibble of the even words. The binary groups are left empty.
+		uint8 Atc[16] = { 0 };
+		Atc[0] = (uint8)((InTimecode.Frames % 10) << 4);
+		Atc[2] = (uint8)((InTimecode.Frames / 10) << 4);
+		Atc[4] = (uint8)((InTimecode.Seconds % 10) << 4);
+		Atc[6] = (uint8)((InTimecode.Seconds / 10) << 4);
+		Atc[8] = (uint8)((InTimecode.Minutes % 10) << 4);
+		Atc[10] = (uint8)((InTimecode.Minutes / 10) << 4);
+		Atc[12] = (uint8)((InTimecode.Hours % 10) << 4);
+		Atc[14] = (uint8)((InTimecode.Hours / 10) << 4);
+		InWriter.Write(bInField2, InLine, 0x60, 0x60, Atc, sizeof(Atc));
+
+		// Frame counter, to verify that no packet is lost or reordered
+		uint8 Counter[4];
+		Counter[0] = (uint8)(InFrameCounter);
+		Counter[1] = (uint8)(InFrameCounter >> 8);
+		Counter[2] = (uint8)(InFrameCounter >> 16);
+		Counter[3] = (uint8)(InFrameCounter >> 24);
+		InWriter.Write(bInField2, InLine + 1, 0x50, 0x01, Counter, sizeof(Counter));
+	}
+
+	/* Audio
+	*****************************************************************************/
+	struct FSineTable
+	{
+		// One period of a 1 kHz sine at 48 kHz, -20 dBFS, 24 bits in the high bits of 32 bits
+		FSineTable()
+		{
+			for (int32 Index = 0; Index < 48; ++Index)
+			{
+				Values[Index] = FMath::RoundToInt(0.1f * 8388607.f * FMath::Sin(2.f * PI * Index / 48.f)) << 8;
+			}
+		}
+
+		int32 Values[48];
+	};
+
+	const int32* GetSineTable()
+	{
+		static const FSineTable Table;
+		return Table.Values;
+	}
+
+	uint64 GetAudioSampleIndex(uint64 InFrameNumber, uint32 InNumerator, uint32 InDenominator)
+	{
+		// 1601/1602 cadence for the 1001 rates
+		return InFrameNumber * AudioSampleRate * InDenominator / InNumerator;
+	}
+
+	/* FDeviceScanner
+	*****************************************************************************/
+	class FDeviceScanner : public IAjaDeviceScanner
+	{
+	public:
+		FDeviceScanner(int32 InNumDevices) : NumDevices(InNumDevices) {}
+
+		virtual int32 GetNumDevices() const override
+		{
+			return NumDevices;
+		}
+
+		virtual bool GetDeviceTextId(int32 InDeviceIndex, AJA::AJADeviceScanner::FormatedTextType& OutTextId) const override
+		{
+			if (InDeviceIndex < 0 || InDeviceIndex >= NumDevices)
+			{
+				return false;
+			}
+			FCString::Strncpy(OutTextId, *FString::Printf(TEXT("Loopback %d"), InDeviceIndex + 1), AJA::AJADeviceScanner::FormatedTextSize);
+			return true;
+		}
+
+		virtual bool GetDeviceInfo(int32 InDeviceIndex, AJA::AJADeviceScanner::DeviceInfo& OutDeviceInfo) const override
+		{
+			if (InDeviceIndex < 0 || InDeviceIndex >= NumDevices)
+			{
+				return false;
+			}
+
+			OutDeviceInfo.bIsSupported = true;
+			OutDeviceInfo.bCanFrameStore1DoPlayback = true;
+			OutDeviceInfo.bCanDoDualLink = true;
+			OutDeviceInfo.bCanDo2K = true;
+			OutDeviceInfo.bCanDo4K = true;
+			OutDeviceInfo.bCanDo12GSdi = true;
+			OutDeviceInfo.bCanDo12GRouting = true;
+			OutDeviceInfo.bCanDoMultiFormat = true;
+			OutDeviceInfo.bCanDoAlpha = true;
+			OutDeviceInfo.bCanDo3GLevelConversion = true;
+			OutDeviceInfo.bCanDoCustomAnc = true;
+			OutDeviceInfo.bCanDoLtc = true;
+			OutDeviceInfo.bCanDoLtcInRefPort = true;
+			OutDeviceInfo.bCanDoTSI = true;
+			OutDeviceInfo.bSupportPixelFormat8bitYCBCR = true;
+			OutDeviceInfo.bSupportPixelFormat8bitARGB = true;
+			OutDeviceInfo.bSupportPixelFormat10bitRGB = true;
+			OutDeviceInfo.bSupportPixelFormat10bitYCBCR = true;
+			OutDeviceInfo.NumberOfLtcInput = 1;
+			OutDeviceInfo.NumSdiInput = FAjaLoopbackDeviceBackend::NumChannelsPerDevice;
+			OutDeviceInfo.NumSdiOutput = FAjaLoopbackDeviceBackend::NumChannelsPerDevice;
+			OutDeviceInfo.NumHdmiInput = 0;
+			OutDeviceInfo.NumHdmiOutput = 0;
+			return true;
+		}
+
+	private:
+		int32 NumDevices;
+	};
+
+	/* FVideoFormats
+	*****************************************************************************/
+	class FVideoFormats : public IAjaVideoFormats
+	{
+	public:
+		FVideoFormats(bool bInIsValidDevice) : bIsValidDevice(bInIsValidDevice) {}
+
+		virtual int32 GetNumSupportedFormat() const override
+		{
+			return bIsValidDevice ? (int32)UE_ARRAY_COUNT(Formats) : 0;
+		}
+
+		virtual AJA::AJAVideoFormats::VideoFormatDescriptor GetSupportedFormat(int32 InIndex) const override
+		{
+			if (!bIsValidDevice || InIndex < 0 || InIndex >= (int32)UE_ARRAY_COUNT(Formats))
+			{
+				return AJA::AJAVideoFormats::VideoFormatDescriptor();
+			}
+			return MakeDescriptor(Formats[InIndex]);
+		}
+
+	private:
+		bool bIsValidDevice;
+	};
+
+	/* FSyncChannel
+	*****************************************************************************/
+	class FSyncChannel : public IAjaSyncChannel, private FFrameClockRunnable
+	{
+	public:
+		FSyncChannel(const FAjaLoopbackDeviceBackend& InBackend)
+			: Backend(InBackend)
+			, CallbackInterface(nullptr)
+			, TimecodeFramesPerSecond(30)
+			, SyncCount(0)
+			, SyncEvent(nullptr)
+			, bSyncClosed(true)
+			, NumSyncWaiters(0)
+		{}
+
+		virtual ~FSyncChannel()
+		{
+			Uninitialize();
+		}
+
+		virtual bool Initialize(const AJA::AJADeviceOptions& InDevice, const AJA::AJASyncChannelOptions& InOptions) override
+		{
+			if (!ValidateChannel(Backend, InDevice.DeviceIndex, InOptions.ChannelIndex, InOptions.bOutput ? TEXT("output") : TEXT("input")))
+			{
+				return false;
+			}
+
+			uint32 Numerator = 0;
+			uint32 Denominator = 0;
+			if (InOptions.bReadTimecodeFromReferenceIn && InOptions.LTCFrameRateNumerator > 0 && InOptions.LTCFrameRateDenominator > 0)
+			{
+				Numerator = InOptions.LTCFrameRateNumerator;
+				Denominator = InOptions.LTCFrameRateDenominator;
+			}
+			else
+			{
+				AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor;
+				if (!FindVideoFormat(InOptions.VideoFormatIndex, Descriptor))
+				{
+					UE_LOG(LogAjaMedia, Error, TEXT("Loopback: The video format %d is not supported."), InOptions.VideoFormatIndex);
+					return false;
+				}
+				Numerator = Descriptor.FrameRateNumerator;
+				Denominator = Descriptor.FrameRateDenominator;
+			}
+
+			CallbackInterface = InOptions.CallbackInterface;
+			TimecodeFramesPerSecond = GetTimecodeFramesPerSecond(Numerator, Denominator);
+			SyncCount = 0;
+
+			const bool bIsManualReset = false;
+			SyncEvent = FPlatformProcess::GetSynchEventFromPool(bIsManualReset);
+			FPlatformAtomics::InterlockedExchange(&bSyncClosed, false);
+
+			return StartClock(TEXT("AjaLoopbackSyncChannel"), Backend.GetEpoch(), (double)Denominator / (double)Numerator);
+		}
+
+		virtual void Uninitialize() override
+		{
+			StopClock();
+			if (SyncEvent)
+			{
+				// The waiters check bSyncClosed once they are counted. Wake them and wait for them to leave before the event goes back to the pool.
+				FPlatformAtomics::InterlockedExchange(&bSyncClosed, true);
+				while (FPlatformAtomics::AtomicRead(&NumSyncWaiters) > 0)
+				{
+					SyncEvent->Trigger();
+					FPlatformProcess::YieldThread();
+				}
+
+				FPlatformProcess::ReturnSynchEventToPool(SyncEvent);
+				SyncEvent = nullptr;
+			}
+		}
+
+		virtual bool WaitForSync() const override
+		{
+			FPlatformAtomics::InterlockedIncrement(&NumSyncWaiters);
+			ON_SCOPE_EXIT
+			{
+				FPlatformAtomics::InterlockedDecrement(&NumSyncWaiters);
+			};
+
+			if (FPlatformAtomics::AtomicRead(&bSyncClosed))
+			{
+				return false;
+			}
+
+			// Give up after a few frames, like the card would do when the reference is lost.
+			const uint32 TimeoutMs = (uint32)(FrameDuration * 4000.0) + 1;
+			const int32 StartCount = FPlatformAtomics::AtomicRead(&SyncCount);
+			const double StartTime = FPlatformTime::Seconds();
+			while (FPlatformAtomics::AtomicRead(&SyncCount) == StartCount)
+			{
+				const uint32 ElapsedMs = (uint32)((FPlatformTime::Seconds() - StartTime) * 1000.0);
+				if (ElapsedMs >= TimeoutMs || FPlatformAtomics::AtomicRead(&bSyncClosed))
+				{
+					return false;
+				}
+				SyncEvent->Wait(TimeoutMs - ElapsedMs);
+			}
+			return true;
+		}
+
+		virtual bool GetTimecode(AJA::FTimecode& OutTimecode) const override
+		{
+			if (SyncEvent == nullptr)
+			{
+				return false;
+			}
+			OutTimecode = MakeTimecode(GetFrameNumber(FPlatformTime::Seconds()), TimecodeFramesPerSecond);
+			return true;
+		}
+
+		virtual bool GetSyncCount(uint32& OutCount) const override
+		{
+			if (SyncEvent == nullptr)
+			{
+				return false;
+			}
+			OutCount = (uint32)FPlatformAtomics::AtomicRead(&SyncCount);
+			return true;
+		}
+
+	protected:
+		//~ FFrameClockRunnable interface
+		virtual bool OnClockStarted() override
+		{
+			if (CallbackInterface)
+			{
+				CallbackInterface->OnInitializationCompleted(true);
+			}
+			return true;
+		}
+
+		virtual bool OnFrame(uint64 InFrameNumber, uint32 InNumSkippedFrames) override
+		{
+			FPlatformAtomics::InterlockedAdd(&SyncCount, (int32)InNumSkippedFrames + 1);
+			SyncEvent->Trigger();
+			return true;
+		}
+
+	private:
+		const FAjaLoopbackDeviceBackend& Backend;
+		AJA::IAJASyncChannelCallbackInterface* CallbackInterface;
+		uint32 TimecodeFramesPerSecond;
+		int32 SyncCount;
+		FEvent* SyncEvent;
+
+		/** Set by Uninitialize before it returns the event to the pool, it waits for the waiters counted by WaitForSync. */
+		volatile int32 bSyncClosed;
+		mutable volatile int32 NumSyncWaiters;
+	};
+
+	/* FCaptureEngine
+	 * Capture every input of a device that runs at the same frame rate from a single thread.
+	 * All the inputs are serviced in one pass at each vertical interrupt, so they receive the same frame.
+	*****************************************************************************/
+	class FInputChannel;
+
+	class FCaptureEngine : private FFrameClockRunnable
+	{
+	public:
+		FCaptureEngine(uint32 InDeviceIndex, uint32 InFrameRateNumerator, uint32 InFrameRateDenominator)
+			: DeviceIndex(InDeviceIndex)
+			, FrameRateNumerator(InFrameRateNumerator)
+			, FrameRateDenominator(InFrameRateDenominator)
+		{}
+
+		virtual ~FCaptureEngine()
+		{
+			StopClock();
+		}
+
+		bool Start(double InEpoch)
+		{
+			const FString ThreadName = FString::Printf(TEXT("AjaLoopbackCaptureEngine%d"), DeviceIndex);
+			return StartClock(*ThreadName, InEpoch, (double)FrameRateDenominator / (double)FrameRateNumerator);
+		}
+
+		bool IsFor(uint32 InDeviceIndex, uint32 InFrameRateNumerator, uint32 InFrameRateDenominator) const
+		{
+			return DeviceIndex == InDeviceIndex && FrameRateNumerator == InFrameRateNumerator && FrameRateDenominator == InFrameRateDenominator;
+		}
+
+		/** The input receives OnInitializationCompleted at the next vertical interrupt and its first frame at the one after. */
+		void AddInput(FInputChannel* InInputChannel)
+		{
+			FInputRef Input = MakeShared<FInput, ESPMode::ThreadSafe>(InInputChannel);
+			FScopeLock Lock(&InputsCriticalSection);
+			Inputs.Add(Input);
+		}
+
+		/** Once this returns, the engine will not call the input anymore. Waits for the call in progress, if any. */
+		void RemoveInput(FInputChannel* InInputChannel)
+		{
+			TSharedPtr<FInput, ESPMode::ThreadSafe> Input;
+			{
+				FScopeLock Lock(&InputsCriticalSection);
+				const int32 Index = Inputs.IndexOfByPredicate([InInputChannel](const FInputRef& Other) { return Other->InputChannel == InInputChannel; });
+				if (Index != INDEX_NONE)
+				{
+					Input = Inputs[Index];
+					Inputs.RemoveAt(Index);
+				}
+			}
+
+			// The engine may have copied the input before it was removed
+			if (Input.IsValid())
+			{
+				FScopeLock InputLock(&Input->CriticalSection);
+				Input->bRemoved = true;
+			}
+		}
+
+		/** Run the function while the input is not being serviced. The other inputs of the device keep running. */
+		void UpdateInput(FInputChannel* InInputChannel, TFunctionRef<void()> InUpdate)
+		{
+			TSharedPtr<FInput, ESPMode::ThreadSafe> Input;
+			{
+				FScopeLock Lock(&InputsCriticalSection);
+				if (const FInputRef* Found = Inputs.FindByPredicate([InInputChannel](const FInputRef& Other) { return Other->InputChannel == InInputChannel; }))
+				{
+					Input = *Found;
+				}
+			}
+
+			if (Input.IsValid())
+			{
+				FScopeLock InputLock(&Input->CriticalSection);
+				InUpdate();
+			}
+			else
+			{
+				InUpdate();
+			}
+		}
+
+	protected:
+		//~ FFrameClockRunnable interface
+		virtual bool OnFrame(uint64 InFrameNumber, uint32 InNumSkippedFrames) override;
+
+	private:
+		/** An input is serviced under its own lock, so a slow input or an update only holds back itself. */
+		struct FInput
+		{
+			FInput(FInputChannel* InInputChannel)
+				: InputChannel(InInputChannel)
+				, bStarted(false)
+				, bRemoved(false)
+			{}
+
+			FInputChannel* InputChannel;
+			bool bStarted;
+			bool bRemoved;
+			FCriticalSection CriticalSection;
+		};
+		typedef TSharedRef<FInput, ESPMode::ThreadSafe> FInputRef;
+
+		uint32 DeviceIndex;
+		uint32 FrameRateNumerator;
+		uint32 FrameRateDenominator;
+
+		TArray<FInputRef> Inputs;
+		FCriticalSection InputsCriticalSection;
+
+		/** Copy of Inputs for the pass in progress, the callbacks are called without the lock of the list. Only used by the engine thread. */
+		TArray<FInputRef> ServicedInputs;
+	};
+
+	/* FInputChannel
+	*****************************************************************************/
+	class FInputChannel : public IAjaInputChannel
+	{
+	public:
+		FInputChannel(FAjaLoopbackDeviceBackend& InBackend)
+			: Backend(InBackend)
+			, Options(TEXT("Loopback"), 1)
+			, Stride(0)
+			, NumAudioChannels(0)
+			, TimecodeFramesPerSecond(30)
+			, FramesDropped(0)
+			, bSignalLost(false)
+		{}
+
+		virtual ~FInputChannel()
+		{
+			Uninitialize();
+		}
+
+		virtual bool Initialize(const AJA::AJADeviceOptions& InDevice, const AJA::AJAInputOutputChannelOptions& InOptions) override
+		{
+			if (!ValidateChannel(Backend, InDevice.DeviceIndex, InOptions.ChannelIndex, TEXT("input")))
+			{
+				return false;
+			}
+			if (InOptions.bOutput || InOptions.CallbackInterface == nullptr)
+			{
+				UE_LOG(LogAjaMedia, Error, TEXT("Loopback: The input channel %d was initialized with invalid options."), InOptions.ChannelIndex);
+				return false;
+			}
+			if (!FindVideoFormat(InOptions.VideoFormatIndex, Descriptor))
+			{
+				UE_LOG(LogAjaMedia, Error, TEXT("Loopback: The video format %d is not supported."), InOptions.VideoFormatIndex);
+				return false;
+			}
+
+			FFormatBuffers Buffers;
+			BuildFormatBuffers(InOptions, Descriptor, Buffers);
+			ApplyFormat(InOptions, Descriptor, Buffers);
+			FramesDropped = 0;
+
+			CaptureEngine = Backend.AcquireCaptureEngine(InDevice.DeviceIndex, Descriptor.FrameRateNumerator, Descriptor.FrameRateDenominator);
+			CaptureEngine->AddInput(this);
+			return true;
+		}
+
+		virtual void Uninitialize() override
+		{
+			if (CaptureEngine.IsValid())
+			{
+				CaptureEngine->RemoveInput(this);
+				CaptureEngine.Reset();
+			}
+		}
+
+		virtual bool Reconfigure(const AJA::AJAInputOutputChannelOptions& InOptions) override
+		{
+			if (!CaptureEngine.IsValid() || InOptions.bOutput || InOptions.CallbackInterface == nullptr || InOptions.ChannelIndex != Options.ChannelIndex)
+			{
+				return false;
+			}
+
+			AJA::AJAVideoFormats::VideoFormatDescriptor NewDescriptor;
+			if (!FindVideoFormat(InOptions.VideoFormatIndex, NewDescriptor))
+			{
+				return false;
+			}
+
+			// The capture engine services every input of the device at a single frame rate
+			if (NewDescriptor.FrameRateNumerator != Descriptor.FrameRateNumerator || NewDescriptor.FrameRateDenominator != Descriptor.FrameRateDenominator)
+			{
+				return false;
+			}
+
+			// Render the new pattern before taking the lock of the input in the engine
+			FFormatBuffers Buffers;
+			BuildFormatBuffers(InOptions, NewDescriptor, Buffers);
+			CaptureEngine->UpdateInput(this, [this, &InOptions, &NewDescriptor, &Buffers]()
+			{
+				ApplyFormat(InOptions, NewDescriptor, Buffers);
+			});
+			return true;
+		}
+
+		virtual bool CanReconfigure() const override
+		{
+			return true;
+		}
+
+		virtual bool IsCallbackThreadShared() const override
+		{
+			// Every input of the device is captured by the thread of the capture engine
+			return true;
+		}
+
+		virtual uint32 GetFrameDropCount() const override
+		{
+			return (uint32)FPlatformAtomics::AtomicRead(&FramesDropped);
+		}
+
+	public:
+		/** Called from the capture engine thread before the first frame. */
+		void OnCaptureStarted()
+		{
+			Options.CallbackInterface->OnInitializationCompleted(true);
+		}
+
+		/** Called from the capture engine thread at every frame boundary. */
+		void CaptureFrame(uint64 InFrameNumber, uint32 InNumSkippedFrames)
+		{
+			// The card stops the input when the signal doesn't match its format. It's switched back by Reconfigure.
+			const int32 SignalFormat = CVarSignalFormat.GetValueOnAnyThread();
+			if (SignalFormat > 0 && (uint32)SignalFormat != Descriptor.VideoFormatIndex)
+			{
+				if (!bSignalLost)
+				{
+					bSignalLost = true;
+					Options.CallbackInterface->OnCompletion(false);
+				}
+				return;
+			}
+
+			if (InNumSkippedFrames > 0)
+			{
+				FPlatformAtomics::InterlockedAdd(&FramesDropped, (int32)InNumSkippedFrames);
+			}
+
+			const bool bIsProgressive = !Descriptor.bIsInterlacedStandard;
+			const uint64 AudioSampleIndex = GetAudioSampleIndex(InFrameNumber, Descriptor.FrameRateNumerator, Descriptor.FrameRateDenominator);
+			const uint32 NumAudioSamples = (uint32)(GetAudioSampleIndex(InFrameNumber + 1, Descriptor.FrameRateNumerator, Descriptor.FrameRateDenominator) - AudioSampleIndex);
+
+			AJA::AJARequestInputBufferData RequestBuffer;
+			RequestBuffer.bIsProgressivePicture = bIsProgressive;
+			RequestBuffer.AncBufferSize = Options.bUseAncillary ? AncBufferSize : 0;
+			RequestBuffer.AncF2BufferSize = Options.bUseAncillary && !bIsProgressive ? AncBufferSize : 0;
+			RequestBuffer.AudioBufferSize = Options.bUseAudio ? NumAudioSamples * NumAudioChannels * sizeof(int32) : 0;
+			RequestBuffer.VideoBufferSize = Options.bUseVideo ? Pattern.Num() : 0;
+
+			AJA::AJARequestedInputBufferData RequestedBuffer;
+			if (!Options.CallbackInterface->OnRequestInputBuffer(RequestBuffer, RequestedBuffer))
+			{
+				return;
+			}
+
+			AJA::AJAInputFrameData InputFrame;
+			InputFrame.FramesDropped = (uint32)FPlatformAtomics::AtomicRead(&FramesDropped);
+			if (Options.TimecodeFormat != AJA::ETimecodeFormat::TCF_None)
+			{
+				// Interlaced timecode counts the fields, the odd field is the next number.
+				InputFrame.Timecode = bIsProgressive ? MakeTimecode(InFrameNumber, TimecodeFramesPerSecond) : MakeTimecode(InFrameNumber * 2, TimecodeFramesPerSecond * 2);
+			}
+
+			AJA::AJAAncillaryFrameData AncillaryFrame;
+			if (Options.bUseAncillary)
+			{
+				AncillaryFrame.AncBuffer = RequestedBuffer.AncBuffer ? RequestedBuffer.AncBuffer : AncBuffer.GetData();
+				AncillaryFrame.AncBufferSize = AncBufferSize;
+				{
+					FAncWriter Writer(AncillaryFrame.AncBuffer, AncillaryFrame.AncBufferSize);
+					WriteAncillaryPackets(Writer, false, 9, InputFrame.Timecode, (uint32)InFrameNumber);
+				}
+
+				if (!bIsProgressive)
+				{
+					// Count the fields like the first one, so the second field rolls over to the next second too
+					AJA::FTimecode TimecodeF2 = InputFrame.Timecode;
+					if (Options.TimecodeFormat != AJA::ETimecodeFormat::TCF_None)
+					{
+						TimecodeF2 = MakeTimecode(InFrameNumber * 2 + 1, TimecodeFramesPerSecond * 2);
+					}
+
+					AncillaryFrame.AncF2Buffer = RequestedBuffer.AncF2Buffer ? RequestedBuffer.AncF2Buffer : AncF2Buffer.GetData();
+					AncillaryFrame.AncF2BufferSize = AncBufferSize;
+					FAncWriter Writer(AncillaryFrame.AncF2Buffer, AncillaryFrame.AncF2BufferSize);
+					WriteAncillaryPackets(Writer, true, 9 + Descriptor.ResolutionHeight / 2 + 8, TimecodeF2, (uint32)InFrameNumber);
+				}
+			}
+
+			AJA::AJAAudioFrameData AudioFrame;
+			if (Options.bUseAudio)
+			{
+				AudioFrame.AudioBuffer = RequestedBuffer.AudioBuffer ? RequestedBuffer.AudioBuffer : AudioBuffer.GetData();
+				AudioFrame.AudioBufferSize = RequestBuffer.AudioBufferSize;
+				AudioFrame.NumChannels = NumAudioChannels;
+				AudioFrame.AudioRate = AudioSampleRate;
+				AudioFrame.NumSamples = NumAudioSamples;
+				WriteAudio(reinterpret_cast<int32*>(AudioFrame.AudioBuffer), AudioSampleIndex, NumAudioSamples);
+			}
+
+			AJA::AJAVideoFrameData VideoFrame;
+			VideoFrame.VideoFormatIndex = Descriptor.VideoFormatIndex;
+			VideoFrame.Stride = Stride;
+			VideoFrame.Width = Descriptor.ResolutionWidth;
+			VideoFrame.Height = Descriptor.ResolutionHeight;
+			VideoFrame.PixelFormat = Options.PixelFormat;
+			VideoFrame.bIsProgressivePicture = bIsProgressive;
+			if (Options.bUseVideo)
+			{
+				VideoFrame.VideoBuffer = RequestedBuffer.VideoBuffer ? RequestedBuffer.VideoBuffer : VideoBuffer.GetData();
+				VideoFrame.VideoBufferSize = Pattern.Num();
+				WriteVideo(VideoFrame.VideoBuffer, InFrameNumber);
+			}
+
+			Options.CallbackInterface->OnInputFrameReceived(InputFrame, AncillaryFrame, AudioFrame, VideoFrame);
+		}
+
+	private:
+		/** The buffers of a format. Built before the format is applied, so the capture engine doesn't wait for them. */
+		struct FFormatBuffers
+		{
+			TArray<uint8> Pattern;
+			TArray<uint8> MovingBoxRow;
+			TArray<uint8> VideoBuffer;
+			TArray<uint8> AncBuffer;
+			TArray<uint8> AncF2Buffer;
+			TArray<uint8> AudioBuffer;
+		};
+
+		static uint32 GetNumAudioChannels(const AJA::AJAInputOutputChannelOptions& InOptions)
+		{
+			return FMath::Clamp<uint32>(InOptions.NumberOfAudioChannel, 1, MaxNumAudioChannels);
+		}
+
+		static uint32 GetMaxAudioBufferSize(const AJA::AJAVideoFormats::VideoFormatDescriptor& InDescriptor, uint32 InNumAudioChannels)
+		{
+			const uint32 MaxNumSamples = (uint32)FMath::DivideAndRoundUp<uint64>((uint64)AudioSampleRate * InDescriptor.FrameRateDenominator, InDescriptor.FrameRateNumerator);
+			return MaxNumSamples * InNumAudioChannels * sizeof(int32);
+		}
+
+		static void BuildFormatBuffers(const AJA::AJAInputOutputChannelOptions& InOptions, const AJA::AJAVideoFormats::VideoFormatDescriptor& InDescriptor, FFormatBuffers& OutBuffers)
+		{
+			const uint32 NewStride = FAja::GetStride(InOptions.PixelFormat, InDescriptor.ResolutionWidth);
+
+			// Render the static part of the frame once. Only the moving box is updated every frame.
+			OutBuffers.Pattern.SetNumZeroed(NewStride * InDescriptor.ResolutionHeight);
+			const uint32 BarWidth = FMath::Max<uint32>(InDescriptor.ResolutionWidth / UE_ARRAY_COUNT(ColorBars), 1);
+			WriteRow(InOptions.PixelFormat, OutBuffers.Pattern.GetData(), InDescriptor.ResolutionWidth, [BarWidth](uint32 X) -> const FPatternColor& { return ColorBars[FMath::Min<uint32>(X / BarWidth, UE_ARRAY_COUNT(ColorBars) - 1)]; });
+			for (uint32 Line = 1; Line < InDescriptor.ResolutionHeight; ++Line)
+			{
+				FMemory::Memcpy(OutBuffers.Pattern.GetData() + Line * NewStride, OutBuffers.Pattern.GetData(), NewStride);
+			}
+			OutBuffers.MovingBoxRow.SetNumZeroed(NewStride);
+
+			if (InOptions.bUseVideo)
+			{
+				OutBuffers.VideoBuffer.SetNumUninitialized(OutBuffers.Pattern.Num());
+			}
+			if (InOptions.bUseAncillary)
+			{
+				OutBuffers.AncBuffer.SetNumZeroed(AncBufferSize);
+				OutBuffers.AncF2Buffer.SetNumZeroed(InDescriptor.bIsInterlacedStandard ? AncBufferSize : 0);
+			}
+			if (InOptions.bUseAudio)
+			{
+				OutBuffers.AudioBuffer.SetNumZeroed(GetMaxAudioBufferSize(InDescriptor, GetNumAudioChannels(InOptions)));
+			}
+		}
+
+		void ApplyFormat(const AJA::AJAInputOutputChannelOptions& InOptions, const AJA::AJAVideoFormats::VideoFormatDescriptor& InDescriptor, FFormatBuffers& InBuffers)
+		{
+			Options = InOptions;
+			Descriptor = InDescriptor;
+			bSignalLost = false;
+			Stride = FAja::GetStride(Options.PixelFormat, Descriptor.ResolutionWidth);
+			NumAudioChannels = GetNumAudioChannels(Options);
+			TimecodeFramesPerSecond = GetTimecodeFramesPerSecond(Descriptor.FrameRateNumerator, Descriptor.FrameRateDenominator);
+
+			Pattern = MoveTemp(InBuffers.Pattern);
+			MovingBoxRow = MoveTemp(InBuffers.MovingBoxRow);
+			VideoBuffer = MoveTemp(InBuffers.VideoBuffer);
+			AncBuffer = MoveTemp(InBuffers.AncBuffer);
+			AncF2Buffer = MoveTemp(InBuffers.AncF2Buffer);
+			AudioBuffer = MoveTemp(InBuffers.AudioBuffer);
+		}
+
+		void WriteVideo(uint8* OutBuffer, uint64 InFrameNumber)
+		{
+			FMemory::Memcpy(OutBuffer, Pattern.GetData(), Pattern.Num());
+
+			// A box moving along the bottom of the frame makes torn or repeated frames visible.
+			const uint32 Width = Descriptor.ResolutionWidth;
+			const uint32 Height = Descriptor.ResolutionHeight;
+			const uint32 BandHeight = FMath::Min(MovingBoxSize, Height);
+			const uint32 BoxX = Width > MovingBoxSize ? (uint32)((InFrameNumber * 8) % (Width - MovingBoxSize)) : 0;
+			WriteRow(Options.PixelFormat, MovingBoxRow.GetData(), Width, [BoxX](uint32 X) -> const FPatternColor& { return (X >= BoxX && X < BoxX + MovingBoxSize) ? ColorWhite : ColorBlack; });
+			for (uint32 Line = Height - BandHeight; Line < Height; ++Line)
+			{
+				FMemory::Memcpy(OutBuffer + Line * Stride, MovingBoxRow.GetData(), Stride);
+			}
+		}
+
+		void WriteAudio(int32* OutBuffer, uint64 InSampleIndex, uint32 InNumSamples) const
+		{
+			// Every channel carries a different harmonic of 1 kHz, to detect channel swaps.
+			const int32* SineTable = GetSineTable();
+			for (uint32 Sample = 0; Sample < InNumSamples; ++Sample)
+			{
+				const uint64 SampleIndex = InSampleIndex + Sample;
+				for (uint32 Channel = 0; Channel < NumAudioChannels; ++Channel)
+				{
+					*OutBuffer++ = SineTable[(SampleIndex * (Channel + 1)) % 48];
+				}
+			}
+		}
+
+	private:
+		FAjaLoopbackDeviceBackend& Backend;
+		TSharedPtr<FCaptureEngine, ESPMode::ThreadSafe> CaptureEngine;
+		AJA::AJAInputOutputChannelOptions Options;
+		AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor;
+		uint32 Stride;
+		uint32 NumAudioChannels;
+		uint32 TimecodeFramesPerSecond;
+		int32 FramesDropped;
+
+		/** Whether the input was stopped because the signal has another format. Only accessed by the capture engine thread and under the lock of the input. */
+		bool bSignalLost;
+
+		TArray<uint8> Pattern;
+		TArray<uint8> MovingBoxRow;
+
+		/** Used when the callback doesn't provide its own buffers. */
+		TArray<uint8> VideoBuffer;
+		TArray<uint8> AncBuffer;
+		TArray<uint8> AncF2Buffer;
+		TArray<uint8> AudioBuffer;
+	};
+
+	/* FCaptureEngine implementation
+	*****************************************************************************/
+	bool FCaptureEngine::OnFrame(uint64 InFrameNumber, uint32 InNumSkippedFrames)
+	{
+		{
+			FScopeLock Lock(&InputsCriticalSection);
+			ServicedInputs.Append(Inputs);
+		}
+
+		for (const FInputRef& Input : ServicedInputs)
+		{
+			FScopeLock InputLock(&Input->CriticalSection);
+			if (Input->bRemoved)
+			{
+				continue;
+			}
+
+			if (Input->bStarted)
+			{
+				Input->InputChannel->CaptureFrame(InFrameNumber, InNumSkippedFrames);
+			}
+			else
+			{
+				Input->InputChannel->OnCaptureStarted();
+				Input->bStarted = true;
+			}
+		}
+
+		// Keep the allocation, release the removed inputs
+		ServicedInputs.Reset();
+		return true;
+	}
+
+	/* FOutputChannel
+	*****************************************************************************/
+	class FOutputChannel : public IAjaOutputChannel, private FFrameClockRunnable
+	{
+	public:
+		FOutputChannel(const FAjaLoopbackDeviceBackend& InBackend)
+			: Backend(InBackend)
+			, Options(TEXT("Loopback"), 1)
+			, bHasPendingVideo(false)
+			, bHasReceivedVideo(false)
+			, FramesDropped(0)
+			, FramesLost(0)
+		{}
+
+		virtual ~FOutputChannel()
+		{
+			Uninitialize();
+		}
+
+		virtual bool Initialize(const AJA::AJADeviceOptions& InDevice, const AJA::AJAInputOutputChannelOptions& InOptions) override
+		{
+			if (!ValidateChannel(Backend, InDevice.DeviceIndex, InOptions.ChannelIndex, TEXT("output")))
+			{
+				return false;
+			}
+			if (!InOptions.bOutput || InOptions.CallbackInterface == nullptr)
+			{
+				UE_LOG(LogAjaMedia, Error, TEXT("Loopback: The output channel %d was initialized with invalid options."), InOptions.ChannelIndex);
+				return false;
+			}
+			if (!FindVideoFormat(InOptions.VideoFormatIndex, Descriptor))
+			{
+				UE_LOG(LogAjaMedia, Error, TEXT("Loopback: The video format %d is not supported."), InOptions.VideoFormatIndex);
+				return false;
+			}
+
+			Options = InOptions;
+			bHasPendingVideo = false;
+			bHasReceivedVideo = false;
+			FramesDropped = 0;
+			FramesLost = 0;
+
+			const uint32 FrameSize = FAja::GetStride(Options.PixelFormat, Descriptor.ResolutionWidth) * Descriptor.ResolutionHeight;
+			PendingVideo.Reserve(FrameSize);
+			CurrentVideo.Reserve(FrameSize);
+
+			return StartClock(TEXT("AjaLoopbackOutputChannel"), Backend.GetEpoch(), (double)Descriptor.FrameRateDenominator / (double)Descriptor.FrameRateNumerator);
+		}
+
+		virtual void Uninitialize() override
+		{
+			StopClock();
+		}
+
+		virtual bool SetAncillaryFrameData(const AJA::AJAOutputFrameBufferData& InFrameData, uint8* InAncillaryBuffer, uint32 InAncillaryBufferSize) override
+		{
+			FScopeLock Lock(&FrameCriticalSection);
+			PendingAncillary.Reset(InAncillaryBufferSize);
+			PendingAncillary.Append(InAncillaryBuffer, InAncillaryBufferSize);
+			return true;
+		}
+
+		virtual bool SetAudioFrameData(const AJA::AJAOutputFrameBufferData& InFrameData, uint8* InAudioBuffer, uint32 InAudioBufferSize) override
+		{
+			FScopeLock Lock(&FrameCriticalSection);
+			PendingAudio.Reset(InAudioBufferSize);
+			PendingAudio.Append(InAudioBuffer, InAudioBufferSize);
+			return true;
+		}
+
+		virtual bool SetVideoFrameData(const AJA::AJAOutputFrameBufferData& InFrameData, uint8* InVideoBuffer, uint32 InVideoBufferSize) override
+		{
+			FScopeLock Lock(&FrameCriticalSection);
+			if (bHasPendingVideo)
+			{
+				// The previous frame was never sent to the device
+				++FramesLost;
+			}
+			PendingVideo.Reset(InVideoBufferSize);
+			PendingVideo.Append(InVideoBuffer, InVideoBufferSize);
+			PendingFrameData = InFrameData;
+			bHasPendingVideo = true;
+			return true;
+		}
+
+		virtual bool GetOutputDimension(uint32& OutWidth, uint32& OutHeight) const override
+		{
+			OutWidth = Descriptor.ResolutionWidth;
+			OutHeight = Descriptor.ResolutionHeight;
+			return Descriptor.bIsValid;
+		}
+
+	protected:
+		//~ FFrameClockRunnable interface
+		virtual bool OnClockStarted() override
+		{
+			Options.CallbackInterface->OnInitializationCompleted(true);
+			return true;
+		}
+
+		virtual bool OnFrame(uint64 InFrameNumber, uint32 InNumSkippedFrames) override
+		{
+			Options.CallbackInterface->OnOutputFrameStarted();
+
+			AJA::AJAOutputFrameData FrameData;
+			{
+				FScopeLock Lock(&FrameCriticalSection);
+				if (bHasPendingVideo)
+				{
+					Swap(PendingVideo, CurrentVideo);
+					CurrentFrameData = PendingFrameData;
+					bHasPendingVideo = false;
+					bHasReceivedVideo = true;
+				}
+				else if (bHasReceivedVideo)
+				{
+					// Nothing new, the previous frame is repeated
+					++FramesDropped;
+				}
+
+				if (bHasReceivedVideo)
+				{
+					FramesDropped += InNumSkippedFrames;
+				}
+
+				FrameData.Timecode = CurrentFrameData.Timecode;
+				FrameData.FramesDropped = FramesDropped;
+				FrameData.FramesLost = FramesLost;
+			}
+
+			Options.CallbackInterface->OnOutputFrameCopied(FrameData);
+			return true;
+		}
+
+	private:
+		const FAjaLoopbackDeviceBackend& Backend;
+		AJA::AJAInputOutputChannelOptions Options;
+		AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor;
+
+		FCriticalSection FrameCriticalSection;
+		AJA::AJAOutputFrameBufferData PendingFrameData;
+		AJA::AJAOutputFrameBufferData CurrentFrameData;
+		TArray<uint8> PendingVideo;
+		TArray<uint8> CurrentVideo;
+		TArray<uint8> PendingAncillary;
+		TArray<uint8> PendingAudio;
+		bool bHasPendingVideo;
+		bool bHasReceivedVideo;
+		uint32 FramesDropped;
+		uint32 FramesLost;
+	};
+
+	/* FAutoDetectChannel
+	*****************************************************************************/
+	class FAutoDetectChannel : public IAjaAutoDetectChannel, private FFrameClockRunnable
+	{
+	public:
+		FAutoDetectChannel(const FAjaLoopbackDeviceBackend& InBackend)
+			: Backend(InBackend)
+			, CallbackInterface(nullptr)
+		{}
+
+		virtual ~FAutoDetectChannel()
+		{
+			Uninitialize();
+		}
+
+		virtual bool Initialize(AJA::IAJAAutoDectectCallbackInterface* InCallbackInterface) override
+		{
+			uint32 SignalFormat = AjaMediaOption::DefaultVideoFormat;
+			if (CVarSignalFormat.GetValueOnAnyThread() > 0)
+			{
+				SignalFormat = (uint32)CVarSignalFormat.GetValueOnAnyThread();
+			}
+			else
+			{
+				FParse::Value(FCommandLine::Get(), TEXT("AjaLoopbackSignal="), SignalFormat);
+			}
+
+			AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor;
+			if (!FindVideoFormat(SignalFormat, Descriptor))
+			{
+				UE_LOG(LogAjaMedia, Warning, TEXT("Loopback: The signal format %d is not supported. Using %d."), SignalFormat, AjaMediaOption::DefaultVideoFormat);
+				SignalFormat = AjaMediaOption::DefaultVideoFormat;
+			}
+
+			CallbackInterface = InCallbackInterface;
+			ChannelData.Reset();
+			for (int32 DeviceIndex = 0; DeviceIndex < Backend.GetNumDevices(); ++DeviceIndex)
+			{
+				for (int32 ChannelIndex = 1; ChannelIndex <= FAjaLoopbackDeviceBackend::NumChannelsPerDevice; ++ChannelIndex)
+				{
+					AJA::AJAAutoDetectChannel::AutoDetectChannelData Data;
+					Data.DetectedVideoFormat = SignalFormat;
+					Data.DeviceIndex = DeviceIndex;
+					Data.ChannelIndex = ChannelIndex;
+					ChannelData.Add(Data);
+				}
+			}
+
+			// Report after a short delay, as the card would.
+			return StartClock(TEXT("AjaLoopbackAutoDetectChannel"), FPlatformTime::Seconds(), 0.1);
+		}
+
+		virtual void Uninitialize() override
+		{
+			StopClock();
+		}
+
+		virtual int32 GetNumOfChannelData() const override
+		{
+			return ChannelData.Num();
+		}
+
+		virtual AJA::AJAAutoDetectChannel::AutoDetectChannelData GetChannelData(int32 InIndex) const override
+		{
+			return ChannelData.IsValidIndex(InIndex) ? ChannelData[InIndex] : AJA::AJAAutoDetectChannel::AutoDetectChannelData();
+		}
+
+	protected:
+		//~ FFrameClockRunnable interface
+		virtual bool OnFrame(uint64 InFrameNumber, uint32 InNumSkippedFrames) override
+		{
+			if (CallbackInterface)
+			{
+				CallbackInterface->OnCompletion(true);
+			}
+			return false;
+		}
+
+	private:
+		const FAjaLoopbackDeviceBackend& Backend;
+		AJA::IAJAAutoDectectCallbackInterface* CallbackInterface;
+		TArray<AJA::AJAAutoDetectChannel::AutoDetectChannelData> ChannelData;
+	};
+}
+
+/* FAjaLoopbackDeviceBackend implementation
+*****************************************************************************/
+FAjaLoopbackDeviceBackend::FAjaLoopbackDeviceBackend()
+	: NumDevices(1)
+	, Epoch(FPlatformTime::Seconds())
+{
+	FParse::Value(FCommandLine::Get(), TEXT("AjaLoopbackDevices="), NumDevices);
+	NumDevices = FMath::Clamp(NumDevices, 1, AjaLoopbackDeviceBackend::MaxNumDevices);
+}
+
+FName FAjaLoopbackDeviceBackend::GetName() const
+{
+	static const FName NAME_Loopback("Loopback");
+	return NAME_Loopback;
+}
+
+TUniquePtr<IAjaDeviceScanner> FAjaLoopbackDeviceBackend::CreateDeviceScanner() const
+{
+	return MakeUnique<AjaLoopbackDeviceBackend::FDeviceScanner>(NumDevices);
+}
+
+TUniquePtr<IAjaVideoFormats> FAjaLoopbackDeviceBackend::CreateVideoFormats(int32 InDeviceIndex) const
+{
+	return MakeUnique<AjaLoopbackDeviceBackend::FVideoFormats>(InDeviceIndex >= 0 && InDeviceIndex < NumDevices);
+}
+
+AJA::AJAVideoFormats::VideoFormatDescriptor FAjaLoopbackDeviceBackend::GetVideoFormat(AJA::FAJAVideoFormat InVideoFormatIndex) const
+{
+	AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor;
+	AjaLoopbackDeviceBackend::FindVideoFormat(InVideoFormatIndex, Descriptor);
+	return Descriptor;
+}
+
+int32 FAjaLoopbackDeviceBackend::GetDeviceNumaNode(int32 InDeviceIndex) const
+{
+	// There is no card, the buffers can live anywhere
+	return INDEX_NONE;
+}
+
+IAjaSyncChannel* FAjaLoopbackDeviceBackend::CreateSyncChannel()
+{
+	return new AjaLoopbackDeviceBackend::FSyncChannel(*this);
+}
+
+IAjaInputChannel* FAjaLoopbackDeviceBackend::CreateInputChannel()
+{
+	return new AjaLoopbackDeviceBackend::FInputChannel(*this);
+}
+
+IAjaOutputChannel* FAjaLoopbackDeviceBackend::CreateOutputChannel()
+{
+	return new AjaLoopbackDeviceBackend::FOutputChannel(*this);
+}
+
+IAjaAutoDetectChannel* FAjaLoopbackDeviceBackend::CreateAutoDetectChannel()
+{
+	return new AjaLoopbackDeviceBackend::FAutoDetectChannel(*this);
+}
+
+TSharedRef<AjaLoopbackDeviceBackend::FCaptureEngine, ESPMode::ThreadSafe> FAjaLoopbackDeviceBackend::AcquireCaptureEngine(uint32 InDeviceIndex, uint32 InFrameRateNumerator, uint32 InFrameRateDenominator)
+{
+	FScopeLock Lock(&CaptureEnginesCriticalSection);
+
+	CaptureEngines.RemoveAll([](const TWeakPtr<AjaLoopbackDeviceBackend::FCaptureEngine, ESPMode::ThreadSafe>& CaptureEngine) { return !CaptureEngine.IsValid(); });
+	for (const TWeakPtr<AjaLoopbackDeviceBackend::FCaptureEngine, ESPMode::ThreadSafe>& WeakCaptureEngine : CaptureEngines)
+	{
+		TSharedPtr<AjaLoopbackDeviceBackend::FCaptureEngine, ESPMode::ThreadSafe> CaptureEngine = WeakCaptureEngine.Pin();
+		if (CaptureEngine.IsValid() && CaptureEngine->IsFor(InDeviceIndex, InFrameRateNumerator, InFrameRateDenominator))
+		{
+			return CaptureEngine.ToSharedRef();
+		}
+	}
+
+	TSharedRef<AjaLoopbackDeviceBackend::FCaptureEngine, ESPMode::ThreadSafe> CaptureEngine = MakeShared<AjaLoopbackDeviceBackend::FCaptureEngine, ESPMode::ThreadSafe>(InDeviceIndex, InFrameRateNumerator, InFrameRateDenominator);
+	if (!CaptureEngine->Start(Epoch))
+	{
+		UE_LOG(LogAjaMedia, Error, TEXT("Loopback: The capture engine of device %d couldn't be started."), InDeviceIndex);
+	}
+	CaptureEngines.Add(CaptureEngine);
+	return CaptureEngine;
+}
+
+#if !AJAMEDIA_DLL_PLATFORM
+
+/* AJA data types
+ * Without the AJA dll, the data types declared in AJALib.h are implemented here.
+*****************************************************************************/
+namespace AJA
+{
+	const uint32_t AJAOutputFrameBufferData::InvalidFrameIdentifier = 0xFFFFFFFF;
+
+	void SetLoggingCallbacks(LoggingCallbackPtr LogInfoFunc, LoggingCallbackPtr LogWarningFunc, LoggingCallbackPtr LogErrorFunc)
+	{
+	}
+
+	FTimecode::FTimecode()
+		: Hours(0)
+		, Minutes(0)
+		, Seconds(0)
+		, Frames(0)
+	{}
+
+	bool FTimecode::operator== (const FTimecode& Other) const
+	{
+		return Hours == Other.Hours && Minutes == Other.Minutes && Seconds == Other.Seconds && Frames == Other.Frames;
+	}
+
+	AJAVideoFormats::VideoFormatDescriptor::VideoFormatDescriptor()
+		: VideoFormatIndex(0)
+		, FrameRateNumerator(0)
+		, FrameRateDenominator(0)
+		, ResolutionWidth(0)
+		, ResolutionHeight(0)
+		, bIsProgressiveStandard(false)
+		, bIsInterlacedStandard(false)
+		, bIsPsfStandard(false)
+		, bIsVideoFormatA(false)
+		, bIsVideoFormatB(false)
+		, bIs372DualLink(false)
+		, bIsSD(false)
+		, bIsHD(false)
+		, bIs2K(false)
+		, bIs4K(false)
+		, bIsValid(false)
+	{}
+
+	IAJASyncChannelCallbackInterface::IAJASyncChannelCallbackInterface() {}
+	IAJASyncChannelCallbackInterface::~IAJASyncChannelCallbackInterface() {}
+
+	AJASyncChannelOptions::AJASyncChannelOptions(const TCHAR* DebugName)
+		: CallbackInterface(nullptr)
+		, TransportType(ETransportType::TT_SdiSingle)
+		, ChannelIndex(1)
+		, VideoFormatIndex(0)
+		, TimecodeFormat(ETimecodeFormat::TCF_None)
+		, bOutput(false)
+		, bWaitForFrameToBeReady(false)
+		, bReadTimecodeFromReferenceIn(false)
+		, LTCSourceIndex(1)
+		, LTCFrameRateNumerator(30)
+		, LTCFrameRateDenominator(1)
+	{}
+
+	AJAInputFrameData::AJAInputFrameData()
+		: FramesDropped(0)
+	{}
+
+	AJAOutputFrameData::AJAOutputFrameData()
+		: FramesLost(0)
+	{}
+
+	AJAAncillaryFrameData::AJAAncillaryFrameData()
+		: AncBuffer(nullptr)
+		, AncBufferSize(0)
+		, AncF2Buffer(nullptr)
+		, AncF2BufferSize(0)
+	{}
+
+	AJAAudioFrameData::AJAAudioFrameData()
+		: AudioBuffer(nullptr)
+		, AudioBufferSize(0)
+		, NumChannels(0)
+		, AudioRate(0)
+		, NumSamples(0)
+	{}
+
+	AJAVideoFrameData::AJAVideoFrameData()
+		: VideoFormatIndex(0)
+		, VideoBuffer(nullptr)
+		, VideoBufferSize(0)
+		, Stride(0)
+		, Width(0)
+		, Height(0)
+		, PixelFormat(EPixelFormat::PF_8BIT_YCBCR)
+		, bIsProgressivePicture(true)
+	{}
+
+	AJARequestInputBufferData::AJARequestInputBufferData()
+		: bIsProgressivePicture(true)
+		, AncBufferSize(0)
+		, AncF2BufferSize(0)
+		, AudioBufferSize(0)
+		, VideoBufferSize(0)
+	{}
+
+	AJARequestedInputBufferData::AJARequestedInputBufferData()
+		: AncBuffer(nullptr)
+		, AncF2Buffer(nullptr)
+		, AudioBuffer(nullptr)
+		, VideoBuffer(nullptr)
+	{}
+
+	IAJAInputOutputChannelCallbackInterface::IAJAInputOutputChannelCallbackInterface() {}
+
+	AJAInputOutputChannelOptions::AJAInputOutputChannelOptions(const TCHAR* DebugName, uint32_t InChannelIndex)
+		: CallbackInterface(nullptr)
+		, NumberOfAudioChannel(8)
+		, TransportType(ETransportType::TT_SdiSingle)
+		, ChannelIndex(InChannelIndex)
+		, SynchronizeChannelIndex(InChannelIndex)
+		, KeyChannelIndex(InChannelIndex + 1)
+		, OutputNumberOfBuffers(2)
+		, VideoFormatIndex(0)
+		, PixelFormat(EPixelFormat::PF_8BIT_YCBCR)
+		, TimecodeFormat(ETimecodeFormat::TCF_None)
+		, OutputReferenceType(EAJAReferenceType::EAJA_REFERENCETYPE_FREERUN)
+		, BurnTimecodePercentY(80)
+	{
+		Options = 0;
+		bConvertOutputLevelAToB = 0;
+		bUseVideo = 1;
+	}
+
+	AJAOutputFrameBufferData::AJAOutputFrameBufferData()
+		: FrameIdentifier(InvalidFrameIdentifier)
+	{}
+
+	IAJAAutoDectectCallbackInterface::IAJAAutoDectectCallbackInterface() {}
+	IAJAAutoDectectCallbackInterface::~IAJAAutoDectectCallbackInterface() {}
+
+	AJAAutoDetectChannel::AutoDetectChannelData::AutoDetectChannelData()
+		: DetectedVideoFormat(0)
+		, DeviceIndex(0)
+		, ChannelIndex(0)
+	{}
+}
+
+#endif // !AJAMEDIA_DLL_PLATFORM
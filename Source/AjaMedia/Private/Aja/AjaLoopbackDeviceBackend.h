@@ -0,0 +1,61 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IAjaDeviceBackend.h"
+
+#include "HAL/CriticalSection.h"
+
+namespace AjaLoopbackDeviceBackend
+{
+	class FCaptureEngine;
+}
+
+/**
+ * Software device backend used to exercise the capture and playout paths without an AJA card.
+ * Selected by launching with -AjaLoopback. The number of simulated devices is set with -AjaLoopbackDevices=N.
+ *
+ * Every simulated device exposes 8 SDI inputs and 8 SDI outputs. Inputs generate colour bars, timecode,
+ * ancillary packets and audio at the cadence of the requested video format. Outputs consume the submitted
+ * frames at the same cadence. All the channels are ticked from the backend epoch, so they stay phase-aligned.
+ * The inputs of a device that share a frame rate are serviced by a single capture engine thread.
+ */
+class FAjaLoopbackDeviceBackend : public IAjaDeviceBackend
+{
+public:
+	FAjaLoopbackDeviceBackend();
+
+	//~ IAjaDeviceBackend interface
+	virtual FName GetName() const override;
+	virtual TUniquePtr<IAjaDeviceScanner> CreateDeviceScanner() const override;
+	virtual TUniquePtr<IAjaVideoFormats> CreateVideoFormats(int32 InDeviceIndex) const override;
+	virtual AJA::AJAVideoFormats::VideoFormatDescriptor GetVideoFormat(AJA::FAJAVideoFormat InVideoFormatIndex) const override;
+	virtual int32 GetDeviceNumaNode(int32 InDeviceIndex) const override;
+	virtual IAjaSyncChannel* CreateSyncChannel() override;
+	virtual IAjaInputChannel* CreateInputChannel() override;
+	virtual IAjaOutputChannel* CreateOutputChannel() override;
+	virtual IAjaAutoDetectChannel* CreateAutoDetectChannel() override;
+
+public:
+	int32 GetNumDevices() const { return NumDevices; }
+
+	/** Time, in FPlatformTime::Seconds, of the first vertical interrupt of every channel. */
+	double GetEpoch() const { return Epoch; }
+
+	/** Number of SDI inputs and outputs of every simulated device. */
+	static const int32 NumChannelsPerDevice = 8;
+
+	/**
+	 * Get the engine that captures every input of a device running at the given frame rate.
+	 * The engine is created with its first input and stops with its last one.
+	 */
+	TSharedRef<AjaLoopbackDeviceBackend::FCaptureEngine, ESPMode::ThreadSafe> AcquireCaptureEngine(uint32 InDeviceIndex, uint32 InFrameRateNumerator, uint32 InFrameRateDenominator);
+
+private:
+	int32 NumDevices;
+	double Epoch;
+
+	/** Running capture engines. The inputs hold the references. */
+	TArray<TWeakPtr<AjaLoopbackDeviceBackend::FCaptureEngine, ESPMode::ThreadSafe>> CaptureEngines;
+	FCriticalSection CaptureEnginesCriticalSection;
+};
@@ -0,0 +1,198 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaSdkDeviceBackend.h"
+
+#if AJAMEDIA_DLL_PLATFORM
+
+#include "AjaMediaPrivate.h"
+
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <setupapi.h>
+#include <initguid.h>
+#include <devpkey.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+
+namespace AjaSdkDeviceBackend
+{
+	/* FDeviceScanner
+	*****************************************************************************/
+	class FDeviceScanner : public IAjaDeviceScanner
+	{
+	public:
+		virtual int32 GetNumDevices() const override { return Scanner.GetNumDevices(); }
+		virtual bool GetDeviceTextId(int32 InDeviceIndex, AJA::AJADeviceScanner::FormatedTextType& OutTextId) const override { return Scanner.GetDeviceTextId(InDeviceIndex, OutTextId); }
+		virtual bool GetDeviceInfo(int32 InDeviceIndex, AJA::AJADeviceScanner::DeviceInfo& OutDeviceInfo) const override { return Scanner.GetDeviceInfo(InDeviceIndex, OutDeviceInfo); }
+
+	private:
+		AJA::AJADeviceScanner Scanner;
+	};
+
+	/* FVideoFormats
+	*****************************************************************************/
+	class FVideoFormats : public IAjaVideoFormats
+	{
+	public:
+		FVideoFormats(int32 InDeviceIndex) : Formats(InDeviceIndex) {}
+
+		virtual int32 GetNumSupportedFormat() const override { return Formats.GetNumSupportedFormat(); }
+		virtual AJA::AJAVideoFormats::VideoFormatDescriptor GetSupportedFormat(int32 InIndex) const override { return Formats.GetSupportedFormat(InIndex); }
+
+	private:
+		AJA::AJAVideoFormats Formats;
+	};
+
+	/* FSyncChannel
+	*****************************************************************************/
+	class FSyncChannel : public IAjaSyncChannel
+	{
+	public:
+		virtual bool Initialize(const AJA::AJADeviceOptions& InDevice, const AJA::AJASyncChannelOptions& InOptions) override { return Channel.Initialize(InDevice, InOptions); }
+		virtual void Uninitialize() override { Channel.Uninitialize(); }
+		virtual bool WaitForSync() const override { return Channel.WaitForSync(); }
+		virtual bool GetTimecode(AJA::FTimecode& OutTimecode) const override { return Channel.GetTimecode(OutTimecode); }
+		virtual bool GetSyncCount(uint32& OutCount) const override { return Channel.GetSyncCount(OutCount); }
+
+	private:
+		AJA::AJASyncChannel Channel;
+	};
+
+	/* FInputChannel
+	*****************************************************************************/
+	class FInputChannel : public IAjaInputChannel
+	{
+	public:
+		virtual bool Initialize(const AJA::AJADeviceOptions& InDevice, const AJA::AJAInputOutputChannelOptions& InOptions) override { return Channel.Initialize(InDevice, InOptions); }
+		virtual void Uninitialize() override { Channel.Uninitialize(); }
+		// The SDK channel only takes its options when it is initialized
+		virtual bool Reconfigure(const AJA::AJAInputOutputChannelOptions& InOptions) override { return false; }
+		virtual bool CanReconfigure() const override { return false; }
+		virtual bool IsCallbackThreadShared() const override { return false; }
+		virtual uint32 GetFrameDropCount() const override { return Channel.GetFrameDropCount(); }
+
+	private:
+		AJA::AJAInputChannel Channel;
+	};
+
+	/* FOutputChannel
+	*****************************************************************************/
+	class FOutputChannel : public IAjaOutputChannel
+	{
+	public:
+		virtual bool Initialize(const AJA::AJADeviceOptions& InDevice, const AJA::AJAInputOutputChannelOptions& InOptions) override { return Channel.Initialize(InDevice, InOptions); }
+		virtual void Uninitialize() override { Channel.Uninitialize(); }
+		virtual bool SetAncillaryFrameData(const AJA::AJAOutputFrameBufferData& InFrameData, uint8* InAncillaryBuffer, uint32 InAncillaryBufferSize) override { return Channel.SetAncillaryFrameData(InFrameData, InAncillaryBuffer, InAncillaryBufferSize); }
+		virtual bool SetAudioFrameData(const AJA::AJAOutputFrameBufferData& InFrameData, uint8* InAudioBuffer, uint32 InAudioBufferSize) override { return Channel.SetAudioFrameData(InFrameData, InAudioBuffer, InAudioBufferSize); }
+		virtual bool SetVideoFrameData(const AJA::AJAOutputFrameBufferData& InFrameData, uint8* InVideoBuffer, uint32 InVideoBufferSize) override { return Channel.SetVideoFrameData(InFrameData, InVideoBuffer, InVideoBufferSize); }
+		virtual bool GetOutputDimension(uint32& OutWidth, uint32& OutHeight) const override { return Channel.GetOutputDimension(OutWidth, OutHeight); }
+
+	private:
+		AJA::AJAOutputChannel Channel;
+	};
+
+	/* FAutoDetectChannel
+	*****************************************************************************/
+	class FAutoDetectChannel : public IAjaAutoDetectChannel
+	{
+	public:
+		virtual bool Initialize(AJA::IAJAAutoDectectCallbackInterface* InCallbackInterface) override { return Channel.Initialize(InCallbackInterface); }
+		virtual void Uninitialize() override { Channel.Uninitialize(); }
+		virtual int32 GetNumOfChannelData() const override { return Channel.GetNumOfChannelData(); }
+		virtual AJA::AJAAutoDetectChannel::AutoDetectChannelData GetChannelData(int32 InIndex) const override { return Channel.GetChannelData(InIndex); }
+
+	private:
+		AJA::AJAAutoDetectChannel Channel;
+	};
+}
+
+/* FAjaSdkDeviceBackend implementation
+*****************************************************************************/
+FName FAjaSdkDeviceBackend::GetName() const
+{
+	static const FName NAME_Sdk("SDK");
+	return NAME_Sdk;
+}
+
+TUniquePtr<IAjaDeviceScanner> FAjaSdkDeviceBackend::CreateDeviceScanner() const
+{
+	return MakeUnique<AjaSdkDeviceBackend::FDeviceScanner>();
+}
+
+TUniquePtr<IAjaVideoFormats> FAjaSdkDeviceBackend::CreateVideoFormats(int32 InDeviceIndex) const
+{
+	return MakeUnique<AjaSdkDeviceBackend::FVideoFormats>(InDeviceIndex);
+}
+
+AJA::AJAVideoFormats::VideoFormatDescriptor FAjaSdkDeviceBackend::GetVideoFormat(AJA::FAJAVideoFormat InVideoFormatIndex) const
+{
+	return AJA::AJAVideoFormats::GetVideoFormat(InVideoFormatIndex);
+}
+
+int32 FAjaSdkDeviceBackend::GetDeviceNumaNode(int32 InDeviceIndex) const
+{
+	// The SDK doesn't report the PCIe bus and slot of a device, and its device indices don't follow the PnP enumeration order.
+	// The node is only known when every AJA function (vendor 0xF1D0) is on the same node, whatever the device.
+	HDEVINFO DeviceInfoSet = ::SetupDiGetClassDevsW(nullptr, L"PCI", nullptr, DIGCF_PRESENT | DIGCF_ALLCLASSES);
+	if (DeviceInfoSet == INVALID_HANDLE_VALUE)
+	{
+		return INDEX_NONE;
+	}
+
+	int32 NumaNode = INDEX_NONE;
+	int32 NumAjaDevices = 0;
+	SP_DEVINFO_DATA DeviceInfoData;
+	DeviceInfoData.cbSize = sizeof(SP_DEVINFO_DATA);
+	for (DWORD Index = 0; ::SetupDiEnumDeviceInfo(DeviceInfoSet, Index, &DeviceInfoData); ++Index)
+	{
+		WCHAR HardwareId[512];
+		if (!::SetupDiGetDeviceRegistryPropertyW(DeviceInfoSet, &DeviceInfoData, SPDRP_HARDWAREID, nullptr, reinterpret_cast<PBYTE>(HardwareId), sizeof(HardwareId), nullptr))
+		{
+			continue;
+		}
+		if (FCString::Strnicmp(HardwareId, TEXT("PCI\\VEN_F1D0"), 12) != 0)
+		{
+			continue;
+		}
+
+		DEVPROPTYPE PropertyType = DEVPROP_TYPE_EMPTY;
+		INT32 DeviceNumaNode = -1;
+		if (!::SetupDiGetDevicePropertyW(DeviceInfoSet, &DeviceInfoData, &DEVPKEY_Device_Numa_Node, &PropertyType, reinterpret_cast<PBYTE>(&DeviceNumaNode), sizeof(DeviceNumaNode), nullptr, 0) || DeviceNumaNode < 0
+			|| (NumAjaDevices > 0 && DeviceNumaNode != NumaNode))
+		{
+			NumaNode = INDEX_NONE;
+			break;
+		}
+
+		NumaNode = DeviceNumaNode;
+		++NumAjaDevices;
+	}
+
+	::SetupDiDestroyDeviceInfoList(DeviceInfoSet);
+
+	if (NumaNode == INDEX_NONE && NumAjaDevices > 0)
+	{
+		UE_LOG(LogAjaMedia, Verbose, TEXT("The NUMA node of the AJA device %d is unknown. The AJA devices are on different nodes, or a node is not reported."), InDeviceIndex);
+	}
+	return NumaNode;
+}
+
+IAjaSyncChannel* FAjaSdkDeviceBackend::CreateSyncChannel()
+{
+	return new AjaSdkDeviceBackend::FSyncChannel();
+}
+
+IAjaInputChannel* FAjaSdkDeviceBackend::CreateInputChannel()
+{
+	return new AjaSdkDeviceBackend::FInputChannel();
+}
+
+IAjaOutputChannel* FAjaSdkDeviceBackend::CreateOutputChannel()
+{
+	return new AjaSdkDeviceBackend::FOutputChannel();
+}
+
+IAjaAutoDetectChannel* FAjaSdkDeviceBackend::CreateAutoDetectChannel()
+{
+	return new AjaSdkDeviceBackend::FAutoDetectChannel();
+}
+
+#endif // AJAMEDIA_DLL_PLATFORM
@@ -0,0 +1,27 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IAjaDeviceBackend.h"
+
+#if AJAMEDIA_DLL_PLATFORM
+
+/**
+ * Device backend that forwards every call to the AJA SDK (AJA.dll).
+ */
+class FAjaSdkDeviceBackend : public IAjaDeviceBackend
+{
+public:
+	//~ IAjaDeviceBackend interface
+	virtual FName GetName() const override;
+	virtual TUniquePtr<IAjaDeviceScanner> CreateDeviceScanner() const override;
+	virtual TUniquePtr<IAjaVideoFormats> CreateVideoFormats(int32 InDeviceIndex) const override;
+	virtual AJA::AJAVideoFormats::VideoFormatDescriptor GetVideoFormat(AJA::FAJAVideoFormat InVideoFormatIndex) const override;
+	virtual int32 GetDeviceNumaNode(int32 InDeviceIndex) const override;
+	virtual IAjaSyncChannel* CreateSyncChannel() override;
+	virtual IAjaInputChannel* CreateInputChannel() override;
+	virtual IAjaOutputChannel* CreateOutputChannel() override;
+	virtual IAjaAutoDetectChannel* CreateAutoDetectChannel() override;
+};
+
+#endif // AJAMEDIA_DLL_PLATFORM
@@ -0,0 +1,258 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaSyncWatcher.h"
+
+#include "AjaMediaPrivate.h"
+#include "IAjaDeviceBackend.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformAtomics.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+#include "Stats/Stats2.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AJA Timecode latched reads"), STAT_AJA_SyncWatcher_LatchedReads, STATGROUP_Media);
+
+namespace AjaSyncWatcher
+{
+	/** Number of periods measured before the estimate is used. */
+	static const int32 MinNumMeasures = 8;
+
+	/** Weight of a new measure in the period. The period of a genlocked signal only drifts slowly. */
+	static const double PeriodSmoothing = 0.05;
+
+	/** How much of a late sync moves the phase. */
+	static const double PhaseCorrection = 0.1;
+
+	/** Measures further than that from the nominal period are rejected. */
+	static const double MaxPeriodError = 0.2;
+
+	/** Number of periods WaitForSync waits before giving up, like the card does. */
+	static const double NumPeriodsBeforeTimeout = 4.0;
+
+	/** Part of the period around a predicted sync where the latched timecode may be the one of either frame. */
+	static const double TimecodeUncertainty = 0.05;
+}
+
+/* FAjaSyncWatcher implementation
+*****************************************************************************/
+FAjaSyncWatcher::FAjaSyncWatcher(IAjaSyncChannel* InSyncChannel, double InNominalPeriod, bool bInLatchTimecode)
+	: SyncChannel(InSyncChannel)
+	, NominalPeriod(InNominalPeriod)
+	, bLatchTimecode(bInLatchTimecode)
+	, bStopping(false)
+	, bFailed(false)
+	, SyncEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	, Thread(nullptr)
+	, NumMeasures(0)
+	, TimecodeSequence(0)
+	, LatchedSyncCount(0)
+{
+	check(SyncChannel);
+	check(NominalPeriod > 0.0);
+	Thread = FRunnableThread::Create(this, TEXT("AjaSyncWatcher"), 0, TPri_TimeCritical);
+}
+
+FAjaSyncWatcher::~FAjaSyncWatcher()
+{
+	Stop();
+	FPlatformProcess::ReturnSynchEventToPool(SyncEvent);
+	SyncEvent = nullptr;
+}
+
+void FAjaSyncWatcher::Stop()
+{
+	if (Thread)
+	{
+		FPlatformAtomics::InterlockedExchange(&bStopping, true);
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+}
+
+bool FAjaSyncWatcher::GetEstimate(FEstimate& OutEstimate) const
+{
+	FScopeLock Lock(&EstimateCriticalSection);
+	OutEstimate = Estimate;
+	return NumMeasures >= AjaSyncWatcher::MinNumMeasures;
+}
+
+bool FAjaSyncWatcher::GetLatchedTimecode(AJA::FTimecode& OutTimecode, uint32& OutSyncCount) const
+{
+	if (HasFailed())
+	{
+		return false;
+	}
+
+	for (;;)
+	{
+		const int32 Sequence = FPlatformAtomics::AtomicRead(&TimecodeSequence);
+		if (Sequence == 0)
+		{
+			return false;
+		}
+		if (Sequence & 1)
+		{
+			FPlatformProcess::YieldThread();
+			continue;
+		}
+
+		OutTimecode = LatchedTimecode;
+		OutSyncCount = LatchedSyncCount;
+		FPlatformMisc::MemoryBarrier();
+
+		if (FPlatformAtomics::AtomicRead(&TimecodeSequence) == Sequence)
+		{
+			return true;
+		}
+	}
+}
+
+bool FAjaSyncWatcher::GetCurrentTimecode(AJA::FTimecode& OutTimecode) const
+{
+	AJA::FTimecode Timecode;
+	uint32 LatchedCount = 0;
+	if (!GetLatchedTimecode(Timecode, LatchedCount))
+	{
+		return false;
+	}
+
+	FEstimate CurrentEstimate;
+	if (!GetEstimate(CurrentEstimate))
+	{
+		return false;
+	}
+
+	const double Position = (FPlatformTime::Seconds() - CurrentEstimate.SyncTime) / CurrentEstimate.Period;
+	const double Phase = Position - FMath::FloorToDouble(Position);
+	if (Phase < AjaSyncWatcher::TimecodeUncertainty || Phase > 1.0 - AjaSyncWatcher::TimecodeUncertainty)
+	{
+		return false;
+	}
+
+	// Behind when the sync came but the watcher didn't latch it yet, or when the read of the timecode failed
+	const uint32 CurrentSyncCount = CurrentEstimate.SyncCount + (int32)FMath::FloorToDouble(Position);
+	if (CurrentSyncCount != LatchedCount)
+	{
+		return false;
+	}
+
+	OutTimecode = Timecode;
+	return true;
+}
+
+bool FAjaSyncWatcher::WaitForSync()
+{
+	const uint32 TimeoutMs = (uint32)(NominalPeriod * AjaSyncWatcher::NumPeriodsBeforeTimeout * 1000.0) + 1;
+	return SyncEvent->Wait(TimeoutMs) && !HasFailed();
+}
+
+void FAjaSyncWatcher::SleepUntil(double InTime)
+{
+	for (double Remaining = InTime - FPlatformTime::Seconds(); Remaining > 0.0; Remaining = InTime - FPlatformTime::Seconds())
+	{
+		if (Remaining > 0.002)
+		{
+			FPlatformProcess::SleepNoStats((float)(Remaining - 0.001));
+		}
+		else
+		{
+			FPlatformProcess::YieldThread();
+		}
+	}
+}
+
+uint32 FAjaSyncWatcher::Run()
+{
+	while (!bStopping)
+	{
+		const bool bWaitIsValid = SyncChannel->WaitForSync();
+		const double SyncTime = FPlatformTime::Seconds();
+		if (bStopping)
+		{
+			break;
+		}
+
+		if (!bWaitIsValid)
+		{
+			// The channel may still be initializing. It only failed once it sent a sync.
+			if (Estimate.Period <= 0.0)
+			{
+				FPlatformProcess::SleepNoStats((float)NominalPeriod);
+				continue;
+			}
+
+			FPlatformAtomics::InterlockedExchange(&bFailed, true);
+			SyncEvent->Trigger();
+			break;
+		}
+
+		// Only this thread writes the estimate
+		uint32 SyncCount = 0;
+		if (!SyncChannel->GetSyncCount(SyncCount))
+		{
+			SyncCount = Estimate.SyncCount + 1;
+		}
+
+		OnSync(SyncTime, SyncCount);
+		if (bLatchTimecode)
+		{
+			LatchTimecode(SyncCount);
+		}
+		SyncEvent->Trigger();
+	}
+
+	return 0;
+}
+
+void FAjaSyncWatcher::OnSync(double InTime, uint32 InSyncCount)
+{
+	FScopeLock Lock(&EstimateCriticalSection);
+
+	if (Estimate.Period <= 0.0)
+	{
+		Estimate.SyncTime = InTime;
+		Estimate.SyncCount = InSyncCount;
+		Estimate.Period = NominalPeriod;
+		return;
+	}
+
+	const int32 NumElapsedSyncs = (int32)(InSyncCount - Estimate.SyncCount);
+	if (NumElapsedSyncs <= 0)
+	{
+		return;
+	}
+
+	const double MeasuredPeriod = (InTime - Estimate.SyncTime) / NumElapsedSyncs;
+	if (FMath::Abs(MeasuredPeriod - NominalPeriod) <= NominalPeriod * AjaSyncWatcher::MaxPeriodError)
+	{
+		Estimate.Period += (MeasuredPeriod - Estimate.Period) * AjaSyncWatcher::PeriodSmoothing;
+		++NumMeasures;
+	}
+
+	// The thread can only wake up after the sync. An early wake up is the sync itself, a late one is mostly the latency of the scheduler.
+	const double PredictedTime = Estimate.GetSyncTime(InSyncCount);
+	Estimate.SyncTime = InTime < PredictedTime ? InTime : PredictedTime + (InTime - PredictedTime) * AjaSyncWatcher::PhaseCorrection;
+	Estimate.SyncCount = InSyncCount;
+}
+
+void FAjaSyncWatcher::LatchTimecode(uint32 InSyncCount)
+{
+	AJA::FTimecode Timecode;
+	if (!SyncChannel->GetTimecode(Timecode))
+	{
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_AJA_SyncWatcher_LatchedReads);
+
+	// Only this thread writes, the sequence is odd while the timecode is not consistent
+	FPlatformAtomics::InterlockedIncrement(&TimecodeSequence);
+	LatchedTimecode = Timecode;
+	LatchedSyncCount = InSyncCount;
+	FPlatformAtomics::InterlockedIncrement(&TimecodeSequence);
+}
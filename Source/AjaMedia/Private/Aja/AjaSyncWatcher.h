@@ -0,0 +1,118 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AJALib.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+
+class FEvent;
+class FRunnableThread;
+class IAjaSyncChannel;
+
+/**
+ * Waits for the syncs of a channel on its own thread, and measures their period and phase.
+ *
+ * The game thread doesn't need to block on the interrupt anymore. It can predict the time of the next sync and wake up before it.
+ * Every real sync corrects the drift of the prediction.
+ * The watcher can also latch the timecode at every sync, so it can be read without going through the driver.
+ * Once the watcher is started, only its thread calls WaitForSync and GetSyncCount on the channel.
+ */
+class FAjaSyncWatcher
+	: private FRunnable
+{
+public:
+
+	/** The last sync seen by the watcher, and the measured period. */
+	struct FEstimate
+	{
+		FEstimate()
+			: SyncTime(0.0)
+			, SyncCount(0)
+			, Period(0.0)
+		{ }
+
+		double SyncTime;
+		uint32 SyncCount;
+		double Period;
+
+		/** @return the predicted time of a sync. */
+		double GetSyncTime(uint32 InSyncCount) const { return SyncTime + (int32)(InSyncCount - SyncCount) * Period; }
+
+		/** @return the count of the last sync before that time. */
+		uint32 GetSyncCount(double InTime) const { return SyncCount + (int32)FMath::FloorToDouble((InTime - SyncTime) / Period); }
+	};
+
+	/**
+	 * Start the watcher thread. The channel must be initialized, or initializing, and must outlive the watcher.
+	 * @param InNominalPeriod The period of the sync at the frame rate of the channel, in seconds. The measures too far from it are rejected.
+	 * @param bInLatchTimecode Read the timecode of the channel once per sync.
+	 */
+	FAjaSyncWatcher(IAjaSyncChannel* InSyncChannel, double InNominalPeriod, bool bInLatchTimecode = false);
+	virtual ~FAjaSyncWatcher();
+
+	/** Stop the thread. Waits for the sync the thread is waiting for. */
+	void Stop();
+
+	/** @return true once the period was measured over enough syncs. */
+	bool GetEstimate(FEstimate& OutEstimate) const;
+
+	/** Block until the next sync seen by the watcher. @return false if it didn't come. */
+	bool WaitForSync();
+
+	/**
+	 * Read the timecode latched at the last sync. Lock-free, can be called from any thread.
+	 * @return false if no timecode was latched yet, or if the channel stopped sending syncs.
+	 */
+	bool GetLatchedTimecode(AJA::FTimecode& OutTimecode, uint32& OutSyncCount) const;
+
+	/**
+	 * Read the timecode of the current frame, if the latched one is known to be it.
+	 * The sync count of the latched timecode is checked against the sync count predicted for now. The timecode is stale between
+	 * a sync and its latch, and the prediction can't tell near a sync.
+	 * @return false if the caller must read the timecode from the driver.
+	 */
+	bool GetCurrentTimecode(AJA::FTimecode& OutTimecode) const;
+
+	/** @return true if the channel stopped sending syncs. */
+	bool HasFailed() const { return FPlatformAtomics::AtomicRead(&bFailed) != 0; }
+
+	/** Sleep until a time, with a better precision than the scheduler. Most of the time is slept and the end is spun. */
+	static void SleepUntil(double InTime);
+
+private:
+
+	//~ FRunnable interface
+	virtual uint32 Run() override;
+
+	void OnSync(double InTime, uint32 InSyncCount);
+	void LatchTimecode(uint32 InSyncCount);
+
+private:
+
+	IAjaSyncChannel* SyncChannel;
+	const double NominalPeriod;
+	const bool bLatchTimecode;
+
+	volatile int32 bStopping;
+	volatile int32 bFailed;
+
+	/** Triggered at every sync, for WaitForSync */
+	FEvent* SyncEvent;
+	FRunnableThread* Thread;
+
+	/** Guards the estimate. Written once per sync. */
+	mutable FCriticalSection EstimateCriticalSection;
+	FEstimate Estimate;
+	int32 NumMeasures;
+
+	/**
+	 * Sequence lock of the latched timecode. Odd while the watcher writes it, 0 until the first latch.
+	 * The readers copy the timecode and try again if the sequence changed meanwhile.
+	 */
+	volatile int32 TimecodeSequence;
+	AJA::FTimecode LatchedTimecode;
+	uint32 LatchedSyncCount;
+};
@@ -3,7 +3,10 @@
 #include "IAjaMediaModule.h"
 
 #include "Aja/Aja.h"
+#include "Aja/AjaDeviceMonitor.h"
+#include "AjaDeviceCatalog.h"
 #include "AjaDeviceProvider.h"
+#include "AjaMediaLog.h"
 #include "AJALib.h"
 #include "Player/AjaMediaPlayer.h"
 
@@ -22,6 +25,10 @@ class FAjaMediaModule : public IAjaMediaModule
 {
 public:
 
+	FAjaMediaModule()
+		: DeviceMonitor(nullptr)
+	{ }
+
 	//~ IAjaMediaModule interface
 	virtual TSharedPtr<IMediaPlayer, ESPMode::ThreadSafe> CreatePlayer(IMediaEventSink& EventSink) override
 	{
@@ -37,11 +44,16 @@ public:
 
 	virtual bool CanBeUsed() const override { return FAja::CanUseAJACard(); }
 
+	virtual IAjaDeviceBackend* GetDeviceBackend() const override { return FAja::GetDeviceBackend(); }
+
 public:
 
 	//~ IModuleInterface interface
 	virtual void StartupModule() override
 	{
+		// Log the messages of the AJA threads from a background thread
+		FAjaMediaLog::Startup();
+
 		// initialize AJA
 		if (!FAja::Initialize())
 		{
@@ -49,6 +61,12 @@ public:
 			return;
 		}
 
+		// Scan the devices once, the provider queries are answered from the catalog
+		FAjaDeviceCatalog::Get();
+
+		// Rescan from a background thread when a device is plugged or removed
+		DeviceMonitor = new FAjaDeviceMonitor();
+
 		IMediaIOCoreModule::Get().RegisterDeviceProvider(&DeviceProvider);
 	}
 
@@ -58,11 +76,19 @@ public:
 		{
 			IMediaIOCoreModule::Get().UnregisterDeviceProvider(&DeviceProvider);
 		}
+		if (DeviceMonitor)
+		{
+			delete DeviceMonitor;
+			DeviceMonitor = nullptr;
+		}
+		FAjaDeviceCatalog::Reset();
 		FAja::Shutdown();
+		FAjaMediaLog::Shutdown();
 	}
 
 private:
 	FAjaDeviceProvider DeviceProvider;
+	FAjaDeviceMonitor* DeviceMonitor;
 };
 
 IMPLEMENT_MODULE(FAjaMediaModule, AjaMedia);
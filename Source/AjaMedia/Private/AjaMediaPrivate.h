@@ -13,6 +13,10 @@
 #endif
 
 #include "CoreMinimal.h"
+
+#if !PLATFORM_WINDOWS
+#include "AJALib.h"
+#endif
 #include "AjaMediaSettings.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogAjaMedia, Log, All);
@@ -34,9 +38,17 @@ namespace AjaMediaOption
 	static const FName AudioChannel("AudioChannel");
 	static const FName MaxAudioFrameBuffer("MaxAudioFrameBuffer");
 	static const FName AjaVideoFormat("AjaVideoFormat");
+	static const FName AutoDetectFormat("AutoDetectFormat");
 	static const FName ColorFormat("ColorFormat");
 	static const FName SRGBInput("sRGBInput");
 	static const FName MaxVideoFrameBuffer("MaxVideoFrameBuffer");
+	static const FName ThreadOverrideAffinity("ThreadOverrideAffinity");
+	static const FName ThreadAffinityMask("ThreadAffinityMask");
+	static const FName ThreadPriority("ThreadPriority");
+	static const FName NumaLocalAllocation("NumaLocalAllocation");
+	static const FName NumaNode("NumaNode");
+	static const FName ClipLoop("ClipLoop");
+	static const FName ClipAsFastAsPossible("ClipAsFastAsPossible");
 
 	static const AJA::FAJAVideoFormat DefaultVideoFormat = 9; // 1080p3000
 }
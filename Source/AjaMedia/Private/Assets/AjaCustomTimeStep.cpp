@@ -3,6 +3,10 @@
 #include "AjaCustomTimeStep.h"
 #include "AjaMediaPrivate.h"
 #include "AJA.h"
+#include "AjaDeviceCatalog.h"
+#include "AjaMediaFramePacing.h"
+#include "AjaSyncWatcher.h"
+#include "IAjaDeviceBackend.h"
 
 #include "HAL/CriticalSection.h"
 #include "HAL/Event.h"
@@ -42,8 +46,11 @@ UAjaCustomTimeStep::UAjaCustomTimeStep(const FObjectInitializer& ObjectInitializ
 	, bUseReferenceIn(false)
 	, TimecodeFormat(EMediaIOTimecodeFormat::LTC)
 	, bEnableOverrunDetection(true)
+	, bUsePredictiveWait(false)
+	, PredictiveWakeMargin(2.f)
 	, SyncChannel(nullptr)
 	, SyncCallback(nullptr)
+	, SyncWatcher(nullptr)
 #if WITH_EDITORONLY_DATA
 	, InitializedEngine(nullptr)
 	, LastAutoSynchronizeInEditorAppTime(0.0)
@@ -53,6 +60,10 @@ UAjaCustomTimeStep::UAjaCustomTimeStep(const FObjectInitializer& ObjectInitializ
 	, bWarnedAboutVSync(false)
 	, bIsPreviousSyncCountValid(false)
 	, PreviousSyncCount(0)
+	, bIsPredictedSyncCountValid(false)
+	, PredictedSyncCount(0)
+	, NumMissedSyncs(0)
+	, LastWaitEndTime(0.0)
 {
 	MediaConfiguration.bIsInput = !bUseReferenceIn;
 }
@@ -88,6 +99,24 @@ bool UAjaCustomTimeStep::Initialize(UEngine* InEngine)
 		return false;
 	}
 
+	// Synchronize again when the device is plugged, removed or enumerated again
+	if (!DevicesChangedHandle.IsValid())
+	{
+		TWeakObjectPtr<UAjaCustomTimeStep> WeakThis = this;
+		DevicesChangedHandle = FAjaDeviceCatalog::OnChanged().AddLambda([WeakThis](const FAjaDeviceCatalog::FChange& InChange)
+		{
+			UAjaCustomTimeStep* This = WeakThis.Get();
+			if (This && This->State != ECustomTimeStepSynchronizationState::Closed && InChange.IsDeviceChanged(This->MediaConfiguration.MediaConnection.Device.DeviceIdentifier))
+			{
+				UE_LOG(LogAjaMedia, Warning, TEXT("The device of the CustomTimeStep '%s' was added, removed or changed."), *This->GetName());
+				This->State = ECustomTimeStepSynchronizationState::Error;
+#if WITH_EDITORONLY_DATA
+				This->LastAutoSynchronizeInEditorAppTime = 0.0;
+#endif
+			}
+		});
+	}
+
 	if (bUseReferenceIn && bWaitForFrameToBeReady)
 	{
 		UE_LOG(LogAjaMedia, Warning, TEXT("The CustomTimeStep '%s' use both the reference and wait for the frame to be ready. These options are not compatible."), *GetName());
@@ -98,6 +127,11 @@ bool UAjaCustomTimeStep::Initialize(UEngine* InEngine)
 		UE_LOG(LogAjaMedia, Warning, TEXT("The CustomTimeStep '%s' is waiting for the frame to be ready and interlaced picture is not supported."), *GetName());
 	}
 
+	if (bUsePredictiveWait && bWaitForFrameToBeReady && !bUseReferenceIn)
+	{
+		UE_LOG(LogAjaMedia, Warning, TEXT("The CustomTimeStep '%s' waits for the frame to be ready. The predictive wait is not used."), *GetName());
+	}
+
 	check(SyncCallback == nullptr);
 	SyncCallback = new FAJACallback(this);
 
@@ -151,7 +185,7 @@ bool UAjaCustomTimeStep::Initialize(UEngine* InEngine)
 	}
 
 	check(SyncChannel == nullptr);
-	SyncChannel = new AJA::AJASyncChannel();
+	SyncChannel = FAja::GetDeviceBackend()->CreateSyncChannel();
 	if (!SyncChannel->Initialize(DeviceOptions, Options))
 	{
 		State = ECustomTimeStepSynchronizationState::Error;
@@ -178,6 +212,9 @@ void UAjaCustomTimeStep::Shutdown(UEngine* InEngine)
 
 	State = ECustomTimeStepSynchronizationState::Closed;
 	ReleaseResources();
+
+	FAjaDeviceCatalog::OnChanged().Remove(DevicesChangedHandle);
+	DevicesChangedHandle.Reset();
 }
 
 bool UAjaCustomTimeStep::UpdateTimeStep(UEngine* InEngine)
@@ -201,12 +238,33 @@ bool UAjaCustomTimeStep::UpdateTimeStep(UEngine* InEngine)
 
 		const double BeforeTime = FPlatformTime::Seconds();
 
-		WaitForSync();
+		// The watcher is started once the channel is initialized
+		const bool bPredictiveWait = bUsePredictiveWait && !(bWaitForFrameToBeReady && !bUseReferenceIn);
+		if (bPredictiveWait && SyncWatcher == nullptr)
+		{
+			SyncWatcher = new FAjaSyncWatcher(SyncChannel, GetFixedFrameRate().AsInterval());
+		}
+
+		NumMissedSyncs = 0;
+		const double WaitStartTime = FPlatformTime::Seconds();
+		if (SyncWatcher)
+		{
+			WaitForPredictedSync();
+		}
+		else
+		{
+			WaitForSync();
+		}
+		const double WaitEndTime = FPlatformTime::Seconds();
 
 		// Use fixed delta time and update time.
-		FApp::SetCurrentTime(FPlatformTime::Seconds());
+		FApp::SetCurrentTime(WaitEndTime);
 		FApp::SetIdleTime(FApp::GetCurrentTime() - BeforeTime);
 
+		const double GameFrameTime = LastWaitEndTime > 0.0 ? BeforeTime - LastWaitEndTime : -1.0;
+		FAjaMediaFramePacing::AddFrame(WaitEndTime - WaitStartTime, FApp::GetIdleTime(), GameFrameTime, NumMissedSyncs, GetFixedFrameRate().AsInterval());
+		LastWaitEndTime = WaitEndTime;
+
 		double InterlacedMultiplier = ((MediaConfiguration.MediaMode.Standard == EMediaIOStandardType::Interlaced) && bWaitForFrameToBeReady) ? 2.0 : 1.0;
 		FApp::SetDeltaTime(GetFixedFrameRate().AsInterval() * InterlacedMultiplier);
 
@@ -253,6 +311,8 @@ FFrameRate UAjaCustomTimeStep::GetFixedFrameRate() const
 void UAjaCustomTimeStep::BeginDestroy()
 {
 	ReleaseResources();
+	FAjaDeviceCatalog::OnChanged().Remove(DevicesChangedHandle);
+	DevicesChangedHandle.Reset();
 	Super::BeginDestroy();
 }
 
@@ -276,14 +336,18 @@ void UAjaCustomTimeStep::WaitForSync()
 	check(SyncChannel);
 
 	bool bWaitIsValid = SyncChannel->WaitForSync();
-	if (bEnableOverrunDetection && bWaitIsValid)
+	if (bWaitIsValid)
 	{
 		uint32 NewSyncCount = 0;
 		bool bIsNewSyncCountValid = SyncChannel->GetSyncCount(NewSyncCount);
 
 		if (bIsNewSyncCountValid && bIsPreviousSyncCountValid && NewSyncCount != PreviousSyncCount+1)
 		{
-			UE_LOG(LogAjaMedia, Warning, TEXT("The Engine couldn't run fast enough to keep up with the CustomTimeStep Sync. '%d' frame(s) was dropped."), NewSyncCount-PreviousSyncCount+1);
+			NumMissedSyncs = NewSyncCount - PreviousSyncCount - 1;
+			if (bEnableOverrunDetection)
+			{
+				UE_LOG(LogAjaMedia, Warning, TEXT("The Engine couldn't run fast enough to keep up with the CustomTimeStep Sync. '%d' frame(s) was dropped."), NewSyncCount-PreviousSyncCount+1);
+			}
 		}
 		bIsPreviousSyncCountValid = bIsNewSyncCountValid;
 		PreviousSyncCount = NewSyncCount;
@@ -296,8 +360,63 @@ void UAjaCustomTimeStep::WaitForSync()
 	}
 }
 
+void UAjaCustomTimeStep::WaitForPredictedSync()
+{
+	check(SyncWatcher);
+
+	if (SyncWatcher->HasFailed())
+	{
+		State = ECustomTimeStepSynchronizationState::Error;
+		UE_LOG(LogAjaMedia, Error, TEXT("The CustomTimeStep '%s' lost the sync. The wait timeout."), *GetName());
+		return;
+	}
+
+	FAjaSyncWatcher::FEstimate Estimate;
+	if (!SyncWatcher->GetEstimate(Estimate))
+	{
+		// Wait for the real sync until its period is measured
+		if (!SyncWatcher->WaitForSync())
+		{
+			State = ECustomTimeStepSynchronizationState::Error;
+			UE_LOG(LogAjaMedia, Error, TEXT("The Engine couldn't run fast enough to keep up with the CustomTimeStep Sync. The wait timeout."));
+		}
+		bIsPredictedSyncCountValid = false;
+		return;
+	}
+
+	const double WakeMargin = FMath::Max(PredictiveWakeMargin, 0.f) / 1000.0;
+	const double CurrentTime = FPlatformTime::Seconds();
+
+	// Every frame starts on the sync after the previous one. When the frame took more than a period, the syncs that went by are skipped.
+	uint32 SyncCount = bIsPredictedSyncCountValid ? PredictedSyncCount + 1 : Estimate.SyncCount + 1;
+	if (CurrentTime > Estimate.GetSyncTime(SyncCount) - WakeMargin + Estimate.Period)
+	{
+		const uint32 NextSyncCount = Estimate.GetSyncCount(CurrentTime + WakeMargin) + 1;
+		if (bIsPredictedSyncCountValid)
+		{
+			NumMissedSyncs = NextSyncCount - SyncCount;
+			if (bEnableOverrunDetection)
+			{
+				UE_LOG(LogAjaMedia, Warning, TEXT("The Engine couldn't run fast enough to keep up with the CustomTimeStep Sync. '%d' frame(s) was dropped."), (int32)NumMissedSyncs);
+			}
+		}
+		SyncCount = NextSyncCount;
+	}
+
+	FAjaSyncWatcher::SleepUntil(Estimate.GetSyncTime(SyncCount) - WakeMargin);
+
+	bIsPredictedSyncCountValid = true;
+	PredictedSyncCount = SyncCount;
+}
+
 void UAjaCustomTimeStep::ReleaseResources()
 {
+	if (SyncWatcher)
+	{
+		delete SyncWatcher;
+		SyncWatcher = nullptr;
+	}
+
 	if (SyncChannel)
 	{
 		SyncChannel->Uninitialize();
@@ -309,5 +428,7 @@ void UAjaCustomTimeStep::ReleaseResources()
 
 	bWarnedAboutVSync = false;
 	bIsPreviousSyncCountValid = false;
+	bIsPredictedSyncCountValid = false;
+	LastWaitEndTime = 0.0;
 }
 
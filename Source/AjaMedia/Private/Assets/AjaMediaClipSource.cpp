@@ -0,0 +1,243 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaClipSource.h"
+
+#include "Aja.h"
+#include "AjaMediaClip.h"
+#include "AjaMediaClipInputChannel.h"
+#include "AjaMediaPrivate.h"
+
+#include "IAjaDeviceBackend.h"
+#include "MediaIOCorePlayerBase.h"
+#include "Misc/Paths.h"
+
+UAjaMediaClipSource::UAjaMediaClipSource()
+	: PlaybackRate(EAjaMediaClipPlaybackRate::Recorded)
+	, bLoop(false)
+	, bUseRecordedTimecode(true)
+	, bCaptureAncillary(false)
+	, MaxNumAncillaryFrameBuffer(8)
+	, bCaptureAudio(false)
+	, MaxNumAudioFrameBuffer(8)
+	, bCaptureVideo(true)
+	, bIsSRGBInput(false)
+	, MaxNumVideoFrameBuffer(8)
+	, bLogDropFrame(true)
+	, bEncodeTimecodeInTexel(false)
+{ }
+
+/*
+ * IMediaOptions interface
+ */
+
+bool UAjaMediaClipSource::GetMediaOption(const FName& Key, bool DefaultValue) const
+{
+	if (Key == AjaMediaOption::ClipLoop)
+	{
+		return bLoop;
+	}
+	if (Key == AjaMediaOption::ClipAsFastAsPossible)
+	{
+		return PlaybackRate == EAjaMediaClipPlaybackRate::AsFastAsPossible;
+	}
+	if (Key == AjaMediaOption::CaptureAncillary)
+	{
+		return bCaptureAncillary;
+	}
+	if (Key == AjaMediaOption::CaptureAudio)
+	{
+		return bCaptureAudio;
+	}
+	if (Key == AjaMediaOption::CaptureVideo)
+	{
+		return bCaptureVideo;
+	}
+	if (Key == AjaMediaOption::LogDropFrame)
+	{
+		return bLogDropFrame;
+	}
+	if (Key == AjaMediaOption::EncodeTimecodeInTexel)
+	{
+		return bEncodeTimecodeInTexel;
+	}
+	if (Key == AjaMediaOption::SRGBInput)
+	{
+		return bIsSRGBInput;
+	}
+
+	return Super::GetMediaOption(Key, DefaultValue);
+}
+
+int64 UAjaMediaClipSource::GetMediaOption(const FName& Key, int64 DefaultValue) const
+{
+	if (Key == FMediaIOCoreMediaOption::FrameRateNumerator
+		|| Key == FMediaIOCoreMediaOption::FrameRateDenominator
+		|| Key == FMediaIOCoreMediaOption::ResolutionWidth
+		|| Key == FMediaIOCoreMediaOption::ResolutionHeight)
+	{
+		// The format is the format the clip was recorded with
+		AjaMediaClip::FIndexHeader Header;
+		if (!FAjaMediaClipInputChannel::ReadHeader(GetClipBaseName(), Header))
+		{
+			return DefaultValue;
+		}
+
+		if (Key == FMediaIOCoreMediaOption::FrameRateNumerator)
+		{
+			return Header.FrameRateNumerator;
+		}
+		if (Key == FMediaIOCoreMediaOption::FrameRateDenominator)
+		{
+			return Header.FrameRateDenominator;
+		}
+		if (Key == FMediaIOCoreMediaOption::ResolutionWidth)
+		{
+			return Header.Width;
+		}
+		return Header.Height;
+	}
+	if (Key == AjaMediaOption::TimecodeFormat)
+	{
+		// The timecode of every format was recorded the same way
+		return (int64)(bUseRecordedTimecode ? EMediaIOTimecodeFormat::LTC : EMediaIOTimecodeFormat::None);
+	}
+	if (Key == AjaMediaOption::MaxAncillaryFrameBuffer)
+	{
+		return MaxNumAncillaryFrameBuffer;
+	}
+	if (Key == AjaMediaOption::MaxAudioFrameBuffer)
+	{
+		return MaxNumAudioFrameBuffer;
+	}
+	if (Key == AjaMediaOption::MaxVideoFrameBuffer)
+	{
+		return MaxNumVideoFrameBuffer;
+	}
+
+	return Super::GetMediaOption(Key, DefaultValue);
+}
+
+FString UAjaMediaClipSource::GetMediaOption(const FName& Key, const FString& DefaultValue) const
+{
+	if (Key == FMediaIOCoreMediaOption::VideoModeName)
+	{
+		AjaMediaClip::FIndexHeader Header;
+		if (FAja::IsInitialized() && FAjaMediaClipInputChannel::ReadHeader(GetClipBaseName(), Header))
+		{
+			const AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = FAja::GetDeviceBackend()->GetVideoFormat(Header.VideoFormatIndex);
+			if (Descriptor.bIsValid)
+			{
+				return FAja::ConvertVideoFormat2MediaMode(Descriptor).GetModeName().ToString();
+			}
+		}
+		return DefaultValue;
+	}
+	return Super::GetMediaOption(Key, DefaultValue);
+}
+
+bool UAjaMediaClipSource::HasMediaOption(const FName& Key) const
+{
+	if ((Key == AjaMediaOption::ClipLoop) ||
+		(Key == AjaMediaOption::ClipAsFastAsPossible) ||
+		(Key == FMediaIOCoreMediaOption::FrameRateNumerator) ||
+		(Key == FMediaIOCoreMediaOption::FrameRateDenominator) ||
+		(Key == FMediaIOCoreMediaOption::ResolutionWidth) ||
+		(Key == FMediaIOCoreMediaOption::ResolutionHeight) ||
+		(Key == FMediaIOCoreMediaOption::VideoModeName) ||
+		(Key == AjaMediaOption::TimecodeFormat) ||
+		(Key == AjaMediaOption::CaptureAncillary) ||
+		(Key == AjaMediaOption::CaptureAudio) ||
+		(Key == AjaMediaOption::CaptureVideo) ||
+		(Key == AjaMediaOption::MaxAncillaryFrameBuffer) ||
+		(Key == AjaMediaOption::MaxAudioFrameBuffer) ||
+		(Key == AjaMediaOption::SRGBInput) ||
+		(Key == AjaMediaOption::MaxVideoFrameBuffer) ||
+		(Key == AjaMediaOption::LogDropFrame) ||
+		(Key == AjaMediaOption::EncodeTimecodeInTexel)
+		)
+	{
+		return true;
+	}
+
+	return Super::HasMediaOption(Key);
+}
+
+/*
+ * UMediaSource interface
+ */
+
+FString UAjaMediaClipSource::GetUrl() const
+{
+	return ClipPath.FilePath.IsEmpty() ? FString() : AjaMediaClip::MakeUrl(GetClipBaseName());
+}
+
+bool UAjaMediaClipSource::Validate() const
+{
+	if (!FAja::IsInitialized())
+	{
+		UE_LOG(LogAjaMedia, Warning, TEXT("Can't validate MediaSource '%s'. the Aja library was not initialized."), *GetName());
+		return false;
+	}
+
+	if (ClipPath.FilePath.IsEmpty())
+	{
+		UE_LOG(LogAjaMedia, Warning, TEXT("The MediaSource '%s' has no clip."), *GetName());
+		return false;
+	}
+
+	AjaMediaClip::FIndexHeader Header;
+	if (!FAjaMediaClipInputChannel::ReadHeader(GetClipBaseName(), Header))
+	{
+		UE_LOG(LogAjaMedia, Warning, TEXT("The MediaSource '%s' use the clip '%s' that can't be read."), *GetName(), *ClipPath.FilePath);
+		return false;
+	}
+
+	if (bUseTimeSynchronization && !bUseRecordedTimecode)
+	{
+		UE_LOG(LogAjaMedia, Warning, TEXT("The MediaSource '%s' use time synchronization but doesn't use the recorded timecode."), *GetName());
+		return false;
+	}
+
+	return true;
+}
+
+FString UAjaMediaClipSource::GetClipBaseName() const
+{
+	return AjaMediaClip::GetBaseName(FPaths::ConvertRelativePathToFull(ClipPath.FilePath));
+}
+
+#if WITH_EDITOR
+bool UAjaMediaClipSource::CanEditChange(const UProperty* InProperty) const
+{
+	if (!Super::CanEditChange(InProperty))
+	{
+		return false;
+	}
+
+	if (InProperty->GetFName() == GET_MEMBER_NAME_CHECKED(UAjaMediaClipSource, bEncodeTimecodeInTexel))
+	{
+		return bUseRecordedTimecode && bCaptureVideo;
+	}
+
+	if (InProperty->GetFName() == GET_MEMBER_NAME_CHECKED(UTimeSynchronizableMediaSource, bUseTimeSynchronization))
+	{
+		return bUseRecordedTimecode;
+	}
+
+	return true;
+}
+
+void UAjaMediaClipSource::PostEditChangeChainProperty(struct FPropertyChangedChainEvent& PropertyChangedEvent)
+{
+	if (PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(UAjaMediaClipSource, bUseRecordedTimecode))
+	{
+		if (!bUseRecordedTimecode)
+		{
+			bUseTimeSynchronization = false;
+			bEncodeTimecodeInTexel = false;
+		}
+	}
+
+	Super::PostEditChangeChainProperty(PropertyChangedEvent);
+}
+#endif //WITH_EDITOR
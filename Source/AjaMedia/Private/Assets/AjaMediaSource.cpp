@@ -3,6 +3,7 @@
 #include "AjaMediaSource.h"
 
 #include "Aja.h"
+#include "AjaDeviceCatalog.h"
 #include "AjaMediaPrivate.h"
 
 #include "MediaIOCorePlayerBase.h"
@@ -11,6 +12,7 @@
 UAjaMediaSource::UAjaMediaSource()
 	: TimecodeFormat(EMediaIOTimecodeFormat::None)
 	, bCaptureWithAutoCirculating(true)
+	, bAutoDetectFormat(false)
 	, bCaptureAncillary(false)
 	, MaxNumAncillaryFrameBuffer(8)
 	, bCaptureAudio(false)
@@ -36,6 +38,10 @@ bool UAjaMediaSource::GetMediaOption(const FName& Key, bool DefaultValue) const
 	{
 		return bCaptureWithAutoCirculating;
 	}
+	if (Key == AjaMediaOption::AutoDetectFormat)
+	{
+		return bAutoDetectFormat;
+	}
 	if (Key == AjaMediaOption::CaptureAncillary)
 	{
 		return bCaptureAncillary;
@@ -60,6 +66,14 @@ bool UAjaMediaSource::GetMediaOption(const FName& Key, bool DefaultValue) const
 	{
 		return bIsSRGBInput;
 	}
+	if (Key == AjaMediaOption::ThreadOverrideAffinity)
+	{
+		return ThreadSettings.bOverrideAffinity;
+	}
+	if (Key == AjaMediaOption::NumaLocalAllocation)
+	{
+		return ThreadSettings.bNumaLocalAllocation;
+	}
 
 
 	return Super::GetMediaOption(Key, DefaultValue);
@@ -127,6 +141,18 @@ int64 UAjaMediaSource::GetMediaOption(const FName& Key, int64 DefaultValue) cons
 	{
 		return MaxNumVideoFrameBuffer;
 	}
+	if (Key == AjaMediaOption::ThreadAffinityMask)
+	{
+		return ThreadSettings.AffinityMask;
+	}
+	if (Key == AjaMediaOption::ThreadPriority)
+	{
+		return (int64)ThreadSettings.Priority;
+	}
+	if (Key == AjaMediaOption::NumaNode)
+	{
+		return ThreadSettings.NumaNode;
+	}
 
 	return Super::GetMediaOption(Key, DefaultValue);
 }
@@ -160,11 +186,17 @@ bool UAjaMediaSource::HasMediaOption(const FName& Key) const
 		(Key == AjaMediaOption::AudioChannel) ||
 		(Key == AjaMediaOption::MaxAudioFrameBuffer) ||
 		(Key == AjaMediaOption::AjaVideoFormat) ||
+		(Key == AjaMediaOption::AutoDetectFormat) ||
 		(Key == AjaMediaOption::ColorFormat) ||
 		(Key == AjaMediaOption::SRGBInput) ||
 		(Key == AjaMediaOption::MaxVideoFrameBuffer) ||
 		(Key == AjaMediaOption::LogDropFrame) ||
-		(Key == AjaMediaOption::EncodeTimecodeInTexel)
+		(Key == AjaMediaOption::EncodeTimecodeInTexel) ||
+		(Key == AjaMediaOption::ThreadOverrideAffinity) ||
+		(Key == AjaMediaOption::ThreadAffinityMask) ||
+		(Key == AjaMediaOption::ThreadPriority) ||
+		(Key == AjaMediaOption::NumaLocalAllocation) ||
+		(Key == AjaMediaOption::NumaNode)
 		)
 	{
 		return true;
@@ -203,14 +235,15 @@ bool UAjaMediaSource::Validate() const
 		return false;
 	}
 
-	TUniquePtr<AJA::AJADeviceScanner> Scanner = MakeUnique<AJA::AJADeviceScanner>();
-	AJA::AJADeviceScanner::DeviceInfo DeviceInfo;
-	if (!Scanner->GetDeviceInfo(MediaConfiguration.MediaConnection.Device.DeviceIdentifier, DeviceInfo))
+	const FAjaDeviceCatalog::FSnapshotRef Devices = FAjaDeviceCatalog::Get();
+	const FAjaDeviceCatalog::FDevice* Device = Devices->FindDevice(MediaConfiguration.MediaConnection.Device.DeviceIdentifier);
+	if (Device == nullptr)
 	{
 		UE_LOG(LogAjaMedia, Warning, TEXT("The MediaSource '%s' use the device '%s' that doesn't exist on this machine."), *GetName(), *MediaConfiguration.MediaConnection.Device.DeviceName.ToString());
 		return false;
 	}
 
+	const AJA::AJADeviceScanner::DeviceInfo& DeviceInfo = Device->Info;
 	if (!DeviceInfo.bIsSupported)
 	{
 		UE_LOG(LogAjaMedia, Warning, TEXT("The MediaSource '%s' use the device '%s' that is not supported by the AJA SDK."), *GetName(), *MediaConfiguration.MediaConnection.Device.DeviceName.ToString());
@@ -0,0 +1,163 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaThreadSettings.h"
+
+#include "Aja.h"
+#include "AjaMediaPrivate.h"
+#include "IAjaDeviceBackend.h"
+
+#include "HAL/PlatformProcess.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX
+#include <sched.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace AjaMediaThreadSettings
+{
+	/**
+	 * Pin the calling thread to the cores of the NUMA node.
+	 * A node can have more than 64 cores, so the affinity is not a 64 bits mask: Windows gives the node its processor group,
+	 * Linux takes a cpu set of any size.
+	 */
+	bool SetCurrentThreadNumaNodeAffinity(int32 InNumaNode)
+	{
+#if PLATFORM_WINDOWS
+		GROUP_AFFINITY Affinity;
+		FMemory::Memzero(Affinity);
+		if (InNumaNode <= MAXUSHORT && ::GetNumaNodeProcessorMaskEx((USHORT)InNumaNode, &Affinity) && Affinity.Mask != 0)
+		{
+			return ::SetThreadGroupAffinity(::GetCurrentThread(), &Affinity, nullptr) != 0;
+		}
+#elif PLATFORM_LINUX
+		// The cpu list looks like "0-15,32-47"
+		char Path[64];
+		snprintf(Path, sizeof(Path), "/sys/devices/system/node/node%d/cpulist", InNumaNode);
+		if (FILE* File = fopen(Path, "r"))
+		{
+			cpu_set_t CpuSet;
+			CPU_ZERO(&CpuSet);
+			int First = 0;
+			int Last = 0;
+			int Read = 0;
+			while ((Read = fscanf(File, "%d-%d", &First, &Last)) > 0)
+			{
+				Last = Read == 2 ? Last : First;
+				for (int Core = First; Core <= Last && Core < CPU_SETSIZE; ++Core)
+				{
+					CPU_SET(Core, &CpuSet);
+				}
+				if (fgetc(File) != ',')
+				{
+					break;
+				}
+			}
+			fclose(File);
+
+			// 0 is the calling thread
+			return CPU_COUNT(&CpuSet) > 0 && sched_setaffinity(0, sizeof(CpuSet), &CpuSet) == 0;
+		}
+#endif
+		return false;
+	}
+
+	void SetCurrentThreadPriority(EAjaMediaThreadPriority InPriority)
+	{
+		if (InPriority == EAjaMediaThreadPriority::Default)
+		{
+			return;
+		}
+
+#if PLATFORM_WINDOWS
+		int Priority = THREAD_PRIORITY_ABOVE_NORMAL;
+		switch (InPriority)
+		{
+		case EAjaMediaThreadPriority::Highest: Priority = THREAD_PRIORITY_HIGHEST; break;
+		case EAjaMediaThreadPriority::TimeCritical: Priority = THREAD_PRIORITY_TIME_CRITICAL; break;
+		default: break;
+		}
+		if (!::SetThreadPriority(::GetCurrentThread(), Priority))
+		{
+			UE_LOG(LogAjaMedia, Warning, TEXT("Couldn't change the priority of the AJA channel thread."));
+		}
+#elif PLATFORM_LINUX
+		int Nice = -5;
+		switch (InPriority)
+		{
+		case EAjaMediaThreadPriority::Highest: Nice = -10; break;
+		case EAjaMediaThreadPriority::TimeCritical: Nice = -15; break;
+		default: break;
+		}
+		// Raising the priority requires CAP_SYS_NICE
+		if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), Nice) != 0)
+		{
+			UE_LOG(LogAjaMedia, Warning, TEXT("Couldn't change the priority of the AJA channel thread. The process may be missing the CAP_SYS_NICE capability."));
+		}
+#endif
+	}
+}
+
+/* FAjaMediaThreadSettings implementation
+*****************************************************************************/
+FAjaMediaThreadSettings::FAjaMediaThreadSettings()
+	: bOverrideAffinity(false)
+	, AffinityMask(0)
+	, Priority(EAjaMediaThreadPriority::Default)
+	, bNumaLocalAllocation(false)
+	, NumaNode(INDEX_NONE)
+{ }
+
+int32 FAjaMediaThreadSettings::ResolveNumaNode(int32 InDeviceIndex) const
+{
+	if (!bNumaLocalAllocation)
+	{
+		return INDEX_NONE;
+	}
+
+	if (NumaNode >= 0)
+	{
+		return NumaNode;
+	}
+
+	IAjaDeviceBackend* DeviceBackend = FAja::GetDeviceBackend();
+	return DeviceBackend ? DeviceBackend->GetDeviceNumaNode(InDeviceIndex) : INDEX_NONE;
+}
+
+int32 FAjaMediaThreadSettings::ApplyToCurrentThread(int32 InDeviceIndex) const
+{
+	const int32 ResolvedNumaNode = ApplyAffinityToCurrentThread(InDeviceIndex);
+	AjaMediaThreadSettings::SetCurrentThreadPriority(Priority);
+
+	if (bNumaLocalAllocation && ResolvedNumaNode == INDEX_NONE)
+	{
+		UE_LOG(LogAjaMedia, Warning, TEXT("The NUMA node of the AJA device %d is unknown. Set it in the thread settings."), InDeviceIndex);
+	}
+
+	return ResolvedNumaNode;
+}
+
+int32 FAjaMediaThreadSettings::ApplyAffinityToCurrentThread(int32 InDeviceIndex) const
+{
+	const int32 ResolvedNumaNode = ResolveNumaNode(InDeviceIndex);
+
+	if (bOverrideAffinity)
+	{
+		if (AffinityMask != 0)
+		{
+			FPlatformProcess::SetThreadAffinityMask((uint64)AffinityMask);
+		}
+	}
+	else if (ResolvedNumaNode != INDEX_NONE && !AjaMediaThreadSettings::SetCurrentThreadNumaNodeAffinity(ResolvedNumaNode))
+	{
+		UE_LOG(LogAjaMedia, Warning, TEXT("Couldn't pin the AJA channel thread to the cores of the NUMA node %d."), ResolvedNumaNode);
+	}
+
+	return ResolvedNumaNode;
+}
@@ -3,8 +3,14 @@
 #include "AjaTimecodeProvider.h"
 #include "AjaMediaPrivate.h"
 #include "AJA.h"
+#include "AjaDeviceCatalog.h"
+#include "AjaSyncWatcher.h"
+#include "IAjaDeviceBackend.h"
 
 #include "Misc/App.h"
+#include "Stats/Stats2.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AJA Timecode driver reads saved"), STAT_AJA_TimecodeProvider_SavedReads, STATGROUP_Media);
 
 #define LOCTEXT_NAMESPACE "AjaTimecodeProvider"
 
@@ -36,6 +42,7 @@ UAjaTimecodeProvider::UAjaTimecodeProvider(const FObjectInitializer& ObjectIniti
 	: Super(ObjectInitializer)
 	, SyncChannel(nullptr)
 	, SyncCallback(nullptr)
+	, SyncWatcher(nullptr)
 #if WITH_EDITORONLY_DATA
 	, InitializedEngine(nullptr)
 	, LastAutoSynchronizeInEditorAppTime(0.0)
@@ -50,8 +57,19 @@ FTimecode UAjaTimecodeProvider::GetTimecode() const
 	{
 		if (State == ETimecodeProviderSynchronizationState::Synchronized)
 		{
+			// Use the timecode latched at the last sync. Until the first one, if the syncs stopped, or if the latch may be a frame behind, ask the driver.
 			AJA::FTimecode NewTimecode;
-			if (SyncChannel->GetTimecode(NewTimecode))
+			bool bHasTimecode = SyncWatcher && SyncWatcher->GetCurrentTimecode(NewTimecode);
+			if (bHasTimecode)
+			{
+				INC_DWORD_STAT(STAT_AJA_TimecodeProvider_SavedReads);
+			}
+			else
+			{
+				bHasTimecode = SyncChannel->GetTimecode(NewTimecode);
+			}
+
+			if (bHasTimecode)
 			{
 				//We expect the timecode to be processed in the library. What we receive will be a "linear" timecode even for frame rates greater than 30.
 				if ((int32)NewTimecode.Frames >= FMath::RoundToInt(GetFrameRate().AsDecimal()))
@@ -104,6 +122,30 @@ bool UAjaTimecodeProvider::Initialize(class UEngine* InEngine)
 		return false;
 	}
 
+	// Synchronize again when the device is plugged, removed or enumerated again
+	if (!DevicesChangedHandle.IsValid())
+	{
+		TWeakObjectPtr<UAjaTimecodeProvider> WeakThis = this;
+		DevicesChangedHandle = FAjaDeviceCatalog::OnChanged().AddLambda([WeakThis](const FAjaDeviceCatalog::FChange& InChange)
+		{
+			UAjaTimecodeProvider* This = WeakThis.Get();
+			if (This == nullptr || This->State == ETimecodeProviderSynchronizationState::Closed)
+			{
+				return;
+			}
+
+			const int32 DeviceIndex = This->bUseReferenceIn ? This->ReferenceConfiguration.Device.DeviceIdentifier : This->VideoConfiguration.MediaConfiguration.MediaConnection.Device.DeviceIdentifier;
+			if (InChange.IsDeviceChanged(DeviceIndex))
+			{
+				UE_LOG(LogAjaMedia, Warning, TEXT("The device of the TimecodeProvider '%s' was added, removed or changed."), *This->GetName());
+				This->State = ETimecodeProviderSynchronizationState::Error;
+#if WITH_EDITORONLY_DATA
+				This->LastAutoSynchronizeInEditorAppTime = 0.0;
+#endif
+			}
+		});
+	}
+
 	check(SyncCallback == nullptr);
 	SyncCallback = new FAJACallback(this);
 
@@ -160,7 +202,7 @@ bool UAjaTimecodeProvider::Initialize(class UEngine* InEngine)
 	}
 
 	check(SyncChannel == nullptr);
-	SyncChannel = new AJA::AJASyncChannel();
+	SyncChannel = FAja::GetDeviceBackend()->CreateSyncChannel();
 	if (!SyncChannel->Initialize(DeviceOptions, Options))
 	{
 		State = ETimecodeProviderSynchronizationState::Error;
@@ -168,6 +210,9 @@ bool UAjaTimecodeProvider::Initialize(class UEngine* InEngine)
 		return false;
 	}
 
+	check(SyncWatcher == nullptr);
+	SyncWatcher = new FAjaSyncWatcher(SyncChannel, GetFrameRate().AsInterval(), true);
+
 #if WITH_EDITORONLY_DATA
 	InitializedEngine = InEngine;
 #endif
@@ -184,16 +229,28 @@ void UAjaTimecodeProvider::Shutdown(class UEngine* InEngine)
 
 	State = ETimecodeProviderSynchronizationState::Closed;
 	ReleaseResources();
+
+	FAjaDeviceCatalog::OnChanged().Remove(DevicesChangedHandle);
+	DevicesChangedHandle.Reset();
 }
 
 void UAjaTimecodeProvider::BeginDestroy()
 {
 	ReleaseResources();
+	FAjaDeviceCatalog::OnChanged().Remove(DevicesChangedHandle);
+	DevicesChangedHandle.Reset();
 	Super::BeginDestroy();
 }
 
 void UAjaTimecodeProvider::ReleaseResources()
 {
+	// The watcher is waiting on the channel
+	if (SyncWatcher)
+	{
+		delete SyncWatcher;
+		SyncWatcher = nullptr;
+	}
+
 	if (SyncChannel)
 	{
 		SyncChannel->Uninitialize();
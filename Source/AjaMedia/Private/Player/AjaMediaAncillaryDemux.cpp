@@ -0,0 +1,179 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaAncillaryDemux.h"
+
+#include "AjaMediaAncillarySubscription.h"
+
+#include "HAL/PlatformAtomics.h"
+#include "Misc/ScopeLock.h"
+
+namespace AjaMediaAncillaryDemux
+{
+	/** Every subscription, of every input. */
+	struct FRegistry
+	{
+		FRegistry()
+			: Generation(0)
+		{ }
+
+		FCriticalSection CriticalSection;
+		TArray<TWeakPtr<FAjaMediaAncillarySubscription, ESPMode::ThreadSafe>> Subscriptions;
+
+		/** Incremented when a subscription is added or destroyed, so the inputs look up their subscriptions again */
+		volatile int32 Generation;
+	};
+
+	FRegistry& GetRegistry()
+	{
+		static FRegistry Registry;
+		return Registry;
+	}
+
+	/** Packets an input can index per field before it allocates. */
+	static const int32 DefaultMaxNumPackets = 64;
+}
+
+/* FAjaMediaAncillarySubscription implementation
+*****************************************************************************/
+TSharedRef<FAjaMediaAncillarySubscription, ESPMode::ThreadSafe> FAjaMediaAncillarySubscription::Subscribe(const FString& InUrl, uint8 InDID, int32 InSDID, int32 InMaxNumPackets)
+{
+	TSharedRef<FAjaMediaAncillarySubscription, ESPMode::ThreadSafe> Subscription = MakeShareable(new FAjaMediaAncillarySubscription(InUrl, InDID, InSDID, InMaxNumPackets));
+
+	AjaMediaAncillaryDemux::FRegistry& Registry = AjaMediaAncillaryDemux::GetRegistry();
+	{
+		FScopeLock Lock(&Registry.CriticalSection);
+		Registry.Subscriptions.RemoveAllSwap([](const TWeakPtr<FAjaMediaAncillarySubscription, ESPMode::ThreadSafe>& Other) { return !Other.IsValid(); });
+		Registry.Subscriptions.Add(Subscription);
+	}
+	FPlatformAtomics::InterlockedIncrement(&Registry.Generation);
+
+	return Subscription;
+}
+
+FAjaMediaAncillarySubscription::FAjaMediaAncillarySubscription(const FString& InUrl, uint8 InDID, int32 InSDID, int32 InMaxNumPackets)
+	: Url(InUrl)
+	, DID(InDID)
+	, SDID(InSDID)
+	, FirstPacket(0)
+	, NumPackets(0)
+	, NumDroppedPackets(0)
+{
+	Packets.SetNum(FMath::Max(InMaxNumPackets, 1));
+}
+
+FAjaMediaAncillarySubscription::~FAjaMediaAncillarySubscription()
+{
+	// The registry only keeps weak pointers, they are removed on the next subscription
+	FPlatformAtomics::InterlockedIncrement(&AjaMediaAncillaryDemux::GetRegistry().Generation);
+}
+
+bool FAjaMediaAncillarySubscription::Dequeue(FAjaMediaAncillaryReceivedPacket& OutPacket)
+{
+	FScopeLock Lock(&PacketsCriticalSection);
+	if (NumPackets == 0)
+	{
+		return false;
+	}
+
+	OutPacket = Packets[FirstPacket];
+	FirstPacket = (FirstPacket + 1) % Packets.Num();
+	--NumPackets;
+	return true;
+}
+
+void FAjaMediaAncillarySubscription::Enqueue(const uint8* InBuffer, const FAjaMediaAncillaryPacketIndex& InIndex, FTimespan InTime, const TOptional<FTimecode>& InTimecode)
+{
+	FScopeLock Lock(&PacketsCriticalSection);
+	if (NumPackets == Packets.Num())
+	{
+		FirstPacket = (FirstPacket + 1) % Packets.Num();
+		--NumPackets;
+		FPlatformAtomics::InterlockedIncrement(&NumDroppedPackets);
+	}
+
+	FAjaMediaAncillaryReceivedPacket& Packet = Packets[(FirstPacket + NumPackets) % Packets.Num()];
+	Packet.DID = InIndex.DID;
+	Packet.SDID = InIndex.SDID;
+	Packet.Line = InIndex.Line;
+	Packet.bField2 = InIndex.bField2;
+	Packet.Time = InTime;
+	Packet.Timecode = InTimecode;
+	Packet.UserData.SetNumUninitialized(InIndex.DataCount, false);
+	FMemory::Memcpy(Packet.UserData.GetData(), InBuffer + InIndex.Offset, InIndex.DataCount);
+	++NumPackets;
+}
+
+/* FAjaMediaAncillaryDemux implementation
+*****************************************************************************/
+FAjaMediaAncillaryDemux::FAjaMediaAncillaryDemux()
+	: SubscriptionsGeneration(INDEX_NONE)
+	, NumParsedPackets(0)
+	, NumDeliveredPackets(0)
+{
+	PacketIndex.Reserve(AjaMediaAncillaryDemux::DefaultMaxNumPackets);
+}
+
+void FAjaMediaAncillaryDemux::Open(const FString& InUrl)
+{
+	Url = InUrl;
+	Subscriptions.Reset();
+	SubscriptionsGeneration = INDEX_NONE;
+	NumParsedPackets = 0;
+	NumDeliveredPackets = 0;
+}
+
+void FAjaMediaAncillaryDemux::UpdateSubscriptions()
+{
+	AjaMediaAncillaryDemux::FRegistry& Registry = AjaMediaAncillaryDemux::GetRegistry();
+	const int32 Generation = FPlatformAtomics::AtomicRead(&Registry.Generation);
+	if (Generation == SubscriptionsGeneration)
+	{
+		return;
+	}
+
+	Subscriptions.Reset();
+	{
+		FScopeLock Lock(&Registry.CriticalSection);
+		for (const TWeakPtr<FAjaMediaAncillarySubscription, ESPMode::ThreadSafe>& Subscription : Registry.Subscriptions)
+		{
+			TSharedPtr<FAjaMediaAncillarySubscription, ESPMode::ThreadSafe> Pinned = Subscription.Pin();
+			if (Pinned.IsValid() && Pinned->GetUrl() == Url)
+			{
+				Subscriptions.Add(Subscription);
+			}
+		}
+	}
+	SubscriptionsGeneration = Generation;
+}
+
+int32 FAjaMediaAncillaryDemux::Demux(const uint8* InBuffer, uint32 InSize, FTimespan InTime, const TOptional<FTimecode>& InTimecode)
+{
+	UpdateSubscriptions();
+	if (Subscriptions.Num() == 0)
+	{
+		return 0;
+	}
+
+	const int32 NumPackets = AjaMediaAncillary::ParsePackets(InBuffer, InSize, PacketIndex);
+	NumParsedPackets += NumPackets;
+
+	for (const TWeakPtr<FAjaMediaAncillarySubscription, ESPMode::ThreadSafe>& Subscription : Subscriptions)
+	{
+		TSharedPtr<FAjaMediaAncillarySubscription, ESPMode::ThreadSafe> Pinned = Subscription.Pin();
+		if (!Pinned.IsValid())
+		{
+			continue;
+		}
+
+		for (const FAjaMediaAncillaryPacketIndex& Index : PacketIndex)
+		{
+			if (Pinned->Matches(Index.DID, Index.SDID))
+			{
+				Pinned->Enqueue(InBuffer, Index, InTime, InTimecode);
+				++NumDeliveredPackets;
+			}
+		}
+	}
+
+	return NumPackets;
+}
@@ -0,0 +1,54 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AjaMediaAncillary.h"
+#include "Misc/Timecode.h"
+
+class FAjaMediaAncillarySubscription;
+
+/**
+ * Parses the ancillary buffers of an input on the AJA thread and delivers the packets to the subscriptions of the input.
+ *
+ * The subscriptions of the input are cached, and only looked up again when a subscription is added or destroyed.
+ */
+class FAjaMediaAncillaryDemux
+{
+public:
+
+	FAjaMediaAncillaryDemux();
+
+	/** Deliver the packets of the input to its subscriptions. Called before the input thread starts. */
+	void Open(const FString& InUrl);
+
+	/**
+	 * Parse an ancillary buffer and deliver its packets. Called by the input thread.
+	 * Nothing is parsed when the input has no subscription.
+	 * @return the number of packets in the buffer, 0 if it was not parsed.
+	 */
+	int32 Demux(const uint8* InBuffer, uint32 InSize, FTimespan InTime, const TOptional<FTimecode>& InTimecode);
+
+	/** @return the number of packets parsed and delivered since the input was opened. */
+	uint32 GetNumParsedPackets() const { return NumParsedPackets; }
+	uint32 GetNumDeliveredPackets() const { return NumDeliveredPackets; }
+
+private:
+
+	void UpdateSubscriptions();
+
+private:
+
+	FString Url;
+
+	/** Subscriptions of the input, and the registry generation they were looked up at */
+	TArray<TWeakPtr<FAjaMediaAncillarySubscription, ESPMode::ThreadSafe>> Subscriptions;
+	int32 SubscriptionsGeneration;
+
+	/** Index of the buffer being demuxed, kept between the fields */
+	TArray<FAjaMediaAncillaryPacketIndex> PacketIndex;
+
+	uint32 NumParsedPackets;
+	uint32 NumDeliveredPackets;
+};
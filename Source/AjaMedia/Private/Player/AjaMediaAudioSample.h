@@ -4,9 +4,13 @@
 
 #include "MediaIOCoreAudioSampleBase.h"
 #include "AjaMediaPrivate.h"
+#include "AjaMediaSamplePool.h"
+
+#include "HAL/UnrealMemory.h"
 
 /*
  * Implements a media audio sample for AjaMedia.
+ * The sample owns a buffer that is kept when the sample goes back to the pool and that only grows.
  */
 class FAjaMediaAudioSample
 	: public FMediaIOCoreAudioSampleBase
@@ -15,21 +19,74 @@ class FAjaMediaAudioSample
 
 public:
 
+	FAjaMediaAudioSample()
+		: PooledBufferNum(0)
+	{ }
+
 	bool Initialize(const AJA::AJAAudioFrameData& InAudioData, FTimespan InTime, const TOptional<FTimecode>& InTimecode)
 	{
-		return Super::Initialize(
-			reinterpret_cast<int32*>(InAudioData.AudioBuffer)
-			, InAudioData.AudioBufferSize / sizeof(int32)
+		if (InAudioData.AudioBuffer == nullptr)
+		{
+			return false;
+		}
+
+		FMemory::Memcpy(RequestBuffer(InAudioData.AudioBufferSize), InAudioData.AudioBuffer, InAudioData.AudioBufferSize);
+		return SetProperties(InAudioData.AudioBufferSize / sizeof(int32)
 			, InAudioData.NumChannels
 			, InAudioData.AudioRate
 			, InTime
 			, InTimecode);
 	}
 
+	/**
+	 * Request a buffer that the device can fill directly. SetProperties should still be called after.
+	 *
+	 * @param InBufferSize The size of the audio buffer, in bytes.
+	 */
 	virtual void* RequestBuffer(uint32 InBufferSize) override
 	{
-		return Super::RequestBuffer(InBufferSize / sizeof(int32));
+		if (InBufferSize > GetBufferCapacity())
+		{
+			PooledBuffer.Reserve(AjaMediaSamplePool::GetSizeClass(InBufferSize) / sizeof(int32));
+		}
+		PooledBufferNum = InBufferSize / sizeof(int32);
+		PooledBuffer.SetNumUninitialized(PooledBufferNum, false);
+		return PooledBuffer.GetData();
+	}
+
+	/** @return the number of bytes reserved by this sample, even when it's in the pool. */
+	uint32 GetBufferCapacity() const
+	{
+		return PooledBuffer.Max() * sizeof(int32);
+	}
+
+	//~ IMediaAudioSample interface
+
+	virtual const void* GetBuffer() override
+	{
+		return PooledBufferNum > 0 ? PooledBuffer.GetData() : Super::GetBuffer();
 	}
+
+	virtual uint32 GetFrames() const override
+	{
+		return PooledBufferNum > 0 ? PooledBufferNum / FMath::Max<uint32>(GetChannels(), 1) : Super::GetFrames();
+	}
+
+	//~ IMediaPoolable interface
+
+	virtual void ShutdownPoolable() override
+	{
+		// Keep the buffer for the next frame
+		PooledBufferNum = 0;
+		PooledBuffer.SetNumUninitialized(0, false);
+		Super::ShutdownPoolable();
+	}
+
+private:
+
+	/** Buffer filled by the device or by Initialize. */
+	TArray<int32> PooledBuffer;
+	uint32 PooledBufferNum;
 };
 
 /*
@@ -5,9 +5,88 @@
 #include "MediaIOCoreBinarySampleBase.h"
 
 #include "AjaMediaPrivate.h"
+#include "AjaMediaSamplePool.h"
+
+#include "HAL/UnrealMemory.h"
 
 /*
- * Implements a pool for AJA binary sample objects. 
+ * Implements a media binary sample for the ancillary data of AjaMedia.
+ * The sample owns a buffer that is kept when the sample goes back to the pool and that only grows.
  */
+class FAjaMediaBinarySample
+	: public FMediaIOCoreBinarySampleBase
+{
+	using Super = FMediaIOCoreBinarySampleBase;
+
+public:
+
+	FAjaMediaBinarySample()
+		: PooledBufferSize(0)
+	{ }
+
+	bool Initialize(const uint8* InBinaryBuffer, uint32 InBufferSize, FTimespan InTime, const FFrameRate& InFrameRate, const TOptional<FTimecode>& InTimecode)
+	{
+		if (InBinaryBuffer == nullptr)
+		{
+			return false;
+		}
+
+		FMemory::Memcpy(RequestBuffer(InBufferSize), InBinaryBuffer, InBufferSize);
+		return SetProperties(InTime, InFrameRate, InTimecode);
+	}
+
+	/**
+	 * Request a buffer that the device can fill directly. SetProperties should still be called after.
+	 *
+	 * @param InBufferSize The size of the ancillary buffer.
+	 */
+	virtual void* RequestBuffer(uint32 InBufferSize) override
+	{
+		if (InBufferSize > GetBufferCapacity())
+		{
+			PooledBuffer.Reserve(AjaMediaSamplePool::GetSizeClass(InBufferSize));
+		}
+		PooledBufferSize = InBufferSize;
+		PooledBuffer.SetNumUninitialized(PooledBufferSize, false);
+		return PooledBuffer.GetData();
+	}
+
+	/** @return the number of bytes reserved by this sample, even when it's in the pool. */
+	uint32 GetBufferCapacity() const
+	{
+		return PooledBuffer.Max();
+	}
+
+	//~ IMediaBinarySample interface
 
-class FAjaMediaBinarySamplePool : public TMediaObjectPool<FMediaIOCoreBinarySampleBase> { };
+	virtual const void* GetData() override
+	{
+		return PooledBufferSize > 0 ? PooledBuffer.GetData() : Super::GetData();
+	}
+
+	virtual uint32 GetSize() const override
+	{
+		return PooledBufferSize > 0 ? PooledBufferSize : Super::GetSize();
+	}
+
+	//~ IMediaPoolable interface
+
+	virtual void ShutdownPoolable() override
+	{
+		// Keep the buffer for the next frame
+		PooledBufferSize = 0;
+		PooledBuffer.SetNumUninitialized(0, false);
+		Super::ShutdownPoolable();
+	}
+
+private:
+
+	/** Buffer filled by the device or by Initialize. */
+	TArray<uint8> PooledBuffer;
+	uint32 PooledBufferSize;
+};
+
+/*
+ * Implements a pool for AJA binary sample objects. 
+ */
+class FAjaMediaBinarySamplePool : public TMediaObjectPool<FAjaMediaBinarySample> { };
@@ -0,0 +1,99 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * File format of the clips written by FAjaMediaRecorder and replayed by FAjaMediaClipInputChannel.
+ *
+ * A clip is 4 files that share a base name: .video, .audio, .anc and .index.
+ * The index has a header with the format of the clip and one fixed-size entry per frame. The other files only hold the data.
+ */
+namespace AjaMediaClip
+{
+	/** Reads "AJAR" in a hex editor. */
+	static const uint32 IndexMagic = 0x52414A41;
+	static const uint32 IndexVersion = 1;
+
+	static const TCHAR* const VideoExtension = TEXT(".video");
+	static const TCHAR* const AudioExtension = TEXT(".audio");
+	static const TCHAR* const AncillaryExtension = TEXT(".anc");
+	static const TCHAR* const IndexExtension = TEXT(".index");
+
+	/** First bytes of the .index file. Rewritten when the clip is closed, with the number of frames. */
+	struct FIndexHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 HeaderSize;
+		uint32 EntrySize;
+		uint32 NumFrames;
+		uint32 Width;
+		uint32 Height;
+		uint32 Stride;
+		uint32 PixelFormat;
+		uint32 bIsProgressive;
+		uint32 FrameRateNumerator;
+		uint32 FrameRateDenominator;
+		uint32 NumAudioChannels;
+		uint32 AudioSampleRate;
+		uint32 VideoAlignment;
+		uint32 VideoFormatIndex;
+	};
+
+	/**
+	 * One per frame, right after the header. The entry of frame N is at HeaderSize + N * EntrySize.
+	 * The video frames are aligned in the .video file. The audio and ancillary data are packed, the F2 ancillary data follows the F1 data.
+	 * A size of 0 means the data was not captured.
+	 */
+	struct FIndexEntry
+	{
+		uint32 FrameNumber;
+		uint32 FramesDropped;
+		uint8 Hours;
+		uint8 Minutes;
+		uint8 Seconds;
+		uint8 Frames;
+		uint32 VideoSize;
+		uint64 VideoOffset;
+		uint64 AudioOffset;
+		uint32 AudioSize;
+		uint32 AncillarySize;
+		uint64 AncillaryOffset;
+		uint32 AncillaryF2Size;
+		uint32 Reserved;
+	};
+
+	/** A clip is opened by the player with ajaclip://<base name>. Also in AjaMediaFactoryModule.cpp. */
+	static const TCHAR* const UrlPrefix = TEXT("ajaclip://");
+
+	inline FString MakeUrl(const FString& InBaseName)
+	{
+		return UrlPrefix + InBaseName;
+	}
+
+	/** @return false if the url is not the url of a clip. */
+	inline bool ParseUrl(const FString& InUrl, FString& OutBaseName)
+	{
+		if (!InUrl.StartsWith(UrlPrefix, ESearchCase::CaseSensitive))
+		{
+			return false;
+		}
+		OutBaseName = InUrl.RightChop(FCString::Strlen(UrlPrefix));
+		return !OutBaseName.IsEmpty();
+	}
+
+	/** @return the base name of the clip of a path, without the extension of any of its files. */
+	inline FString GetBaseName(const FString& InPath)
+	{
+		for (const TCHAR* Extension : { VideoExtension, AudioExtension, AncillaryExtension, IndexExtension })
+		{
+			if (InPath.EndsWith(Extension))
+			{
+				return InPath.LeftChop(FCString::Strlen(Extension));
+			}
+		}
+		return InPath;
+	}
+}
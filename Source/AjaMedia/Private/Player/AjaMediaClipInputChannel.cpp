@@ -0,0 +1,557 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaClipInputChannel.h"
+
+#include "AjaMediaPrivate.h"
+#include "AjaSyncWatcher.h"
+
+#include "Async/MappedFileHandle.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformAtomics.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Stats/Stats2.h"
+
+#if PLATFORM_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+DECLARE_CYCLE_STAT(TEXT("AJA Clip Play frame"), STAT_AJA_Clip_PlayFrame, STATGROUP_Media);
+
+namespace AjaMediaClipInputChannel
+{
+	static TAutoConsoleVariable<int32> CVarReadAhead(
+		TEXT("Aja.Clip.ReadAhead"),
+		4,
+		TEXT("Frames of a replayed AJA clip the OS is asked to read ahead of the delivered one. Read when the clip is opened."),
+		ECVF_Default);
+
+	static const uint64 PageSize = 4096;
+
+	/** A file mapped read-only in memory. */
+	class FMappedFile
+	{
+	public:
+		FMappedFile()
+			: Data(nullptr)
+			, Size(0)
+#if PLATFORM_WINDOWS
+			, File(INVALID_HANDLE_VALUE)
+			, Mapping(nullptr)
+#elif PLATFORM_LINUX
+			, Descriptor(-1)
+#endif
+		{ }
+
+		~FMappedFile()
+		{
+			Close();
+		}
+
+		/** An empty file is valid, it has no data. */
+		bool Open(const FString& InPath)
+		{
+#if PLATFORM_WINDOWS
+			// The recorder may still be writing the clip
+			File = ::CreateFileW(*InPath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (File == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+
+			LARGE_INTEGER FileSize;
+			if (!::GetFileSizeEx(File, &FileSize))
+			{
+				return false;
+			}
+
+			Size = (uint64)FileSize.QuadPart;
+			if (Size > 0)
+			{
+				Mapping = ::CreateFileMappingW(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (Mapping == nullptr)
+				{
+					return false;
+				}
+				Data = static_cast<const uint8*>(::MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0));
+			}
+#elif PLATFORM_LINUX
+			Descriptor = ::open(TCHAR_TO_UTF8(*InPath), O_RDONLY);
+			if (Descriptor < 0)
+			{
+				return false;
+			}
+
+			struct stat FileStat;
+			if (::fstat(Descriptor, &FileStat) != 0)
+			{
+				return false;
+			}
+
+			Size = (uint64)FileStat.st_size;
+			if (Size > 0)
+			{
+				void* Address = ::mmap(nullptr, Size, PROT_READ, MAP_SHARED, Descriptor, 0);
+				if (Address != MAP_FAILED)
+				{
+					Data = static_cast<const uint8*>(Address);
+					::madvise(Address, Size, MADV_SEQUENTIAL);
+				}
+			}
+#else
+			Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*InPath));
+			if (!Handle.IsValid())
+			{
+				return false;
+			}
+
+			Size = (uint64)Handle->GetFileSize();
+			if (Size > 0)
+			{
+				Region.Reset(Handle->MapRegion());
+				Data = Region.IsValid() ? Region->GetMappedPtr() : nullptr;
+			}
+#endif
+			return Size == 0 || Data != nullptr;
+		}
+
+		void Close()
+		{
+#if PLATFORM_WINDOWS
+			if (Data)
+			{
+				::UnmapViewOfFile(Data);
+			}
+			if (Mapping)
+			{
+				::CloseHandle(Mapping);
+				Mapping = nullptr;
+			}
+			if (File != INVALID_HANDLE_VALUE)
+			{
+				::CloseHandle(File);
+				File = INVALID_HANDLE_VALUE;
+			}
+#elif PLATFORM_LINUX
+			if (Data)
+			{
+				::munmap(const_cast<uint8*>(Data), Size);
+			}
+			if (Descriptor >= 0)
+			{
+				::close(Descriptor);
+				Descriptor = -1;
+			}
+#else
+			Region.Reset();
+			Handle.Reset();
+#endif
+			Data = nullptr;
+			Size = 0;
+		}
+
+		const uint8* GetData() const { return Data; }
+		uint64 GetSize() const { return Size; }
+
+		/** @return whether the range is in the file. */
+		bool Contains(uint64 InOffset, uint64 InSize) const
+		{
+			return InSize == 0 || (InOffset <= Size && InSize <= Size - InOffset);
+		}
+
+		/** Ask the OS to read a range, so the delivery of the frame doesn't wait on the disk. */
+		void Prefetch(uint64 InOffset, uint64 InSize) const
+		{
+			if (InSize == 0 || !Contains(InOffset, InSize))
+			{
+				return;
+			}
+
+			const uint64 Begin = AlignDown(InOffset, PageSize);
+			const uint64 End = InOffset + InSize;
+#if PLATFORM_LINUX
+			// The pages are read in the background
+			::madvise(const_cast<uint8*>(Data) + Begin, End - Begin, MADV_WILLNEED);
+#else
+			// Fault the pages in while the thread waits for the next frame
+			uint8 Sum = 0;
+			for (uint64 Offset = Begin; Offset < End; Offset += PageSize)
+			{
+				Sum += static_cast<const volatile uint8*>(Data)[Offset];
+			}
+			(void)Sum;
+#endif
+		}
+
+	private:
+		const uint8* Data;
+		uint64 Size;
+#if PLATFORM_WINDOWS
+		HANDLE File;
+		HANDLE Mapping;
+#elif PLATFORM_LINUX
+		int Descriptor;
+#else
+		TUniquePtr<IMappedFileHandle> Handle;
+		TUniquePtr<IMappedFileRegion> Region;
+#endif
+	};
+
+	/** @return the buffer of the callback, or the fallback buffer, with the data copied in it. */
+	uint8* CopyData(uint8* InRequestedBuffer, TArray<uint8>& InFallbackBuffer, const uint8* InData, uint32 InSize)
+	{
+		uint8* Buffer = InRequestedBuffer;
+		if (Buffer == nullptr)
+		{
+			InFallbackBuffer.SetNumUninitialized(InSize, false);
+			Buffer = InFallbackBuffer.GetData();
+		}
+		FMemory::Memcpy(Buffer, InData, InSize);
+		return Buffer;
+	}
+}
+
+/* FAjaMediaClipInputChannel implementation
+*****************************************************************************/
+FAjaMediaClipInputChannel::FAjaMediaClipInputChannel(const FString& InBaseName, bool bInLoop, bool bInAsFastAsPossible)
+	: BaseName(InBaseName)
+	, bLoop(bInLoop)
+	, bAsFastAsPossible(bInAsFastAsPossible)
+	, Options(TEXT("Clip"), 1)
+	, NumFrames(0)
+	, NumReadAheadFrames(0)
+	, Index(nullptr)
+	, Video(nullptr)
+	, Audio(nullptr)
+	, Ancillary(nullptr)
+	, FramesDropped(0)
+	, bStopping(false)
+	, Thread(nullptr)
+{
+	FMemory::Memzero(Header);
+}
+
+FAjaMediaClipInputChannel::~FAjaMediaClipInputChannel()
+{
+	Uninitialize();
+}
+
+bool FAjaMediaClipInputChannel::ReadHeader(const FString& InBaseName, AjaMediaClip::FIndexHeader& OutHeader)
+{
+	TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*(InBaseName + AjaMediaClip::IndexExtension), true));
+	if (!File.IsValid() || !File->Read(reinterpret_cast<uint8*>(&OutHeader), sizeof(OutHeader)))
+	{
+		return false;
+	}
+
+	if (OutHeader.Magic != AjaMediaClip::IndexMagic
+		|| OutHeader.Version != AjaMediaClip::IndexVersion
+		|| OutHeader.HeaderSize < sizeof(AjaMediaClip::FIndexHeader)
+		|| OutHeader.EntrySize < sizeof(AjaMediaClip::FIndexEntry)
+		|| OutHeader.FrameRateNumerator == 0
+		|| OutHeader.FrameRateDenominator == 0)
+	{
+		return false;
+	}
+
+	// The header is only rewritten when the clip is closed
+	const int64 NumEntries = (File->Size() - OutHeader.HeaderSize) / OutHeader.EntrySize;
+	if (OutHeader.NumFrames == 0 || OutHeader.NumFrames > NumEntries)
+	{
+		OutHeader.NumFrames = (uint32)FMath::Max<int64>(NumEntries, 0);
+	}
+	return true;
+}
+
+bool FAjaMediaClipInputChannel::Initialize(const AJA::AJADeviceOptions& InDevice, const AJA::AJAInputOutputChannelOptions& InOptions)
+{
+	using namespace AjaMediaClipInputChannel;
+
+	check(Thread == nullptr);
+	if (InOptions.bOutput || InOptions.CallbackInterface == nullptr)
+	{
+		UE_LOG(LogAjaMedia, Error, TEXT("The AJA clip %s was opened with invalid options."), *BaseName);
+		return false;
+	}
+
+	if (!ReadHeader(BaseName, Header))
+	{
+		UE_LOG(LogAjaMedia, Error, TEXT("The AJA clip %s couldn't be read."), *BaseName);
+		return false;
+	}
+
+	if (InOptions.VideoFormatIndex != Header.VideoFormatIndex || InOptions.PixelFormat != (AJA::EPixelFormat)Header.PixelFormat)
+	{
+		UE_LOG(LogAjaMedia, Error, TEXT("The AJA clip %s was recorded with the video format %d and pixel format %d. It can't be played with the video format %d and pixel format %d.")
+			, *BaseName, Header.VideoFormatIndex, Header.PixelFormat, InOptions.VideoFormatIndex, (int32)InOptions.PixelFormat);
+		return false;
+	}
+
+	Index = new FMappedFile();
+	Video = new FMappedFile();
+	Audio = new FMappedFile();
+	Ancillary = new FMappedFile();
+	if (!Index->Open(BaseName + AjaMediaClip::IndexExtension)
+		|| !Video->Open(BaseName + AjaMediaClip::VideoExtension)
+		|| !Audio->Open(BaseName + AjaMediaClip::AudioExtension)
+		|| !Ancillary->Open(BaseName + AjaMediaClip::AncillaryExtension))
+	{
+		UE_LOG(LogAjaMedia, Error, TEXT("The files of the AJA clip %s couldn't be mapped."), *BaseName);
+		CloseFiles();
+		return false;
+	}
+
+	// The header may have been read while the recorder was still writing
+	const uint64 NumEntries = Index->GetSize() > Header.HeaderSize ? (Index->GetSize() - Header.HeaderSize) / Header.EntrySize : 0;
+	NumFrames = (uint32)FMath::Min<uint64>(Header.NumFrames, NumEntries);
+	for (uint32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+	{
+		if (!IsEntryComplete(GetEntry(FrameIndex)))
+		{
+			UE_LOG(LogAjaMedia, Warning, TEXT("The AJA clip %s is incomplete. Only its first %d frames of %d are played."), *BaseName, FrameIndex, NumFrames);
+			NumFrames = FrameIndex;
+			break;
+		}
+	}
+
+	if (NumFrames == 0)
+	{
+		UE_LOG(LogAjaMedia, Error, TEXT("The AJA clip %s has no frame."), *BaseName);
+		CloseFiles();
+		return false;
+	}
+
+	Options = InOptions;
+	NumReadAheadFrames = (uint32)FMath::Clamp(CVarReadAhead.GetValueOnAnyThread(), 0, 64);
+	FramesDropped = 0;
+	bStopping = false;
+
+	Thread = FRunnableThread::Create(this, TEXT("AjaMediaClipInput"), 0, TPri_TimeCritical);
+	if (Thread == nullptr)
+	{
+		CloseFiles();
+		return false;
+	}
+
+	UE_LOG(LogAjaMedia, Log, TEXT("Playing the AJA clip %s (%d frames%s)."), *BaseName, NumFrames, bAsFastAsPossible ? TEXT(", as fast as possible") : TEXT(""));
+	return true;
+}
+
+void FAjaMediaClipInputChannel::Uninitialize()
+{
+	if (Thread)
+	{
+		FPlatformAtomics::InterlockedExchange(&bStopping, true);
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+	CloseFiles();
+}
+
+bool FAjaMediaClipInputChannel::Reconfigure(const AJA::AJAInputOutputChannelOptions& InOptions)
+{
+	// The format of a clip can't be changed
+	return false;
+}
+
+bool FAjaMediaClipInputChannel::CanReconfigure() const
+{
+	return false;
+}
+
+bool FAjaMediaClipInputChannel::IsCallbackThreadShared() const
+{
+	// Each clip has its own playback thread
+	return false;
+}
+
+uint32 FAjaMediaClipInputChannel::GetFrameDropCount() const
+{
+	return (uint32)FPlatformAtomics::AtomicRead(&FramesDropped);
+}
+
+uint32 FAjaMediaClipInputChannel::Run()
+{
+	Options.CallbackInterface->OnInitializationCompleted(true);
+
+	for (uint32 Ahead = 0; Ahead < NumReadAheadFrames; ++Ahead)
+	{
+		ReadAhead(Ahead);
+	}
+
+	const double FrameDuration = (double)Header.FrameRateDenominator / (double)Header.FrameRateNumerator;
+	const double StartTime = FPlatformTime::Seconds();
+	uint64 FrameNumber = 0;
+	uint64 FrameIndex = 0;
+
+	while (!bStopping)
+	{
+		if (!bAsFastAsPossible)
+		{
+			// The first frame comes one frame after the start, like the first frame of an input
+			FAjaSyncWatcher::SleepUntil(StartTime + (FrameNumber + 1) * FrameDuration);
+			if (bStopping)
+			{
+				break;
+			}
+
+			// When the thread was not scheduled in time, the frames in between are lost
+			const uint64 CurrentFrameNumber = (uint64)((FPlatformTime::Seconds() - StartTime) / FrameDuration);
+			if (CurrentFrameNumber > FrameNumber + 1)
+			{
+				const uint64 NumSkippedFrames = CurrentFrameNumber - FrameNumber - 1;
+				FPlatformAtomics::InterlockedAdd(&FramesDropped, (int32)NumSkippedFrames);
+				FrameNumber += NumSkippedFrames;
+				FrameIndex += NumSkippedFrames;
+			}
+		}
+
+		if (FrameIndex >= NumFrames)
+		{
+			if (!bLoop)
+			{
+				Options.CallbackInterface->OnCompletion(true);
+				break;
+			}
+			FrameIndex %= NumFrames;
+		}
+
+		PlayFrame((uint32)FrameIndex);
+		++FrameNumber;
+		++FrameIndex;
+
+		if (NumReadAheadFrames > 0)
+		{
+			const uint64 AheadIndex = FrameIndex + NumReadAheadFrames - 1;
+			if (AheadIndex < NumFrames || bLoop)
+			{
+				ReadAhead((uint32)(AheadIndex % NumFrames));
+			}
+		}
+	}
+
+	return 0;
+}
+
+void FAjaMediaClipInputChannel::PlayFrame(uint32 InFrameIndex)
+{
+	using namespace AjaMediaClipInputChannel;
+	SCOPE_CYCLE_COUNTER(STAT_AJA_Clip_PlayFrame);
+
+	const AjaMediaClip::FIndexEntry& Entry = GetEntry(InFrameIndex);
+	const bool bIsProgressive = Header.bIsProgressive != 0;
+
+	AJA::AJARequestInputBufferData RequestBuffer;
+	RequestBuffer.bIsProgressivePicture = bIsProgressive;
+	RequestBuffer.AncBufferSize = Options.bUseAncillary ? Entry.AncillarySize : 0;
+	RequestBuffer.AncF2BufferSize = Options.bUseAncillary ? Entry.AncillaryF2Size : 0;
+	RequestBuffer.AudioBufferSize = Options.bUseAudio && Header.NumAudioChannels > 0 ? Entry.AudioSize : 0;
+	RequestBuffer.VideoBufferSize = Options.bUseVideo ? Entry.VideoSize : 0;
+
+	AJA::AJARequestedInputBufferData RequestedBuffer;
+	if (!Options.CallbackInterface->OnRequestInputBuffer(RequestBuffer, RequestedBuffer))
+	{
+		return;
+	}
+
+	AJA::AJAInputFrameData InputFrame;
+	InputFrame.FramesDropped = (uint32)FPlatformAtomics::AtomicRead(&FramesDropped);
+	if (Options.TimecodeFormat != AJA::ETimecodeFormat::TCF_None)
+	{
+		InputFrame.Timecode.Hours = Entry.Hours;
+		InputFrame.Timecode.Minutes = Entry.Minutes;
+		InputFrame.Timecode.Seconds = Entry.Seconds;
+		InputFrame.Timecode.Frames = Entry.Frames;
+	}
+
+	AJA::AJAAncillaryFrameData AncillaryFrame;
+	if (RequestBuffer.AncBufferSize > 0)
+	{
+		AncillaryFrame.AncBuffer = CopyData(RequestedBuffer.AncBuffer, AncBuffer, Ancillary->GetData() + Entry.AncillaryOffset, Entry.AncillarySize);
+		AncillaryFrame.AncBufferSize = Entry.AncillarySize;
+	}
+	if (RequestBuffer.AncF2BufferSize > 0)
+	{
+		AncillaryFrame.AncF2Buffer = CopyData(RequestedBuffer.AncF2Buffer, AncF2Buffer, Ancillary->GetData() + Entry.AncillaryOffset + Entry.AncillarySize, Entry.AncillaryF2Size);
+		AncillaryFrame.AncF2BufferSize = Entry.AncillaryF2Size;
+	}
+
+	AJA::AJAAudioFrameData AudioFrame;
+	if (RequestBuffer.AudioBufferSize > 0)
+	{
+		AudioFrame.AudioBuffer = CopyData(RequestedBuffer.AudioBuffer, AudioBuffer, Audio->GetData() + Entry.AudioOffset, Entry.AudioSize);
+		AudioFrame.AudioBufferSize = Entry.AudioSize;
+		AudioFrame.NumChannels = Header.NumAudioChannels;
+		AudioFrame.AudioRate = Header.AudioSampleRate;
+		AudioFrame.NumSamples = Entry.AudioSize / (Header.NumAudioChannels * sizeof(int32));
+	}
+
+	AJA::AJAVideoFrameData VideoFrame;
+	VideoFrame.VideoFormatIndex = Header.VideoFormatIndex;
+	VideoFrame.Stride = Header.Stride;
+	VideoFrame.Width = Header.Width;
+	VideoFrame.Height = Header.Height;
+	VideoFrame.PixelFormat = (AJA::EPixelFormat)Header.PixelFormat;
+	VideoFrame.bIsProgressivePicture = bIsProgressive;
+	if (RequestBuffer.VideoBufferSize > 0)
+	{
+		VideoFrame.VideoBuffer = CopyData(RequestedBuffer.VideoBuffer, VideoBuffer, Video->GetData() + Entry.VideoOffset, Entry.VideoSize);
+		VideoFrame.VideoBufferSize = Entry.VideoSize;
+	}
+
+	Options.CallbackInterface->OnInputFrameReceived(InputFrame, AncillaryFrame, AudioFrame, VideoFrame);
+}
+
+void FAjaMediaClipInputChannel::ReadAhead(uint32 InFrameIndex) const
+{
+	if (InFrameIndex >= NumFrames)
+	{
+		return;
+	}
+
+	const AjaMediaClip::FIndexEntry& Entry = GetEntry(InFrameIndex);
+	if (Options.bUseVideo)
+	{
+		Video->Prefetch(Entry.VideoOffset, Entry.VideoSize);
+	}
+	if (Options.bUseAudio)
+	{
+		Audio->Prefetch(Entry.AudioOffset, Entry.AudioSize);
+	}
+	if (Options.bUseAncillary)
+	{
+		Ancillary->Prefetch(Entry.AncillaryOffset, (uint64)Entry.AncillarySize + Entry.AncillaryF2Size);
+	}
+}
+
+bool FAjaMediaClipInputChannel::IsEntryComplete(const AjaMediaClip::FIndexEntry& InEntry) const
+{
+	return Video->Contains(InEntry.VideoOffset, InEntry.VideoSize)
+		&& Audio->Contains(InEntry.AudioOffset, InEntry.AudioSize)
+		&& Ancillary->Contains(InEntry.AncillaryOffset, (uint64)InEntry.AncillarySize + InEntry.AncillaryF2Size);
+}
+
+const AjaMediaClip::FIndexEntry& FAjaMediaClipInputChannel::GetEntry(uint32 InFrameIndex) const
+{
+	check(InFrameIndex < NumFrames);
+	return *reinterpret_cast<const AjaMediaClip::FIndexEntry*>(Index->GetData() + Header.HeaderSize + (uint64)InFrameIndex * Header.EntrySize);
+}
+
+void FAjaMediaClipInputChannel::CloseFiles()
+{
+	delete Index;
+	delete Video;
+	delete Audio;
+	delete Ancillary;
+	Index = nullptr;
+	Video = nullptr;
+	Audio = nullptr;
+	Ancillary = nullptr;
+	NumFrames = 0;
+}
@@ -0,0 +1,102 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IAjaDeviceBackend.h"
+
+#include "AjaMediaClip.h"
+#include "HAL/Runnable.h"
+
+class FRunnableThread;
+
+namespace AjaMediaClipInputChannel
+{
+	class FMappedFile;
+}
+
+/**
+ * Input channel that replays a clip recorded by FAjaMediaRecorder. The player uses it in place of the channel of a device.
+ *
+ * The frames go through OnRequestInputBuffer and OnInputFrameReceived like the frames of a card, with the timecode, audio and
+ * ancillary data that were recorded with them, so everything after the channel runs as it would on the stage.
+ * The files are memory mapped. The OS is asked to read the next frames while the current one is delivered.
+ * The frames are delivered at the frame rate of the clip, losing the ones that are late like a card does, or as fast as the player takes them.
+ * The format of the channel must be the format of the clip, the frames are not converted.
+ */
+class FAjaMediaClipInputChannel
+	: public IAjaInputChannel
+	, private FRunnable
+{
+public:
+
+	/**
+	 * @param InBaseName Path of the files of the clip, without their extension.
+	 * @param bInLoop Play the clip again from its first frame once it ends. Otherwise the channel completes.
+	 * @param bInAsFastAsPossible Deliver every frame as soon as the previous one was received, instead of at the frame rate of the clip.
+	 */
+	FAjaMediaClipInputChannel(const FString& InBaseName, bool bInLoop, bool bInAsFastAsPossible);
+	virtual ~FAjaMediaClipInputChannel();
+
+	/**
+	 * Read the format of a clip. The number of frames of a clip that was not closed is taken from the size of its index.
+	 * @return false if the index is missing or is not a clip.
+	 */
+	static bool ReadHeader(const FString& InBaseName, AjaMediaClip::FIndexHeader& OutHeader);
+
+	//~ IAjaInputChannel interface
+	virtual bool Initialize(const AJA::AJADeviceOptions& InDevice, const AJA::AJAInputOutputChannelOptions& InOptions) override;
+	virtual void Uninitialize() override;
+	virtual bool Reconfigure(const AJA::AJAInputOutputChannelOptions& InOptions) override;
+	virtual bool CanReconfigure() const override;
+	virtual bool IsCallbackThreadShared() const override;
+	virtual uint32 GetFrameDropCount() const override;
+
+private:
+
+	//~ FRunnable interface
+	virtual uint32 Run() override;
+
+	/** Deliver a frame to the callback. Only called by the playback thread. */
+	void PlayFrame(uint32 InFrameIndex);
+
+	/** Ask the OS to read the data of a frame that will be delivered soon. */
+	void ReadAhead(uint32 InFrameIndex) const;
+
+	/** @return whether the data of the entry is in the files. The last frames of a clip that was not closed may be missing. */
+	bool IsEntryComplete(const AjaMediaClip::FIndexEntry& InEntry) const;
+
+	const AjaMediaClip::FIndexEntry& GetEntry(uint32 InFrameIndex) const;
+
+	/** Unmap the files. */
+	void CloseFiles();
+
+private:
+
+	FString BaseName;
+	bool bLoop;
+	bool bAsFastAsPossible;
+
+	AJA::AJAInputOutputChannelOptions Options;
+	AjaMediaClip::FIndexHeader Header;
+
+	/** Number of frames that can be played, the frames of the index that have their data in the files. */
+	uint32 NumFrames;
+
+	/** Number of frames read ahead of the delivered one. */
+	uint32 NumReadAheadFrames;
+
+	AjaMediaClipInputChannel::FMappedFile* Index;
+	AjaMediaClipInputChannel::FMappedFile* Video;
+	AjaMediaClipInputChannel::FMappedFile* Audio;
+	AjaMediaClipInputChannel::FMappedFile* Ancillary;
+
+	/** Used when the callback doesn't provide its own buffers. The mapped files can't be written. */
+	TArray<uint8> VideoBuffer;
+	TArray<uint8> AudioBuffer;
+	TArray<uint8> AncBuffer;
+	TArray<uint8> AncF2Buffer;
+
+	volatile int32 FramesDropped;
+	volatile int32 bStopping;
+	FRunnableThread* Thread;
+};
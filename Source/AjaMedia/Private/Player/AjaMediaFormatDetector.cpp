@@ -0,0 +1,84 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaFormatDetector.h"
+
+#include "Aja.h"
+#include "AjaMediaPrivate.h"
+#include "IAjaDeviceBackend.h"
+
+#include "HAL/PlatformAtomics.h"
+
+/* FAjaMediaFormatDetector implementation
+*****************************************************************************/
+FAjaMediaFormatDetector::FAjaMediaFormatDetector()
+	: Channel(nullptr)
+	, DeviceIndex(INDEX_NONE)
+	, PortIndex(0)
+	, DetectedFormat(AjaMediaOption::DefaultVideoFormat)
+	, Status((int32)EStatus::Idle)
+{ }
+
+FAjaMediaFormatDetector::~FAjaMediaFormatDetector()
+{
+	Stop();
+}
+
+bool FAjaMediaFormatDetector::Start(int32 InDeviceIndex, uint32 InPortIndex)
+{
+	Stop();
+
+	if (!FAja::IsInitialized())
+	{
+		FPlatformAtomics::InterlockedExchange(&Status, (int32)EStatus::Failed);
+		return false;
+	}
+
+	DeviceIndex = InDeviceIndex;
+	PortIndex = InPortIndex;
+	FPlatformAtomics::InterlockedExchange(&Status, (int32)EStatus::Detecting);
+
+	Channel = FAja::GetDeviceBackend()->CreateAutoDetectChannel();
+	if (!Channel->Initialize(this))
+	{
+		UE_LOG(LogAjaMedia, Warning, TEXT("The format of the signal on the AJA port %d of device %d couldn't be detected. The auto-detect channel couldn't be initialized."), PortIndex, DeviceIndex);
+		delete Channel;
+		Channel = nullptr;
+		FPlatformAtomics::InterlockedExchange(&Status, (int32)EStatus::Failed);
+		return false;
+	}
+
+	return true;
+}
+
+void FAjaMediaFormatDetector::Stop()
+{
+	if (Channel)
+	{
+		Channel->Uninitialize(); // this may block, until the completion of the callback
+		delete Channel;
+		Channel = nullptr;
+	}
+
+	FPlatformAtomics::InterlockedExchange(&Status, (int32)EStatus::Idle);
+}
+
+void FAjaMediaFormatDetector::OnCompletion(bool bSucceed)
+{
+	// Called from the detection thread. The channel data is complete once the callback is invoked.
+	if (bSucceed && Channel)
+	{
+		const int32 NumChannelData = Channel->GetNumOfChannelData();
+		for (int32 Index = 0; Index < NumChannelData; ++Index)
+		{
+			const AJA::AJAAutoDetectChannel::AutoDetectChannelData ChannelData = Channel->GetChannelData(Index);
+			if ((int32)ChannelData.DeviceIndex == DeviceIndex && ChannelData.ChannelIndex == PortIndex)
+			{
+				DetectedFormat = ChannelData.DetectedVideoFormat;
+				FPlatformAtomics::InterlockedExchange(&Status, (int32)EStatus::Detected);
+				return;
+			}
+		}
+	}
+
+	FPlatformAtomics::InterlockedExchange(&Status, (int32)EStatus::Failed);
+}
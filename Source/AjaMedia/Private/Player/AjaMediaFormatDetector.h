@@ -0,0 +1,60 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AJALib.h"
+
+class IAjaAutoDetectChannel;
+
+/**
+ * Detects the video format of the signal on an input port, with the auto-detect channel of the device.
+ *
+ * The detection runs on a thread owned by the backend. The game thread polls the status and stops the detector once it's done.
+ */
+class FAjaMediaFormatDetector
+	: private AJA::IAJAAutoDectectCallbackInterface
+{
+public:
+
+	enum class EStatus : int32
+	{
+		Idle,
+		Detecting,
+		Detected,
+		Failed,
+	};
+
+	FAjaMediaFormatDetector();
+	virtual ~FAjaMediaFormatDetector();
+
+	/**
+	 * Start detecting the format of the signal on a port. Stops the previous detection.
+	 * @return false if the auto-detect channel couldn't be initialized.
+	 */
+	bool Start(int32 InDeviceIndex, uint32 InPortIndex);
+
+	/** Release the auto-detect channel. May block until the completion callback returns. */
+	void Stop();
+
+	EStatus GetStatus() const { return (EStatus)FPlatformAtomics::AtomicRead(&Status); }
+
+	/** @return the format of the signal. Only valid when the status is Detected. */
+	AJA::FAJAVideoFormat GetDetectedFormat() const { return DetectedFormat; }
+
+private:
+
+	//~ IAJAAutoDectectCallbackInterface interface
+	virtual void OnCompletion(bool bSucceed) override;
+
+private:
+
+	IAjaAutoDetectChannel* Channel;
+	int32 DeviceIndex;
+	uint32 PortIndex;
+
+	/** Written by the detection thread before the status is published */
+	AJA::FAJAVideoFormat DetectedFormat;
+	volatile int32 Status;
+};
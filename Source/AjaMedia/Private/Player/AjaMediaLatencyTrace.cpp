@@ -0,0 +1,178 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaLatencyTrace.h"
+
+#include "AjaMediaPrivate.h"
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformAtomics.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/Timecode.h"
+
+namespace AjaMediaLatencyTrace
+{
+	/** About a minute of 8 inputs at 60Hz. */
+	static const uint32 NumRecords = 32 * 1024;
+
+	struct FRecord
+	{
+		volatile int32 TraceId;
+		int32 InputId;
+		FTimecode Timecode;
+		uint64 Cycles[(int32)EAjaMediaLatencyStage::Num];
+	};
+
+	static FRecord Records[NumRecords];
+	static volatile int32 LastTraceId = 0;
+
+	static TArray<FString> InputNames;
+	static FCriticalSection InputNamesCriticalSection;
+
+	static const TCHAR* StageNames[] =
+	{
+		TEXT("DMA"),
+		TEXT("Process"),
+		TEXT("Queued"),
+		TEXT("Render"),
+	};
+	static_assert(UE_ARRAY_COUNT(StageNames) == (int32)EAjaMediaLatencyStage::Num - 1, "Every interval between 2 stages needs a name.");
+
+	static TAutoConsoleVariable<int32> CVarAjaTraceEnable(
+		TEXT("Aja.Trace.Enable"),
+		0,
+		TEXT("Record the latency of every frame captured by the AJA inputs. Dump the records with Aja.Trace.Dump."),
+		ECVF_Default);
+
+	static FAutoConsoleCommand AjaTraceDumpCmd(
+		TEXT("Aja.Trace.Dump"),
+		TEXT("Write the AJA input latency records to a Chrome trace file. Optional argument: the file name."),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const FString Filename = Args.Num() > 0 ? Args[0] : FPaths::ProfilingDir() / FString::Printf(TEXT("AjaLatency-%s.json"), *FDateTime::Now().ToString());
+			if (FAjaMediaLatencyTrace::DumpChromeTrace(Filename))
+			{
+				UE_LOG(LogAjaMedia, Display, TEXT("AJA latency trace written to '%s'."), *Filename);
+			}
+			else
+			{
+				UE_LOG(LogAjaMedia, Error, TEXT("Couldn't write the AJA latency trace to '%s'."), *Filename);
+			}
+		}));
+}
+
+/* FAjaMediaLatencyTrace implementation
+*****************************************************************************/
+bool FAjaMediaLatencyTrace::IsEnabled()
+{
+	return AjaMediaLatencyTrace::CVarAjaTraceEnable.GetValueOnAnyThread() != 0;
+}
+
+int32 FAjaMediaLatencyTrace::RegisterInput(const FString& InName)
+{
+	FScopeLock Lock(&AjaMediaLatencyTrace::InputNamesCriticalSection);
+	return AjaMediaLatencyTrace::InputNames.Add(InName);
+}
+
+uint32 FAjaMediaLatencyTrace::BeginFrame(int32 InInputId)
+{
+	if (!IsEnabled())
+	{
+		return InvalidTraceId;
+	}
+
+	uint32 TraceId = (uint32)FPlatformAtomics::InterlockedIncrement(&AjaMediaLatencyTrace::LastTraceId);
+	if (TraceId == InvalidTraceId)
+	{
+		TraceId = (uint32)FPlatformAtomics::InterlockedIncrement(&AjaMediaLatencyTrace::LastTraceId);
+	}
+
+	// Invalidate the record first, so late stamps of the frame it held are ignored
+	AjaMediaLatencyTrace::FRecord& Record = AjaMediaLatencyTrace::Records[TraceId % AjaMediaLatencyTrace::NumRecords];
+	FPlatformAtomics::AtomicStore(&Record.TraceId, (int32)InvalidTraceId);
+	Record.InputId = InInputId;
+	Record.Timecode = FTimecode();
+	FMemory::Memzero(Record.Cycles);
+	Record.Cycles[(int32)EAjaMediaLatencyStage::RequestBuffer] = FPlatformTime::Cycles64();
+	FPlatformAtomics::AtomicStore(&Record.TraceId, (int32)TraceId);
+
+	return TraceId;
+}
+
+void FAjaMediaLatencyTrace::SetTimecode(uint32 InTraceId, const AJA::FTimecode& InTimecode)
+{
+	if (InTraceId != InvalidTraceId)
+	{
+		AjaMediaLatencyTrace::FRecord& Record = AjaMediaLatencyTrace::Records[InTraceId % AjaMediaLatencyTrace::NumRecords];
+		if ((uint32)FPlatformAtomics::AtomicRead(&Record.TraceId) == InTraceId)
+		{
+			Record.Timecode = FTimecode(InTimecode.Hours, InTimecode.Minutes, InTimecode.Seconds, InTimecode.Frames, false);
+		}
+	}
+}
+
+void FAjaMediaLatencyTrace::Stamp(uint32 InTraceId, EAjaMediaLatencyStage InStage)
+{
+	if (InTraceId != InvalidTraceId)
+	{
+		AjaMediaLatencyTrace::FRecord& Record = AjaMediaLatencyTrace::Records[InTraceId % AjaMediaLatencyTrace::NumRecords];
+		if ((uint32)FPlatformAtomics::AtomicRead(&Record.TraceId) == InTraceId)
+		{
+			Record.Cycles[(int32)InStage] = FPlatformTime::Cycles64();
+		}
+	}
+}
+
+bool FAjaMediaLatencyTrace::DumpChromeTrace(const FString& InFilename)
+{
+	TArray<FString> Names;
+	{
+		FScopeLock Lock(&AjaMediaLatencyTrace::InputNamesCriticalSection);
+		Names = AjaMediaLatencyTrace::InputNames;
+	}
+
+	const double MicrosecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1000000.0;
+
+	FString Json = TEXT("{\"traceEvents\":[\n");
+	for (int32 InputId = 0; InputId < Names.Num(); ++InputId)
+	{
+		Json += FString::Printf(TEXT("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n"), InputId, *Names[InputId].ReplaceCharWithEscapedChar());
+	}
+
+	// The records are copied as they are. A record that is overwritten while dumping only produces a wrong event.
+	for (uint32 Index = 0; Index < AjaMediaLatencyTrace::NumRecords; ++Index)
+	{
+		const AjaMediaLatencyTrace::FRecord Record = AjaMediaLatencyTrace::Records[Index];
+		if ((uint32)Record.TraceId == InvalidTraceId)
+		{
+			continue;
+		}
+
+		const FString Timecode = Record.Timecode.ToString();
+		for (int32 Stage = 0; Stage < (int32)EAjaMediaLatencyStage::Num - 1; ++Stage)
+		{
+			const uint64 Begin = Record.Cycles[Stage];
+			const uint64 End = Record.Cycles[Stage + 1];
+			if (Begin == 0 || End < Begin)
+			{
+				break;
+			}
+
+			Json += FString::Printf(TEXT("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u,\"timecode\":\"%s\"}},\n")
+				, AjaMediaLatencyTrace::StageNames[Stage]
+				, Record.InputId
+				, Begin * MicrosecondsPerCycle
+				, (End - Begin) * MicrosecondsPerCycle
+				, (uint32)Record.TraceId
+				, *Timecode);
+		}
+	}
+
+	Json.RemoveFromEnd(TEXT(",\n"));
+	Json += TEXT("\n]}\n");
+
+	return FFileHelper::SaveStringToFile(Json, *InFilename);
+}
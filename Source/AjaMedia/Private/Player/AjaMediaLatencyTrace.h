@@ -0,0 +1,64 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AJALib.h"
+
+/** Steps of a captured frame, from the device to the texture. */
+enum class EAjaMediaLatencyStage : uint8
+{
+	/** The device requests the buffers of a new frame. This is right after the vertical interrupt, before the DMA. */
+	RequestBuffer,
+	/** The DMA is completed and OnInputFrameReceived is entered. */
+	FrameReceived,
+	/** The sample is in the player queue. */
+	Enqueued,
+	/** The sample was fetched by the game thread. */
+	Dequeued,
+	/** The render thread read the sample buffer to upload the texture. */
+	Uploaded,
+
+	Num
+};
+
+/**
+ * Per-frame latency records of every AJA input.
+ *
+ * Records are kept in a fixed ring that is written without lock from the AJA, game and render threads.
+ * Enable with Aja.Trace.Enable 1 and write the ring to a Chrome trace file (chrome://tracing) with Aja.Trace.Dump.
+ */
+class FAjaMediaLatencyTrace
+{
+public:
+	/** Trace id of the frames that are not traced. */
+	static const uint32 InvalidTraceId = 0;
+
+	/** @return true if frames should be traced. */
+	static bool IsEnabled();
+
+	/**
+	 * Register an input. The name is used to label the input in the dump.
+	 * @return the id of the input.
+	 */
+	static int32 RegisterInput(const FString& InName);
+
+	/**
+	 * Start the record of a new frame and stamp the RequestBuffer stage.
+	 * @return the trace id of the frame, or InvalidTraceId if tracing is disabled.
+	 */
+	static uint32 BeginFrame(int32 InInputId);
+
+	/** Tag the frame with its timecode. */
+	static void SetTimecode(uint32 InTraceId, const AJA::FTimecode& InTimecode);
+
+	/** Stamp a stage of the frame with the current time. Does nothing if the record was recycled. */
+	static void Stamp(uint32 InTraceId, EAjaMediaLatencyStage InStage);
+
+	/**
+	 * Write the records to a Chrome trace file.
+	 * @return true if the file was written.
+	 */
+	static bool DumpChromeTrace(const FString& InFilename);
+};
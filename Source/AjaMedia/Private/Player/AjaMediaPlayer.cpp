@@ -4,9 +4,10 @@
 #include "AjaMediaPrivate.h"
 
 #include "AJA.h"
-#include "MediaIOCoreEncodeTime.h"
+#include "AjaDeviceCatalog.h"
+#include "AjaMediaTimecodeBurnIn.h"
+#include "IAjaDeviceBackend.h"
 #include "MediaIOCoreFileWriter.h"
-#include "MediaIOCoreSamples.h"
 
 #include "HAL/PlatformAtomics.h"
 #include "HAL/PlatformProcess.h"
@@ -15,8 +16,16 @@
 #include "Misc/ScopeLock.h"
 #include "Stats/Stats2.h"
 
+#include "AjaMediaAncillaryDemux.h"
 #include "AjaMediaAudioSample.h"
 #include "AjaMediaBinarySample.h"
+#include "AjaMediaClip.h"
+#include "AjaMediaClipInputChannel.h"
+#include "AjaMediaFormatDetector.h"
+#include "AjaMediaLatencyTrace.h"
+#include "AjaMediaLog.h"
+#include "AjaMediaRecorder.h"
+#include "AjaMediaSamples.h"
 #include "AjaMediaSettings.h"
 #include "AjaMediaTextureSample.h"
 
@@ -26,11 +35,69 @@
 
 DECLARE_CYCLE_STAT(TEXT("AJA MediaPlayer Request frame"), STAT_AJA_MediaPlayer_RequestFrame, STATGROUP_Media);
 DECLARE_CYCLE_STAT(TEXT("AJA MediaPlayer Process frame"), STAT_AJA_MediaPlayer_ProcessFrame, STATGROUP_Media);
+DECLARE_CYCLE_STAT(TEXT("AJA MediaPlayer Demux ancillary"), STAT_AJA_MediaPlayer_DemuxAncillary, STATGROUP_Media);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AJA MediaPlayer Copied video frames"), STAT_AJA_MediaPlayer_CopiedVideoFrames, STATGROUP_Media);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AJA MediaPlayer Callback allocations"), STAT_AJA_MediaPlayer_CallbackAllocations, STATGROUP_Media);
 
 namespace AjaMediaPlayerConst
 {
 	static const uint32 ModeNameBufferSize = 64;
 	static const int32 ToleratedExtraMaxBufferCount = 2;
+
+	/** Size of the ancillary buffer of a field the device requests by default. */
+	static const uint32 DefaultAncillaryBufferSize = 8 * 1024;
+	static const uint32 AudioSampleRate = 48000;
+}
+
+namespace AjaMediaPlayer
+{
+	/**
+	 * Request the buffer of a sample on the AJA thread.
+	 * The pools are warmed up at open, so any allocation here is a miss that is counted.
+	 */
+	template<typename SampleType>
+	void* RequestSampleBuffer(SampleType& InSample, uint32 InBufferSize, int32& InOutAllocationCount)
+	{
+		if (InBufferSize > InSample.GetBufferCapacity())
+		{
+			INC_DWORD_STAT(STAT_AJA_MediaPlayer_CallbackAllocations);
+			FPlatformAtomics::InterlockedIncrement(&InOutAllocationCount);
+		}
+		return InSample.RequestBuffer(InBufferSize);
+	}
+
+	/** Acquire every sample that can be in flight, give each of them a touched buffer of the size class, and return them to the pool. */
+	template<typename PoolType>
+	void WarmUpPool(PoolType& InPool, int32 InNumSamples, uint32 InBufferSize)
+	{
+		using FSampleRef = decltype(InPool.AcquireShared());
+
+		TArray<FSampleRef> WarmSamples;
+		WarmSamples.Reserve(InNumSamples);
+		for (int32 Index = 0; Index < InNumSamples; ++Index)
+		{
+			FSampleRef Sample = InPool.AcquireShared();
+			if (InBufferSize > 0)
+			{
+				// Touch every page, so they are faulted in now and on the NUMA node of the calling thread
+				FMemory::Memzero(Sample->RequestBuffer(InBufferSize), InBufferSize);
+			}
+			WarmSamples.Add(Sample);
+		}
+		// The samples go back to the pool with their buffer
+	}
+
+	/** Format of the frames, as given to the timecode burn-in by OnInputFrameReceived. */
+	EMediaIOCoreEncodePixelFormat GetEncodePixelFormat(AJA::EPixelFormat InPixelFormat)
+	{
+		switch (InPixelFormat)
+		{
+		case AJA::EPixelFormat::PF_8BIT_YCBCR: return EMediaIOCoreEncodePixelFormat::CharUYVY;
+		case AJA::EPixelFormat::PF_10BIT_RGB: return EMediaIOCoreEncodePixelFormat::A2B10G10R10;
+		case AJA::EPixelFormat::PF_10BIT_YCBCR: return EMediaIOCoreEncodePixelFormat::YUVv210;
+		default: return EMediaIOCoreEncodePixelFormat::CharBGRA;
+		}
+	}
 }
 
 bool bAjaWriteOutputRawDataCmdEnable = false;
@@ -40,6 +107,12 @@ static FAutoConsoleCommand AjaWriteOutputRawDataCmd(
 	FConsoleCommandDelegate::CreateLambda([]() { bAjaWriteOutputRawDataCmdEnable = true; })
 	);
 
+static TAutoConsoleVariable<int32> CVarAjaReuseInputChannel(
+	TEXT("Aja.Player.ReuseInputChannel"),
+	1,
+	TEXT("Keep the AJA input channel open when a player is closed. If the same port is opened right after, the channel switches to the new format in place instead of being opened again."),
+	ECVF_Default);
+
 /* FAjaVideoPlayer structors
  *****************************************************************************/
 
@@ -48,6 +121,9 @@ FAjaMediaPlayer::FAjaMediaPlayer(IMediaEventSink& InEventSink)
 	, AudioSamplePool(new FAjaMediaAudioSamplePool)
 	, MetadataSamplePool(new FAjaMediaBinarySamplePool)
 	, TextureSamplePool(new FAjaMediaTextureSamplePool)
+	, OddFieldSamplePool(new FAjaMediaTextureSamplePool)
+	, MediaSamples(new FAjaMediaSamples)
+	, AncillaryDemux(new FAjaMediaAncillaryDemux)
 	, MaxNumAudioFrameBuffer(8)
 	, MaxNumMetadataFrameBuffer(8)
 	, MaxNumVideoFrameBuffer(8)
@@ -59,6 +135,10 @@ FAjaMediaPlayer::FAjaMediaPlayer(IMediaEventSink& InEventSink)
 	, AjaThreadAutoCirculateAudioFrameDropCount(0)
 	, AjaThreadAutoCirculateMetadataFrameDropCount(0)
 	, AjaThreadAutoCirculateVideoFrameDropCount(0)
+	, AjaThreadCopiedVideoFrameCount(0)
+	, AjaThreadAllocationCount(0)
+	, TraceInputId(INDEX_NONE)
+	, AjaThreadCurrentTraceId(FAjaMediaLatencyTrace::InvalidTraceId)
 	, LastFrameDropCount(0)
 	, PreviousFrameDropCount(0)
 	, bEncodeTimecodeInTexel(false)
@@ -69,15 +149,48 @@ FAjaMediaPlayer::FAjaMediaPlayer(IMediaEventSink& InEventSink)
 	, bUseVideo(false)
 	, bVerifyFrameDropCount(true)
 	, InputChannel(nullptr)
+	, InputPortIndex(0)
+	, InputTransportType(AJA::ETransportType::TT_SdiSingle)
+	, bSamplePoolsFilled(false)
+	, PooledVideoFormatIndex(AjaMediaOption::DefaultVideoFormat)
+	, PooledPixelFormat(AJA::EPixelFormat::PF_8BIT_YCBCR)
+	, PooledNumAudioChannels(0)
+	, PooledDeviceIndex(INDEX_NONE)
+	, PooledNumVideoSamples(0)
+	, PooledNumAudioSamples(0)
+	, PooledNumMetadataSamples(0)
+	, ReusableInputChannel(nullptr)
+	, ReusableDeviceIndex(INDEX_NONE)
+	, ReusablePortIndex(0)
+	, ReusableTransportType(AJA::ETransportType::TT_SdiSingle)
+	, InputOptions(TEXT("MediaPlayer"), 1)
+	, bAutoDetectFormat(false)
+	, bDetectingAfterFailure(false)
+	, FormatDetector(new FAjaMediaFormatDetector)
+	, bLoopClip(false)
+	, bPlayClipAsFastAsPossible(false)
+	, Recorder(new FAjaMediaRecorder)
+	, AjaThreadSignalChanged(0)
+	, AjaThreadInputFailed(0)
+	, LastVideoFormatIndex(AjaMediaOption::DefaultVideoFormat)
+	, LastPixelFormat(AJA::EPixelFormat::PF_8BIT_YCBCR)
+	, LastNumAudioChannels(8)
+	, DeviceIndex(0)
 { }
 
 
 FAjaMediaPlayer::~FAjaMediaPlayer()
 {
 	Close();
+	ReleaseReusableInputChannel();
 	delete AudioSamplePool;
 	delete MetadataSamplePool;
 	delete TextureSamplePool;
+	delete OddFieldSamplePool;
+	delete MediaSamples;
+	delete AncillaryDemux;
+	delete FormatDetector;
+	delete Recorder;
 }
 
 
@@ -96,7 +209,7 @@ bool FAjaMediaPlayer::Open(const FString& Url, const IMediaOptions* Options)
 		return false;
 	}
 
-	AJA::AJADeviceOptions DeviceOptions(Options->GetMediaOption(AjaMediaOption::DeviceIndex, (int64)0));
+	DeviceIndex = Options->GetMediaOption(AjaMediaOption::DeviceIndex, (int64)0);
 
 	// Read options
 	AJA::AJAInputOutputChannelOptions AjaOptions(TEXT("MediaPlayer"), Options->GetMediaOption(AjaMediaOption::PortIndex, (int64)0));
@@ -147,7 +260,7 @@ bool FAjaMediaPlayer::Open(const FString& Url, const IMediaOptions* Options)
 	}
 	{
 		AjaOptions.VideoFormatIndex = Options->GetMediaOption(AjaMediaOption::AjaVideoFormat, (int64)0);
-		LastVideoFormatIndex = AjaOptions.VideoFormatIndex;
+		bAutoDetectFormat = Options->GetMediaOption(AjaMediaOption::AutoDetectFormat, false);
 	}
 	{
 		const EAjaMediaSourceColorFormat ColorFormat = (EAjaMediaSourceColorFormat)(Options->GetMediaOption(AjaMediaOption::ColorFormat, (int64)EAjaMediaSourceColorFormat::YUV2_8bit));
@@ -190,22 +303,59 @@ bool FAjaMediaPlayer::Open(const FString& Url, const IMediaOptions* Options)
 		AjaOptions.BurnTimecodePercentY = 80;
 	}
 
+	// A recorded clip is played in place of the device input, in the format it was recorded with
+	ClipBaseName.Reset();
+	if (AjaMediaClip::ParseUrl(Url, ClipBaseName))
+	{
+		AjaMediaClip::FIndexHeader ClipHeader;
+		if (!FAjaMediaClipInputChannel::ReadHeader(ClipBaseName, ClipHeader))
+		{
+			UE_LOG(LogAjaMedia, Warning, TEXT("The AjaMediaPlayer can't open URL '%s' because it isn't a valid AJA clip."), *Url);
+			ClipBaseName.Reset();
+			return false;
+		}
+
+		AjaOptions.VideoFormatIndex = ClipHeader.VideoFormatIndex;
+		AjaOptions.PixelFormat = (AJA::EPixelFormat)ClipHeader.PixelFormat;
+		if (ClipHeader.NumAudioChannels > 0)
+		{
+			AjaOptions.NumberOfAudioChannel = ClipHeader.NumAudioChannels;
+		}
+		bAutoDetectFormat = false;
+		bLoopClip = Options->GetMediaOption(AjaMediaOption::ClipLoop, false);
+		bPlayClipAsFastAsPossible = Options->GetMediaOption(AjaMediaOption::ClipAsFastAsPossible, false);
+	}
+
+	LastPixelFormat = AjaOptions.PixelFormat;
+	LastNumAudioChannels = AjaOptions.NumberOfAudioChannel;
+
+	ThreadSettings.bOverrideAffinity = Options->GetMediaOption(AjaMediaOption::ThreadOverrideAffinity, false);
+	ThreadSettings.AffinityMask = Options->GetMediaOption(AjaMediaOption::ThreadAffinityMask, (int64)0);
+	ThreadSettings.Priority = (EAjaMediaThreadPriority)Options->GetMediaOption(AjaMediaOption::ThreadPriority, (int64)EAjaMediaThreadPriority::Default);
+	ThreadSettings.bNumaLocalAllocation = Options->GetMediaOption(AjaMediaOption::NumaLocalAllocation, false);
+	ThreadSettings.NumaNode = Options->GetMediaOption(AjaMediaOption::NumaNode, (int64)INDEX_NONE);
+
 	bVerifyFrameDropCount = Options->GetMediaOption(AjaMediaOption::LogDropFrame, true);
 	MaxNumAudioFrameBuffer = Options->GetMediaOption(AjaMediaOption::MaxAudioFrameBuffer, (int64)8);
 	MaxNumMetadataFrameBuffer = Options->GetMediaOption(AjaMediaOption::MaxAncillaryFrameBuffer, (int64)8);
 	MaxNumVideoFrameBuffer = Options->GetMediaOption(AjaMediaOption::MaxVideoFrameBuffer, (int64)8);
 
-	check(InputChannel == nullptr);
-	InputChannel = new AJA::AJAInputChannel();
-	if (!InputChannel->Initialize(DeviceOptions, AjaOptions))
+	// Room for the tolerated extra samples, plus the odd field of an interlaced frame
+	MediaSamples->Initialize(MaxNumAudioFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount
+		, MaxNumMetadataFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount
+		, MaxNumVideoFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount + 1);
+
+	if (TraceInputId == INDEX_NONE)
 	{
-		UE_LOG(LogAjaMedia, Warning, TEXT("The AJA port couldn't be opened."));
-		CurrentState = EMediaState::Error;
-		AjaThreadNewState = EMediaState::Error;
-		delete InputChannel;
-		InputChannel = nullptr;
+		TraceInputId = FAjaMediaLatencyTrace::RegisterInput(Url);
 	}
 
+	AncillaryDemux->Open(Url);
+
+	InputPortIndex = AjaOptions.ChannelIndex;
+	InputTransportType = AjaOptions.TransportType;
+	InputOptions = AjaOptions;
+
 	// configure format information for base class
 	AudioTrackFormat.BitsPerSample = 32;
 	AudioTrackFormat.NumChannels = 0;
@@ -217,23 +367,58 @@ bool FAjaMediaPlayer::Open(const FString& Url, const IMediaOptions* Options)
 	AjaThreadNewState = EMediaState::Preparing;
 	EventSink.ReceiveMediaEvent(EMediaEvent::MediaConnecting);
 
+	if (bAutoDetectFormat)
+	{
+		// The input is opened by TickInput, once the format of the signal is known
+		bDetectingAfterFailure = false;
+		StartFormatDetection();
+	}
+	else
+	{
+		OpenInputChannel();
+	}
+
 	return true;
 }
 
 void FAjaMediaPlayer::Close()
 {
-	AjaThreadNewState = EMediaState::Closed;
+	FormatDetector->Stop();
+	FPlatformAtomics::InterlockedExchange(&AjaThreadSignalChanged, 0);
+	FPlatformAtomics::InterlockedExchange(&AjaThreadInputFailed, 0);
+
+	// Only a channel that is capturing, with a backend that can switch it to another format, is kept. The others would keep their port busy for nothing.
+	const bool bKeepInputChannel = InputChannel && InputChannel->CanReconfigure() && AjaThreadNewState == EMediaState::Playing && ClipBaseName.IsEmpty() && CVarAjaReuseInputChannel.GetValueOnGameThread() != 0;
+	{
+		// Once the state is changed, the callbacks return right away
+		FScopeLock Lock(&AjaThreadCallbackCriticalSection);
+		AjaThreadNewState = EMediaState::Closed;
+	}
 
 	if (InputChannel)
 	{
-		InputChannel->Uninitialize(); // this may block, until the completion of a callback from IAJAChannelCallbackInterface
-		delete InputChannel;
+		if (bKeepInputChannel)
+		{
+			ReleaseReusableInputChannel();
+			ReusableInputChannel = InputChannel;
+			ReusableDeviceIndex = DeviceIndex;
+			ReusablePortIndex = InputPortIndex;
+			ReusableTransportType = InputTransportType;
+		}
+		else
+		{
+			InputChannel->Uninitialize(); // this may block, until the completion of a callback from IAJAChannelCallbackInterface
+			delete InputChannel;
+		}
 		InputChannel = nullptr;
 	}
 
-	AudioSamplePool->Reset();
-	MetadataSamplePool->Reset();
-	TextureSamplePool->Reset();
+	// No frame comes anymore, the clip is finished
+	Recorder->Stop();
+
+	MediaSamples->FlushSamples();
+
+	// The buffers are kept for the next open of the port, with or without the channel. They are released by the next tick if the player stays closed.
 
 	AjaThreadCurrentAncSample.Reset();
 	AjaThreadCurrentAncF2Sample.Reset();
@@ -251,6 +436,12 @@ FName FAjaMediaPlayer::GetPlayerName() const
 }
 
 
+IMediaSamples& FAjaMediaPlayer::GetSamples()
+{
+	return *MediaSamples;
+}
+
+
 FString FAjaMediaPlayer::GetStats() const
 {
 	FString Stats;
@@ -274,7 +465,8 @@ FString FAjaMediaPlayer::GetStats() const
 
 	if (bUseVideo)
 	{
-		Stats += FString::Printf(TEXT("		Buffered video frames: %d\n"), GetSamples().NumVideoSamples());
+		Stats += FString::Printf(TEXT("		Buffered video frames: %d\n"), MediaSamples->NumVideoSamples());
+		Stats += FString::Printf(TEXT("		Copied video frames: %d\n"), AjaThreadCopiedVideoFrameCount);
 	}
 	else
 	{
@@ -283,13 +475,24 @@ FString FAjaMediaPlayer::GetStats() const
 	
 	if (bUseAudio)
 	{
-		Stats += FString::Printf(TEXT("		Buffered audio frames: %d\n"), GetSamples().NumAudioSamples());
+		Stats += FString::Printf(TEXT("		Buffered audio frames: %d\n"), MediaSamples->NumAudioSamples());
 	}
 	else
 	{
 		Stats += FString::Printf(TEXT("		Buffered audio frames: Not enabled\n"));
 	}
 	
+	if (bUseAncillary)
+	{
+		Stats += FString::Printf(TEXT("		Buffered ancillary frames: %d\n"), MediaSamples->NumMetadataSamples());
+		Stats += FString::Printf(TEXT("		Ancillary packets parsed: %u, delivered: %u\n"), AncillaryDemux->GetNumParsedPackets(), AncillaryDemux->GetNumDeliveredPackets());
+	}
+	else
+	{
+		Stats += FString::Printf(TEXT("		Buffered ancillary frames: Not enabled\n"));
+	}
+
+	Stats += Recorder->GetStats();
 	Stats += FString::Printf(TEXT("		Frames dropped: %d"), LastFrameDropCount);
 
 	return Stats;
@@ -308,6 +511,32 @@ void FAjaMediaPlayer::TickFetch(FTimespan DeltaTime, FTimespan /*Timecode*/)
 
 void FAjaMediaPlayer::TickInput(FTimespan DeltaTime, FTimespan Timecode)
 {
+	if (bAutoDetectFormat)
+	{
+		const bool bSignalChanged = FPlatformAtomics::InterlockedExchange(&AjaThreadSignalChanged, 0) != 0;
+		const bool bInputFailed = FPlatformAtomics::InterlockedExchange(&AjaThreadInputFailed, 0) != 0;
+		if ((bSignalChanged || bInputFailed) && CurrentState != EMediaState::Closed && CurrentState != EMediaState::Error)
+		{
+			UE_LOG(LogAjaMedia, Log, TEXT("The signal of the AJA input %s changed. Detecting its format."), *GetUrl());
+			bDetectingAfterFailure = !bSignalChanged;
+			StartFormatDetection();
+		}
+
+		TickFormatDetection();
+	}
+
+	// The player was closed and not opened again right after. A channel kept while the format is detected is switched to it.
+	if (ReusableInputChannel && FormatDetector->GetStatus() == FAjaMediaFormatDetector::EStatus::Idle)
+	{
+		ReleaseReusableInputChannel();
+	}
+
+	// Same for the buffers of the pools, when the player stayed closed
+	if (bSamplePoolsFilled && CurrentState == EMediaState::Closed && InputChannel == nullptr && ReusableInputChannel == nullptr)
+	{
+		ResetSamplePools();
+	}
+
 	// update player state
 	EMediaState NewState = AjaThreadNewState;
 	
@@ -332,46 +561,297 @@ void FAjaMediaPlayer::TickInput(FTimespan DeltaTime, FTimespan Timecode)
 		return;
 	}
 
+	// The samples held by the recorder queue are added to the pools by the writer thread, from the NUMA node of the card
+	if (Recorder->Tick())
+	{
+		const AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = FAja::GetDeviceBackend()->GetVideoFormat(LastVideoFormatIndex);
+		const AJA::EPixelFormat PixelFormat = LastPixelFormat;
+		const int32 NumAudioChannels = LastNumAudioChannels;
+		Recorder->Start(GetUrl(), [this, Descriptor, PixelFormat, NumAudioChannels]()
+		{
+			if (ThreadSettings.bNumaLocalAllocation)
+			{
+				ThreadSettings.ApplyAffinityToCurrentThread(DeviceIndex);
+			}
+
+			if (Descriptor.bIsValid)
+			{
+				int32 NumVideoSamples = 0;
+				int32 NumAudioSamples = 0;
+				int32 NumMetadataSamples = 0;
+				GetNumSamplesInFlight(Descriptor, true, NumVideoSamples, NumAudioSamples, NumMetadataSamples);
+				WarmUpSamplePools(Descriptor, PixelFormat, NumAudioChannels, NumVideoSamples, NumAudioSamples, NumMetadataSamples);
+			}
+		});
+	}
+
 	TickTimeManagement();
 }
 
 
 /* FAjaMediaPlayer implementation
  *****************************************************************************/
-void FAjaMediaPlayer::ProcessFrame()
+void FAjaMediaPlayer::PreallocateSamples(AJA::FAJAVideoFormat InVideoFormatIndex, AJA::EPixelFormat InPixelFormat, int32 InNumAudioChannels)
 {
-	if (CurrentState == EMediaState::Playing)
+	const AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = FAja::GetDeviceBackend()->GetVideoFormat(InVideoFormatIndex);
+	if (!Descriptor.bIsValid)
 	{
-		// No need to lock here. That info is only used for debug information.
-		AudioTrackFormat.NumChannels = AjaThreadAudioChannels;
-		AudioTrackFormat.SampleRate = AjaThreadAudioSampleRate;
+		return;
+	}
+
+	int32 NumVideoSamples = 0;
+	int32 NumAudioSamples = 0;
+	int32 NumMetadataSamples = 0;
+	GetNumSamplesInFlight(Descriptor, Recorder->IsRecording(), NumVideoSamples, NumAudioSamples, NumMetadataSamples);
+
+	// The pools kept by Close already hold the buffers of this format, on the NUMA node of the same device
+	if (bSamplePoolsFilled && PooledDeviceIndex == DeviceIndex && PooledVideoFormatIndex == InVideoFormatIndex && PooledPixelFormat == InPixelFormat && PooledNumAudioChannels == InNumAudioChannels
+		&& PooledNumVideoSamples >= NumVideoSamples && PooledNumAudioSamples >= NumAudioSamples && PooledNumMetadataSamples >= NumMetadataSamples)
+	{
+		return;
 	}
+
+	WarmUpSamplePools(Descriptor, InPixelFormat, InNumAudioChannels, NumVideoSamples, NumAudioSamples, NumMetadataSamples);
+
+	bSamplePoolsFilled = true;
+	PooledDeviceIndex = DeviceIndex;
+	PooledVideoFormatIndex = InVideoFormatIndex;
+	PooledPixelFormat = InPixelFormat;
+	PooledNumAudioChannels = InNumAudioChannels;
+	PooledNumVideoSamples = NumVideoSamples;
+	PooledNumAudioSamples = NumAudioSamples;
+	PooledNumMetadataSamples = NumMetadataSamples;
 }
 
-void FAjaMediaPlayer::VerifyFrameDropCount()
+void FAjaMediaPlayer::GetNumSamplesInFlight(const AJA::AJAVideoFormats::VideoFormatDescriptor& InDescriptor, bool bInRecording, int32& OutNumVideoSamples, int32& OutNumAudioSamples, int32& OutNumMetadataSamples) const
 {
-	//Verify if a buffer is in overflow state. Popping samples MUST be done from the GameThread to respect single consumer
+	// Every sample that can be in flight: the buffered ones, the tolerated extra ones, the one being filled by the device and the ones waiting to be recorded.
+	const int32 NumRecordedSamples = bInRecording ? (int32)Recorder->GetQueueCapacity() : 0;
+	OutNumVideoSamples = bUseVideo ? MaxNumVideoFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount + 1 + NumRecordedSamples : 0;
+	OutNumAudioSamples = bUseAudio && InDescriptor.FrameRateNumerator > 0 ? MaxNumAudioFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount + 1 + NumRecordedSamples : 0;
+	// One ring per field
+	OutNumMetadataSamples = bUseAncillary ? (MaxNumMetadataFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount + 1 + NumRecordedSamples) * 2 : 0;
+}
 
-	//Anc buffer
-	int32 MetaDataOverflowCount = FMath::Max(Samples->NumMetadataSamples() - MaxNumMetadataFrameBuffer, 0);
-	for (int32 i = 0; i < MetaDataOverflowCount; ++i)
+void FAjaMediaPlayer::WarmUpSamplePools(const AJA::AJAVideoFormats::VideoFormatDescriptor& InDescriptor, AJA::EPixelFormat InPixelFormat, int32 InNumAudioChannels, int32 InNumVideoSamples, int32 InNumAudioSamples, int32 InNumMetadataSamples)
+{
+	if (InNumVideoSamples > 0)
 	{
-		Samples->PopMetadata();
+		// An interlaced frame is a single sample, its odd field is a view into the same buffer.
+		const uint32 FrameSize = FAja::GetStride(InPixelFormat, InDescriptor.ResolutionWidth) * InDescriptor.ResolutionHeight;
+		AjaMediaPlayer::WarmUpPool(*TextureSamplePool, InNumVideoSamples, FrameSize);
+		if (!InDescriptor.bIsProgressiveStandard)
+		{
+			AjaMediaPlayer::WarmUpPool(*OddFieldSamplePool, InNumVideoSamples, 0);
+		}
 	}
 
-	//Audio buffer
-	int32 AudioOverflowCount = FMath::Max(Samples->NumAudioSamples() - MaxNumAudioFrameBuffer, 0);
-	for (int32 i = 0; i < AudioOverflowCount; ++i)
+	if (InNumAudioSamples > 0)
 	{
-		Samples->PopAudio();
+		// The number of audio samples per frame alternates for fractional frame rates, use the biggest
+		const uint32 NumAudioSamplesPerFrame = FMath::DivideAndRoundUp<uint64>((uint64)AjaMediaPlayerConst::AudioSampleRate * InDescriptor.FrameRateDenominator, InDescriptor.FrameRateNumerator);
+		const uint32 AudioBufferSize = NumAudioSamplesPerFrame * InNumAudioChannels * sizeof(int32);
+		AjaMediaPlayer::WarmUpPool(*AudioSamplePool, InNumAudioSamples, AudioBufferSize);
 	}
 
-	//Video buffer
-	int32 VideoOverflowCount = FMath::Max(Samples->NumVideoSamples() - MaxNumVideoFrameBuffer, 0);
-	for (int32 i = 0; i < VideoOverflowCount; ++i)
+	if (InNumMetadataSamples > 0)
 	{
-		Samples->PopVideo();
+		AjaMediaPlayer::WarmUpPool(*MetadataSamplePool, InNumMetadataSamples, AjaMediaPlayerConst::DefaultAncillaryBufferSize);
 	}
+}
+
+void FAjaMediaPlayer::ReleaseReusableInputChannel()
+{
+	if (ReusableInputChannel)
+	{
+		ReusableInputChannel->Uninitialize(); // this may block, until the completion of a callback from IAJAChannelCallbackInterface
+		delete ReusableInputChannel;
+		ReusableInputChannel = nullptr;
+	}
+}
+
+void FAjaMediaPlayer::ResetSamplePools()
+{
+	AudioSamplePool->Reset();
+	MetadataSamplePool->Reset();
+	TextureSamplePool->Reset();
+	OddFieldSamplePool->Reset();
+	bSamplePoolsFilled = false;
+}
+
+void FAjaMediaPlayer::OpenInputChannel()
+{
+	LastVideoFormatIndex = InputOptions.VideoFormatIndex;
+
+	if (bEncodeTimecodeInTexel && bUseVideo)
+	{
+		// Build the timecode stamps while the channel opens, not on the first frames
+		const AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = FAja::GetDeviceBackend()->GetVideoFormat(InputOptions.VideoFormatIndex);
+		FAjaMediaTimecodeBurnIn::Prepare(AjaMediaPlayer::GetEncodePixelFormat(InputOptions.PixelFormat), Descriptor.ResolutionWidth, Descriptor.ResolutionHeight);
+	}
+
+	// Switch the channel kept by Close in place, when it's the same port. No frame is lost to the teardown of the channel.
+	bool bPreallocated = false;
+	bool bReconfigured = false;
+	check(InputChannel == nullptr);
+	if (ReusableInputChannel)
+	{
+		if (ClipBaseName.IsEmpty() && ReusableDeviceIndex == DeviceIndex && ReusablePortIndex == InputPortIndex && ReusableTransportType == InputTransportType)
+		{
+			// The pool buffers that are big enough for the new format are kept
+			PreallocateSamples(InputOptions.VideoFormatIndex, InputOptions.PixelFormat, InputOptions.NumberOfAudioChannel);
+			bPreallocated = true;
+
+			if (ReusableInputChannel->Reconfigure(InputOptions))
+			{
+				InputChannel = ReusableInputChannel;
+				ReusableInputChannel = nullptr;
+				bReconfigured = true;
+				UE_LOG(LogAjaMedia, Verbose, TEXT("The AJA input %s was switched to the new format without being closed."), *GetUrl());
+			}
+		}
+
+		if (ReusableInputChannel)
+		{
+			ReusableInputChannel->Uninitialize(); // this may block, until the completion of a callback from IAJAChannelCallbackInterface
+			delete ReusableInputChannel;
+			ReusableInputChannel = nullptr;
+		}
+	}
+
+	if (bReconfigured)
+	{
+		// The channel is already running, OnInitializationCompleted won't be called again. The next frame is in the new format.
+		LastFrameDropCount = InputChannel->GetFrameDropCount();
+		AjaThreadNewState = EMediaState::Playing;
+		return;
+	}
+
+	AJA::AJADeviceOptions DeviceOptions(DeviceIndex);
+	if (ClipBaseName.IsEmpty())
+	{
+		InputChannel = FAja::GetDeviceBackend()->CreateInputChannel();
+	}
+	else
+	{
+		InputChannel = new FAjaMediaClipInputChannel(ClipBaseName, bLoopClip, bPlayClipAsFastAsPossible);
+	}
+
+	// NUMA-local buffers are allocated by the capture thread, once it runs on the node of the card. MediaOpened is only sent after that.
+	// A thread that services other inputs is not moved, and the buffers are allocated here so the other inputs don't wait for them.
+	const bool bAllocateOnCaptureThread = ThreadSettings.bNumaLocalAllocation && !InputChannel->IsCallbackThreadShared();
+	if (!bAllocateOnCaptureThread && !bPreallocated)
+	{
+		PreallocateSamples(InputOptions.VideoFormatIndex, InputOptions.PixelFormat, InputOptions.NumberOfAudioChannel);
+	}
+
+	if (!InputChannel->Initialize(DeviceOptions, InputOptions))
+	{
+		UE_LOG(LogAjaMedia, Warning, TEXT("The AJA port couldn't be opened."));
+		AjaThreadNewState = EMediaState::Error;
+		delete InputChannel;
+		InputChannel = nullptr;
+	}
+}
+
+void FAjaMediaPlayer::StartFormatDetection()
+{
+	if (InputChannel)
+	{
+		{
+			// Once the state is changed, the callbacks return right away
+			FScopeLock Lock(&AjaThreadCallbackCriticalSection);
+			AjaThreadNewState = EMediaState::Preparing;
+		}
+
+		ReleaseReusableInputChannel();
+		if (InputChannel->CanReconfigure() && CVarAjaReuseInputChannel.GetValueOnGameThread() != 0)
+		{
+			ReusableInputChannel = InputChannel;
+			ReusableDeviceIndex = DeviceIndex;
+			ReusablePortIndex = InputPortIndex;
+			ReusableTransportType = InputTransportType;
+		}
+		else
+		{
+			InputChannel->Uninitialize(); // this may block, until the completion of a callback from IAJAChannelCallbackInterface
+			delete InputChannel;
+		}
+		InputChannel = nullptr;
+
+		// The samples of the previous format are not presented
+		MediaSamples->FlushSamples();
+	}
+
+	if (!FormatDetector->Start(DeviceIndex, InputPortIndex))
+	{
+		AjaThreadNewState = EMediaState::Error;
+	}
+}
+
+void FAjaMediaPlayer::TickFormatDetection()
+{
+	const FAjaMediaFormatDetector::EStatus Status = FormatDetector->GetStatus();
+	if (Status == FAjaMediaFormatDetector::EStatus::Failed)
+	{
+		FormatDetector->Stop();
+		UE_LOG(LogAjaMedia, Warning, TEXT("The format of the signal on the AJA input %s couldn't be detected."), *GetUrl());
+		AjaThreadNewState = EMediaState::Error;
+	}
+	else if (Status == FAjaMediaFormatDetector::EStatus::Detected)
+	{
+		const AJA::FAJAVideoFormat DetectedFormat = FormatDetector->GetDetectedFormat();
+		FormatDetector->Stop();
+
+		if (bDetectingAfterFailure && DetectedFormat == InputOptions.VideoFormatIndex)
+		{
+			UE_LOG(LogAjaMedia, Warning, TEXT("The AJA input %s stopped, but the format of its signal didn't change."), *GetUrl());
+			AjaThreadNewState = EMediaState::Error;
+			return;
+		}
+
+		// The card may detect a format that it can't capture
+		const FAjaDeviceCatalog::FSnapshotRef Devices = FAjaDeviceCatalog::Get();
+		const FAjaDeviceCatalog::FDevice* Device = Devices->FindDevice(DeviceIndex);
+		const AJA::AJAVideoFormats::VideoFormatDescriptor* Descriptor = Device ? Device->Formats.FindByPredicate([DetectedFormat](const AJA::AJAVideoFormats::VideoFormatDescriptor& Format) { return Format.VideoFormatIndex == DetectedFormat; }) : nullptr;
+		if (Descriptor == nullptr || !Descriptor->bIsValid)
+		{
+			UE_LOG(LogAjaMedia, Warning, TEXT("The signal on the AJA input %s has the format %d, which the device doesn't support."), *GetUrl(), DetectedFormat);
+			AjaThreadNewState = EMediaState::Error;
+			return;
+		}
+
+		const FMediaIOMode MediaMode = FAja::ConvertVideoFormat2MediaMode(*Descriptor);
+		VideoFrameRate = MediaMode.FrameRate;
+		VideoTrackFormat.Dim = MediaMode.Resolution;
+		VideoTrackFormat.FrameRate = VideoFrameRate.AsDecimal();
+		VideoTrackFormat.FrameRates = TRange<float>(VideoTrackFormat.FrameRate);
+		VideoTrackFormat.TypeName = MediaMode.GetModeName().ToString();
+		UE_LOG(LogAjaMedia, Log, TEXT("Detected the format %s on the AJA input %s."), *VideoTrackFormat.TypeName, *GetUrl());
+
+		InputOptions.VideoFormatIndex = DetectedFormat;
+		OpenInputChannel();
+	}
+}
+
+void FAjaMediaPlayer::ProcessFrame()
+{
+	if (CurrentState == EMediaState::Playing)
+	{
+		// No need to lock here. That info is only used for debug information.
+		AudioTrackFormat.NumChannels = AjaThreadAudioChannels;
+		AudioTrackFormat.SampleRate = AjaThreadAudioSampleRate;
+	}
+}
+
+void FAjaMediaPlayer::VerifyFrameDropCount()
+{
+	//Verify if a buffer is in overflow state. Trimming MUST be done from the GameThread, it is the single consumer of the rings
+
+	int32 AudioOverflowCount = 0;
+	int32 MetaDataOverflowCount = 0;
+	int32 VideoOverflowCount = 0;
+	MediaSamples->Trim(MaxNumAudioFrameBuffer, MaxNumMetadataFrameBuffer, MaxNumVideoFrameBuffer, AudioOverflowCount, MetaDataOverflowCount, VideoOverflowCount);
 
 	if (bVerifyFrameDropCount)
 	{
@@ -383,12 +863,12 @@ void FAjaMediaPlayer::VerifyFrameDropCount()
 			static const int32 NumMaxFrameBeforeWarning = 50;
 			if (PreviousFrameDropCount % NumMaxFrameBeforeWarning == 0)
 			{
-				UE_LOG(LogAjaMedia, Warning, TEXT("Loosing frames on AJA input %s. The current count is %d."), *GetUrl(), PreviousFrameDropCount);
+				AJA_LOG_ASYNC(LogAjaMedia, Warning, TEXT("Loosing frames on AJA input %s. The current count is %d."), *GetUrl(), PreviousFrameDropCount);
 			}
 		}
 		else if (PreviousFrameDropCount > 0)
 		{
-			UE_LOG(LogAjaMedia, Warning, TEXT("Lost %d frames on input %s. UE4 frame rate is too slow and the capture card was not able to send the frame(s) to UE4."), PreviousFrameDropCount, *GetUrl());
+			AJA_LOG_ASYNC(LogAjaMedia, Warning, TEXT("Lost %d frames on input %s. UE4 frame rate is too slow and the capture card was not able to send the frame(s) to UE4."), PreviousFrameDropCount, *GetUrl());
 			PreviousFrameDropCount = 0;
 		}
 		LastFrameDropCount = FrameDropCount;
@@ -396,19 +876,19 @@ void FAjaMediaPlayer::VerifyFrameDropCount()
 		MetaDataOverflowCount += FPlatformAtomics::InterlockedExchange(&AjaThreadAutoCirculateMetadataFrameDropCount, 0);
 		if (MetaDataOverflowCount > 0)
 		{
-			UE_LOG(LogAjaMedia, Warning, TEXT("Lost %d metadata frames on input %s. Frame rate is either too slow or buffering capacity is too small."), MetaDataOverflowCount, *GetUrl());
+			AJA_LOG_ASYNC(LogAjaMedia, Warning, TEXT("Lost %d metadata frames on input %s. Frame rate is either too slow or buffering capacity is too small."), MetaDataOverflowCount, *GetUrl());
 		}
 
 		AudioOverflowCount += FPlatformAtomics::InterlockedExchange(&AjaThreadAutoCirculateAudioFrameDropCount, 0);
 		if (AudioOverflowCount > 0)
 		{
-			UE_LOG(LogAjaMedia, Warning, TEXT("Lost %d audio frames on input %s. Frame rate is either too slow or buffering capacity is too small."), AudioOverflowCount, *GetUrl());
+			AJA_LOG_ASYNC(LogAjaMedia, Warning, TEXT("Lost %d audio frames on input %s. Frame rate is either too slow or buffering capacity is too small."), AudioOverflowCount, *GetUrl());
 		}
 
 		VideoOverflowCount += FPlatformAtomics::InterlockedExchange(&AjaThreadAutoCirculateVideoFrameDropCount, 0);
 		if (bVerifyFrameDropCount && VideoOverflowCount > 0)
 		{
-			UE_LOG(LogAjaMedia, Warning, TEXT("Lost %d video frames on input %s. Frame rate is either too slow or buffering capacity is too small."), VideoOverflowCount, *GetUrl());
+			AJA_LOG_ASYNC(LogAjaMedia, Warning, TEXT("Lost %d video frames on input %s. Frame rate is either too slow or buffering capacity is too small."), VideoOverflowCount, *GetUrl());
 		}
 	}
 }
@@ -422,6 +902,17 @@ void FAjaMediaPlayer::OnInitializationCompleted(bool bSucceed)
 	if (bSucceed)
 	{
 		LastFrameDropCount = InputChannel->GetFrameDropCount();
+
+		// The thread settings are for the thread of this input only, the buffers were allocated by OpenInputChannel otherwise
+		if (!InputChannel->IsCallbackThreadShared())
+		{
+			const int32 NumaNode = ThreadSettings.ApplyToCurrentThread(DeviceIndex);
+			if (ThreadSettings.bNumaLocalAllocation)
+			{
+				UE_LOG(LogAjaMedia, Verbose, TEXT("Allocating the sample buffers of input %s on NUMA node %d."), *GetUrl(), NumaNode);
+				PreallocateSamples(LastVideoFormatIndex, LastPixelFormat, LastNumAudioChannels);
+			}
+		}
 	}
 	AjaThreadNewState = bSucceed ? EMediaState::Playing : EMediaState::Error;
 }
@@ -429,6 +920,14 @@ void FAjaMediaPlayer::OnInitializationCompleted(bool bSucceed)
 
 void FAjaMediaPlayer::OnCompletion(bool bSucceed)
 {
+	// The card stops the input when the signal doesn't match its format anymore. The format is detected again.
+	if (!bSucceed && bAutoDetectFormat && AjaThreadNewState == EMediaState::Playing)
+	{
+		FPlatformAtomics::InterlockedExchange(&AjaThreadInputFailed, 1);
+		AjaThreadNewState = EMediaState::Preparing;
+		return;
+	}
+
 	AjaThreadNewState = bSucceed ? EMediaState::Closed : EMediaState::Error;
 }
 
@@ -437,18 +936,18 @@ bool FAjaMediaPlayer::OnRequestInputBuffer(const AJA::AJARequestInputBufferData&
 {
 	SCOPE_CYCLE_COUNTER(STAT_AJA_MediaPlayer_RequestFrame);
 
-	// Do not request a video buffer if the frame is interlaced. We need 2 samples and we need to process them.
-	//We would be able when we have a de-interlacer on the GPU.
-
+	FScopeLock Lock(&AjaThreadCallbackCriticalSection);
 	if (AjaThreadNewState != EMediaState::Playing)
 	{
 		return false;
 	}
 
+	AjaThreadCurrentTraceId = FAjaMediaLatencyTrace::BeginFrame(TraceInputId);
+
 	// Anc Field 1
 	if (bUseAncillary && InRequestBuffer.AncBufferSize > 0)
 	{
-		const int32 NumMetadataSamples = Samples->NumMetadataSamples();
+		const int32 NumMetadataSamples = MediaSamples->NumMetadataSamples();
 		if (NumMetadataSamples >= MaxNumMetadataFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount)
 		{
 			if (bVerifyFrameDropCount)
@@ -459,14 +958,14 @@ bool FAjaMediaPlayer::OnRequestInputBuffer(const AJA::AJARequestInputBufferData&
 		else
 		{
 			AjaThreadCurrentAncSample = MetadataSamplePool->AcquireShared();
-			OutRequestedBuffer.AncBuffer = reinterpret_cast<uint8_t*>(AjaThreadCurrentAncSample->RequestBuffer(InRequestBuffer.AncBufferSize));
+			OutRequestedBuffer.AncBuffer = reinterpret_cast<uint8_t*>(AjaMediaPlayer::RequestSampleBuffer(*AjaThreadCurrentAncSample, InRequestBuffer.AncBufferSize, AjaThreadAllocationCount));
 		}
 	}
 
 	// Anc Field 2
 	if (bUseAncillary && InRequestBuffer.AncF2BufferSize > 0)
 	{
-		const int32 NumMetadataSamples = Samples->NumMetadataSamples();
+		const int32 NumMetadataSamples = MediaSamples->NumMetadataSamples();
 		if (NumMetadataSamples >= MaxNumMetadataFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount)
 		{
 			if (bVerifyFrameDropCount)
@@ -477,14 +976,14 @@ bool FAjaMediaPlayer::OnRequestInputBuffer(const AJA::AJARequestInputBufferData&
 		else
 		{
 			AjaThreadCurrentAncF2Sample = MetadataSamplePool->AcquireShared();
-			OutRequestedBuffer.AncBuffer = reinterpret_cast<uint8_t*>(AjaThreadCurrentAncF2Sample->RequestBuffer(InRequestBuffer.AncF2BufferSize));
+			OutRequestedBuffer.AncF2Buffer = reinterpret_cast<uint8_t*>(AjaMediaPlayer::RequestSampleBuffer(*AjaThreadCurrentAncF2Sample, InRequestBuffer.AncF2BufferSize, AjaThreadAllocationCount));
 		}
 	}
 
 	// Audio
 	if (bUseAudio && InRequestBuffer.AudioBufferSize > 0)
 	{
-		const int32 NumAudioSamples = Samples->NumAudioSamples();
+		const int32 NumAudioSamples = MediaSamples->NumAudioSamples();
 		if (NumAudioSamples >= MaxNumAudioFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount)
 		{
 			if (bVerifyFrameDropCount)
@@ -495,14 +994,15 @@ bool FAjaMediaPlayer::OnRequestInputBuffer(const AJA::AJARequestInputBufferData&
 		else
 		{
 			AjaThreadCurrentAudioSample = AudioSamplePool->AcquireShared();
-			OutRequestedBuffer.AudioBuffer = reinterpret_cast<uint8_t*>(AjaThreadCurrentAudioSample->RequestBuffer(InRequestBuffer.AudioBufferSize));
+			OutRequestedBuffer.AudioBuffer = reinterpret_cast<uint8_t*>(AjaMediaPlayer::RequestSampleBuffer(*AjaThreadCurrentAudioSample, InRequestBuffer.AudioBufferSize, AjaThreadAllocationCount));
 		}
 	}
 
 	// Video
-	if (bUseVideo && InRequestBuffer.VideoBufferSize > 0 && InRequestBuffer.bIsProgressivePicture)
+	// An interlaced frame is captured in a single sample and split in 2 fields without copy.
+	if (bUseVideo && InRequestBuffer.VideoBufferSize > 0)
 	{
-		const int32 NumVideoSamples = Samples->NumVideoSamples();
+		const int32 NumVideoSamples = MediaSamples->NumVideoSamples() + (!InRequestBuffer.bIsProgressivePicture ? 1 : 0);
 		if (NumVideoSamples >= MaxNumVideoFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount)
 		{
 			if (bVerifyFrameDropCount)
@@ -513,7 +1013,7 @@ bool FAjaMediaPlayer::OnRequestInputBuffer(const AJA::AJARequestInputBufferData&
 		else
 		{
 			AjaThreadCurrentTextureSample = TextureSamplePool->AcquireShared();
-			OutRequestedBuffer.VideoBuffer = reinterpret_cast<uint8_t*>(AjaThreadCurrentTextureSample->RequestBuffer(InRequestBuffer.VideoBufferSize));
+			OutRequestedBuffer.VideoBuffer = reinterpret_cast<uint8_t*>(AjaMediaPlayer::RequestSampleBuffer(*AjaThreadCurrentTextureSample, InRequestBuffer.VideoBufferSize, AjaThreadAllocationCount));
 		}
 	}
 
@@ -525,13 +1025,34 @@ bool FAjaMediaPlayer::OnInputFrameReceived(const AJA::AJAInputFrameData& InInput
 {
 	SCOPE_CYCLE_COUNTER(STAT_AJA_MediaPlayer_ProcessFrame);
 
+	FScopeLock Lock(&AjaThreadCallbackCriticalSection);
 	if (AjaThreadNewState != EMediaState::Playing)
 	{
 		return false;
 	}
 
+	// The signal changed format. The frame is dropped and the format is detected again.
+	if (bAutoDetectFormat && InVideoFrame.VideoFormatIndex != LastVideoFormatIndex)
+	{
+		FPlatformAtomics::InterlockedExchange(&AjaThreadSignalChanged, 1);
+		AjaThreadNewState = EMediaState::Preparing;
+
+		AjaThreadCurrentAncSample.Reset();
+		AjaThreadCurrentAncF2Sample.Reset();
+		AjaThreadCurrentAudioSample.Reset();
+		AjaThreadCurrentTextureSample.Reset();
+		AjaThreadCurrentTraceId = FAjaMediaLatencyTrace::InvalidTraceId;
+		return false;
+	}
+
 	AjaThreadFrameDropCount = InInputFrame.FramesDropped;
 
+	// The samples given to the player are also given to the recorder
+	FAjaMediaRecorder::FFrame RecordedFrame;
+
+	FAjaMediaLatencyTrace::Stamp(AjaThreadCurrentTraceId, EAjaMediaLatencyStage::FrameReceived);
+	FAjaMediaLatencyTrace::SetTimecode(AjaThreadCurrentTraceId, InInputFrame.Timecode);
+
 	FTimespan DecodedTime = FTimespan::FromSeconds(GetPlatformSeconds());
 	FTimespan DecodedTimeF2 = DecodedTime + FTimespan::FromSeconds(VideoFrameRate.AsInterval());
 
@@ -569,16 +1090,23 @@ bool FAjaMediaPlayer::OnInputFrameReceived(const AJA::AJAInputFrameData& InInput
 	// Anc Field 1
 	if (bUseAncillary && InAncillaryFrame.AncBuffer)
 	{
+		{
+			// Parsed once for every subscription, even when the binary sample is dropped
+			SCOPE_CYCLE_COUNTER(STAT_AJA_MediaPlayer_DemuxAncillary);
+			AncillaryDemux->Demux(InAncillaryFrame.AncBuffer, InAncillaryFrame.AncBufferSize, DecodedTime, DecodedTimecode);
+		}
+
 		if (AjaThreadCurrentAncSample.IsValid())
 		{
 			if (AjaThreadCurrentAncSample->SetProperties(DecodedTime, VideoFrameRate, DecodedTimecode))
 			{
-				Samples->AddMetadata(AjaThreadCurrentAncSample.ToSharedRef());
+				MediaSamples->AddAncillary(AjaThreadCurrentAncSample.ToSharedRef());
+				RecordedFrame.Ancillary = AjaThreadCurrentAncSample;
 			}
 		}
 		else
 		{
-			const int32 NumMetadataSamples = Samples->NumMetadataSamples();
+			const int32 NumMetadataSamples = MediaSamples->NumMetadataSamples();
 			if (NumMetadataSamples >= MaxNumMetadataFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount)
 			{
 				FPlatformAtomics::InterlockedIncrement(&AjaThreadAutoCirculateMetadataFrameDropCount);
@@ -586,9 +1114,11 @@ bool FAjaMediaPlayer::OnInputFrameReceived(const AJA::AJAInputFrameData& InInput
 			else
 			{
 				auto MetaDataSample = MetadataSamplePool->AcquireShared();
+				AjaMediaPlayer::RequestSampleBuffer(*MetaDataSample, InAncillaryFrame.AncBufferSize, AjaThreadAllocationCount);
 				if (MetaDataSample->Initialize(InAncillaryFrame.AncBuffer, InAncillaryFrame.AncBufferSize, DecodedTime, VideoFrameRate, DecodedTimecode))
 				{
-					Samples->AddMetadata(MetaDataSample);
+					MediaSamples->AddAncillary(MetaDataSample);
+					RecordedFrame.Ancillary = MetaDataSample;
 				}
 			}
 		}
@@ -597,16 +1127,22 @@ bool FAjaMediaPlayer::OnInputFrameReceived(const AJA::AJAInputFrameData& InInput
 	// Anc Field 2
 	if (bUseAncillary && InAncillaryFrame.AncF2Buffer && !InVideoFrame.bIsProgressivePicture)
 	{
+		{
+			SCOPE_CYCLE_COUNTER(STAT_AJA_MediaPlayer_DemuxAncillary);
+			AncillaryDemux->Demux(InAncillaryFrame.AncF2Buffer, InAncillaryFrame.AncF2BufferSize, DecodedTimeF2, DecodedTimecodeF2);
+		}
+
 		if (AjaThreadCurrentAncF2Sample.IsValid())
 		{
 			if (AjaThreadCurrentAncF2Sample->SetProperties(DecodedTimeF2, VideoFrameRate, DecodedTimecodeF2))
 			{
-				Samples->AddMetadata(AjaThreadCurrentAncF2Sample.ToSharedRef());
+				MediaSamples->AddAncillaryF2(AjaThreadCurrentAncF2Sample.ToSharedRef());
+				RecordedFrame.AncillaryF2 = AjaThreadCurrentAncF2Sample;
 			}
 		}
 		else
 		{
-			const int32 NumMetadataSamples = Samples->NumMetadataSamples();
+			const int32 NumMetadataSamples = MediaSamples->NumMetadataSamples();
 			if (NumMetadataSamples >= MaxNumMetadataFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount)
 			{
 				FPlatformAtomics::InterlockedIncrement(&AjaThreadAutoCirculateMetadataFrameDropCount);
@@ -614,9 +1150,11 @@ bool FAjaMediaPlayer::OnInputFrameReceived(const AJA::AJAInputFrameData& InInput
 			else
 			{
 				auto MetaDataSample = MetadataSamplePool->AcquireShared();
+				AjaMediaPlayer::RequestSampleBuffer(*MetaDataSample, InAncillaryFrame.AncF2BufferSize, AjaThreadAllocationCount);
 				if (MetaDataSample->Initialize(InAncillaryFrame.AncF2Buffer, InAncillaryFrame.AncF2BufferSize, DecodedTimeF2, VideoFrameRate, DecodedTimecodeF2))
 				{
-					Samples->AddMetadata(MetaDataSample);
+					MediaSamples->AddAncillaryF2(MetaDataSample);
+					RecordedFrame.AncillaryF2 = MetaDataSample;
 				}
 			}
 		}
@@ -629,7 +1167,8 @@ bool FAjaMediaPlayer::OnInputFrameReceived(const AJA::AJAInputFrameData& InInput
 		{
 			if (AjaThreadCurrentAudioSample->SetProperties(InAudioFrame.AudioBufferSize / sizeof(int32), InAudioFrame.NumChannels, InAudioFrame.AudioRate, DecodedTime, DecodedTimecode))
 			{
-				Samples->AddAudio(AjaThreadCurrentAudioSample.ToSharedRef());
+				MediaSamples->AddAudio(AjaThreadCurrentAudioSample.ToSharedRef());
+				RecordedFrame.Audio = AjaThreadCurrentAudioSample;
 			}
 
 			AjaThreadAudioChannels = AjaThreadCurrentAudioSample->GetChannels();
@@ -637,16 +1176,18 @@ bool FAjaMediaPlayer::OnInputFrameReceived(const AJA::AJAInputFrameData& InInput
 		}
 		else
 		{
-			if (Samples->NumAudioSamples() >= MaxNumAudioFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount)
+			if (MediaSamples->NumAudioSamples() >= MaxNumAudioFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount)
 			{
 				FPlatformAtomics::InterlockedIncrement(&AjaThreadAutoCirculateAudioFrameDropCount);
 			}
 			else
 			{
 				auto AudioSample = AudioSamplePool->AcquireShared();
+				AjaMediaPlayer::RequestSampleBuffer(*AudioSample, InAudioFrame.AudioBufferSize, AjaThreadAllocationCount);
 				if (AudioSample->Initialize(InAudioFrame, DecodedTime, DecodedTimecode))
 				{
-					Samples->AddAudio(AudioSample);
+					MediaSamples->AddAudio(AudioSample);
+					RecordedFrame.Audio = AudioSample;
 				}
 
 				AjaThreadAudioChannels = AudioSample->GetChannels();
@@ -689,8 +1230,7 @@ bool FAjaMediaPlayer::OnInputFrameReceived(const AJA::AJAInputFrameData& InInput
 		if (bEncodeTimecodeInTexel && DecodedTimecode.IsSet() && InVideoFrame.bIsProgressivePicture)
 		{
 			FTimecode SetTimecode = DecodedTimecode.GetValue();
-			FMediaIOCoreEncodeTime EncodeTime(EncodePixelFormat, InVideoFrame.VideoBuffer, InVideoFrame.Stride, InVideoFrame.Width, InVideoFrame.Height);
-			EncodeTime.Render(SetTimecode.Hours, SetTimecode.Minutes, SetTimecode.Seconds, SetTimecode.Frames);
+			FAjaMediaTimecodeBurnIn::Render(EncodePixelFormat, InVideoFrame.VideoBuffer, InVideoFrame.Stride, InVideoFrame.Width, InVideoFrame.Height, SetTimecode.Hours, SetTimecode.Minutes, SetTimecode.Seconds, SetTimecode.Frames);
 		}
 
 		if (bAjaWriteOutputRawDataCmdEnable)
@@ -699,54 +1239,81 @@ bool FAjaMediaPlayer::OnInputFrameReceived(const AJA::AJAInputFrameData& InInput
 			bAjaWriteOutputRawDataCmdEnable = false;
 		}
 
-		if (AjaThreadCurrentTextureSample.IsValid())
+		TSharedPtr<FAjaMediaTextureSample, ESPMode::ThreadSafe> TextureSample = AjaThreadCurrentTextureSample;
+		if (!TextureSample.IsValid())
 		{
-			if (AjaThreadCurrentTextureSample->SetProperties(InVideoFrame.Stride, InVideoFrame.Width, InVideoFrame.Height, VideoSampleFormat, DecodedTime, VideoFrameRate, DecodedTimecode, bIsSRGBInput))
-			{
-				Samples->AddVideo(AjaThreadCurrentTextureSample.ToSharedRef());
-			}
-		}
-		else
-		{
-			const int32 NumVideoSamples = Samples->NumVideoSamples() + (!InVideoFrame.bIsProgressivePicture ? 1 : 0);
+			const int32 NumVideoSamples = MediaSamples->NumVideoSamples() + (!InVideoFrame.bIsProgressivePicture ? 1 : 0);
 			if (NumVideoSamples >= MaxNumVideoFrameBuffer * AjaMediaPlayerConst::ToleratedExtraMaxBufferCount)
 			{
 				FPlatformAtomics::InterlockedIncrement(&AjaThreadAutoCirculateVideoFrameDropCount);
 			}
 			else
 			{
-				auto TextureSample = TextureSamplePool->AcquireShared();
-				if (InVideoFrame.bIsProgressivePicture)
+				// The device didn't fill a sample buffer, the frame needs to be copied.
+				INC_DWORD_STAT(STAT_AJA_MediaPlayer_CopiedVideoFrames);
+				FPlatformAtomics::InterlockedIncrement(&AjaThreadCopiedVideoFrameCount);
+
+				TextureSample = TextureSamplePool->AcquireShared();
+				AjaMediaPlayer::RequestSampleBuffer(*TextureSample, InVideoFrame.VideoBufferSize, AjaThreadAllocationCount);
+				if (!TextureSample->CopyFrame(InVideoFrame))
 				{
-					if (TextureSample->InitializeProgressive(InVideoFrame, VideoSampleFormat, DecodedTime, VideoFrameRate, DecodedTimecode, bIsSRGBInput))
-					{
-						Samples->AddVideo(TextureSample);
-					}
+					TextureSample.Reset();
 				}
-				else
+			}
+		}
+
+		if (TextureSample.IsValid())
+		{
+			if (InVideoFrame.bIsProgressivePicture)
+			{
+				if (TextureSample->SetProperties(InVideoFrame.Stride, InVideoFrame.Width, InVideoFrame.Height, VideoSampleFormat, DecodedTime, VideoFrameRate, DecodedTimecode, bIsSRGBInput))
 				{
-					bool bEven = true;
-					if (TextureSample->InitializeInterlaced_Halfed(InVideoFrame, VideoSampleFormat, DecodedTime, VideoFrameRate, DecodedTimecode, bEven, bIsSRGBInput))
-					{
-						Samples->AddVideo(TextureSample);
-					}
+					TextureSample->SetTraceId(AjaThreadCurrentTraceId);
+					FAjaMediaLatencyTrace::Stamp(AjaThreadCurrentTraceId, EAjaMediaLatencyStage::Enqueued);
+					MediaSamples->AddVideo(TextureSample.ToSharedRef());
+					RecordedFrame.Video = TextureSample;
+				}
+			}
+			else
+			{
+				// Both fields share the frame buffer. The frame sample is the even field and the odd field is a view that keeps it alive.
+				if (TextureSample->InitializeEvenField(InVideoFrame, VideoSampleFormat, DecodedTime, VideoFrameRate, DecodedTimecode, bIsSRGBInput))
+				{
+					TextureSample->SetTraceId(AjaThreadCurrentTraceId);
+					FAjaMediaLatencyTrace::Stamp(AjaThreadCurrentTraceId, EAjaMediaLatencyStage::Enqueued);
+					MediaSamples->AddVideo(TextureSample.ToSharedRef());
+					RecordedFrame.Video = TextureSample;
 
-					auto TextureSampleOdd = TextureSamplePool->AcquireShared();
-					bEven = false;
-					if (TextureSampleOdd->InitializeInterlaced_Halfed(InVideoFrame, VideoSampleFormat, DecodedTimeF2, VideoFrameRate, DecodedTimecodeF2, bEven, bIsSRGBInput))
+					auto OddFieldSample = OddFieldSamplePool->AcquireShared();
+					if (OddFieldSample->InitializeOddField(TextureSample.ToSharedRef(), InVideoFrame, VideoSampleFormat, DecodedTimeF2, VideoFrameRate, DecodedTimecodeF2, bIsSRGBInput))
 					{
-						Samples->AddVideo(TextureSampleOdd);
+						MediaSamples->AddVideo(OddFieldSample);
 					}
 				}
 			}
 		}
+	}
 
-		AjaThreadCurrentAncSample.Reset();
-		AjaThreadCurrentAncF2Sample.Reset();
-		AjaThreadCurrentAudioSample.Reset();
-		AjaThreadCurrentTextureSample.Reset();
+	if (Recorder->IsRecording())
+	{
+		RecordedFrame.Timecode = InInputFrame.Timecode;
+		RecordedFrame.FramesDropped = InInputFrame.FramesDropped;
+		RecordedFrame.FrameRate = VideoFrameRate;
+		RecordedFrame.Width = InVideoFrame.Width;
+		RecordedFrame.Height = InVideoFrame.Height;
+		RecordedFrame.Stride = InVideoFrame.Stride;
+		RecordedFrame.VideoFormatIndex = InVideoFrame.VideoFormatIndex;
+		RecordedFrame.PixelFormat = InVideoFrame.PixelFormat;
+		RecordedFrame.bIsProgressive = InVideoFrame.bIsProgressivePicture;
+		Recorder->AddFrame(RecordedFrame);
 	}
 
+	AjaThreadCurrentAncSample.Reset();
+	AjaThreadCurrentAncF2Sample.Reset();
+	AjaThreadCurrentAudioSample.Reset();
+	AjaThreadCurrentTextureSample.Reset();
+	AjaThreadCurrentTraceId = FAjaMediaLatencyTrace::InvalidTraceId;
+
 	return true;
 }
 
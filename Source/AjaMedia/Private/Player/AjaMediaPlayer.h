@@ -6,22 +6,23 @@
 
 #include "AjaMediaPrivate.h"
 #include "AjaMediaSource.h"
+#include "HAL/CriticalSection.h"
 
+class FAjaMediaAncillaryDemux;
 class FAjaMediaAudioSample;
 class FAjaMediaAudioSamplePool;
+class FAjaMediaBinarySample;
 class FAjaMediaBinarySamplePool;
+class FAjaMediaFormatDetector;
+class FAjaMediaRecorder;
+class FAjaMediaSamples;
 class FAjaMediaTextureSample;
 class FAjaMediaTextureSamplePool;
-class FMediaIOCoreBinarySampleBase;
+class IAjaInputChannel;
 class IMediaEventSink;
 
 enum class EMediaTextureSampleFormat;
 
-namespace AJA
-{
-	class AJAInputChannel;
-}
-
 /**
  * Implements a media player using AJA.
  *
@@ -56,6 +57,7 @@ public:
 
 	virtual void Close() override;
 	virtual FName GetPlayerName() const override;
+	virtual IMediaSamples& GetSamples() override;
 
 	virtual bool Open(const FString& Url, const IMediaOptions* Options) override;
 
@@ -80,6 +82,34 @@ protected:
 	 * Process pending audio and video frames, and forward them to the sinks.
 	 */
 	void ProcessFrame();
+
+	/**
+	 * Fill the sample pools before the capture starts, with every sample that can be in flight and a buffer big enough for the video format.
+	 * The buffers are touched, so no allocation or page fault happens on the AJA thread afterward.
+	 * Nothing is done when the pools are already filled for the same format.
+	 */
+	void PreallocateSamples(AJA::FAJAVideoFormat InVideoFormatIndex, AJA::EPixelFormat InPixelFormat, int32 InNumAudioChannels);
+
+	/** Get the number of samples of each pool that can be in flight. */
+	void GetNumSamplesInFlight(const AJA::AJAVideoFormats::VideoFormatDescriptor& InDescriptor, bool bInRecording, int32& OutNumVideoSamples, int32& OutNumAudioSamples, int32& OutNumMetadataSamples) const;
+
+	/** Give a touched buffer of the format to that many samples of each pool. The pools are thread-safe, it can be called from any thread. */
+	void WarmUpSamplePools(const AJA::AJAVideoFormats::VideoFormatDescriptor& InDescriptor, AJA::EPixelFormat InPixelFormat, int32 InNumAudioChannels, int32 InNumVideoSamples, int32 InNumAudioSamples, int32 InNumMetadataSamples);
+
+	/** Release the buffers of the sample pools. */
+	void ResetSamplePools();
+
+	/** Release the channel kept by Close. */
+	void ReleaseReusableInputChannel();
+
+	/** Open the input with InputOptions. The channel kept by Close is switched to the format in place when it's on the same port. */
+	void OpenInputChannel();
+
+	/** Detect the format of the signal. The current channel is kept, so it can be switched to the detected format. */
+	void StartFormatDetection();
+
+	/** Open the input once the format of the signal is detected. Called on the game thread. */
+	void TickFormatDetection();
 	
 protected:
 
@@ -96,8 +126,30 @@ private:
 	FAjaMediaBinarySamplePool* MetadataSamplePool;
 	FAjaMediaTextureSamplePool* TextureSamplePool;
 
-	TSharedPtr<FMediaIOCoreBinarySampleBase, ESPMode::ThreadSafe> AjaThreadCurrentAncSample;
-	TSharedPtr<FMediaIOCoreBinarySampleBase, ESPMode::ThreadSafe> AjaThreadCurrentAncF2Sample;
+	/** Odd field views of the interlaced frames. They don't own a buffer, so they are kept apart from the frame samples. */
+	FAjaMediaTextureSamplePool* OddFieldSamplePool;
+
+	/**
+	 * Format and number of samples the pools were filled with by PreallocateSamples. The pools are kept by Close, whether the channel
+	 * is kept or not, so a port opened again with the same format starts with warm buffers. Released on the next tick otherwise.
+	 */
+	bool bSamplePoolsFilled;
+	AJA::FAJAVideoFormat PooledVideoFormatIndex;
+	AJA::EPixelFormat PooledPixelFormat;
+	int32 PooledNumAudioChannels;
+	int32 PooledDeviceIndex;
+	int32 PooledNumVideoSamples;
+	int32 PooledNumAudioSamples;
+	int32 PooledNumMetadataSamples;
+
+	/** Lock-free sample queues. Filled by the AJA thread, consumed by the game thread. */
+	FAjaMediaSamples* MediaSamples;
+
+	/** Delivers the ancillary packets to the subscriptions of this input. */
+	FAjaMediaAncillaryDemux* AncillaryDemux;
+
+	TSharedPtr<FAjaMediaBinarySample, ESPMode::ThreadSafe> AjaThreadCurrentAncSample;
+	TSharedPtr<FAjaMediaBinarySample, ESPMode::ThreadSafe> AjaThreadCurrentAncF2Sample;
 	TSharedPtr<FAjaMediaAudioSample, ESPMode::ThreadSafe> AjaThreadCurrentAudioSample;
 	TSharedPtr<FAjaMediaTextureSample, ESPMode::ThreadSafe> AjaThreadCurrentTextureSample;
 
@@ -124,6 +176,16 @@ private:
 	int32 AjaThreadAutoCirculateMetadataFrameDropCount;
 	int32 AjaThreadAutoCirculateVideoFrameDropCount;
 
+	/** Number of progressive frames that were not received in a sample buffer and had to be copied. */
+	int32 AjaThreadCopiedVideoFrameCount;
+
+	/** Number of sample buffers that were allocated by the AJA thread because the pools were not warm enough. */
+	int32 AjaThreadAllocationCount;
+
+	/** Latency trace id of this input and of the frame being captured. */
+	int32 TraceInputId;
+	uint32 AjaThreadCurrentTraceId;
+
 	/** Number of frames drop from the last tick. */
 	uint32 LastFrameDropCount;
 	uint32 PreviousFrameDropCount;
@@ -144,10 +206,55 @@ private:
 	bool bVerifyFrameDropCount;
 
 	/** Maps to the current input Device */
-	AJA::AJAInputChannel* InputChannel;
+	IAjaInputChannel* InputChannel;
+
+	/** Port of the current input channel */
+	uint32 InputPortIndex;
+	AJA::ETransportType InputTransportType;
+
+	/** Options of the input, kept to open it again once the format of the signal is detected */
+	AJA::AJAInputOutputChannelOptions InputOptions;
+
+	/** Whether the input is opened with the format of the signal instead of the format of the source. */
+	bool bAutoDetectFormat;
+
+	/** Whether the detection was started because the channel stopped. The format must be different to open the input again. */
+	bool bDetectingAfterFailure;
+
+	FAjaMediaFormatDetector* FormatDetector;
+
+	/** Base name of the recorded clip played instead of the device input, empty for a device input. */
+	FString ClipBaseName;
+	bool bLoopClip;
+	bool bPlayClipAsFastAsPossible;
+
+	/** Writes the captured frames to disk while Aja.Recorder.Start is on. */
+	FAjaMediaRecorder* Recorder;
+
+	/** Set by the AJA thread when the signal doesn't match the format of the input, or when the channel stopped. */
+	volatile int32 AjaThreadSignalChanged;
+	volatile int32 AjaThreadInputFailed;
+
+	/**
+	 * Channel kept open by Close. When the same port is opened right after, the channel is switched to the new format in place.
+	 * Released on the next tick otherwise.
+	 */
+	IAjaInputChannel* ReusableInputChannel;
+	int32 ReusableDeviceIndex;
+	uint32 ReusablePortIndex;
+	AJA::ETransportType ReusableTransportType;
+
+	/** Held by the AJA thread callbacks, so Close knows that no callback is running once the state is changed. */
+	FCriticalSection AjaThreadCallbackCriticalSection;
 
 	/** Frame Description from capture device */
 	AJA::FAJAVideoFormat LastVideoFormatIndex;
+	AJA::EPixelFormat LastPixelFormat;
+	int32 LastNumAudioChannels;
+
+	/** Device of the input, and scheduling of the thread that services it */
+	int32 DeviceIndex;
+	FAjaMediaThreadSettings ThreadSettings;
 	/** Previous frame timecode for stats purpose */
 	AJA::FTimecode AjaThreadPreviousFrameTimecode;
 };
@@ -0,0 +1,742 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaRecorder.h"
+
+#include "AjaMediaPrivate.h"
+
+#include "AjaMediaAudioSample.h"
+#include "AjaMediaBinarySample.h"
+#include "AjaMediaClip.h"
+#include "AjaMediaTextureSample.h"
+
+#include "Async/Async.h"
+#include "Containers/CircularQueue.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformAtomics.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Stats/Stats2.h"
+
+#if PLATFORM_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+DECLARE_CYCLE_STAT(TEXT("AJA Recorder Write"), STAT_AJA_Recorder_Write, STATGROUP_Media);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AJA Recorder dropped frames"), STAT_AJA_Recorder_DroppedFrames, STATGROUP_Media);
+
+namespace AjaMediaRecorder
+{
+	static TAutoConsoleVariable<int32> CVarQueueSize(
+		TEXT("Aja.Recorder.QueueSize"),
+		16,
+		TEXT("Frames of an input that can wait for the writer thread. Their samples are kept out of the pools of the player. Read when the player is created."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<int32> CVarChunkSize(
+		TEXT("Aja.Recorder.ChunkSize"),
+		4,
+		TEXT("Size in MB of the chunks the audio and ancillary data are packed in before they are written."),
+		ECVF_Default);
+
+	/** The unbuffered writes must be aligned on the sector size. The page size covers every disk. */
+	static const uint32 Alignment = 4096;
+
+	/** The index file is flushed to the OS at that interval. */
+	static const uint32 NumFramesBetweenIndexFlushes = 64;
+
+	/** The recording session of every input. Only accessed on the game thread. */
+	int32 SessionSerial = 0;
+	bool bSessionRecording = false;
+	FString SessionDirectory;
+
+	static FAutoConsoleCommand StartCommand(
+		TEXT("Aja.Recorder.Start"),
+		TEXT("Record every AJA input to disk until Aja.Recorder.Stop. The optional argument is the directory of the clips, a new folder in Saved/AjaRecordings by default."),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			SessionDirectory = Args.Num() > 0 ? Args[0] : FPaths::ProjectSavedDir() / TEXT("AjaRecordings") / FDateTime::Now().ToString();
+			bSessionRecording = true;
+			++SessionSerial;
+			UE_LOG(LogAjaMedia, Display, TEXT("Recording the AJA inputs to %s."), *SessionDirectory);
+		})
+		);
+
+	static FAutoConsoleCommand StopCommand(
+		TEXT("Aja.Recorder.Stop"),
+		TEXT("Stop the recording of the AJA inputs."),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			if (bSessionRecording)
+			{
+				bSessionRecording = false;
+				++SessionSerial;
+				UE_LOG(LogAjaMedia, Display, TEXT("Stopped the recording of the AJA inputs."));
+			}
+		})
+		);
+
+	/** A file written without going through the cache of the OS, when the file system allows it. */
+	class FDirectFile
+	{
+	public:
+		FDirectFile()
+#if PLATFORM_WINDOWS
+			: Handle(INVALID_HANDLE_VALUE)
+#elif PLATFORM_LINUX
+			: Descriptor(-1)
+#else
+			: Handle(nullptr)
+#endif
+		{ }
+
+		~FDirectFile()
+		{
+			Close(0);
+		}
+
+		bool Open(const FString& InPath)
+		{
+#if PLATFORM_WINDOWS
+			Handle = ::CreateFileW(*InPath, GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			return Handle != INVALID_HANDLE_VALUE;
+#elif PLATFORM_LINUX
+			Descriptor = ::open(TCHAR_TO_UTF8(*InPath), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+			if (Descriptor < 0 && errno == EINVAL)
+			{
+				// The file system doesn't support direct I/O
+				Descriptor = ::open(TCHAR_TO_UTF8(*InPath), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			}
+			return Descriptor >= 0;
+#else
+			Handle = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*InPath);
+			return Handle != nullptr;
+#endif
+		}
+
+		/** The data must be aligned, and its size must be a multiple of the alignment. */
+		bool Write(const void* InData, uint64 InSize)
+		{
+			check(IsAligned(InData, Alignment) && InSize % Alignment == 0);
+
+			const uint8* Data = static_cast<const uint8*>(InData);
+			while (InSize > 0)
+			{
+				// Split in pieces that fit the size of the OS calls, still aligned
+				const uint32 Size = (uint32)FMath::Min<uint64>(InSize, 1u << 30);
+#if PLATFORM_WINDOWS
+				::DWORD Written = 0;
+				if (!::WriteFile(Handle, Data, Size, &Written, nullptr) || Written != Size)
+				{
+					return false;
+				}
+#elif PLATFORM_LINUX
+				const ssize_t Written = ::write(Descriptor, Data, Size);
+				if (Written < 0 && errno == EINTR)
+				{
+					continue;
+				}
+				if (Written != (ssize_t)Size)
+				{
+					return false;
+				}
+#else
+				if (!Handle->Write(Data, Size))
+				{
+					return false;
+				}
+#endif
+				Data += Size;
+				InSize -= Size;
+			}
+			return true;
+		}
+
+		/** Close the file, cut to its real size. The last write was padded to the alignment. */
+		void Close(uint64 InFileSize)
+		{
+#if PLATFORM_WINDOWS
+			if (Handle != INVALID_HANDLE_VALUE)
+			{
+				LARGE_INTEGER FileSize;
+				FileSize.QuadPart = InFileSize;
+				if (::SetFilePointerEx(Handle, FileSize, nullptr, FILE_BEGIN))
+				{
+					::SetEndOfFile(Handle);
+				}
+				::CloseHandle(Handle);
+				Handle = INVALID_HANDLE_VALUE;
+			}
+#elif PLATFORM_LINUX
+			if (Descriptor >= 0)
+			{
+				if (::ftruncate(Descriptor, InFileSize) != 0)
+				{
+					UE_LOG(LogAjaMedia, Verbose, TEXT("A file of the AJA recorder couldn't be cut to its size."));
+				}
+				::close(Descriptor);
+				Descriptor = -1;
+			}
+#else
+			delete Handle;
+			Handle = nullptr;
+#endif
+		}
+
+	private:
+#if PLATFORM_WINDOWS
+		HANDLE Handle;
+#elif PLATFORM_LINUX
+		int Descriptor;
+#else
+		IFileHandle* Handle;
+#endif
+	};
+
+	/** A data file of a clip. Small data is packed in an aligned chunk, written once it is full. */
+	class FStream
+	{
+	public:
+		FStream()
+			: Chunk(nullptr)
+			, ChunkSize(0)
+			, ChunkUsed(0)
+			, FileOffset(0)
+			, Size(0)
+			, bFailed(false)
+		{ }
+
+		~FStream()
+		{
+			Close();
+		}
+
+		bool Open(const FString& InPath, uint32 InChunkSize)
+		{
+			ChunkSize = Align(FMath::Max(InChunkSize, Alignment), Alignment);
+			Chunk = static_cast<uint8*>(FMemory::Malloc(ChunkSize, Alignment));
+			ChunkUsed = 0;
+			FileOffset = 0;
+			Size = 0;
+			bFailed = !File.Open(InPath);
+			if (bFailed)
+			{
+				UE_LOG(LogAjaMedia, Error, TEXT("The AJA recorder couldn't create %s."), *InPath);
+			}
+			return !bFailed;
+		}
+
+		void Close()
+		{
+			if (Chunk)
+			{
+				if (ChunkUsed > 0)
+				{
+					// The padding is cut by the close
+					FMemory::Memzero(Chunk + ChunkUsed, Align(ChunkUsed, Alignment) - ChunkUsed);
+					Write(Chunk, Align(ChunkUsed, Alignment));
+					ChunkUsed = 0;
+				}
+				File.Close(Size);
+				FMemory::Free(Chunk);
+				Chunk = nullptr;
+			}
+		}
+
+		/**
+		 * Write a whole buffer at an aligned offset. The packed data must be flushed.
+		 * The buffer is written in place when it is aligned and big enough to be padded, it goes through the chunk otherwise.
+		 * @return the offset of the data in the file.
+		 */
+		uint64 WriteAligned(const void* InData, uint32 InSize, uint32 InCapacity)
+		{
+			check(ChunkUsed == 0);
+
+			const uint64 Offset = FileOffset;
+			const uint32 AlignedSize = Align(InSize, Alignment);
+			if (IsAligned(InData, Alignment) && InCapacity >= AlignedSize)
+			{
+				Write(InData, AlignedSize);
+			}
+			else
+			{
+				const uint8* Data = static_cast<const uint8*>(InData);
+				for (uint32 Written = 0; Written < InSize; Written += ChunkSize)
+				{
+					const uint32 PieceSize = FMath::Min(InSize - Written, ChunkSize);
+					FMemory::Memcpy(Chunk, Data + Written, PieceSize);
+					FMemory::Memzero(Chunk + PieceSize, Align(PieceSize, Alignment) - PieceSize);
+					Write(Chunk, Align(PieceSize, Alignment));
+				}
+			}
+
+			Size = Offset + InSize;
+			return Offset;
+		}
+
+		/** Pack data after the previous one. @return the offset of the data in the file. */
+		uint64 Append(const void* InData, uint32 InSize)
+		{
+			const uint64 Offset = FileOffset + ChunkUsed;
+
+			const uint8* Data = static_cast<const uint8*>(InData);
+			uint32 Remaining = InSize;
+			while (Remaining > 0)
+			{
+				const uint32 PieceSize = FMath::Min(Remaining, ChunkSize - ChunkUsed);
+				FMemory::Memcpy(Chunk + ChunkUsed, Data, PieceSize);
+				ChunkUsed += PieceSize;
+				Data += PieceSize;
+				Remaining -= PieceSize;
+
+				if (ChunkUsed == ChunkSize)
+				{
+					Write(Chunk, ChunkSize);
+					ChunkUsed = 0;
+				}
+			}
+
+			Size = Offset + InSize;
+			return Offset;
+		}
+
+	private:
+		void Write(const void* InData, uint32 InSize)
+		{
+			if (!bFailed && !File.Write(InData, InSize))
+			{
+				UE_LOG(LogAjaMedia, Error, TEXT("The AJA recorder couldn't write to disk. The rest of the clip is lost."));
+				bFailed = true;
+			}
+			FileOffset += InSize;
+		}
+
+	private:
+		FDirectFile File;
+
+		uint8* Chunk;
+		uint32 ChunkSize;
+		uint32 ChunkUsed;
+
+		/** Bytes sent to the file, always aligned. */
+		uint64 FileOffset;
+
+		/** End of the last data, the size of the file once it is closed. */
+		uint64 Size;
+
+		bool bFailed;
+	};
+}
+
+/** The files of a clip, and its format. A new clip is started when the format of the frames changes. */
+struct FAjaMediaRecorder::FClip
+{
+	FClip()
+		: Index(nullptr)
+		, NumFrames(0)
+	{
+		FMemory::Memzero(Header);
+	}
+
+	~FClip()
+	{
+		if (Index)
+		{
+			// The final header has the number of frames and the audio format
+			Header.NumFrames = NumFrames;
+			Index->Seek(0);
+			Index->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+			delete Index;
+		}
+	}
+
+	bool Open(const FString& InBaseName, const FFrame& InFrame)
+	{
+		using namespace AjaMediaRecorder;
+
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		PlatformFile.CreateDirectoryTree(*FPaths::GetPath(InBaseName));
+
+		const uint32 ChunkSize = (uint32)FMath::Clamp(CVarChunkSize.GetValueOnAnyThread(), 1, 256) * 1024 * 1024;
+		if (!Video.Open(InBaseName + AjaMediaClip::VideoExtension, ChunkSize) || !Audio.Open(InBaseName + AjaMediaClip::AudioExtension, ChunkSize) || !Ancillary.Open(InBaseName + AjaMediaClip::AncillaryExtension, ChunkSize))
+		{
+			return false;
+		}
+
+		Index = PlatformFile.OpenWrite(*(InBaseName + AjaMediaClip::IndexExtension));
+		if (Index == nullptr)
+		{
+			UE_LOG(LogAjaMedia, Error, TEXT("The AJA recorder couldn't create %s.index."), *InBaseName);
+			return false;
+		}
+
+		Header.Magic = AjaMediaClip::IndexMagic;
+		Header.Version = AjaMediaClip::IndexVersion;
+		Header.HeaderSize = sizeof(AjaMediaClip::FIndexHeader);
+		Header.EntrySize = sizeof(AjaMediaClip::FIndexEntry);
+		Header.Width = InFrame.Width;
+		Header.Height = InFrame.Height;
+		Header.Stride = InFrame.Stride;
+		Header.PixelFormat = (uint32)InFrame.PixelFormat;
+		Header.bIsProgressive = InFrame.bIsProgressive ? 1 : 0;
+		Header.FrameRateNumerator = InFrame.FrameRate.Numerator;
+		Header.FrameRateDenominator = InFrame.FrameRate.Denominator;
+		Header.VideoAlignment = Alignment;
+		Header.VideoFormatIndex = InFrame.VideoFormatIndex;
+		Index->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+
+		UE_LOG(LogAjaMedia, Log, TEXT("Recording the AJA clip %s (%dx%d, %s)."), *InBaseName, InFrame.Width, InFrame.Height, *InFrame.FrameRate.ToPrettyText().ToString());
+		return true;
+	}
+
+	bool HasFormatOf(const FFrame& InFrame) const
+	{
+		return Header.Width == InFrame.Width
+			&& Header.Height == InFrame.Height
+			&& Header.Stride == InFrame.Stride
+			&& Header.VideoFormatIndex == InFrame.VideoFormatIndex
+			&& Header.PixelFormat == (uint32)InFrame.PixelFormat
+			&& (Header.bIsProgressive != 0) == InFrame.bIsProgressive
+			&& Header.FrameRateNumerator == (uint32)InFrame.FrameRate.Numerator
+			&& Header.FrameRateDenominator == (uint32)InFrame.FrameRate.Denominator;
+	}
+
+	void Write(const FFrame& InFrame)
+	{
+		using namespace AjaMediaRecorder;
+
+		AjaMediaClip::FIndexEntry Entry;
+		FMemory::Memzero(Entry);
+		Entry.FrameNumber = NumFrames;
+		Entry.FramesDropped = InFrame.FramesDropped;
+		Entry.Hours = (uint8)InFrame.Timecode.Hours;
+		Entry.Minutes = (uint8)InFrame.Timecode.Minutes;
+		Entry.Seconds = (uint8)InFrame.Timecode.Seconds;
+		Entry.Frames = (uint8)InFrame.Timecode.Frames;
+
+		if (InFrame.Video.IsValid())
+		{
+			Entry.VideoSize = InFrame.Video->GetFrameBufferSize();
+			Entry.VideoOffset = Video.WriteAligned(InFrame.Video->GetFrameBuffer(), Entry.VideoSize, InFrame.Video->GetBufferCapacity());
+		}
+
+		if (InFrame.Audio.IsValid())
+		{
+			Header.NumAudioChannels = InFrame.Audio->GetChannels();
+			Header.AudioSampleRate = InFrame.Audio->GetSampleRate();
+			Entry.AudioSize = InFrame.Audio->GetFrames() * InFrame.Audio->GetChannels() * sizeof(int32);
+			Entry.AudioOffset = Audio.Append(InFrame.Audio->GetBuffer(), Entry.AudioSize);
+		}
+
+		if (InFrame.Ancillary.IsValid())
+		{
+			Entry.AncillarySize = InFrame.Ancillary->GetSize();
+			Entry.AncillaryOffset = Ancillary.Append(InFrame.Ancillary->GetData(), Entry.AncillarySize);
+		}
+
+		if (InFrame.AncillaryF2.IsValid())
+		{
+			const uint64 Offset = Ancillary.Append(InFrame.AncillaryF2->GetData(), InFrame.AncillaryF2->GetSize());
+			if (Entry.AncillarySize == 0)
+			{
+				Entry.AncillaryOffset = Offset;
+			}
+			Entry.AncillaryF2Size = InFrame.AncillaryF2->GetSize();
+		}
+
+		Index->Write(reinterpret_cast<const uint8*>(&Entry), sizeof(Entry));
+		if (++NumFrames % NumFramesBetweenIndexFlushes == 0)
+		{
+			Index->Flush();
+		}
+	}
+
+	AjaMediaRecorder::FStream Video;
+	AjaMediaRecorder::FStream Audio;
+	AjaMediaRecorder::FStream Ancillary;
+	IFileHandle* Index;
+
+	AjaMediaClip::FIndexHeader Header;
+	uint32 NumFrames;
+};
+
+/** The clip numbering and the counters of a recording session. */
+struct FAjaMediaRecorder::FSession
+{
+	FSession(int32 InSerial)
+		: Serial(InSerial)
+		, NextClipIndex(0)
+		, NumWrittenFrames(0)
+		, NumDroppedFrames(0)
+	{ }
+
+	const int32 Serial;
+
+	/** The clips of a session are numbered, an input closed and opened again starts a new one. */
+	volatile int32 NextClipIndex;
+
+	volatile int32 NumWrittenFrames;
+	volatile int32 NumDroppedFrames;
+};
+
+/** The thread that writes the frames of a recording, and its queue. */
+class FAjaMediaRecorder::FWriter
+	: private FRunnable
+{
+public:
+
+	FWriter(const TSharedRef<FSession, ESPMode::ThreadSafe>& InSession, const FString& InClipBaseName, uint32 InQueueCapacity, TFunction<void()>&& InWarmUp)
+		: Session(InSession)
+		, ClipBaseName(InClipBaseName)
+		, Queue(InQueueCapacity + 1)
+		, bStopping(false)
+		, WakeUpEvent(FPlatformProcess::GetSynchEventFromPool(false))
+		, WarmedUpEvent(FPlatformProcess::GetSynchEventFromPool(true))
+		, Thread(nullptr)
+		, Clip(nullptr)
+		, bClipFailed(false)
+		, WarmUp(MoveTemp(InWarmUp))
+	{
+		Thread = FRunnableThread::Create(this, TEXT("AjaMediaRecorder"), 0, TPri_AboveNormal);
+	}
+
+	virtual ~FWriter()
+	{
+		RequestStop();
+		WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+
+		FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+		WakeUpEvent = nullptr;
+		FPlatformProcess::ReturnSynchEventToPool(WarmedUpEvent);
+		WarmedUpEvent = nullptr;
+	}
+
+	/** Called under the lock of AddFrame. @return false if the queue is full. */
+	bool Enqueue(const FFrame& InFrame)
+	{
+		if (!Queue.Enqueue(InFrame))
+		{
+			FPlatformAtomics::InterlockedIncrement(&Session->NumDroppedFrames);
+			INC_DWORD_STAT(STAT_AJA_Recorder_DroppedFrames);
+			return false;
+		}
+
+		WakeUpEvent->Trigger();
+		return true;
+	}
+
+	/** The thread writes the queued frames, closes the clip and completes. Nothing is queued after that. */
+	void RequestStop()
+	{
+		FPlatformAtomics::InterlockedExchange(&bStopping, true);
+		WakeUpEvent->Trigger();
+	}
+
+	void WaitForWarmUp()
+	{
+		WarmedUpEvent->Wait();
+	}
+
+	void WaitForCompletion()
+	{
+		if (Thread)
+		{
+			Thread->WaitForCompletion();
+		}
+	}
+
+private:
+
+	//~ FRunnable interface
+	virtual uint32 Run() override
+	{
+		if (WarmUp)
+		{
+			WarmUp();
+			WarmUp = nullptr;
+		}
+		WarmedUpEvent->Trigger();
+
+		while (!bStopping)
+		{
+			WakeUpEvent->Wait();
+			WriteFrames();
+		}
+
+		WriteFrames();
+		CloseClip();
+		return 0;
+	}
+
+	/** Write every queued frame. */
+	void WriteFrames()
+	{
+		FFrame Frame;
+		while (Queue.Dequeue(Frame))
+		{
+			SCOPE_CYCLE_COUNTER(STAT_AJA_Recorder_Write);
+
+			if (Clip && !Clip->HasFormatOf(Frame))
+			{
+				CloseClip();
+			}
+
+			if (Clip == nullptr && !bClipFailed)
+			{
+				const int32 ClipIndex = FPlatformAtomics::InterlockedIncrement(&Session->NextClipIndex) - 1;
+				Clip = new FClip();
+				if (!Clip->Open(FString::Printf(TEXT("%s_%03d"), *ClipBaseName, ClipIndex), Frame))
+				{
+					CloseClip();
+					bClipFailed = true;
+				}
+			}
+
+			if (Clip)
+			{
+				Clip->Write(Frame);
+				FPlatformAtomics::InterlockedIncrement(&Session->NumWrittenFrames);
+			}
+			else
+			{
+				FPlatformAtomics::InterlockedIncrement(&Session->NumDroppedFrames);
+			}
+
+			// Give the samples back to the player now
+			Frame = FFrame();
+		}
+	}
+
+	void CloseClip()
+	{
+		delete Clip;
+		Clip = nullptr;
+	}
+
+private:
+
+	TSharedRef<FSession, ESPMode::ThreadSafe> Session;
+	const FString ClipBaseName;
+
+	/** Frames from the capture thread to the writer thread. */
+	TCircularQueue<FFrame> Queue;
+
+	volatile int32 bStopping;
+	FEvent* WakeUpEvent;
+	FEvent* WarmedUpEvent;
+	FRunnableThread* Thread;
+
+	/** The clip being written. Only accessed by the writer thread while it runs. */
+	FClip* Clip;
+
+	/** Set when the files of a clip couldn't be created. The frames are dropped until the recording is started again. */
+	bool bClipFailed;
+
+	TFunction<void()> WarmUp;
+};
+
+/* FAjaMediaRecorder implementation
+*****************************************************************************/
+FAjaMediaRecorder::FAjaMediaRecorder()
+	: QueueCapacity(FMath::RoundUpToPowerOfTwo(FMath::Max(AjaMediaRecorder::CVarQueueSize.GetValueOnAnyThread(), 1) + 1) - 1)
+	, bRecording(false)
+	, SessionSerial(INDEX_NONE)
+{ }
+
+FAjaMediaRecorder::~FAjaMediaRecorder()
+{
+	Stop();
+}
+
+bool FAjaMediaRecorder::Tick()
+{
+	check(IsInGameThread());
+
+	const int32 CurrentSessionSerial = AjaMediaRecorder::bSessionRecording ? AjaMediaRecorder::SessionSerial : INDEX_NONE;
+	if (CurrentSessionSerial == SessionSerial)
+	{
+		return false;
+	}
+
+	Stop();
+	return CurrentSessionSerial != INDEX_NONE;
+}
+
+void FAjaMediaRecorder::Start(const FString& InInputName, TFunction<void()>&& InWarmUp)
+{
+	check(IsInGameThread());
+
+	const int32 CurrentSessionSerial = AjaMediaRecorder::bSessionRecording ? AjaMediaRecorder::SessionSerial : INDEX_NONE;
+	if (CurrentSessionSerial == INDEX_NONE || CurrentSessionSerial == SessionSerial)
+	{
+		return;
+	}
+
+	Stop();
+	if (!Session.IsValid() || Session->Serial != CurrentSessionSerial)
+	{
+		Session = MakeShared<FSession, ESPMode::ThreadSafe>(CurrentSessionSerial);
+	}
+	ClipBaseName = AjaMediaRecorder::SessionDirectory / FPaths::MakeValidFileName(InInputName.Replace(TEXT("://"), TEXT("_")).Replace(TEXT("/"), TEXT("_")));
+	SessionSerial = CurrentSessionSerial;
+
+	Writer = MakeShared<FWriter, ESPMode::ThreadSafe>(Session.ToSharedRef(), ClipBaseName, QueueCapacity, MoveTemp(InWarmUp));
+	FPlatformAtomics::InterlockedExchange(&bRecording, true);
+}
+
+void FAjaMediaRecorder::Stop()
+{
+	TSharedPtr<FWriter, ESPMode::ThreadSafe> StoppedWriter;
+	{
+		// Once released, AddFrame doesn't queue anything
+		FScopeLock Lock(&AddFrameCriticalSection);
+		FPlatformAtomics::InterlockedExchange(&bRecording, false);
+		StoppedWriter = MoveTemp(Writer);
+	}
+	SessionSerial = INDEX_NONE;
+
+	if (StoppedWriter.IsValid())
+	{
+		// The warm up uses the pools of the player, it must be done when Stop returns
+		StoppedWriter->WaitForWarmUp();
+		StoppedWriter->RequestStop();
+
+		// Up to a full queue of frames is still written. The last reference is released once the writer thread completed.
+		Async(EAsyncExecution::Thread, [StoppedWriter]()
+		{
+			StoppedWriter->WaitForCompletion();
+		});
+	}
+}
+
+bool FAjaMediaRecorder::AddFrame(const FFrame& InFrame)
+{
+	FScopeLock Lock(&AddFrameCriticalSection);
+
+	// Stop may have run since IsRecording was checked. The frame isn't queued, the caller keeps its samples.
+	if (!IsRecording())
+	{
+		return false;
+	}
+
+	return Writer->Enqueue(InFrame);
+}
+
+FString FAjaMediaRecorder::GetStats() const
+{
+	if (!IsRecording() || !Session.IsValid())
+	{
+		return FString();
+	}
+	return FString::Printf(TEXT("		Recording: %s, frames written: %d, dropped: %d\n"), *ClipBaseName, Session->NumWrittenFrames, Session->NumDroppedFrames);
+}
@@ -0,0 +1,122 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AJALib.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/FrameRate.h"
+#include "Templates/Function.h"
+
+class FAjaMediaAudioSample;
+class FAjaMediaBinarySample;
+class FAjaMediaTextureSample;
+
+/**
+ * Records the video, audio and ancillary data of an input to disk, continuously.
+ *
+ * The recording of every input is started and stopped together with Aja.Recorder.Start and Aja.Recorder.Stop.
+ * The capture thread only queues references to the samples of the frame, it never waits on the disk. When the queue is full the frame is dropped.
+ * Every recording input has its own writer thread. The video frames are written straight from the page aligned sample buffers with
+ * unbuffered writes, and the audio and ancillary data are packed in large aligned chunks.
+ * Once stopped, the writer thread finishes the queued frames and the clip in the background, the game thread doesn't wait for the disk.
+ *
+ * A clip is 4 files: .video, .audio, .anc and .index. The index has a header with the format of the clip and one fixed-size entry per frame,
+ * with its timecode and the offset of its data in the other files. A clip can be seeked without reading anything else.
+ * A new clip is started when the format of the signal changes. The format of the files is in AjaMediaClip.h.
+ */
+class FAjaMediaRecorder
+{
+public:
+
+	/** A captured frame. The samples are referenced, not copied, until the writer thread wrote them. */
+	struct FFrame
+	{
+		FFrame()
+			: FramesDropped(0)
+			, Width(0)
+			, Height(0)
+			, Stride(0)
+			, VideoFormatIndex(0)
+			, PixelFormat(AJA::EPixelFormat::PF_8BIT_YCBCR)
+			, bIsProgressive(true)
+		{ }
+
+		/** The sample that owns the frame buffer. For an interlaced frame, both fields. */
+		TSharedPtr<FAjaMediaTextureSample, ESPMode::ThreadSafe> Video;
+		TSharedPtr<FAjaMediaAudioSample, ESPMode::ThreadSafe> Audio;
+		TSharedPtr<FAjaMediaBinarySample, ESPMode::ThreadSafe> Ancillary;
+		TSharedPtr<FAjaMediaBinarySample, ESPMode::ThreadSafe> AncillaryF2;
+
+		AJA::FTimecode Timecode;
+		uint32 FramesDropped;
+
+		FFrameRate FrameRate;
+		uint32 Width;
+		uint32 Height;
+		uint32 Stride;
+		AJA::FAJAVideoFormat VideoFormatIndex;
+		AJA::EPixelFormat PixelFormat;
+		bool bIsProgressive;
+	};
+
+	FAjaMediaRecorder();
+	~FAjaMediaRecorder();
+
+	/**
+	 * Stop the recording when Aja.Recorder.Start or Aja.Recorder.Stop was used. Called on the game thread.
+	 * @return true if a recording must be started with Start.
+	 */
+	bool Tick();
+
+	/**
+	 * Start the recording of the current session. Called on the game thread.
+	 * @param InInputName Name of the input, used to name its clips.
+	 * @param InWarmUp Called on the writer thread before it writes anything, to add the samples held by the queue to the pools of the player.
+	 */
+	void Start(const FString& InInputName, TFunction<void()>&& InWarmUp);
+
+	/**
+	 * Stop taking frames. The queued frames are written and the clip is closed in the background. Called on the game thread.
+	 * Only waits for the warm up of the writer thread, it doesn't use the player once Stop returned.
+	 */
+	void Stop();
+
+	/** @return true if the frames should be given to AddFrame. Can be called from any thread. */
+	bool IsRecording() const { return FPlatformAtomics::AtomicRead(&bRecording) != 0; }
+
+	/**
+	 * Queue a frame for the writer thread. Called on the capture thread, only waits for Stop to stop taking frames.
+	 * @return false if the queue is full or the recording was stopped, the frame is dropped.
+	 */
+	bool AddFrame(const FFrame& InFrame);
+
+	/** @return the number of frames that can be queued. The samples they hold are not in the pools of the player. */
+	uint32 GetQueueCapacity() const { return QueueCapacity; }
+
+	/** @return a line for the stats of the player, empty when not recording. */
+	FString GetStats() const;
+
+private:
+
+	class FWriter;
+	struct FSession;
+
+	const uint32 QueueCapacity;
+
+	volatile int32 bRecording;
+
+	/** Held by AddFrame while it checks bRecording and queues the frame, so no frame is queued once Stop has cleared bRecording. */
+	FCriticalSection AddFrameCriticalSection;
+
+	/** The writer thread of the recording. A stopped writer is owned by the task that waits for it. */
+	TSharedPtr<FWriter, ESPMode::ThreadSafe> Writer;
+
+	/** The clip numbering and the counters of the recording session, shared with the stopped writers that are still writing. */
+	TSharedPtr<FSession, ESPMode::ThreadSafe> Session;
+	FString ClipBaseName;
+
+	/** The recording session being recorded. */
+	int32 SessionSerial;
+};
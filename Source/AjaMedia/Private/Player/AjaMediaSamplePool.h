@@ -0,0 +1,20 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace AjaMediaSamplePool
+{
+	/** Sample buffers grow by whole pages. */
+	static const uint32 SizeClassGranularity = 4096;
+
+	/**
+	 * Round a buffer size up to its size class.
+	 * The audio and ancillary sizes change a little from one frame to the next, they all fall in the same class and reuse the same buffer.
+	 */
+	inline uint32 GetSizeClass(uint32 InBufferSize)
+	{
+		return Align(InBufferSize, SizeClassGranularity);
+	}
+}
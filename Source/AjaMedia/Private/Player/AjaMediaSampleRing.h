@@ -0,0 +1,216 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "HAL/PlatformAtomics.h"
+
+/**
+ * Bounded single-producer/single-consumer ring of media samples.
+ *
+ * The producer (the AJA thread) only writes Tail and the consumer (the game thread) only writes Head,
+ * so neither side ever waits on the other. The two indices live on their own cache line.
+ * The consumer can drop any number of stale samples by moving Head once.
+ */
+template<typename SampleType>
+class TAjaMediaSampleRing
+{
+public:
+	using FSamplePtr = TSharedPtr<SampleType, ESPMode::ThreadSafe>;
+
+	TAjaMediaSampleRing()
+		: Head(0)
+		, Tail(0)
+	{ }
+
+	/**
+	 * Resize the ring and release every sample in it.
+	 * Not thread safe, must only be called while nothing is produced or consumed.
+	 *
+	 * @param InCapacity The maximum number of samples in the ring.
+	 */
+	void Reset(int32 InCapacity)
+	{
+		Slots.Reset();
+		// One slot is always kept empty to tell a full ring from an empty one
+		Slots.SetNum(FMath::Max(InCapacity, 1) + 1);
+		FPlatformAtomics::AtomicStore(&Head, 0);
+		FPlatformAtomics::AtomicStore(&Tail, 0);
+	}
+
+	/** @return the number of samples in the ring. Exact from either side for its own index, a snapshot otherwise. */
+	int32 Num() const
+	{
+		const int32 Size = Slots.Num();
+		return Size > 0 ? (FPlatformAtomics::AtomicRead(&Tail) - FPlatformAtomics::AtomicRead(&Head) + Size) % Size : 0;
+	}
+
+	/** @return the maximum number of samples in the ring. */
+	int32 Capacity() const
+	{
+		return FMath::Max(Slots.Num() - 1, 0);
+	}
+
+public:
+
+	//~ Producer
+
+	/**
+	 * Add a sample at the end of the ring.
+	 *
+	 * @return false if the ring is full, the sample is not added.
+	 */
+	bool Enqueue(const FSamplePtr& InSample)
+	{
+		const int32 Size = Slots.Num();
+		if (Size == 0)
+		{
+			return false;
+		}
+
+		const int32 CurrentTail = FPlatformAtomics::AtomicRead(&Tail);
+		const int32 NextTail = (CurrentTail + 1) % Size;
+		if (NextTail == FPlatformAtomics::AtomicRead(&Head))
+		{
+			return false;
+		}
+
+		Slots[CurrentTail] = InSample;
+		FPlatformAtomics::AtomicStore(&Tail, NextTail);
+		return true;
+	}
+
+public:
+
+	//~ Consumer
+
+	/** @return false if the ring is empty. Otherwise the oldest sample, that stays in the ring. */
+	bool Peek(FSamplePtr& OutSample) const
+	{
+		const int32 CurrentHead = FPlatformAtomics::AtomicRead(&Head);
+		if (CurrentHead == FPlatformAtomics::AtomicRead(&Tail))
+		{
+			return false;
+		}
+
+		OutSample = Slots[CurrentHead];
+		return true;
+	}
+
+	/** Remove the oldest sample, if any. */
+	void Pop()
+	{
+		const int32 CurrentHead = FPlatformAtomics::AtomicRead(&Head);
+		if (CurrentHead != FPlatformAtomics::AtomicRead(&Tail))
+		{
+			Release(CurrentHead, (CurrentHead + 1) % Slots.Num());
+		}
+	}
+
+	/**
+	 * Remove the oldest sample if it overlaps the time range, like FMediaIOCoreSamples.
+	 *
+	 * @return false if the ring is empty or its oldest sample doesn't overlap the time range.
+	 */
+	template<typename OutputType>
+	bool FetchHead(const TRange<FTimespan>& InTimeRange, TSharedPtr<OutputType, ESPMode::ThreadSafe>& OutSample)
+	{
+		FSamplePtr Sample;
+		if (!Peek(Sample) || !Overlaps(*Sample, InTimeRange))
+		{
+			return false;
+		}
+
+		OutSample = Sample;
+		Pop();
+		return true;
+	}
+
+	/**
+	 * Remove the newest sample that overlaps the time range and every sample older than it.
+	 * Samples newer than the returned one stay in the ring. Only for streams where a newer sample replaces the older ones, like video.
+	 *
+	 * @return false if no sample overlaps the time range.
+	 */
+	template<typename OutputType>
+	bool FetchNewest(const TRange<FTimespan>& InTimeRange, TSharedPtr<OutputType, ESPMode::ThreadSafe>& OutSample)
+	{
+		const int32 Size = Slots.Num();
+		const int32 CurrentHead = FPlatformAtomics::AtomicRead(&Head);
+		const int32 CurrentTail = FPlatformAtomics::AtomicRead(&Tail);
+
+		int32 FoundIndex = INDEX_NONE;
+		for (int32 Index = CurrentHead; Index != CurrentTail; Index = (Index + 1) % Size)
+		{
+			if (Overlaps(*Slots[Index], InTimeRange))
+			{
+				FoundIndex = Index;
+			}
+		}
+
+		if (FoundIndex == INDEX_NONE)
+		{
+			return false;
+		}
+
+		OutSample = Slots[FoundIndex];
+		Release(CurrentHead, (FoundIndex + 1) % Size);
+		return true;
+	}
+
+	/**
+	 * Remove the oldest samples until at most InMaxNum are left.
+	 *
+	 * @return the number of samples removed.
+	 */
+	int32 Trim(int32 InMaxNum)
+	{
+		const int32 NumToDrop = Num() - FMath::Max(InMaxNum, 0);
+		if (NumToDrop <= 0)
+		{
+			return 0;
+		}
+
+		const int32 CurrentHead = FPlatformAtomics::AtomicRead(&Head);
+		Release(CurrentHead, (CurrentHead + NumToDrop) % Slots.Num());
+		return NumToDrop;
+	}
+
+	/** Remove every sample. */
+	void Flush()
+	{
+		Trim(0);
+	}
+
+private:
+
+	static bool Overlaps(const SampleType& InSample, const TRange<FTimespan>& InTimeRange)
+	{
+		const FTimespan SampleTime = InSample.GetTime();
+		return InTimeRange.Overlaps(TRange<FTimespan>(SampleTime, SampleTime + InSample.GetDuration()));
+	}
+
+	/** Release the samples in [InFrom, InTo) and hand the slots back to the producer with a single index move. */
+	void Release(int32 InFrom, int32 InTo)
+	{
+		const int32 Size = Slots.Num();
+		for (int32 Index = InFrom; Index != InTo; Index = (Index + 1) % Size)
+		{
+			// Return the sample to its pool now instead of when the producer wraps around
+			Slots[Index].Reset();
+		}
+		FPlatformAtomics::AtomicStore(&Head, InTo);
+	}
+
+private:
+
+	/** Next slot to be read. Only written by the consumer. */
+	MS_ALIGN(PLATFORM_CACHE_LINE_SIZE) volatile int32 Head GCC_ALIGN(PLATFORM_CACHE_LINE_SIZE);
+
+	/** Next slot to be written. Only written by the producer. */
+	MS_ALIGN(PLATFORM_CACHE_LINE_SIZE) volatile int32 Tail GCC_ALIGN(PLATFORM_CACHE_LINE_SIZE);
+
+	/** Sample slots, sized once by Reset. */
+	MS_ALIGN(PLATFORM_CACHE_LINE_SIZE) TArray<FSamplePtr> Slots GCC_ALIGN(PLATFORM_CACHE_LINE_SIZE);
+};
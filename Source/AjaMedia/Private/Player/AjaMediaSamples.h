@@ -0,0 +1,130 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IMediaAudioSample.h"
+#include "IMediaBinarySample.h"
+#include "IMediaSamples.h"
+#include "IMediaTextureSample.h"
+
+#include "AjaMediaLatencyTrace.h"
+#include "AjaMediaSampleRing.h"
+#include "AjaMediaTextureSample.h"
+
+/**
+ * Sample queues of the AJA player. One ring per stream.
+ *
+ * The AJA thread is the only producer and the game thread, that fetches, trims and flushes, is the only consumer.
+ * Ancillary data of the 2 fields are kept in separate rings, so a field 2 packet never waits behind a field 1 packet.
+ * They are fetched and trimmed as one queue, in the order of their time.
+ * Audio and metadata samples are fetched one at a time from the oldest. Video skips to the newest sample of the time range.
+ */
+class FAjaMediaSamples
+	: public IMediaSamples
+{
+public:
+
+	/**
+	 * Size the rings. Not thread safe, must be called before the capture starts.
+	 */
+	void Initialize(int32 InMaxNumAudioSamples, int32 InMaxNumMetadataSamples, int32 InMaxNumVideoSamples)
+	{
+		AudioSamples.Reset(InMaxNumAudioSamples);
+		AncSamples.Reset(InMaxNumMetadataSamples);
+		AncF2Samples.Reset(InMaxNumMetadataSamples);
+		VideoSamples.Reset(InMaxNumVideoSamples);
+	}
+
+	//~ Producer
+
+	bool AddAudio(const TSharedRef<IMediaAudioSample, ESPMode::ThreadSafe>& InSample) { return AudioSamples.Enqueue(InSample); }
+	bool AddAncillary(const TSharedRef<IMediaBinarySample, ESPMode::ThreadSafe>& InSample) { return AncSamples.Enqueue(InSample); }
+	bool AddAncillaryF2(const TSharedRef<IMediaBinarySample, ESPMode::ThreadSafe>& InSample) { return AncF2Samples.Enqueue(InSample); }
+	bool AddVideo(const TSharedRef<FAjaMediaTextureSample, ESPMode::ThreadSafe>& InSample) { return VideoSamples.Enqueue(InSample); }
+
+	int32 NumAudioSamples() const { return AudioSamples.Num(); }
+	/** Ancillary samples of both fields. */
+	int32 NumMetadataSamples() const { return AncSamples.Num() + AncF2Samples.Num(); }
+	int32 NumVideoSamples() const { return VideoSamples.Num(); }
+
+	//~ Consumer
+
+	/**
+	 * Drop the oldest samples of every stream so at most the given number is left in each. The 2 ancillary rings count as one stream.
+	 * Returns the number of samples dropped per stream.
+	 */
+	void Trim(int32 InMaxNumAudioSamples, int32 InMaxNumMetadataSamples, int32 InMaxNumVideoSamples, int32& OutAudioDropped, int32& OutMetadataDropped, int32& OutVideoDropped)
+	{
+		OutAudioDropped = AudioSamples.Trim(InMaxNumAudioSamples);
+		OutMetadataDropped = 0;
+		while (NumMetadataSamples() > FMath::Max(InMaxNumMetadataSamples, 0))
+		{
+			GetOldestAncillaryRing()->Pop();
+			++OutMetadataDropped;
+		}
+		OutVideoDropped = VideoSamples.Trim(InMaxNumVideoSamples);
+	}
+
+public:
+
+	//~ IMediaSamples interface
+
+	virtual bool FetchAudio(TRange<FTimespan> TimeRange, TSharedPtr<IMediaAudioSample, ESPMode::ThreadSafe>& OutSample) override
+	{
+		return AudioSamples.FetchHead(TimeRange, OutSample);
+	}
+
+	virtual bool FetchMetadata(TRange<FTimespan> TimeRange, TSharedPtr<IMediaBinarySample, ESPMode::ThreadSafe>& OutSample) override
+	{
+		TAjaMediaSampleRing<IMediaBinarySample>* Oldest = GetOldestAncillaryRing();
+		return Oldest != nullptr && Oldest->FetchHead(TimeRange, OutSample);
+	}
+
+	virtual bool FetchVideo(TRange<FTimespan> TimeRange, TSharedPtr<IMediaTextureSample, ESPMode::ThreadSafe>& OutSample) override
+	{
+		TSharedPtr<FAjaMediaTextureSample, ESPMode::ThreadSafe> Sample;
+		if (!VideoSamples.FetchNewest(TimeRange, Sample))
+		{
+			return false;
+		}
+
+		FAjaMediaLatencyTrace::Stamp(Sample->GetTraceId(), EAjaMediaLatencyStage::Dequeued);
+		OutSample = Sample;
+		return true;
+	}
+
+	virtual void FlushSamples() override
+	{
+		AudioSamples.Flush();
+		AncSamples.Flush();
+		AncF2Samples.Flush();
+		VideoSamples.Flush();
+	}
+
+private:
+
+	/** @return the ancillary ring with the oldest sample, or nullptr if both are empty. Field 1 is older than field 2 of the same frame. */
+	TAjaMediaSampleRing<IMediaBinarySample>* GetOldestAncillaryRing()
+	{
+		TSharedPtr<IMediaBinarySample, ESPMode::ThreadSafe> F1Sample;
+		TSharedPtr<IMediaBinarySample, ESPMode::ThreadSafe> F2Sample;
+		const bool bHasF1 = AncSamples.Peek(F1Sample);
+		const bool bHasF2 = AncF2Samples.Peek(F2Sample);
+		if (bHasF1 && bHasF2)
+		{
+			return F2Sample->GetTime() < F1Sample->GetTime() ? &AncF2Samples : &AncSamples;
+		}
+		if (bHasF1)
+		{
+			return &AncSamples;
+		}
+		return bHasF2 ? &AncF2Samples : nullptr;
+	}
+
+private:
+
+	TAjaMediaSampleRing<IMediaAudioSample> AudioSamples;
+	TAjaMediaSampleRing<IMediaBinarySample> AncSamples;
+	TAjaMediaSampleRing<IMediaBinarySample> AncF2Samples;
+	TAjaMediaSampleRing<FAjaMediaTextureSample> VideoSamples;
+};
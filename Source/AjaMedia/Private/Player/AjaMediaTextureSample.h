@@ -5,8 +5,21 @@
 #include "MediaIOCoreTextureSampleBase.h"
 #include "MediaShaders.h"
 
+#include "AjaMediaLatencyTrace.h"
+#include "AjaMediaSamplePool.h"
+
+#include "HAL/UnrealMemory.h"
+
+namespace AjaMediaTextureSample
+{
+	/** Frames are page aligned, so the device can DMA straight into them. */
+	static const uint32 BufferAlignment = 4096;
+}
+
 /**
  * Implements a media texture sample for AjaMedia.
+ * The sample owns a page aligned buffer that is kept when the sample goes back to the pool.
+ * It only grows, so once the pool is warmed up no allocation happens while capturing.
  */
 class FAjaMediaTextureSample
 	: public FMediaIOCoreTextureSampleBase
@@ -15,8 +28,38 @@ class FAjaMediaTextureSample
 
 public:
 
+	FAjaMediaTextureSample()
+		: AlignedBuffer(nullptr)
+		, AlignedBufferCapacity(0)
+		, AlignedBufferSize(0)
+		, FieldOffset(0)
+		, TraceId(FAjaMediaLatencyTrace::InvalidTraceId)
+	{ }
+
+	virtual ~FAjaMediaTextureSample()
+	{
+		FMemory::Free(AlignedBuffer);
+	}
+
 	/**
-	 * Initialize the sample.
+	 * Copy the frame in the sample buffer, for when the device didn't fill it directly.
+	 *
+	 * @param InVideoData The video frame data.
+	 */
+	bool CopyFrame(const AJA::AJAVideoFrameData& InVideoData)
+	{
+		if (InVideoData.VideoBuffer == nullptr)
+		{
+			return false;
+		}
+
+		FMemory::Memcpy(RequestBuffer(InVideoData.VideoBufferSize), InVideoData.VideoBuffer, InVideoData.VideoBufferSize);
+		return true;
+	}
+
+	/**
+	 * Initialize the sample as the even field of the interlaced frame in its buffer.
+	 * No line is moved, the stride skips over the odd lines.
 	 *
 	 * @param InVideoData The video frame data.
 	 * @param InSampleFormat The sample format.
@@ -25,13 +68,11 @@ public:
 	 * @param InTimecode The sample timecode if available.
 	 * @param bInIsSRGB Whether the sample is in sRGB space.
 	 */
-	bool InitializeProgressive(const AJA::AJAVideoFrameData& InVideoData, EMediaTextureSampleFormat InSampleFormat, FTimespan InTime, const FFrameRate& InFrameRate, const TOptional<FTimecode>& InTimecode, bool bInIsSRGB)
+	bool InitializeEvenField(const AJA::AJAVideoFrameData& InVideoData, EMediaTextureSampleFormat InSampleFormat, FTimespan InTime, const FFrameRate& InFrameRate, const TOptional<FTimecode>& InTimecode, bool bInIsSRGB)
 	{
-		return Super::Initialize(InVideoData.VideoBuffer
-			, InVideoData.VideoBufferSize
-			, InVideoData.Stride
+		return SetProperties(InVideoData.Stride * 2
 			, InVideoData.Width
-			, InVideoData.Height
+			, InVideoData.Height / 2
 			, InSampleFormat
 			, InTime
 			, InFrameRate
@@ -40,24 +81,29 @@ public:
 	}
 
 	/**
-	 * Initialize the sample.
+	 * Initialize the sample as the odd field of an interlaced frame owned by another sample.
+	 * The sample keeps the frame alive and points one line into its buffer.
 	 *
+	 * @param InFrameSample The sample that holds the interlaced frame.
 	 * @param InVideoData The video frame data.
 	 * @param InSampleFormat The sample format.
 	 * @param InTime The sample time (in the player's own clock).
 	 * @param InFrameRate The framerate of the media that produce the sample.
 	 * @param InTimecode The sample timecode if available.
-	 * @param bEven Only take the even frame from the image.
 	 * @param bInIsSRGB Whether the sample is in sRGB space.
 	 */
-	bool InitializeInterlaced_Halfed(const AJA::AJAVideoFrameData& InVideoData, EMediaTextureSampleFormat InSampleFormat, FTimespan InTime, const FFrameRate& InFrameRate, const TOptional<FTimecode>& InTimecode, bool bInEven, bool bInIsSRGB)
+	bool InitializeOddField(const TSharedRef<FAjaMediaTextureSample, ESPMode::ThreadSafe>& InFrameSample, const AJA::AJAVideoFrameData& InVideoData, EMediaTextureSampleFormat InSampleFormat, FTimespan InTime, const FFrameRate& InFrameRate, const TOptional<FTimecode>& InTimecode, bool bInIsSRGB)
 	{
-		return Super::InitializeWithEvenOddLine(bInEven
-			, InVideoData.VideoBuffer
-			, InVideoData.VideoBufferSize
-			, InVideoData.Stride
+		if (InFrameSample->AlignedBufferSize < InVideoData.Stride * InVideoData.Height)
+		{
+			return false;
+		}
+
+		FrameSample = InFrameSample;
+		FieldOffset = InVideoData.Stride;
+		return SetProperties(InVideoData.Stride * 2
 			, InVideoData.Width
-			, InVideoData.Height
+			, InVideoData.Height / 2
 			, InSampleFormat
 			, InTime
 			, InFrameRate
@@ -65,6 +111,81 @@ public:
 			, bInIsSRGB);
 	}
 
+	/**
+	 * Request a page aligned buffer that the device can fill directly. SetProperties should still be called after.
+	 *
+	 * @param InBufferSize The size of the video buffer.
+	 */
+	virtual void* RequestBuffer(uint32 InBufferSize) override
+	{
+		if (InBufferSize > AlignedBufferCapacity)
+		{
+			FMemory::Free(AlignedBuffer);
+			AlignedBufferCapacity = AjaMediaSamplePool::GetSizeClass(InBufferSize);
+			AlignedBuffer = FMemory::Malloc(AlignedBufferCapacity, AjaMediaTextureSample::BufferAlignment);
+		}
+		AlignedBufferSize = InBufferSize;
+		return AlignedBuffer;
+	}
+
+	/** Set the latency trace record of the frame. The upload is stamped the first time the buffer is read. */
+	void SetTraceId(uint32 InTraceId)
+	{
+		TraceId = InTraceId;
+	}
+
+	uint32 GetTraceId() const
+	{
+		return TraceId;
+	}
+
+	/** @return the whole frame in the buffer of the sample, both fields for an interlaced frame. Doesn't stamp the latency trace. */
+	const void* GetFrameBuffer() const
+	{
+		return AlignedBuffer;
+	}
+
+	uint32 GetFrameBufferSize() const
+	{
+		return AlignedBufferSize;
+	}
+
+	/** @return the number of bytes reserved by this sample, even when it's in the pool. */
+	uint32 GetBufferCapacity() const
+	{
+		return AlignedBufferCapacity;
+	}
+
+	//~ IMediaTextureSample interface
+
+	virtual const void* GetBuffer() override
+	{
+		if (TraceId != FAjaMediaLatencyTrace::InvalidTraceId)
+		{
+			// The render thread reads the buffer to upload the texture
+			FAjaMediaLatencyTrace::Stamp(TraceId, EAjaMediaLatencyStage::Uploaded);
+			TraceId = FAjaMediaLatencyTrace::InvalidTraceId;
+		}
+
+		if (FrameSample.IsValid())
+		{
+			return static_cast<const uint8*>(FrameSample->AlignedBuffer) + FieldOffset;
+		}
+		return AlignedBufferSize > 0 ? AlignedBuffer : Super::GetBuffer();
+	}
+
+	//~ IMediaPoolable interface
+
+	virtual void ShutdownPoolable() override
+	{
+		// Keep the aligned buffer for the next frame
+		AlignedBufferSize = 0;
+		FrameSample.Reset();
+		FieldOffset = 0;
+		TraceId = FAjaMediaLatencyTrace::InvalidTraceId;
+		Super::ShutdownPoolable();
+	}
+
 	/**
 	 * Get YUV to RGB conversion matrix
 	 *
@@ -75,6 +196,19 @@ public:
 		return MediaShaders::YuvToRgbRec709Full;
 	}
 
+private:
+
+	/** Buffer filled by the device or by CopyFrame. */
+	void* AlignedBuffer;
+	uint32 AlignedBufferCapacity;
+	uint32 AlignedBufferSize;
+
+	/** When the sample is the odd field view, the sample that owns the interlaced frame. */
+	TSharedPtr<FAjaMediaTextureSample, ESPMode::ThreadSafe> FrameSample;
+	uint32 FieldOffset;
+
+	/** Latency trace record of the frame, until it is uploaded. */
+	uint32 TraceId;
 };
 
 /*
@@ -0,0 +1,38 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaAncillary.h"
+
+namespace AjaMediaAncillary
+{
+	int32 ParsePackets(const uint8* InBuffer, uint32 InSize, TArray<FAjaMediaAncillaryPacketIndex>& OutIndex)
+	{
+		OutIndex.Reset();
+		if (InBuffer == nullptr)
+		{
+			return 0;
+		}
+
+		uint32 Offset = 0;
+		while (Offset + HeaderSize <= InSize && InBuffer[Offset] == StartCode)
+		{
+			const uint8* Header = InBuffer + Offset;
+			const uint32 PacketSize = HeaderSize + Header[6];
+			if (Offset + PacketSize > InSize)
+			{
+				break;
+			}
+
+			FAjaMediaAncillaryPacketIndex& Index = OutIndex.AddDefaulted_GetRef();
+			Index.Offset = Offset + HeaderSize;
+			Index.DataCount = Header[6];
+			Index.DID = Header[4];
+			Index.SDID = Header[5];
+			Index.bField2 = (Header[1] & Flags::Field2) != 0;
+			Index.Line = (uint16)(((Header[1] & 0x0F) << 7) | (Header[2] & 0x7F));
+
+			Offset += PacketSize;
+		}
+
+		return OutIndex.Num();
+	}
+}
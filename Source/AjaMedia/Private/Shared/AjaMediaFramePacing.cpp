@@ -0,0 +1,183 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaFramePacing.h"
+
+#include "AjaMediaPrivate.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Stats/Stats2.h"
+
+DECLARE_STATS_GROUP(TEXT("AjaPacing"), STATGROUP_AjaPacing, STATCAT_Advanced);
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Wait for sync (ms)"), STAT_AjaPacing_Wait, STATGROUP_AjaPacing);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Idle (ms)"), STAT_AjaPacing_Idle, STATGROUP_AjaPacing);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Game frame (ms)"), STAT_AjaPacing_GameFrame, STATGROUP_AjaPacing);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Headroom (ms)"), STAT_AjaPacing_Headroom, STATGROUP_AjaPacing);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Missed syncs"), STAT_AjaPacing_MissedSyncs, STATGROUP_AjaPacing);
+
+namespace AjaMediaFramePacing
+{
+	/** Durations are bucketed by 50us, up to 100ms. Longer ones go in the last bucket. */
+	static const double BucketSize = 0.05;
+	static const int32 NumBuckets = 2000;
+
+	/** Fixed-size histogram of durations, in milliseconds. */
+	struct FHistogram
+	{
+		FHistogram()
+		{
+			Reset();
+		}
+
+		void Reset()
+		{
+			FMemory::Memzero(Buckets);
+			Count = 0;
+			Sum = 0.0;
+			Max = 0.0;
+		}
+
+		void Add(double InValue)
+		{
+			InValue = FMath::Max(InValue, 0.0);
+			++Buckets[FMath::Min((int32)(InValue / BucketSize), NumBuckets - 1)];
+			++Count;
+			Sum += InValue;
+			Max = FMath::Max(Max, InValue);
+		}
+
+		/** @return the upper bound of the bucket that holds the percentile. */
+		double GetPercentile(double InPercentile) const
+		{
+			if (Count == 0)
+			{
+				return 0.0;
+			}
+
+			const uint64 Rank = FMath::Max<uint64>((uint64)FMath::CeilToDouble(InPercentile * Count), 1);
+			uint64 Cumulated = 0;
+			for (int32 Index = 0; Index < NumBuckets - 1; ++Index)
+			{
+				Cumulated += Buckets[Index];
+				if (Cumulated >= Rank)
+				{
+					return FMath::Min((Index + 1) * BucketSize, Max);
+				}
+			}
+			return Max;
+		}
+
+		double GetMean() const { return Count > 0 ? Sum / Count : 0.0; }
+
+		uint32 Buckets[NumBuckets];
+		uint64 Count;
+		double Sum;
+		double Max;
+	};
+
+	/** Missed syncs per frame. The last bucket holds the frames that missed more. */
+	static const int32 NumMissedSyncsBuckets = 8;
+
+	FHistogram WaitHistogram;
+	FHistogram IdleHistogram;
+	FHistogram GameFrameHistogram;
+	uint64 MissedSyncsHistogram[NumMissedSyncsBuckets] = { 0 };
+	uint64 NumMissedSyncs = 0;
+	double LastSyncPeriod = 0.0;
+
+	static const double Percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+	void DumpHistogram(const TCHAR* InName, const FHistogram& InHistogram)
+	{
+		FString Line = FString::Printf(TEXT("  %-12s"), InName);
+		for (double Percentile : Percentiles)
+		{
+			Line += FString::Printf(TEXT(" %8.2f"), InHistogram.GetPercentile(Percentile));
+		}
+		Line += FString::Printf(TEXT(" %8.2f %8.2f"), InHistogram.Max, InHistogram.GetMean());
+		UE_LOG(LogAjaMedia, Display, TEXT("%s"), *Line);
+	}
+
+	static FAutoConsoleCommand AjaPacingDumpCmd(
+		TEXT("Aja.Pacing.Dump"),
+		TEXT("Log the percentiles of the frame pacing of the AJA custom time step."),
+		FConsoleCommandDelegate::CreateStatic(&FAjaMediaFramePacing::Dump)
+		);
+
+	static FAutoConsoleCommand AjaPacingResetCmd(
+		TEXT("Aja.Pacing.Reset"),
+		TEXT("Clear the frame pacing histograms of the AJA custom time step."),
+		FConsoleCommandDelegate::CreateStatic(&FAjaMediaFramePacing::Reset)
+		);
+}
+
+/* FAjaMediaFramePacing implementation
+*****************************************************************************/
+void FAjaMediaFramePacing::AddFrame(double InWaitTime, double InIdleTime, double InGameFrameTime, uint32 InNumMissedSyncs, double InSyncPeriod)
+{
+	using namespace AjaMediaFramePacing;
+	check(IsInGameThread());
+
+	WaitHistogram.Add(InWaitTime * 1000.0);
+	IdleHistogram.Add(InIdleTime * 1000.0);
+	SET_FLOAT_STAT(STAT_AjaPacing_Wait, InWaitTime * 1000.0);
+	SET_FLOAT_STAT(STAT_AjaPacing_Idle, InIdleTime * 1000.0);
+
+	if (InGameFrameTime >= 0.0)
+	{
+		GameFrameHistogram.Add(InGameFrameTime * 1000.0);
+		SET_FLOAT_STAT(STAT_AjaPacing_GameFrame, InGameFrameTime * 1000.0);
+		SET_FLOAT_STAT(STAT_AjaPacing_Headroom, (InSyncPeriod - InGameFrameTime) * 1000.0);
+	}
+
+	++MissedSyncsHistogram[FMath::Min<uint32>(InNumMissedSyncs, NumMissedSyncsBuckets - 1)];
+	NumMissedSyncs += InNumMissedSyncs;
+	INC_DWORD_STAT_BY(STAT_AjaPacing_MissedSyncs, InNumMissedSyncs);
+
+	LastSyncPeriod = InSyncPeriod;
+}
+
+void FAjaMediaFramePacing::Reset()
+{
+	using namespace AjaMediaFramePacing;
+
+	WaitHistogram.Reset();
+	IdleHistogram.Reset();
+	GameFrameHistogram.Reset();
+	FMemory::Memzero(MissedSyncsHistogram);
+	NumMissedSyncs = 0;
+}
+
+void FAjaMediaFramePacing::Dump()
+{
+	using namespace AjaMediaFramePacing;
+
+	if (WaitHistogram.Count == 0)
+	{
+		UE_LOG(LogAjaMedia, Display, TEXT("No frame was paced by an AJA custom time step."));
+		return;
+	}
+
+	const double PeriodMs = LastSyncPeriod * 1000.0;
+	UE_LOG(LogAjaMedia, Display, TEXT("AJA frame pacing over %llu frames, sync period %.2f ms."), WaitHistogram.Count, PeriodMs);
+	UE_LOG(LogAjaMedia, Display, TEXT("  %-12s %8s %8s %8s %8s %8s %8s"), TEXT("(ms)"), TEXT("p50"), TEXT("p90"), TEXT("p99"), TEXT("p99.9"), TEXT("max"), TEXT("mean"));
+	DumpHistogram(TEXT("Wait"), WaitHistogram);
+	DumpHistogram(TEXT("Idle"), IdleHistogram);
+	DumpHistogram(TEXT("Game frame"), GameFrameHistogram);
+
+	// The headroom left to the game frame, at the same percentiles
+	FString HeadroomLine = FString::Printf(TEXT("  %-12s"), TEXT("Headroom"));
+	for (double Percentile : Percentiles)
+	{
+		HeadroomLine += FString::Printf(TEXT(" %8.2f"), PeriodMs - GameFrameHistogram.GetPercentile(Percentile));
+	}
+	HeadroomLine += FString::Printf(TEXT(" %8.2f %8.2f"), PeriodMs - GameFrameHistogram.Max, PeriodMs - GameFrameHistogram.GetMean());
+	UE_LOG(LogAjaMedia, Display, TEXT("%s"), *HeadroomLine);
+
+	FString MissedLine;
+	for (int32 Index = 0; Index < NumMissedSyncsBuckets; ++Index)
+	{
+		MissedLine += FString::Printf(Index == NumMissedSyncsBuckets - 1 ? TEXT(" %d+: %llu") : TEXT(" %d: %llu"), Index, MissedSyncsHistogram[Index]);
+	}
+	UE_LOG(LogAjaMedia, Display, TEXT("  Missed syncs: %llu in total. Frames per number of missed syncs:%s"), NumMissedSyncs, *MissedLine);
+}
@@ -0,0 +1,33 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Frame pacing of the engine when it is driven by an AJA custom time step.
+ *
+ * Every frame, the time waited for the sync, the idle time, the duration of the game frame and the number of syncs missed are
+ * recorded in fixed-size histograms. The last frame is in "stat AjaPacing", and Aja.Pacing.Dump logs the percentiles.
+ * Everything is accessed from the game thread.
+ */
+class FAjaMediaFramePacing
+{
+public:
+
+	/**
+	 * Record a frame. Times are in seconds.
+	 * @param InWaitTime Time blocked waiting for the sync.
+	 * @param InIdleTime Idle time given to the engine.
+	 * @param InGameFrameTime Time between the end of the previous wait and the start of this one. Negative if there's no previous frame.
+	 * @param InNumMissedSyncs Syncs that went by since the previous frame, without a frame.
+	 * @param InSyncPeriod Period of the sync.
+	 */
+	static void AddFrame(double InWaitTime, double InIdleTime, double InGameFrameTime, uint32 InNumMissedSyncs, double InSyncPeriod);
+
+	/** Clear the histograms. */
+	static void Reset();
+
+	/** Log the percentiles of the histograms. */
+	static void Dump();
+};
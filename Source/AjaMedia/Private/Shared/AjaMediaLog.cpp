@@ -0,0 +1,379 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaLog.h"
+
+#include "AjaMediaPrivate.h"
+
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformAtomics.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Logging/LogMacros.h"
+
+namespace AjaMediaLog
+{
+	static TAutoConsoleVariable<int32> CVarAsync(
+		TEXT("Aja.Log.Async"),
+		1,
+		TEXT("Log the messages of the AJA threads from a background thread. 0 to log them synchronously, still rate limited."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<int32> CVarMaxPerSecond(
+		TEXT("Aja.Log.MaxPerSecond"),
+		5,
+		TEXT("Messages logged per second by a call site of the AJA threads. The others are coalesced. 0 for no limit."),
+		ECVF_Default);
+
+	/** Size of the queue, a power of 2. */
+	static const int32 QueueCapacity = 256;
+
+	/** A message longer than that is truncated. */
+	static const int32 MaxMessageLength = 512;
+
+	/** Size of the table of call sites, a power of 2. When it is full, the new call sites are not rate limited. */
+	static const int32 NumSites = 512;
+	static const int32 MaxSiteProbes = 16;
+
+	/** A call site is remembered by the beginning of its format. */
+	static const int32 MaxFormatLength = 128;
+
+	/** The queue is drained at that interval. */
+	static const uint32 DrainIntervalMs = 50;
+
+	/**
+	 * A slot of the queue. The sequence tells who owns it: the producers write the slot when it equals the enqueue position,
+	 * the log thread reads it when it equals the position + 1.
+	 */
+	struct FSlot
+	{
+		volatile int32 Sequence;
+		FName Category;
+		ELogVerbosity::Type Verbosity;
+		TCHAR Text[MaxMessageLength];
+	};
+
+	struct FSite
+	{
+		/** The format pointer, nullptr while the entry is free. */
+		void* volatile Key;
+		/** Set once the rest of the entry is written by the thread that took it. */
+		volatile int32 bReady;
+
+		volatile int32 Second;
+		volatile int32 NumInSecond;
+		volatile int32 NumSuppressed;
+
+		FName Category;
+		ELogVerbosity::Type Verbosity;
+		TCHAR Format[MaxFormatLength];
+	};
+
+	/** Bounded multi-producer/single-consumer queue, the log thread being the only consumer. */
+	FSlot Slots[QueueCapacity];
+	volatile int32 EnqueuePosition = 0;
+	int32 DequeuePosition = 0;
+	volatile int32 NumDropped = 0;
+
+	FSite Sites[NumSites];
+
+	class FLogThread;
+	FLogThread* Thread = nullptr;
+	volatile int32 bRunning = 0;
+
+	/** Producers that saw bRunning and may still reserve or publish a slot. Shutdown waits for them before the last drain. */
+	volatile int32 NumProducers = 0;
+
+	void Write(FName InCategory, ELogVerbosity::Type InVerbosity, const TCHAR* InText)
+	{
+#if !NO_LOGGING
+		FMsg::Logf(__FILE__, __LINE__, InCategory, InVerbosity, TEXT("%s"), InText);
+#endif
+	}
+
+	void ResetQueue()
+	{
+		for (int32 Index = 0; Index < QueueCapacity; ++Index)
+		{
+			Slots[Index].Sequence = Index;
+		}
+		EnqueuePosition = 0;
+		DequeuePosition = 0;
+		NumDropped = 0;
+	}
+
+	/** @return the site of the format, nullptr if it can't be rate limited. */
+	FSite* FindOrAddSite(const FLogCategoryBase& InCategory, ELogVerbosity::Type InVerbosity, const TCHAR* InFormat)
+	{
+		void* Key = (void*)InFormat;
+		const uint32 Hash = PointerHash(InFormat);
+		for (int32 Probe = 0; Probe < MaxSiteProbes; ++Probe)
+		{
+			FSite& Site = Sites[(Hash + Probe) & (NumSites - 1)];
+			void* SiteKey = Site.Key;
+			if (SiteKey == nullptr)
+			{
+				SiteKey = FPlatformAtomics::InterlockedCompareExchangePointer((void**)&Site.Key, Key, nullptr);
+				if (SiteKey == nullptr)
+				{
+					Site.Category = InCategory.GetCategoryName();
+					Site.Verbosity = InVerbosity;
+					FCString::Strncpy(Site.Format, InFormat, MaxFormatLength);
+					Site.Second = 0;
+					Site.NumInSecond = 0;
+					Site.NumSuppressed = 0;
+					FPlatformAtomics::InterlockedExchange(&Site.bReady, 1);
+					return &Site;
+				}
+			}
+
+			if (SiteKey == Key)
+			{
+				return FPlatformAtomics::AtomicRead(&Site.bReady) ? &Site : nullptr;
+			}
+		}
+		return nullptr;
+	}
+
+	/** @return false if the site already logged enough messages this second. */
+	bool AcquireSite(FSite& InSite)
+	{
+		const int32 MaxPerSecond = CVarMaxPerSecond.GetValueOnAnyThread();
+		if (MaxPerSecond <= 0)
+		{
+			return true;
+		}
+
+		// Racing threads may let a few more messages through when the second changes, that's fine
+		const int32 Now = (int32)FPlatformTime::Seconds();
+		if (FPlatformAtomics::AtomicRead(&InSite.Second) != Now)
+		{
+			FPlatformAtomics::InterlockedExchange(&InSite.Second, Now);
+			FPlatformAtomics::InterlockedExchange(&InSite.NumInSecond, 0);
+		}
+
+		if (FPlatformAtomics::InterlockedIncrement(&InSite.NumInSecond) > MaxPerSecond)
+		{
+			FPlatformAtomics::InterlockedIncrement(&InSite.NumSuppressed);
+			return false;
+		}
+		return true;
+	}
+
+	/** @return the slot reserved for the message, nullptr if the queue is full. */
+	FSlot* BeginEnqueue()
+	{
+		int32 Position = FPlatformAtomics::AtomicRead(&EnqueuePosition);
+		for (;;)
+		{
+			FSlot& Slot = Slots[Position & (QueueCapacity - 1)];
+			const int32 Difference = FPlatformAtomics::AtomicRead(&Slot.Sequence) - Position;
+			if (Difference == 0)
+			{
+				const int32 PreviousPosition = FPlatformAtomics::InterlockedCompareExchange(&EnqueuePosition, Position + 1, Position);
+				if (PreviousPosition == Position)
+				{
+					return &Slot;
+				}
+				Position = PreviousPosition;
+			}
+			else if (Difference < 0)
+			{
+				return nullptr;
+			}
+			else
+			{
+				Position = FPlatformAtomics::AtomicRead(&EnqueuePosition);
+			}
+		}
+	}
+
+	void EndEnqueue(FSlot& InSlot)
+	{
+		// Publish the slot to the log thread. The sequence of a reserved slot is its position.
+		FPlatformAtomics::InterlockedIncrement(&InSlot.Sequence);
+	}
+
+	/** Log every message in the queue. Only called by the log thread, or once it is stopped. */
+	void Drain()
+	{
+		for (;;)
+		{
+			FSlot& Slot = Slots[DequeuePosition & (QueueCapacity - 1)];
+			if (FPlatformAtomics::AtomicRead(&Slot.Sequence) != DequeuePosition + 1)
+			{
+				break;
+			}
+
+			Write(Slot.Category, Slot.Verbosity, Slot.Text);
+
+			FPlatformAtomics::InterlockedExchange(&Slot.Sequence, DequeuePosition + QueueCapacity);
+			++DequeuePosition;
+		}
+
+		const int32 Dropped = FPlatformAtomics::InterlockedExchange(&NumDropped, 0);
+		if (Dropped > 0)
+		{
+			Write(LogAjaMedia.GetCategoryName(), ELogVerbosity::Warning, *FString::Printf(TEXT("%d messages of the AJA threads were dropped, the log queue was full."), Dropped));
+		}
+	}
+
+	/** Log the number of messages each site suppressed since the last summary. */
+	void Summarize()
+	{
+		for (FSite& Site : Sites)
+		{
+			if (FPlatformAtomics::AtomicRead(&Site.bReady))
+			{
+				const int32 Suppressed = FPlatformAtomics::InterlockedExchange(&Site.NumSuppressed, 0);
+				if (Suppressed > 0)
+				{
+					Write(Site.Category, Site.Verbosity, *FString::Printf(TEXT("%d occurrences in the last second of: %s"), Suppressed, Site.Format));
+				}
+			}
+		}
+	}
+
+	class FLogThread : public FRunnable
+	{
+	public:
+		FLogThread()
+			: bStopping(false)
+			, WakeUpEvent(FPlatformProcess::GetSynchEventFromPool(false))
+			, Thread(nullptr)
+		{
+			Thread = FRunnableThread::Create(this, TEXT("AjaMediaLog"), 0, TPri_BelowNormal);
+		}
+
+		virtual ~FLogThread()
+		{
+			FPlatformAtomics::InterlockedExchange(&bStopping, true);
+			WakeUpEvent->Trigger();
+			Thread->WaitForCompletion();
+			delete Thread;
+			FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+		}
+
+		//~ FRunnable interface
+		virtual uint32 Run() override
+		{
+			double LastSummaryTime = FPlatformTime::Seconds();
+			while (!bStopping)
+			{
+				// Polled, waking up the thread would cost a system call to the producers
+				WakeUpEvent->Wait(DrainIntervalMs);
+				Drain();
+
+				const double Now = FPlatformTime::Seconds();
+				if (Now - LastSummaryTime >= 1.0)
+				{
+					Summarize();
+					LastSummaryTime = Now;
+				}
+			}
+			return 0;
+		}
+
+	private:
+		volatile int32 bStopping;
+		FEvent* WakeUpEvent;
+		FRunnableThread* Thread;
+	};
+}
+
+/* FAjaMediaLog implementation
+*****************************************************************************/
+void FAjaMediaLog::Startup()
+{
+	using namespace AjaMediaLog;
+	check(IsInGameThread());
+
+	if (Thread == nullptr)
+	{
+		ResetQueue();
+		Thread = new FLogThread();
+		FPlatformAtomics::InterlockedExchange(&bRunning, 1);
+	}
+}
+
+void FAjaMediaLog::Shutdown()
+{
+	using namespace AjaMediaLog;
+	check(IsInGameThread());
+
+	if (Thread)
+	{
+		// The messages that are still queued are logged from here
+		FPlatformAtomics::InterlockedExchange(&bRunning, 0);
+		delete Thread;
+		Thread = nullptr;
+
+		// Drain stops at the first slot that is reserved but not published yet, wait for the producers to publish theirs
+		while (FPlatformAtomics::AtomicRead(&NumProducers) != 0)
+		{
+			FPlatformProcess::YieldThread();
+		}
+		Drain();
+		Summarize();
+	}
+}
+
+void FAjaMediaLog::Log(const FLogCategoryBase& InCategory, ELogVerbosity::Type InVerbosity, const TCHAR* InFormat, ...)
+{
+	va_list Args;
+	va_start(Args, InFormat);
+	LogV(InCategory, InVerbosity, InFormat, Args);
+	va_end(Args);
+}
+
+void FAjaMediaLog::LogV(const FLogCategoryBase& InCategory, ELogVerbosity::Type InVerbosity, const TCHAR* InFormat, va_list InArgs)
+{
+#if !NO_LOGGING
+	using namespace AjaMediaLog;
+
+	if (InCategory.IsSuppressed(InVerbosity))
+	{
+		return;
+	}
+
+	if ((InVerbosity & ELogVerbosity::VerbosityMask) != ELogVerbosity::Fatal)
+	{
+		if (FSite* Site = FindOrAddSite(InCategory, InVerbosity, InFormat))
+		{
+			if (!AcquireSite(*Site))
+			{
+				return;
+			}
+		}
+
+		if (CVarAsync.GetValueOnAnyThread() != 0)
+		{
+			// Counted before bRunning is read, so Shutdown either sees the producer or the producer sees the shutdown
+			FPlatformAtomics::InterlockedIncrement(&NumProducers);
+			if (FPlatformAtomics::AtomicRead(&bRunning))
+			{
+				if (FSlot* Slot = BeginEnqueue())
+				{
+					Slot->Category = InCategory.GetCategoryName();
+					Slot->Verbosity = InVerbosity;
+					FCString::GetVarArgs(Slot->Text, MaxMessageLength, InFormat, InArgs);
+					EndEnqueue(*Slot);
+				}
+				else
+				{
+					FPlatformAtomics::InterlockedIncrement(&NumDropped);
+				}
+				FPlatformAtomics::InterlockedDecrement(&NumProducers);
+				return;
+			}
+			FPlatformAtomics::InterlockedDecrement(&NumProducers);
+		}
+	}
+
+	TCHAR Text[MaxMessageLength];
+	FCString::GetVarArgs(Text, MaxMessageLength, InFormat, InArgs);
+	Write(InCategory.GetCategoryName(), InVerbosity, Text);
+#endif // !NO_LOGGING
+}
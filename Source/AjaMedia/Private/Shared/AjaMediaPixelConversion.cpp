@@ -0,0 +1,1292 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaPixelConversion.h"
+
+#include "AjaMediaPrivate.h"
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <immintrin.h>
+#if PLATFORM_WINDOWS
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// MSVC compiles any intrinsic, clang and gcc only the ones of the target of the function
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AJA_TARGET_SSE41
+#define AJA_TARGET_AVX2
+#else
+#define AJA_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define AJA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#define AJA_SIMD_ROW(Function) &Function
+#else
+#define AJA_SIMD_ROW(Function) nullptr
+#endif
+
+namespace AjaMediaPixelConversion
+{
+	enum class EInstructionSet : int32
+	{
+		Scalar,
+		SSE41,
+		AVX2,
+	};
+
+	static TAutoConsoleVariable<int32> CVarAjaPixelConversionMaxInstructionSet(
+		TEXT("Aja.PixelConversion.MaxInstructionSet"),
+		2,
+		TEXT("Highest instruction set of the AJA pixel conversions. 0: scalar, 1: SSE4.1, 2: AVX2. The CPU may support less."),
+		ECVF_Default);
+
+	const TCHAR* GetInstructionSetName(EInstructionSet InSet)
+	{
+		switch (InSet)
+		{
+		case EInstructionSet::AVX2: return TEXT("AVX2");
+		case EInstructionSet::SSE41: return TEXT("SSE4.1");
+		default: return TEXT("Scalar");
+		}
+	}
+
+	EInstructionSet DetectInstructionSet()
+	{
+#if PLATFORM_CPU_X86_FAMILY
+		auto CpuId = [](int32 InLeaf, uint32 OutInfo[4])
+		{
+#if PLATFORM_WINDOWS
+			__cpuidex(reinterpret_cast<int32*>(OutInfo), InLeaf, 0);
+#else
+			__cpuid_count(InLeaf, 0, OutInfo[0], OutInfo[1], OutInfo[2], OutInfo[3]);
+#endif
+		};
+
+		uint32 Info[4];
+		CpuId(0, Info);
+		const uint32 MaxLeaf = Info[0];
+		CpuId(1, Info);
+		const bool bSSE41 = (Info[2] & (1 << 19)) != 0;
+
+		// AVX also needs the OS to save the YMM registers
+		bool bAVX = (Info[2] & (1 << 27)) != 0 && (Info[2] & (1 << 28)) != 0;
+		if (bAVX)
+		{
+#if PLATFORM_WINDOWS
+			const uint64 EnabledFeatures = _xgetbv(0);
+#else
+			uint32 Low, High;
+			__asm__ volatile("xgetbv" : "=a"(Low), "=d"(High) : "c"(0));
+			const uint64 EnabledFeatures = ((uint64)High << 32) | Low;
+#endif
+			bAVX = (EnabledFeatures & 6) == 6;
+		}
+
+		bool bAVX2 = false;
+		if (bAVX && MaxLeaf >= 7)
+		{
+			CpuId(7, Info);
+			bAVX2 = (Info[1] & (1 << 5)) != 0;
+		}
+
+		if (bSSE41 && bAVX2)
+		{
+			return EInstructionSet::AVX2;
+		}
+		if (bSSE41)
+		{
+			return EInstructionSet::SSE41;
+		}
+#endif
+		return EInstructionSet::Scalar;
+	}
+
+	EInstructionSet GetSupportedInstructionSet()
+	{
+		static const EInstructionSet SupportedSet = DetectInstructionSet();
+		return SupportedSet;
+	}
+
+	EInstructionSet GetInstructionSet()
+	{
+		const int32 MaxSet = FMath::Clamp(CVarAjaPixelConversionMaxInstructionSet.GetValueOnAnyThread(), 0, (int32)EInstructionSet::AVX2);
+		return (EInstructionSet)FMath::Min(MaxSet, (int32)GetSupportedInstructionSet());
+	}
+
+	/** @return the row function of the instruction set, or of the best set below it that has one. */
+	template<typename FunctionType>
+	FunctionType SelectRow(const FunctionType (&InRows)[3], EInstructionSet InSet)
+	{
+		int32 Set = (int32)InSet;
+		while (Set > 0 && InRows[Set] == nullptr)
+		{
+			--Set;
+		}
+		return InRows[Set];
+	}
+
+	template<typename T>
+	T* GetRow(void* InFrame, uint32 InStride, uint32 InRow)
+	{
+		return reinterpret_cast<T*>(static_cast<uint8*>(InFrame) + (SIZE_T)InStride * InRow);
+	}
+
+	template<typename T>
+	const T* GetRow(const void* InFrame, uint32 InStride, uint32 InRow)
+	{
+		return reinterpret_cast<const T*>(static_cast<const uint8*>(InFrame) + (SIZE_T)InStride * InRow);
+	}
+
+	/** YCbCr to RGB, with 13 fractional bits. */
+	struct FYUVToRGB
+	{
+		int16 Y;
+		int16 RV;
+		int16 GU;
+		int16 GV;
+		int16 BU;
+	};
+
+	static const int32 YUVToRGBShift = 13;
+	static const int32 YUVToRGBRounding = 1 << (YUVToRGBShift - 1);
+
+	/** Indexed by EAjaMediaColorMatrix. */
+	static const FYUVToRGB YUVToRGBCoefficients[] =
+	{
+		{ 9539, 14686, -1747, -4366, 17305 },
+		{ 9539, 13075, -3209, -6660, 16525 },
+	};
+
+	/** RGB to YCbCr, with 15 fractional bits. The chroma is computed from the sum of a pixel pair, so with one more shift. The chroma rows sum to 0. */
+	struct FRGBToYUV
+	{
+		int16 YR;
+		int16 YG;
+		int16 YB;
+		int16 UR;
+		int16 UG;
+		int16 UB;
+		int16 VR;
+		int16 VG;
+		int16 VB;
+	};
+
+	static const int32 RGBToYShift = 15;
+	static const int32 RGBToYBias = (16 << RGBToYShift) + (1 << (RGBToYShift - 1));
+	static const int32 RGBToUVShift = 16;
+	static const int32 RGBToUVBias = (128 << RGBToUVShift) + (1 << (RGBToUVShift - 1));
+
+	/** Indexed by EAjaMediaColorMatrix. */
+	static const FRGBToYUV RGBToYUVCoefficients[] =
+	{
+		{ 5983, 20127, 2032, -3298, -11094, 14392, 14392, -13073, -1319 },
+		{ 8414, 16520, 3208, -4857, -9535, 14392, 14392, -12052, -2340 },
+	};
+
+	inline uint8 ClampToByte(int32 InValue)
+	{
+		return (uint8)FMath::Clamp(InValue, 0, 255);
+	}
+
+	/** Two 16-bit values in a 32-bit lane, for _mm_madd_epi16. */
+	inline int32 PackPair(int16 InLow, int16 InHigh)
+	{
+		return (int32)(((uint32)(uint16)InHigh << 16) | (uint16)InLow);
+	}
+
+	/* Scalar rows. They are also the tails of the vector rows.
+	 *****************************************************************************/
+
+	// A v210 row is the U Y V Y components of its pixels, 3 per 32-bit word, in the low 30 bits
+
+	inline uint16 GetV210Component(const uint32* InSource, uint32 InIndex)
+	{
+		return (uint16)(((InSource[InIndex / 3] >> (InIndex % 3 * 10)) << 6) & 0xFFC0);
+	}
+
+	inline uint32 GetNumV210Words(uint32 InWidth)
+	{
+		return FMath::DivideAndRoundUp(InWidth, 6u) * 4;
+	}
+
+	void V210ToYUV16Row_Scalar(const uint32* InSource, uint16* OutDestination, uint32 InWidth)
+	{
+		const uint32 NumComponents = InWidth * 2;
+		uint32 Index = 0;
+		for (; Index + 3 <= NumComponents; Index += 3)
+		{
+			const uint32 Word = InSource[Index / 3];
+			OutDestination[Index + 0] = (uint16)((Word << 6) & 0xFFC0);
+			OutDestination[Index + 1] = (uint16)((Word >> 4) & 0xFFC0);
+			OutDestination[Index + 2] = (uint16)((Word >> 14) & 0xFFC0);
+		}
+		for (; Index < NumComponents; ++Index)
+		{
+			OutDestination[Index] = GetV210Component(InSource, Index);
+		}
+	}
+
+	void YUV16ToV210Row_Scalar(const uint16* InSource, uint32* OutDestination, uint32 InWidth)
+	{
+		const uint32 NumComponents = InWidth * 2;
+		const uint32 NumWords = GetNumV210Words(InWidth);
+		for (uint32 WordIndex = 0; WordIndex < NumWords; ++WordIndex)
+		{
+			uint32 Word = 0;
+			for (uint32 Field = 0; Field < 3; ++Field)
+			{
+				const uint32 Index = WordIndex * 3 + Field;
+				if (Index < NumComponents)
+				{
+					Word |= (uint32)(InSource[Index] >> 6) << (Field * 10);
+				}
+			}
+			OutDestination[WordIndex] = Word;
+		}
+	}
+
+	/** @return where the component of a v210 row goes in the planes. */
+	inline uint16* GetPlanarComponent(uint16* InY, uint16* InU, uint16* InV, uint32 InIndex)
+	{
+		const uint32 Pair = InIndex / 4;
+		switch (InIndex % 4)
+		{
+		case 0: return InU + Pair;
+		case 1: return InY + Pair * 2;
+		case 2: return InV + Pair;
+		default: return InY + Pair * 2 + 1;
+		}
+	}
+
+	void V210ToPlanarYUV16Row_Scalar(const uint32* InSource, uint16* OutY, uint16* OutU, uint16* OutV, uint32 InWidth)
+	{
+		const uint32 NumComponents = InWidth * 2;
+		for (uint32 Index = 0; Index < NumComponents; ++Index)
+		{
+			*GetPlanarComponent(OutY, OutU, OutV, Index) = GetV210Component(InSource, Index);
+		}
+	}
+
+	void PlanarYUV16ToV210Row_Scalar(const uint16* InY, const uint16* InU, const uint16* InV, uint32* OutDestination, uint32 InWidth)
+	{
+		const uint32 NumComponents = InWidth * 2;
+		const uint32 NumWords = GetNumV210Words(InWidth);
+		for (uint32 WordIndex = 0; WordIndex < NumWords; ++WordIndex)
+		{
+			uint32 Word = 0;
+			for (uint32 Field = 0; Field < 3; ++Field)
+			{
+				const uint32 Index = WordIndex * 3 + Field;
+				if (Index < NumComponents)
+				{
+					const uint16 Value = *GetPlanarComponent(const_cast<uint16*>(InY), const_cast<uint16*>(InU), const_cast<uint16*>(InV), Index);
+					Word |= (uint32)(Value >> 6) << (Field * 10);
+				}
+			}
+			OutDestination[WordIndex] = Word;
+		}
+	}
+
+	void UYVYToBGRARow_Scalar(const uint8* InSource, uint8* OutDestination, uint32 InWidth, const FYUVToRGB& InCoefficients)
+	{
+		for (uint32 Pair = 0; Pair < InWidth / 2; ++Pair, InSource += 4, OutDestination += 8)
+		{
+			const int32 U = InSource[0] - 128;
+			const int32 V = InSource[2] - 128;
+			for (int32 Index = 0; Index < 2; ++Index)
+			{
+				const int32 Y = InCoefficients.Y * (InSource[1 + Index * 2] - 16) + YUVToRGBRounding;
+				uint8* Pixel = OutDestination + Index * 4;
+				Pixel[0] = ClampToByte((Y + InCoefficients.BU * U) >> YUVToRGBShift);
+				Pixel[1] = ClampToByte((Y + InCoefficients.GU * U + InCoefficients.GV * V) >> YUVToRGBShift);
+				Pixel[2] = ClampToByte((Y + InCoefficients.RV * V) >> YUVToRGBShift);
+				Pixel[3] = 0xFF;
+			}
+		}
+	}
+
+	void BGRAToUYVYRow_Scalar(const uint8* InSource, uint8* OutDestination, uint32 InWidth, const FRGBToYUV& InCoefficients)
+	{
+		for (uint32 Pair = 0; Pair < InWidth / 2; ++Pair, InSource += 8, OutDestination += 4)
+		{
+			const uint8* Pixel0 = InSource;
+			const uint8* Pixel1 = InSource + 4;
+			OutDestination[1] = ClampToByte((InCoefficients.YR * Pixel0[2] + InCoefficients.YG * Pixel0[1] + InCoefficients.YB * Pixel0[0] + RGBToYBias) >> RGBToYShift);
+			OutDestination[3] = ClampToByte((InCoefficients.YR * Pixel1[2] + InCoefficients.YG * Pixel1[1] + InCoefficients.YB * Pixel1[0] + RGBToYBias) >> RGBToYShift);
+
+			const int32 R = Pixel0[2] + Pixel1[2];
+			const int32 G = Pixel0[1] + Pixel1[1];
+			const int32 B = Pixel0[0] + Pixel1[0];
+			OutDestination[0] = ClampToByte((InCoefficients.UR * R + InCoefficients.UG * G + InCoefficients.UB * B + RGBToUVBias) >> RGBToUVShift);
+			OutDestination[2] = ClampToByte((InCoefficients.VR * R + InCoefficients.VG * G + InCoefficients.VB * B + RGBToUVBias) >> RGBToUVShift);
+		}
+	}
+
+	inline uint16 Expand10To16(uint32 InValue)
+	{
+		return (uint16)((InValue << 6) | (InValue >> 4));
+	}
+
+	void BGR10A2ToRGBA16Row_Scalar(const uint32* InSource, uint16* OutDestination, uint32 InWidth)
+	{
+		for (uint32 Pixel = 0; Pixel < InWidth; ++Pixel, OutDestination += 4)
+		{
+			const uint32 Word = InSource[Pixel];
+			OutDestination[0] = Expand10To16(Word & 0x3FF);
+			OutDestination[1] = Expand10To16((Word >> 10) & 0x3FF);
+			OutDestination[2] = Expand10To16((Word >> 20) & 0x3FF);
+			OutDestination[3] = (uint16)((Word >> 30) * 0x5555);
+		}
+	}
+
+	void RGBA16ToBGR10A2Row_Scalar(const uint16* InSource, uint32* OutDestination, uint32 InWidth)
+	{
+		for (uint32 Pixel = 0; Pixel < InWidth; ++Pixel, InSource += 4)
+		{
+			OutDestination[Pixel] = (uint32)(InSource[0] >> 6)
+				| ((uint32)(InSource[1] >> 6) << 10)
+				| ((uint32)(InSource[2] >> 6) << 20)
+				| ((uint32)(InSource[3] >> 14) << 30);
+		}
+	}
+
+#if PLATFORM_CPU_X86_FAMILY
+	/* Vector rows. Every access is unaligned, the part of a row that doesn't fill a vector is done by the scalar rows.
+	 *****************************************************************************/
+
+	/** Byte of a shuffle mask that clears the byte. */
+	static const uint8 Z = 0x80;
+
+	// v210 words split in their 3 fields, each shifted to the top of 16 bits. AB holds the first and second fields, CC the third one twice.
+	static const uint8 V210ToYUV16Shuffles[4][16] =
+	{
+		{ 0, 1, 8, 9, Z, Z, 2, 3, 10, 11, Z, Z, 4, 5, 12, 13 }, // AB to components 0-7
+		{ Z, Z, Z, Z, 0, 1, Z, Z, Z, Z, 2, 3, Z, Z, Z, Z },     // CC to components 0-7
+		{ Z, Z, 6, 7, 14, 15, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z },   // AB to components 8-11
+		{ 4, 5, Z, Z, Z, Z, 6, 7, Z, Z, Z, Z, Z, Z, Z, Z },     // CC to components 8-11
+	};
+
+	static const uint8 V210ToPlanarShuffles[6][16] =
+	{
+		{ 8, 9, 2, 3, Z, Z, 12, 13, 6, 7, Z, Z, Z, Z, Z, Z },   // AB to Y
+		{ Z, Z, Z, Z, 2, 3, Z, Z, Z, Z, 6, 7, Z, Z, Z, Z },     // CC to Y
+		{ 0, 1, 10, 11, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z },   // AB to U
+		{ Z, Z, Z, Z, 4, 5, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z },     // CC to U
+		{ Z, Z, 4, 5, 14, 15, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z },   // AB to V
+		{ 0, 1, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z },     // CC to V
+	};
+
+	// Components to the 3 fields of the v210 words, zero extended to 32 bits
+	static const uint8 YUV16ToV210Shuffles[6][16] =
+	{
+		{ 0, 1, Z, Z, 6, 7, Z, Z, 12, 13, Z, Z, Z, Z, Z, Z },   // Components 0-7 to the first field
+		{ Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, 2, 3, Z, Z },     // Components 8-11 to the first field
+		{ 2, 3, Z, Z, 8, 9, Z, Z, 14, 15, Z, Z, Z, Z, Z, Z },   // Components 0-7 to the second field
+		{ Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, 4, 5, Z, Z },     // Components 8-11 to the second field
+		{ 4, 5, Z, Z, 10, 11, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z },   // Components 0-7 to the third field
+		{ Z, Z, Z, Z, Z, Z, Z, Z, 0, 1, Z, Z, 6, 7, Z, Z },     // Components 8-11 to the third field
+	};
+
+	// The planes are loaded as Y0-Y7 and U0-U3 V0-V3
+	static const uint8 PlanarToV210Shuffles[6][16] =
+	{
+		{ Z, Z, Z, Z, 2, 3, Z, Z, Z, Z, Z, Z, 8, 9, Z, Z },     // Y to the first field
+		{ 0, 1, Z, Z, Z, Z, Z, Z, 10, 11, Z, Z, Z, Z, Z, Z },   // UV to the first field
+		{ 0, 1, Z, Z, Z, Z, Z, Z, 6, 7, Z, Z, Z, Z, Z, Z },     // Y to the second field
+		{ Z, Z, Z, Z, 2, 3, Z, Z, Z, Z, Z, Z, 12, 13, Z, Z },   // UV to the second field
+		{ Z, Z, Z, Z, 4, 5, Z, Z, Z, Z, Z, Z, 10, 11, Z, Z },   // Y to the third field
+		{ 8, 9, Z, Z, Z, Z, Z, Z, 4, 5, Z, Z, Z, Z, Z, Z },     // UV to the third field
+	};
+
+	// UYVY components zero extended to 16 bits, the chroma repeated for the two pixels of the pair
+	static const uint8 UYVYShuffles[3][16] =
+	{
+		{ 1, Z, 3, Z, 5, Z, 7, Z, 9, Z, 11, Z, 13, Z, 15, Z },  // Y
+		{ 0, Z, 0, Z, 4, Z, 4, Z, 8, Z, 8, Z, 12, Z, 12, Z },   // U
+		{ 2, Z, 2, Z, 6, Z, 6, Z, 10, Z, 10, Z, 14, Z, 14, Z }, // V
+	};
+
+	static const uint8 BGRAShuffles[3][16] =
+	{
+		{ 2, Z, 1, Z, 6, Z, 5, Z, 10, Z, 9, Z, 14, Z, 13, Z },  // R and G of each pixel, zero extended to 16 bits
+		{ 0, Z, Z, Z, 4, Z, Z, Z, 8, Z, Z, Z, 12, Z, Z, Z },    // B of each pixel, zero extended to 32 bits
+		{ 0, 4, 1, 5, 2, 6, 3, 7, Z, Z, Z, Z, Z, Z, Z, Z },     // U0-U3 V0-V3 to U0 V0 U1 V1...
+	};
+
+	inline __m128i LoadShuffle(const uint8* InShuffle)
+	{
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(InShuffle));
+	}
+
+	AJA_TARGET_AVX2 inline __m256i LoadShuffle256(const uint8* InShuffle)
+	{
+		return _mm256_broadcastsi128_si256(LoadShuffle(InShuffle));
+	}
+
+	AJA_TARGET_SSE41 void V210ToYUV16Row_SSE41(const uint32* InSource, uint16* OutDestination, uint32 InWidth)
+	{
+		const uint32 NumGroups = InWidth / 6;
+		const __m128i Mask = _mm_set1_epi32(0xFFC0);
+		const __m128i ShuffleAB0 = LoadShuffle(V210ToYUV16Shuffles[0]);
+		const __m128i ShuffleCC0 = LoadShuffle(V210ToYUV16Shuffles[1]);
+		const __m128i ShuffleAB1 = LoadShuffle(V210ToYUV16Shuffles[2]);
+		const __m128i ShuffleCC1 = LoadShuffle(V210ToYUV16Shuffles[3]);
+
+		uint32 Group = 0;
+		for (; Group < NumGroups; ++Group)
+		{
+			const __m128i Words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(InSource + Group * 4));
+			const __m128i A = _mm_and_si128(_mm_slli_epi32(Words, 6), Mask);
+			const __m128i B = _mm_and_si128(_mm_srli_epi32(Words, 4), Mask);
+			const __m128i C = _mm_and_si128(_mm_srli_epi32(Words, 14), Mask);
+			const __m128i AB = _mm_packus_epi32(A, B);
+			const __m128i CC = _mm_packus_epi32(C, C);
+
+			uint16* Destination = OutDestination + Group * 12;
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Destination), _mm_or_si128(_mm_shuffle_epi8(AB, ShuffleAB0), _mm_shuffle_epi8(CC, ShuffleCC0)));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(Destination + 8), _mm_or_si128(_mm_shuffle_epi8(AB, ShuffleAB1), _mm_shuffle_epi8(CC, ShuffleCC1)));
+		}
+
+		V210ToYUV16Row_Scalar(InSource + Group * 4, OutDestination + Group * 12, InWidth - Group * 6);
+	}
+
+	AJA_TARGET_AVX2 void V210ToYUV16Row_AVX2(const uint32* InSource, uint16* OutDestination, uint32 InWidth)
+	{
+		const uint32 NumGroups = InWidth / 6;
+		const __m256i Mask = _mm256_set1_epi32(0xFFC0);
+		const __m256i ShuffleAB0 = LoadShuffle256(V210ToYUV16Shuffles[0]);
+		const __m256i ShuffleCC0 = LoadShuffle256(V210ToYUV16Shuffles[1]);
+		const __m256i ShuffleAB1 = LoadShuffle256(V210ToYUV16Shuffles[2]);
+		const __m256i ShuffleCC1 = LoadShuffle256(V210ToYUV16Shuffles[3]);
+
+		// Two groups at a time, one per lane
+		uint32 Group = 0;
+		for (; Group + 2 <= NumGroups; Group += 2)
+		{
+			const __m256i Words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(InSource + Group * 4));
+			const __m256i A = _mm256_and_si256(_mm256_slli_epi32(Words, 6), Mask);
+			const __m256i B = _mm256_and_si256(_mm256_srli_epi32(Words, 4), Mask);
+			const __m256i C = _mm256_and_si256(_mm256_srli_epi32(Words, 14), Mask);
+			const __m256i AB = _mm256_packus_epi32(A, B);
+			const __m256i CC = _mm256_packus_epi32(C, C);
+			const __m256i Components0 = _mm256_or_si256(_mm256_shuffle_epi8(AB, ShuffleAB0), _mm256_shuffle_epi8(CC, ShuffleCC0));
+			const __m256i Components1 = _mm256_or_si256(_mm256_shuffle_epi8(AB, ShuffleAB1), _mm256_shuffle_epi8(CC, ShuffleCC1));
+
+			uint16* Destination = OutDestination + Group * 12;
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Destination), _mm256_castsi256_si128(Components0));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(Destination + 8), _mm256_castsi256_si128(Components1));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Destination + 12), _mm256_extracti128_si256(Components0, 1));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(Destination + 20), _mm256_extracti128_si256(Components1, 1));
+		}
+
+		V210ToYUV16Row_Scalar(InSource + Group * 4, OutDestination + Group * 12, InWidth - Group * 6);
+	}
+
+	AJA_TARGET_SSE41 void YUV16ToV210Row_SSE41(const uint16* InSource, uint32* OutDestination, uint32 InWidth)
+	{
+		const uint32 NumGroups = InWidth / 6;
+		__m128i Shuffles[6];
+		for (int32 Index = 0; Index < 6; ++Index)
+		{
+			Shuffles[Index] = LoadShuffle(YUV16ToV210Shuffles[Index]);
+		}
+
+		uint32 Group = 0;
+		for (; Group < NumGroups; ++Group)
+		{
+			const uint16* Source = InSource + Group * 12;
+			const __m128i Components0 = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Source)), 6);
+			const __m128i Components1 = _mm_srli_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(Source + 8)), 6);
+			const __m128i A = _mm_or_si128(_mm_shuffle_epi8(Components0, Shuffles[0]), _mm_shuffle_epi8(Components1, Shuffles[1]));
+			const __m128i B = _mm_or_si128(_mm_shuffle_epi8(Components0, Shuffles[2]), _mm_shuffle_epi8(Components1, Shuffles[3]));
+			const __m128i C = _mm_or_si128(_mm_shuffle_epi8(Components0, Shuffles[4]), _mm_shuffle_epi8(Components1, Shuffles[5]));
+			const __m128i Words = _mm_or_si128(A, _mm_or_si128(_mm_slli_epi32(B, 10), _mm_slli_epi32(C, 20)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutDestination + Group * 4), Words);
+		}
+
+		YUV16ToV210Row_Scalar(InSource + Group * 12, OutDestination + Group * 4, InWidth - Group * 6);
+	}
+
+	AJA_TARGET_SSE41 void V210ToPlanarYUV16Row_SSE41(const uint32* InSource, uint16* OutY, uint16* OutU, uint16* OutV, uint32 InWidth)
+	{
+		const uint32 NumGroups = InWidth / 6;
+		const __m128i Mask = _mm_set1_epi32(0xFFC0);
+		__m128i Shuffles[6];
+		for (int32 Index = 0; Index < 6; ++Index)
+		{
+			Shuffles[Index] = LoadShuffle(V210ToPlanarShuffles[Index]);
+		}
+
+		// The stores write a few components past the group, so the last group is left to the scalar row
+		uint32 Group = 0;
+		for (; Group + 1 < NumGroups; ++Group)
+		{
+			const __m128i Words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(InSource + Group * 4));
+			const __m128i A = _mm_and_si128(_mm_slli_epi32(Words, 6), Mask);
+			const __m128i B = _mm_and_si128(_mm_srli_epi32(Words, 4), Mask);
+			const __m128i C = _mm_and_si128(_mm_srli_epi32(Words, 14), Mask);
+			const __m128i AB = _mm_packus_epi32(A, B);
+			const __m128i CC = _mm_packus_epi32(C, C);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutY + Group * 6), _mm_or_si128(_mm_shuffle_epi8(AB, Shuffles[0]), _mm_shuffle_epi8(CC, Shuffles[1])));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(OutU + Group * 3), _mm_or_si128(_mm_shuffle_epi8(AB, Shuffles[2]), _mm_shuffle_epi8(CC, Shuffles[3])));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(OutV + Group * 3), _mm_or_si128(_mm_shuffle_epi8(AB, Shuffles[4]), _mm_shuffle_epi8(CC, Shuffles[5])));
+		}
+
+		V210ToPlanarYUV16Row_Scalar(InSource + Group * 4, OutY + Group * 6, OutU + Group * 3, OutV + Group * 3, InWidth - Group * 6);
+	}
+
+	AJA_TARGET_SSE41 void PlanarYUV16ToV210Row_SSE41(const uint16* InY, const uint16* InU, const uint16* InV, uint32* OutDestination, uint32 InWidth)
+	{
+		const uint32 NumGroups = InWidth / 6;
+		__m128i Shuffles[6];
+		for (int32 Index = 0; Index < 6; ++Index)
+		{
+			Shuffles[Index] = LoadShuffle(PlanarToV210Shuffles[Index]);
+		}
+
+		// The loads read a few components past the group, so the last group is left to the scalar row
+		uint32 Group = 0;
+		for (; Group + 1 < NumGroups; ++Group)
+		{
+			const __m128i Y = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(InY + Group * 6)), 6);
+			const __m128i U = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(InU + Group * 3));
+			const __m128i V = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(InV + Group * 3));
+			const __m128i UV = _mm_srli_epi16(_mm_unpacklo_epi64(U, V), 6);
+			const __m128i A = _mm_or_si128(_mm_shuffle_epi8(Y, Shuffles[0]), _mm_shuffle_epi8(UV, Shuffles[1]));
+			const __m128i B = _mm_or_si128(_mm_shuffle_epi8(Y, Shuffles[2]), _mm_shuffle_epi8(UV, Shuffles[3]));
+			const __m128i C = _mm_or_si128(_mm_shuffle_epi8(Y, Shuffles[4]), _mm_shuffle_epi8(UV, Shuffles[5]));
+			const __m128i Words = _mm_or_si128(A, _mm_or_si128(_mm_slli_epi32(B, 10), _mm_slli_epi32(C, 20)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutDestination + Group * 4), Words);
+		}
+
+		PlanarYUV16ToV210Row_Scalar(InY + Group * 6, InU + Group * 3, InV + Group * 3, OutDestination + Group * 4, InWidth - Group * 6);
+	}
+
+	AJA_TARGET_SSE41 void UYVYToBGRARow_SSE41(const uint8* InSource, uint8* OutDestination, uint32 InWidth, const FYUVToRGB& InCoefficients)
+	{
+		const __m128i ShuffleY = LoadShuffle(UYVYShuffles[0]);
+		const __m128i ShuffleU = LoadShuffle(UYVYShuffles[1]);
+		const __m128i ShuffleV = LoadShuffle(UYVYShuffles[2]);
+		const __m128i LumaOffset = _mm_set1_epi16(16);
+		const __m128i ChromaOffset = _mm_set1_epi16(128);
+		const __m128i CoefficientsR = _mm_set1_epi32(PackPair(InCoefficients.Y, InCoefficients.RV));
+		const __m128i CoefficientsG = _mm_set1_epi32(PackPair(InCoefficients.Y, InCoefficients.GU));
+		const __m128i CoefficientsGV = _mm_set1_epi32(PackPair(InCoefficients.GV, 0));
+		const __m128i CoefficientsB = _mm_set1_epi32(PackPair(InCoefficients.Y, InCoefficients.BU));
+		const __m128i Rounding = _mm_set1_epi32(YUVToRGBRounding);
+		const __m128i Zero = _mm_setzero_si128();
+		const __m128i Alpha = _mm_set1_epi8(-1);
+
+		// 8 pixels at a time
+		uint32 Pixel = 0;
+		for (; Pixel + 8 <= InWidth; Pixel += 8)
+		{
+			const __m128i Source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(InSource + Pixel * 2));
+			const __m128i Y = _mm_sub_epi16(_mm_shuffle_epi8(Source, ShuffleY), LumaOffset);
+			const __m128i U = _mm_sub_epi16(_mm_shuffle_epi8(Source, ShuffleU), ChromaOffset);
+			const __m128i V = _mm_sub_epi16(_mm_shuffle_epi8(Source, ShuffleV), ChromaOffset);
+
+			const __m128i YVLow = _mm_unpacklo_epi16(Y, V);
+			const __m128i YVHigh = _mm_unpackhi_epi16(Y, V);
+			const __m128i YULow = _mm_unpacklo_epi16(Y, U);
+			const __m128i YUHigh = _mm_unpackhi_epi16(Y, U);
+			const __m128i VLow = _mm_unpacklo_epi16(V, Zero);
+			const __m128i VHigh = _mm_unpackhi_epi16(V, Zero);
+
+			const __m128i R = _mm_packs_epi32(
+				_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(YVLow, CoefficientsR), Rounding), YUVToRGBShift),
+				_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(YVHigh, CoefficientsR), Rounding), YUVToRGBShift));
+			const __m128i G = _mm_packs_epi32(
+				_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(YULow, CoefficientsG), _mm_madd_epi16(VLow, CoefficientsGV)), Rounding), YUVToRGBShift),
+				_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(YUHigh, CoefficientsG), _mm_madd_epi16(VHigh, CoefficientsGV)), Rounding), YUVToRGBShift));
+			const __m128i B = _mm_packs_epi32(
+				_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(YULow, CoefficientsB), Rounding), YUVToRGBShift),
+				_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(YUHigh, CoefficientsB), Rounding), YUVToRGBShift));
+
+			const __m128i BG = _mm_unpacklo_epi8(_mm_packus_epi16(B, B), _mm_packus_epi16(G, G));
+			const __m128i RA = _mm_unpacklo_epi8(_mm_packus_epi16(R, R), Alpha);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutDestination + Pixel * 4), _mm_unpacklo_epi16(BG, RA));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutDestination + Pixel * 4 + 16), _mm_unpackhi_epi16(BG, RA));
+		}
+
+		UYVYToBGRARow_Scalar(InSource + Pixel * 2, OutDestination + Pixel * 4, InWidth - Pixel, InCoefficients);
+	}
+
+	AJA_TARGET_AVX2 void UYVYToBGRARow_AVX2(const uint8* InSource, uint8* OutDestination, uint32 InWidth, const FYUVToRGB& InCoefficients)
+	{
+		const __m256i ShuffleY = LoadShuffle256(UYVYShuffles[0]);
+		const __m256i ShuffleU = LoadShuffle256(UYVYShuffles[1]);
+		const __m256i ShuffleV = LoadShuffle256(UYVYShuffles[2]);
+		const __m256i LumaOffset = _mm256_set1_epi16(16);
+		const __m256i ChromaOffset = _mm256_set1_epi16(128);
+		const __m256i CoefficientsR = _mm256_set1_epi32(PackPair(InCoefficients.Y, InCoefficients.RV));
+		const __m256i CoefficientsG = _mm256_set1_epi32(PackPair(InCoefficients.Y, InCoefficients.GU));
+		const __m256i CoefficientsGV = _mm256_set1_epi32(PackPair(InCoefficients.GV, 0));
+		const __m256i CoefficientsB = _mm256_set1_epi32(PackPair(InCoefficients.Y, InCoefficients.BU));
+		const __m256i Rounding = _mm256_set1_epi32(YUVToRGBRounding);
+		const __m256i Zero = _mm256_setzero_si256();
+		const __m256i Alpha = _mm256_set1_epi8(-1);
+
+		// 16 pixels at a time, 8 per lane
+		uint32 Pixel = 0;
+		for (; Pixel + 16 <= InWidth; Pixel += 16)
+		{
+			const __m256i Source = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(InSource + Pixel * 2));
+			const __m256i Y = _mm256_sub_epi16(_mm256_shuffle_epi8(Source, ShuffleY), LumaOffset);
+			const __m256i U = _mm256_sub_epi16(_mm256_shuffle_epi8(Source, ShuffleU), ChromaOffset);
+			const __m256i V = _mm256_sub_epi16(_mm256_shuffle_epi8(Source, ShuffleV), ChromaOffset);
+
+			const __m256i YVLow = _mm256_unpacklo_epi16(Y, V);
+			const __m256i YVHigh = _mm256_unpackhi_epi16(Y, V);
+			const __m256i YULow = _mm256_unpacklo_epi16(Y, U);
+			const __m256i YUHigh = _mm256_unpackhi_epi16(Y, U);
+			const __m256i VLow = _mm256_unpacklo_epi16(V, Zero);
+			const __m256i VHigh = _mm256_unpackhi_epi16(V, Zero);
+
+			const __m256i R = _mm256_packs_epi32(
+				_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(YVLow, CoefficientsR), Rounding), YUVToRGBShift),
+				_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(YVHigh, CoefficientsR), Rounding), YUVToRGBShift));
+			const __m256i G = _mm256_packs_epi32(
+				_mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(YULow, CoefficientsG), _mm256_madd_epi16(VLow, CoefficientsGV)), Rounding), YUVToRGBShift),
+				_mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(YUHigh, CoefficientsG), _mm256_madd_epi16(VHigh, CoefficientsGV)), Rounding), YUVToRGBShift));
+			const __m256i B = _mm256_packs_epi32(
+				_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(YULow, CoefficientsB), Rounding), YUVToRGBShift),
+				_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(YUHigh, CoefficientsB), Rounding), YUVToRGBShift));
+
+			// Each lane holds pixels 0-3 in its low half and 4-7 in its high half
+			const __m256i BG = _mm256_unpacklo_epi8(_mm256_packus_epi16(B, B), _mm256_packus_epi16(G, G));
+			const __m256i RA = _mm256_unpacklo_epi8(_mm256_packus_epi16(R, R), Alpha);
+			const __m256i Pixels0 = _mm256_unpacklo_epi16(BG, RA);
+			const __m256i Pixels1 = _mm256_unpackhi_epi16(BG, RA);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(OutDestination + Pixel * 4), _mm256_permute2x128_si256(Pixels0, Pixels1, 0x20));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(OutDestination + Pixel * 4 + 32), _mm256_permute2x128_si256(Pixels0, Pixels1, 0x31));
+		}
+
+		UYVYToBGRARow_Scalar(InSource + Pixel * 2, OutDestination + Pixel * 4, InWidth - Pixel, InCoefficients);
+	}
+
+	AJA_TARGET_SSE41 void BGRAToUYVYRow_SSE41(const uint8* InSource, uint8* OutDestination, uint32 InWidth, const FRGBToYUV& InCoefficients)
+	{
+		const __m128i ShuffleRG = LoadShuffle(BGRAShuffles[0]);
+		const __m128i ShuffleB = LoadShuffle(BGRAShuffles[1]);
+		const __m128i ShuffleChroma = LoadShuffle(BGRAShuffles[2]);
+		const __m128i CoefficientsYRG = _mm_set1_epi32(PackPair(InCoefficients.YR, InCoefficients.YG));
+		const __m128i CoefficientsYB = _mm_set1_epi32(PackPair(InCoefficients.YB, 0));
+		const __m128i CoefficientsURG = _mm_set1_epi32(PackPair(InCoefficients.UR, InCoefficients.UG));
+		const __m128i CoefficientsUB = _mm_set1_epi32(PackPair(InCoefficients.UB, 0));
+		const __m128i CoefficientsVRG = _mm_set1_epi32(PackPair(InCoefficients.VR, InCoefficients.VG));
+		const __m128i CoefficientsVB = _mm_set1_epi32(PackPair(InCoefficients.VB, 0));
+		const __m128i YBias = _mm_set1_epi32(RGBToYBias);
+		const __m128i UVBias = _mm_set1_epi32(RGBToUVBias);
+
+		// 8 pixels at a time
+		uint32 Pixel = 0;
+		for (; Pixel + 8 <= InWidth; Pixel += 8)
+		{
+			const __m128i Source0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(InSource + Pixel * 4));
+			const __m128i Source1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(InSource + Pixel * 4 + 16));
+			const __m128i RG0 = _mm_shuffle_epi8(Source0, ShuffleRG);
+			const __m128i RG1 = _mm_shuffle_epi8(Source1, ShuffleRG);
+			const __m128i B0 = _mm_shuffle_epi8(Source0, ShuffleB);
+			const __m128i B1 = _mm_shuffle_epi8(Source1, ShuffleB);
+
+			const __m128i Y = _mm_packs_epi32(
+				_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(RG0, CoefficientsYRG), _mm_madd_epi16(B0, CoefficientsYB)), YBias), RGBToYShift),
+				_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(RG1, CoefficientsYRG), _mm_madd_epi16(B1, CoefficientsYB)), YBias), RGBToYShift));
+
+			// Sum of the pixel pairs. The components can't carry into each other.
+			const __m128i RGSum = _mm_hadd_epi32(RG0, RG1);
+			const __m128i BSum = _mm_hadd_epi32(B0, B1);
+			const __m128i UV = _mm_packs_epi32(
+				_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(RGSum, CoefficientsURG), _mm_madd_epi16(BSum, CoefficientsUB)), UVBias), RGBToUVShift),
+				_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(RGSum, CoefficientsVRG), _mm_madd_epi16(BSum, CoefficientsVB)), UVBias), RGBToUVShift));
+
+			const __m128i Chroma = _mm_shuffle_epi8(_mm_packus_epi16(UV, UV), ShuffleChroma);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutDestination + Pixel * 2), _mm_unpacklo_epi8(Chroma, _mm_packus_epi16(Y, Y)));
+		}
+
+		BGRAToUYVYRow_Scalar(InSource + Pixel * 4, OutDestination + Pixel * 2, InWidth - Pixel, InCoefficients);
+	}
+
+	AJA_TARGET_SSE41 void BGR10A2ToRGBA16Row_SSE41(const uint32* InSource, uint16* OutDestination, uint32 InWidth)
+	{
+		const __m128i Mask = _mm_set1_epi32(0x3FF);
+		const __m128i AlphaScale = _mm_set1_epi32(0x5555);
+
+		// 4 pixels at a time
+		uint32 Pixel = 0;
+		for (; Pixel + 4 <= InWidth; Pixel += 4)
+		{
+			const __m128i Words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(InSource + Pixel));
+			const __m128i R = _mm_and_si128(Words, Mask);
+			const __m128i G = _mm_and_si128(_mm_srli_epi32(Words, 10), Mask);
+			const __m128i B = _mm_and_si128(_mm_srli_epi32(Words, 20), Mask);
+			const __m128i A = _mm_mullo_epi32(_mm_srli_epi32(Words, 30), AlphaScale);
+			const __m128i R16 = _mm_or_si128(_mm_slli_epi32(R, 6), _mm_srli_epi32(R, 4));
+			const __m128i G16 = _mm_or_si128(_mm_slli_epi32(G, 6), _mm_srli_epi32(G, 4));
+			const __m128i B16 = _mm_or_si128(_mm_slli_epi32(B, 6), _mm_srli_epi32(B, 4));
+			const __m128i RG = _mm_or_si128(R16, _mm_slli_epi32(G16, 16));
+			const __m128i BA = _mm_or_si128(B16, _mm_slli_epi32(A, 16));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutDestination + Pixel * 4), _mm_unpacklo_epi32(RG, BA));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutDestination + Pixel * 4 + 8), _mm_unpackhi_epi32(RG, BA));
+		}
+
+		BGR10A2ToRGBA16Row_Scalar(InSource + Pixel, OutDestination + Pixel * 4, InWidth - Pixel);
+	}
+
+	AJA_TARGET_AVX2 void BGR10A2ToRGBA16Row_AVX2(const uint32* InSource, uint16* OutDestination, uint32 InWidth)
+	{
+		const __m256i Mask = _mm256_set1_epi32(0x3FF);
+		const __m256i AlphaScale = _mm256_set1_epi32(0x5555);
+
+		// 8 pixels at a time
+		uint32 Pixel = 0;
+		for (; Pixel + 8 <= InWidth; Pixel += 8)
+		{
+			const __m256i Words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(InSource + Pixel));
+			const __m256i R = _mm256_and_si256(Words, Mask);
+			const __m256i G = _mm256_and_si256(_mm256_srli_epi32(Words, 10), Mask);
+			const __m256i B = _mm256_and_si256(_mm256_srli_epi32(Words, 20), Mask);
+			const __m256i A = _mm256_mullo_epi32(_mm256_srli_epi32(Words, 30), AlphaScale);
+			const __m256i R16 = _mm256_or_si256(_mm256_slli_epi32(R, 6), _mm256_srli_epi32(R, 4));
+			const __m256i G16 = _mm256_or_si256(_mm256_slli_epi32(G, 6), _mm256_srli_epi32(G, 4));
+			const __m256i B16 = _mm256_or_si256(_mm256_slli_epi32(B, 6), _mm256_srli_epi32(B, 4));
+			const __m256i RG = _mm256_or_si256(R16, _mm256_slli_epi32(G16, 16));
+			const __m256i BA = _mm256_or_si256(B16, _mm256_slli_epi32(A, 16));
+
+			// Pixels 0-1 and 4-5, then 2-3 and 6-7
+			const __m256i Pixels0 = _mm256_unpacklo_epi32(RG, BA);
+			const __m256i Pixels1 = _mm256_unpackhi_epi32(RG, BA);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(OutDestination + Pixel * 4), _mm256_permute2x128_si256(Pixels0, Pixels1, 0x20));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(OutDestination + Pixel * 4 + 16), _mm256_permute2x128_si256(Pixels0, Pixels1, 0x31));
+		}
+
+		BGR10A2ToRGBA16Row_Scalar(InSource + Pixel, OutDestination + Pixel * 4, InWidth - Pixel);
+	}
+
+	AJA_TARGET_SSE41 void RGBA16ToBGR10A2Row_SSE41(const uint16* InSource, uint32* OutDestination, uint32 InWidth)
+	{
+		// R + G * 1024 and B + A * 1024, the alpha being 2 bits
+		const __m128i Coefficients = _mm_set1_epi32(PackPair(1, 1024));
+		const __m128i LowMask = _mm_setr_epi32(-1, 0, -1, 0);
+
+		// 4 pixels at a time
+		uint32 Pixel = 0;
+		for (; Pixel + 4 <= InWidth; Pixel += 4)
+		{
+			__m128i Words[2];
+			for (int32 Index = 0; Index < 2; ++Index)
+			{
+				const __m128i Source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(InSource + Pixel * 4 + Index * 8));
+				const __m128i Components = _mm_blend_epi16(_mm_srli_epi16(Source, 6), _mm_srli_epi16(Source, 14), 0x88);
+				const __m128i Sums = _mm_madd_epi16(Components, Coefficients);
+				const __m128i Packed = _mm_or_si128(_mm_and_si128(Sums, LowMask), _mm_slli_epi32(_mm_srli_epi64(Sums, 32), 20));
+				Words[Index] = _mm_shuffle_epi32(Packed, _MM_SHUFFLE(3, 1, 2, 0));
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutDestination + Pixel), _mm_unpacklo_epi64(Words[0], Words[1]));
+		}
+
+		RGBA16ToBGR10A2Row_Scalar(InSource + Pixel * 4, OutDestination + Pixel, InWidth - Pixel);
+	}
+
+	AJA_TARGET_AVX2 void RGBA16ToBGR10A2Row_AVX2(const uint16* InSource, uint32* OutDestination, uint32 InWidth)
+	{
+		const __m256i Coefficients = _mm256_set1_epi32(PackPair(1, 1024));
+		const __m256i LowMask = _mm256_setr_epi32(-1, 0, -1, 0, -1, 0, -1, 0);
+
+		// 8 pixels at a time
+		uint32 Pixel = 0;
+		for (; Pixel + 8 <= InWidth; Pixel += 8)
+		{
+			__m256i Words[2];
+			for (int32 Index = 0; Index < 2; ++Index)
+			{
+				const __m256i Source = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(InSource + Pixel * 4 + Index * 16));
+				const __m256i Components = _mm256_blend_epi16(_mm256_srli_epi16(Source, 6), _mm256_srli_epi16(Source, 14), 0x88);
+				const __m256i Sums = _mm256_madd_epi16(Components, Coefficients);
+				const __m256i Packed = _mm256_or_si256(_mm256_and_si256(Sums, LowMask), _mm256_slli_epi32(_mm256_srli_epi64(Sums, 32), 20));
+				Words[Index] = _mm256_shuffle_epi32(Packed, _MM_SHUFFLE(3, 1, 2, 0));
+			}
+			// Pixels 0-1, 4-5, 2-3 and 6-7
+			const __m256i Pixels = _mm256_unpacklo_epi64(Words[0], Words[1]);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(OutDestination + Pixel), _mm256_permute4x64_epi64(Pixels, _MM_SHUFFLE(3, 1, 2, 0)));
+		}
+
+		RGBA16ToBGR10A2Row_Scalar(InSource + Pixel * 4, OutDestination + Pixel, InWidth - Pixel);
+	}
+#endif //PLATFORM_CPU_X86_FAMILY
+
+	/* Frames
+	 *****************************************************************************/
+
+	// Indexed by EInstructionSet. The AVX2 rows are only written when the data fills the 256-bit lanes without extra shuffles.
+
+	typedef void (*FV210ToYUV16Row)(const uint32*, uint16*, uint32);
+	static const FV210ToYUV16Row V210ToYUV16Rows[] = { &V210ToYUV16Row_Scalar, AJA_SIMD_ROW(V210ToYUV16Row_SSE41), AJA_SIMD_ROW(V210ToYUV16Row_AVX2) };
+
+	typedef void (*FYUV16ToV210Row)(const uint16*, uint32*, uint32);
+	static const FYUV16ToV210Row YUV16ToV210Rows[] = { &YUV16ToV210Row_Scalar, AJA_SIMD_ROW(YUV16ToV210Row_SSE41), nullptr };
+
+	typedef void (*FV210ToPlanarYUV16Row)(const uint32*, uint16*, uint16*, uint16*, uint32);
+	static const FV210ToPlanarYUV16Row V210ToPlanarYUV16Rows[] = { &V210ToPlanarYUV16Row_Scalar, AJA_SIMD_ROW(V210ToPlanarYUV16Row_SSE41), nullptr };
+
+	typedef void (*FPlanarYUV16ToV210Row)(const uint16*, const uint16*, const uint16*, uint32*, uint32);
+	static const FPlanarYUV16ToV210Row PlanarYUV16ToV210Rows[] = { &PlanarYUV16ToV210Row_Scalar, AJA_SIMD_ROW(PlanarYUV16ToV210Row_SSE41), nullptr };
+
+	typedef void (*FUYVYToBGRARow)(const uint8*, uint8*, uint32, const FYUVToRGB&);
+	static const FUYVYToBGRARow UYVYToBGRARows[] = { &UYVYToBGRARow_Scalar, AJA_SIMD_ROW(UYVYToBGRARow_SSE41), AJA_SIMD_ROW(UYVYToBGRARow_AVX2) };
+
+	typedef void (*FBGRAToUYVYRow)(const uint8*, uint8*, uint32, const FRGBToYUV&);
+	static const FBGRAToUYVYRow BGRAToUYVYRows[] = { &BGRAToUYVYRow_Scalar, AJA_SIMD_ROW(BGRAToUYVYRow_SSE41), nullptr };
+
+	typedef void (*FBGR10A2ToRGBA16Row)(const uint32*, uint16*, uint32);
+	static const FBGR10A2ToRGBA16Row BGR10A2ToRGBA16Rows[] = { &BGR10A2ToRGBA16Row_Scalar, AJA_SIMD_ROW(BGR10A2ToRGBA16Row_SSE41), AJA_SIMD_ROW(BGR10A2ToRGBA16Row_AVX2) };
+
+	typedef void (*FRGBA16ToBGR10A2Row)(const uint16*, uint32*, uint32);
+	static const FRGBA16ToBGR10A2Row RGBA16ToBGR10A2Rows[] = { &RGBA16ToBGR10A2Row_Scalar, AJA_SIMD_ROW(RGBA16ToBGR10A2Row_SSE41), AJA_SIMD_ROW(RGBA16ToBGR10A2Row_AVX2) };
+
+	void V210ToYUV16(EInstructionSet InSet, const void* InSource, uint32 InSourceStride, uint16* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight)
+	{
+		check(InWidth % 2 == 0);
+		const FV210ToYUV16Row Row = SelectRow(V210ToYUV16Rows, InSet);
+		for (uint32 Y = 0; Y < InHeight; ++Y)
+		{
+			Row(GetRow<uint32>(InSource, InSourceStride, Y), GetRow<uint16>(OutDestination, InDestinationStride, Y), InWidth);
+		}
+	}
+
+	void YUV16ToV210(EInstructionSet InSet, const uint16* InSource, uint32 InSourceStride, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight)
+	{
+		check(InWidth % 2 == 0);
+		const FYUV16ToV210Row Row = SelectRow(YUV16ToV210Rows, InSet);
+		for (uint32 Y = 0; Y < InHeight; ++Y)
+		{
+			Row(GetRow<uint16>(InSource, InSourceStride, Y), GetRow<uint32>(OutDestination, InDestinationStride, Y), InWidth);
+		}
+	}
+
+	void V210ToPlanarYUV16(EInstructionSet InSet, const void* InSource, uint32 InSourceStride, const FAjaMediaYUV16Planes& OutDestination, uint32 InWidth, uint32 InHeight)
+	{
+		check(InWidth % 2 == 0);
+		const FV210ToPlanarYUV16Row Row = SelectRow(V210ToPlanarYUV16Rows, InSet);
+		for (uint32 Y = 0; Y < InHeight; ++Y)
+		{
+			Row(GetRow<uint32>(InSource, InSourceStride, Y)
+				, GetRow<uint16>(OutDestination.Y, OutDestination.YStride, Y)
+				, GetRow<uint16>(OutDestination.U, OutDestination.UVStride, Y)
+				, GetRow<uint16>(OutDestination.V, OutDestination.UVStride, Y)
+				, InWidth);
+		}
+	}
+
+	void PlanarYUV16ToV210(EInstructionSet InSet, const FAjaMediaYUV16Planes& InSource, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight)
+	{
+		check(InWidth % 2 == 0);
+		const FPlanarYUV16ToV210Row Row = SelectRow(PlanarYUV16ToV210Rows, InSet);
+		for (uint32 Y = 0; Y < InHeight; ++Y)
+		{
+			Row(GetRow<uint16>(static_cast<const void*>(InSource.Y), InSource.YStride, Y)
+				, GetRow<uint16>(static_cast<const void*>(InSource.U), InSource.UVStride, Y)
+				, GetRow<uint16>(static_cast<const void*>(InSource.V), InSource.UVStride, Y)
+				, GetRow<uint32>(OutDestination, InDestinationStride, Y)
+				, InWidth);
+		}
+	}
+
+	void UYVYToBGRA(EInstructionSet InSet, const void* InSource, uint32 InSourceStride, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight, EAjaMediaColorMatrix InMatrix)
+	{
+		check(InWidth % 2 == 0);
+		const FUYVYToBGRARow Row = SelectRow(UYVYToBGRARows, InSet);
+		const FYUVToRGB& Coefficients = YUVToRGBCoefficients[(int32)InMatrix];
+		for (uint32 Y = 0; Y < InHeight; ++Y)
+		{
+			Row(GetRow<uint8>(InSource, InSourceStride, Y), GetRow<uint8>(OutDestination, InDestinationStride, Y), InWidth, Coefficients);
+		}
+	}
+
+	void BGRAToUYVY(EInstructionSet InSet, const void* InSource, uint32 InSourceStride, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight, EAjaMediaColorMatrix InMatrix)
+	{
+		check(InWidth % 2 == 0);
+		const FBGRAToUYVYRow Row = SelectRow(BGRAToUYVYRows, InSet);
+		const FRGBToYUV& Coefficients = RGBToYUVCoefficients[(int32)InMatrix];
+		for (uint32 Y = 0; Y < InHeight; ++Y)
+		{
+			Row(GetRow<uint8>(InSource, InSourceStride, Y), GetRow<uint8>(OutDestination, InDestinationStride, Y), InWidth, Coefficients);
+		}
+	}
+
+	void BGR10A2ToRGBA16(EInstructionSet InSet, const void* InSource, uint32 InSourceStride, uint16* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight)
+	{
+		const FBGR10A2ToRGBA16Row Row = SelectRow(BGR10A2ToRGBA16Rows, InSet);
+		for (uint32 Y = 0; Y < InHeight; ++Y)
+		{
+			Row(GetRow<uint32>(InSource, InSourceStride, Y), GetRow<uint16>(OutDestination, InDestinationStride, Y), InWidth);
+		}
+	}
+
+	void RGBA16ToBGR10A2(EInstructionSet InSet, const uint16* InSource, uint32 InSourceStride, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight)
+	{
+		const FRGBA16ToBGR10A2Row Row = SelectRow(RGBA16ToBGR10A2Rows, InSet);
+		for (uint32 Y = 0; Y < InHeight; ++Y)
+		{
+			Row(GetRow<uint16>(InSource, InSourceStride, Y), GetRow<uint32>(OutDestination, InDestinationStride, Y), InWidth);
+		}
+	}
+
+	/* Benchmark
+	 *****************************************************************************/
+
+	enum class EFormat : uint8
+	{
+		V210,
+		YUV16,
+		PlanarYUV16,
+		UYVY,
+		BGRA,
+		BGR10A2,
+		RGBA16,
+	};
+
+	const TCHAR* GetFormatName(EFormat InFormat)
+	{
+		switch (InFormat)
+		{
+		case EFormat::V210: return TEXT("v210");
+		case EFormat::YUV16: return TEXT("YUV16");
+		case EFormat::PlanarYUV16: return TEXT("planar YUV16");
+		case EFormat::UYVY: return TEXT("UYVY");
+		case EFormat::BGRA: return TEXT("BGRA");
+		case EFormat::BGR10A2: return TEXT("BGR10A2");
+		default: return TEXT("RGBA16");
+		}
+	}
+
+	/** Bytes of the pixels of a row. The luma row for the planar format. */
+	uint32 GetRowSize(EFormat InFormat, uint32 InWidth)
+	{
+		switch (InFormat)
+		{
+		case EFormat::V210: return GetNumV210Words(InWidth) * 4;
+		case EFormat::PlanarYUV16: return InWidth * 2;
+		case EFormat::UYVY: return InWidth * 2;
+		case EFormat::RGBA16: return InWidth * 8;
+		default: return InWidth * 4;
+		}
+	}
+
+	/**
+	 * Frame of the benchmark. The rows are padded and the frame is not 16-byte aligned, like the frames of a consumer may be.
+	 * The planes of the planar format follow each other.
+	 */
+	struct FBenchmarkFrame
+	{
+		static const uint32 Padding = 68;
+		static const uint32 Misalignment = 4;
+
+		FBenchmarkFrame(EFormat InFormat, uint32 InWidth, uint32 InHeight)
+			: Format(InFormat)
+			, Width(InWidth)
+			, Height(InHeight)
+			, Stride(GetRowSize(InFormat, InWidth) + Padding)
+			, UVStride(InWidth + Padding)
+		{
+			const uint64 Size = (uint64)Stride * Height + (Format == EFormat::PlanarYUV16 ? (uint64)UVStride * Height * 2 : 0);
+			Data.SetNumUninitialized((int32)Size + Misalignment);
+			FMemory::Memset(Data.GetData(), 0xCD, Data.Num());
+		}
+
+		uint8* GetData() { return Data.GetData() + Misalignment; }
+		const uint8* GetData() const { return Data.GetData() + Misalignment; }
+
+		FAjaMediaYUV16Planes GetPlanes()
+		{
+			FAjaMediaYUV16Planes Planes;
+			Planes.Y = reinterpret_cast<uint16*>(GetData());
+			Planes.U = reinterpret_cast<uint16*>(GetData() + (SIZE_T)Stride * Height);
+			Planes.V = reinterpret_cast<uint16*>(GetData() + (SIZE_T)Stride * Height + (SIZE_T)UVStride * Height);
+			Planes.YStride = Stride;
+			Planes.UVStride = UVStride;
+			return Planes;
+		}
+
+		/** Bytes of the pixels, without the padding. */
+		uint64 GetImageSize() const
+		{
+			return ((uint64)GetRowSize(Format, Width) + (Format == EFormat::PlanarYUV16 ? Width * 2 : 0)) * Height;
+		}
+
+		void Randomize(FRandomStream& InStream)
+		{
+			for (int32 Index = 0; Index + 4 <= Data.Num(); Index += 4)
+			{
+				const uint32 Value = InStream.GetUnsignedInt();
+				FMemory::Memcpy(Data.GetData() + Index, &Value, 4);
+			}
+		}
+
+		/** @return whether the pixels are the same. The padding is not compared. */
+		bool HasSamePixels(const FBenchmarkFrame& InOther) const
+		{
+			check(Format == InOther.Format && Width == InOther.Width && Height == InOther.Height);
+			const uint32 NumRows = Format == EFormat::PlanarYUV16 ? Height * 3 : Height;
+			for (uint32 Row = 0; Row < NumRows; ++Row)
+			{
+				// The rows of the chroma planes follow the rows of the luma plane
+				const bool bIsChroma = Row >= Height;
+				const SIZE_T Offset = bIsChroma ? (SIZE_T)Stride * Height + (SIZE_T)UVStride * (Row - Height) : (SIZE_T)Stride * Row;
+				const uint32 RowSize = bIsChroma ? Width : GetRowSize(Format, Width);
+				if (FMemory::Memcmp(GetData() + Offset, InOther.GetData() + Offset, RowSize) != 0)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		EFormat Format;
+		uint32 Width;
+		uint32 Height;
+		uint32 Stride;
+		uint32 UVStride;
+		TArray<uint8> Data;
+	};
+
+	void Convert(EInstructionSet InSet, FBenchmarkFrame& InSource, FBenchmarkFrame& OutDestination)
+	{
+		const uint32 Width = InSource.Width;
+		const uint32 Height = InSource.Height;
+		switch (InSource.Format)
+		{
+		case EFormat::V210:
+			if (OutDestination.Format == EFormat::PlanarYUV16)
+			{
+				V210ToPlanarYUV16(InSet, InSource.GetData(), InSource.Stride, OutDestination.GetPlanes(), Width, Height);
+			}
+			else
+			{
+				V210ToYUV16(InSet, InSource.GetData(), InSource.Stride, reinterpret_cast<uint16*>(OutDestination.GetData()), OutDestination.Stride, Width, Height);
+			}
+			break;
+		case EFormat::YUV16:
+			YUV16ToV210(InSet, reinterpret_cast<const uint16*>(InSource.GetData()), InSource.Stride, OutDestination.GetData(), OutDestination.Stride, Width, Height);
+			break;
+		case EFormat::PlanarYUV16:
+			PlanarYUV16ToV210(InSet, InSource.GetPlanes(), OutDestination.GetData(), OutDestination.Stride, Width, Height);
+			break;
+		case EFormat::UYVY:
+			UYVYToBGRA(InSet, InSource.GetData(), InSource.Stride, OutDestination.GetData(), OutDestination.Stride, Width, Height, EAjaMediaColorMatrix::Rec709);
+			break;
+		case EFormat::BGRA:
+			BGRAToUYVY(InSet, InSource.GetData(), InSource.Stride, OutDestination.GetData(), OutDestination.Stride, Width, Height, EAjaMediaColorMatrix::Rec709);
+			break;
+		case EFormat::BGR10A2:
+			BGR10A2ToRGBA16(InSet, InSource.GetData(), InSource.Stride, reinterpret_cast<uint16*>(OutDestination.GetData()), OutDestination.Stride, Width, Height);
+			break;
+		case EFormat::RGBA16:
+			RGBA16ToBGR10A2(InSet, reinterpret_cast<const uint16*>(InSource.GetData()), InSource.Stride, OutDestination.GetData(), OutDestination.Stride, Width, Height);
+			break;
+		}
+	}
+
+	struct FConversion
+	{
+		EFormat Source;
+		EFormat Destination;
+		/** Converted back, the source is found again. */
+		bool bLossless;
+	};
+
+	static const FConversion Conversions[] =
+	{
+		{ EFormat::V210, EFormat::YUV16, true },
+		{ EFormat::YUV16, EFormat::V210, false },
+		{ EFormat::V210, EFormat::PlanarYUV16, true },
+		{ EFormat::PlanarYUV16, EFormat::V210, false },
+		{ EFormat::UYVY, EFormat::BGRA, false },
+		{ EFormat::BGRA, EFormat::UYVY, false },
+		{ EFormat::BGR10A2, EFormat::RGBA16, true },
+		{ EFormat::RGBA16, EFormat::BGR10A2, false },
+	};
+
+	/** Fill the source of a conversion with random pixels. */
+	void RandomizeSource(FRandomStream& InStream, FBenchmarkFrame& OutSource)
+	{
+		OutSource.Randomize(InStream);
+		if (OutSource.Format == EFormat::V210)
+		{
+			// Without anything in the unused bits and in the padding of the last group, like the frames of a card
+			FBenchmarkFrame Components(EFormat::YUV16, OutSource.Width, OutSource.Height);
+			Components.Randomize(InStream);
+			Convert(EInstructionSet::Scalar, Components, OutSource);
+		}
+	}
+
+	void Benchmark(int32 InNumFrames)
+	{
+		static const FIntPoint Resolutions[] = { FIntPoint(1280, 720), FIntPoint(1920, 1080), FIntPoint(3840, 2160) };
+
+		UE_LOG(LogAjaMedia, Display, TEXT("The CPU supports %s. Aja.PixelConversion.MaxInstructionSet selects %s.")
+			, GetInstructionSetName(GetSupportedInstructionSet())
+			, GetInstructionSetName(GetInstructionSet()));
+
+		FRandomStream Stream(0x414A41);
+		for (const FIntPoint& Resolution : Resolutions)
+		{
+			const uint32 Width = (uint32)Resolution.X;
+			const uint32 Height = (uint32)Resolution.Y;
+
+			for (const FConversion& Conversion : Conversions)
+			{
+				FBenchmarkFrame Source(Conversion.Source, Width, Height);
+				RandomizeSource(Stream, Source);
+
+				double ScalarThroughput = 0.0;
+				for (int32 Set = 0; Set <= (int32)GetSupportedInstructionSet(); ++Set)
+				{
+					FBenchmarkFrame Destination(Conversion.Destination, Width, Height);
+
+					const double StartTime = FPlatformTime::Seconds();
+					for (int32 Frame = 0; Frame < InNumFrames; ++Frame)
+					{
+						Convert((EInstructionSet)Set, Source, Destination);
+					}
+					const double Time = FPlatformTime::Seconds() - StartTime;
+					const double Throughput = Time > 0.0 ? (double)(Source.GetImageSize() + Destination.GetImageSize()) * InNumFrames / Time / 1000000000.0 : 0.0;
+					if (Set == (int32)EInstructionSet::Scalar)
+					{
+						ScalarThroughput = Throughput;
+					}
+
+					UE_LOG(LogAjaMedia, Display, TEXT("%s to %s %ux%u %s: %.2f GB/s (x%.1f).")
+						, GetFormatName(Conversion.Source), GetFormatName(Conversion.Destination), Width, Height
+						, GetInstructionSetName((EInstructionSet)Set)
+						, Throughput
+						, ScalarThroughput > 0.0 ? Throughput / ScalarThroughput : 0.0);
+				}
+			}
+		}
+	}
+
+	static FAutoConsoleCommand AjaPixelConversionBenchmarkCmd(
+		TEXT("Aja.PixelConversion.Benchmark"),
+		TEXT("Report the throughput of every instruction set of the pixel conversions, at 720p, 1080p and 2160p. The automation test Plugins.AjaMedia.PixelConversion checks them against the scalar code. Optional argument: the number of frames (default 20)."),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const int32 NumFrames = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 20;
+			Benchmark(NumFrames);
+		}));
+}
+
+/* FAjaMediaPixelConversion implementation
+*****************************************************************************/
+void FAjaMediaPixelConversion::V210ToYUV16(const void* InSource, uint32 InSourceStride, uint16* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight)
+{
+	AjaMediaPixelConversion::V210ToYUV16(AjaMediaPixelConversion::GetInstructionSet(), InSource, InSourceStride, OutDestination, InDestinationStride, InWidth, InHeight);
+}
+
+void FAjaMediaPixelConversion::YUV16ToV210(const uint16* InSource, uint32 InSourceStride, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight)
+{
+	AjaMediaPixelConversion::YUV16ToV210(AjaMediaPixelConversion::GetInstructionSet(), InSource, InSourceStride, OutDestination, InDestinationStride, InWidth, InHeight);
+}
+
+void FAjaMediaPixelConversion::V210ToPlanarYUV16(const void* InSource, uint32 InSourceStride, const FAjaMediaYUV16Planes& OutDestination, uint32 InWidth, uint32 InHeight)
+{
+	AjaMediaPixelConversion::V210ToPlanarYUV16(AjaMediaPixelConversion::GetInstructionSet(), InSource, InSourceStride, OutDestination, InWidth, InHeight);
+}
+
+void FAjaMediaPixelConversion::PlanarYUV16ToV210(const FAjaMediaYUV16Planes& InSource, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight)
+{
+	AjaMediaPixelConversion::PlanarYUV16ToV210(AjaMediaPixelConversion::GetInstructionSet(), InSource, OutDestination, InDestinationStride, InWidth, InHeight);
+}
+
+void FAjaMediaPixelConversion::UYVYToBGRA(const void* InSource, uint32 InSourceStride, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight, EAjaMediaColorMatrix InMatrix)
+{
+	AjaMediaPixelConversion::UYVYToBGRA(AjaMediaPixelConversion::GetInstructionSet(), InSource, InSourceStride, OutDestination, InDestinationStride, InWidth, InHeight, InMatrix);
+}
+
+void FAjaMediaPixelConversion::BGRAToUYVY(const void* InSource, uint32 InSourceStride, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight, EAjaMediaColorMatrix InMatrix)
+{
+	AjaMediaPixelConversion::BGRAToUYVY(AjaMediaPixelConversion::GetInstructionSet(), InSource, InSourceStride, OutDestination, InDestinationStride, InWidth, InHeight, InMatrix);
+}
+
+void FAjaMediaPixelConversion::BGR10A2ToRGBA16(const void* InSource, uint32 InSourceStride, uint16* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight)
+{
+	AjaMediaPixelConversion::BGR10A2ToRGBA16(AjaMediaPixelConversion::GetInstructionSet(), InSource, InSourceStride, OutDestination, InDestinationStride, InWidth, InHeight);
+}
+
+void FAjaMediaPixelConversion::RGBA16ToBGR10A2(const uint16* InSource, uint32 InSourceStride, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight)
+{
+	AjaMediaPixelConversion::RGBA16ToBGR10A2(AjaMediaPixelConversion::GetInstructionSet(), InSource, InSourceStride, OutDestination, InDestinationStride, InWidth, InHeight);
+}
+
+const TCHAR* FAjaMediaPixelConversion::GetInstructionSetName()
+{
+	return AjaMediaPixelConversion::GetInstructionSetName(AjaMediaPixelConversion::GetInstructionSet());
+}
+
+/* Automation tests
+*****************************************************************************/
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAjaMediaPixelConversionTest, "Plugins.AjaMedia.PixelConversion", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FAjaMediaPixelConversionTest::RunTest(const FString& Parameters)
+{
+	using namespace AjaMediaPixelConversion;
+
+	// A few rows are enough, the SIMD code only differs along the rows. 1280 is not a multiple of 6 pixels, the v210 rows end with a partial group.
+	static const FIntPoint Resolutions[] = { FIntPoint(1280, 8), FIntPoint(1920, 8), FIntPoint(3840, 4) };
+
+	FRandomStream Stream(0x414A41);
+	for (const FIntPoint& Resolution : Resolutions)
+	{
+		const uint32 Width = (uint32)Resolution.X;
+		const uint32 Height = (uint32)Resolution.Y;
+
+		for (const FConversion& Conversion : Conversions)
+		{
+			FBenchmarkFrame Source(Conversion.Source, Width, Height);
+			RandomizeSource(Stream, Source);
+
+			FBenchmarkFrame Reference(Conversion.Destination, Width, Height);
+			Convert(EInstructionSet::Scalar, Source, Reference);
+
+			for (int32 Set = 0; Set <= (int32)GetSupportedInstructionSet(); ++Set)
+			{
+				const FString Name = FString::Printf(TEXT("%s to %s %ux%u %s"), GetFormatName(Conversion.Source), GetFormatName(Conversion.Destination), Width, Height, GetInstructionSetName((EInstructionSet)Set));
+
+				FBenchmarkFrame Destination(Conversion.Destination, Width, Height);
+				Convert((EInstructionSet)Set, Source, Destination);
+
+				// The padding is compared too, nothing may be written past the rows
+				if (FMemory::Memcmp(Destination.Data.GetData(), Reference.Data.GetData(), Destination.Data.Num()) != 0)
+				{
+					AddError(FString::Printf(TEXT("%s differs from the scalar conversion."), *Name));
+				}
+
+				if (Conversion.bLossless)
+				{
+					FBenchmarkFrame Back(Conversion.Source, Width, Height);
+					Convert((EInstructionSet)Set, Destination, Back);
+					if (!Back.HasSamePixels(Source))
+					{
+						AddError(FString::Printf(TEXT("%s converted back differs from the source."), *Name));
+					}
+				}
+			}
+		}
+	}
+
+	return !HasAnyErrors();
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,730 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaTimecodeBurnIn.h"
+
+#include "AjaMediaPrivate.h"
+
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformAtomics.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#endif
+
+namespace AjaMediaTimecodeBurnIn
+{
+	enum EField
+	{
+		Hours,
+		Minutes,
+		Seconds,
+		Frames,
+		NumFields
+	};
+
+	/** Number of stamps cached per field. Bigger values use FMediaIOCoreEncodeTime. */
+	static const uint32 NumValues[NumFields] = { 24, 60, 60, 60 };
+
+	/** The scratch frames are filled with these before the encoder runs. They differ in every bit, so a bit written by the encoder differs from one of them. */
+	static const uint8 SentinelA = 0x5A;
+	static const uint8 SentinelB = 0xA5;
+
+	/** Layouts bigger than that are not cached. */
+	static const uint64 MaxFrameSize = 512 * 1024 * 1024;
+
+	/** Number of cached layouts. One per format and resolution of the open inputs and outputs is enough. */
+	static const int32 MaxLayouts = 8;
+
+	static TAutoConsoleVariable<int32> CVarAjaBurnInFast(
+		TEXT("Aja.BurnIn.Fast"),
+		1,
+		TEXT("Burn the timecode in the AJA frames with cached stamps. 0 renders every frame with FMediaIOCoreEncodeTime."),
+		ECVF_Default);
+
+	/** Bytes to store in every row of a band. */
+	struct FSpan
+	{
+		uint32 Offset;
+		uint32 Size;
+		uint32 DataOffset;
+		/** Offset of the bits to store in Masks, INDEX_NONE when every bit of the span is stored. */
+		int32 MaskOffset;
+	};
+
+	/** Consecutive rows that receive the same bytes. */
+	struct FBand
+	{
+		uint32 FirstRow;
+		uint32 NumRows;
+		int32 FirstSpan;
+		int32 NumSpans;
+	};
+
+	/** Part of a stamp. The data of a masked span only has the bits of its mask set. */
+	struct FLayer
+	{
+		TArray<FSpan> Spans;
+		TArray<FBand> Bands;
+		TArray<uint8> Data;
+		TArray<uint8> Masks;
+	};
+
+	enum class ELayoutState : int32
+	{
+		Building,
+		Ready,
+		Unsupported,
+	};
+
+	/** The stamps of a frame layout. */
+	struct FLayout
+	{
+		FLayout()
+			: State((int32)ELayoutState::Building)
+			, RowSize(0)
+			, LastUse(0)
+		{ }
+
+		volatile int32 State;
+
+		/** Bytes of a row covered by the spans. A frame with a smaller pitch uses FMediaIOCoreEncodeTime. */
+		uint32 RowSize;
+
+		/** Value of UseCounter when the layout was last found. Only accessed under LayoutsCriticalSection. */
+		uint64 LastUse;
+
+		/** Bits of the stamp that are the same for every timecode. */
+		FLayer Base;
+
+		/** Bits of the stamp that depend on a field, per value of the field. */
+		TArray<FLayer> Fields[NumFields];
+	};
+
+	/** The stamps don't depend on the pitch: the encoder writes the same bytes at the start of the rows. */
+	struct FLayoutKey
+	{
+		EMediaIOCoreEncodePixelFormat Format;
+		uint32 Width;
+		uint32 Height;
+
+		bool operator==(const FLayoutKey& Other) const
+		{
+			return Format == Other.Format && Width == Other.Width && Height == Other.Height;
+		}
+
+		friend uint32 GetTypeHash(const FLayoutKey& Key)
+		{
+			return HashCombine(::GetTypeHash((uint32)Key.Format), HashCombine(::GetTypeHash(Key.Width), ::GetTypeHash(Key.Height)));
+		}
+	};
+
+	/** The layouts of the open inputs and outputs. The least recently used is evicted past MaxLayouts. */
+	static TMap<FLayoutKey, TSharedPtr<FLayout, ESPMode::ThreadSafe>> Layouts;
+	static uint64 UseCounter = 0;
+	static FCriticalSection LayoutsCriticalSection;
+
+	const TCHAR* GetFormatName(EMediaIOCoreEncodePixelFormat InFormat)
+	{
+		switch (InFormat)
+		{
+		case EMediaIOCoreEncodePixelFormat::CharBGRA: return TEXT("CharBGRA");
+		case EMediaIOCoreEncodePixelFormat::CharUYVY: return TEXT("CharUYVY");
+		case EMediaIOCoreEncodePixelFormat::A2B10G10R10: return TEXT("A2B10G10R10");
+		case EMediaIOCoreEncodePixelFormat::YUVv210: return TEXT("YUVv210");
+		}
+		return TEXT("Unknown");
+	}
+
+	/** Pitch of the frames the stamps are rendered in. Also the pitch of the frames of the benchmark. */
+	uint32 GetPitch(EMediaIOCoreEncodePixelFormat InFormat, uint32 InWidth)
+	{
+		switch (InFormat)
+		{
+		case EMediaIOCoreEncodePixelFormat::CharUYVY: return InWidth * 2;
+		case EMediaIOCoreEncodePixelFormat::YUVv210: return FMath::DivideAndRoundUp<uint32>(InWidth, 6) * 16;
+		default: return InWidth * 4;
+		}
+	}
+
+	/**
+	 * Store the same bytes in consecutive rows.
+	 * Each 16 bytes block is loaded once and stored in all the rows, so a band costs one load and one store per block and row.
+	 */
+	FORCEINLINE void StoreBand(uint8* InDestination, uint32 InPitch, uint32 InNumRows, const uint8* InSource, uint32 InSize)
+	{
+		uint32 Offset = 0;
+#if PLATFORM_CPU_X86_FAMILY
+		for (; Offset + sizeof(__m128i) <= InSize; Offset += sizeof(__m128i))
+		{
+			const __m128i Texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(InSource + Offset));
+			uint8* Row = InDestination + Offset;
+			for (uint32 Index = 0; Index < InNumRows; ++Index, Row += InPitch)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Row), Texels);
+			}
+		}
+#endif
+		if (Offset < InSize)
+		{
+			uint8* Row = InDestination + Offset;
+			for (uint32 Index = 0; Index < InNumRows; ++Index, Row += InPitch)
+			{
+				FMemory::Memcpy(Row, InSource + Offset, InSize - Offset);
+			}
+		}
+	}
+
+	/**
+	 * Store the bits of the mask in consecutive rows, the other bits keep their value.
+	 * The 10-bit components of v210 and A2B10G10R10 straddle bytes, so two fields of the timecode can share a byte but not a bit.
+	 */
+	FORCEINLINE void BlendBand(uint8* InDestination, uint32 InPitch, uint32 InNumRows, const uint8* InSource, const uint8* InMask, uint32 InSize)
+	{
+		uint32 Offset = 0;
+#if PLATFORM_CPU_X86_FAMILY
+		for (; Offset + sizeof(__m128i) <= InSize; Offset += sizeof(__m128i))
+		{
+			const __m128i Texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(InSource + Offset));
+			const __m128i Mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(InMask + Offset));
+			uint8* Row = InDestination + Offset;
+			for (uint32 Index = 0; Index < InNumRows; ++Index, Row += InPitch)
+			{
+				const __m128i Frame = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Row));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Row), _mm_or_si128(_mm_andnot_si128(Mask, Frame), Texels));
+			}
+		}
+#endif
+		for (; Offset < InSize; ++Offset)
+		{
+			uint8* Row = InDestination + Offset;
+			for (uint32 Index = 0; Index < InNumRows; ++Index, Row += InPitch)
+			{
+				*Row = (uint8)((*Row & ~InMask[Offset]) | InSource[Offset]);
+			}
+		}
+	}
+
+	void ApplyLayer(const FLayer& InLayer, uint8* InBuffer, uint32 InPitch)
+	{
+		for (const FBand& Band : InLayer.Bands)
+		{
+			uint8* Rows = InBuffer + (uint64)Band.FirstRow * InPitch;
+			for (int32 SpanIndex = Band.FirstSpan; SpanIndex < Band.FirstSpan + Band.NumSpans; ++SpanIndex)
+			{
+				const FSpan& Span = InLayer.Spans[SpanIndex];
+				if (Span.MaskOffset == INDEX_NONE)
+				{
+					StoreBand(Rows + Span.Offset, InPitch, Band.NumRows, InLayer.Data.GetData() + Span.DataOffset, Span.Size);
+				}
+				else
+				{
+					BlendBand(Rows + Span.Offset, InPitch, Band.NumRows, InLayer.Data.GetData() + Span.DataOffset, InLayer.Masks.GetData() + Span.MaskOffset, Span.Size);
+				}
+			}
+		}
+	}
+
+	void ApplyLayout(const FLayout& InLayout, uint8* InBuffer, uint32 InPitch, uint32 InHours, uint32 InMinutes, uint32 InSeconds, uint32 InFrames)
+	{
+		ApplyLayer(InLayout.Base, InBuffer, InPitch);
+		ApplyLayer(InLayout.Fields[Hours][InHours], InBuffer, InPitch);
+		ApplyLayer(InLayout.Fields[Minutes][InMinutes], InBuffer, InPitch);
+		ApplyLayer(InLayout.Fields[Seconds][InSeconds], InBuffer, InPitch);
+		ApplyLayer(InLayout.Fields[Frames][InFrames], InBuffer, InPitch);
+	}
+
+	/**
+	 * Render the stamps of a layout with FMediaIOCoreEncodeTime and split them per field.
+	 *
+	 * The sentinels differ in every bit, so a bit written by the encoder is the one that is the same in both scratch frames.
+	 * The stamp is cached only if
+	 *  - every bit written by the encoder is overwritten, it doesn't depend on the frame content,
+	 *  - the encoder writes the same bits for every timecode,
+	 *  - the bits that depend on a field don't depend on another field. They may share a byte, like the components of a v210 word.
+	 * The cached stamps are then verified against the encoder.
+	 */
+	class FLayoutBuilder
+	{
+	public:
+
+		FLayoutBuilder(const FLayoutKey& InKey)
+			: Key(InKey)
+			, Pitch(GetPitch(InKey.Format, InKey.Width))
+			, NumStampRows(0)
+		{ }
+
+		bool Build(FLayout& OutLayout)
+		{
+			const uint64 FrameSize = (uint64)Pitch * Key.Height;
+			if (FrameSize == 0 || FrameSize > MaxFrameSize)
+			{
+				return false;
+			}
+
+			ScratchA.SetNumUninitialized((int32)FrameSize);
+			ScratchB.SetNumUninitialized((int32)FrameSize);
+
+			// Find the last row written by the encoder
+			static const uint32 RowProbes[][NumFields] = { { 0, 0, 0, 0 }, { 23, 59, 59, 59 }, { 11, 11, 11, 11 }, { 22, 22, 22, 22 }, { 13, 37, 42, 17 } };
+			for (const uint32* Timecode : RowProbes)
+			{
+				RenderScratch(Key.Height, Timecode);
+				for (uint32 Row = Key.Height; Row > NumStampRows; --Row)
+				{
+					if (IsRowWritten(Row - 1))
+					{
+						NumStampRows = Row;
+						break;
+					}
+				}
+			}
+
+			if (NumStampRows == 0)
+			{
+				return false;
+			}
+
+			const uint32 StampSize = NumStampRows * Pitch;
+
+			// Base stamp, every field at 0
+			static const uint32 ZeroTimecode[NumFields] = { 0, 0, 0, 0 };
+			RenderScratch(NumStampRows, ZeroTimecode);
+			const TArray<uint8> BaseA(ScratchA.GetData(), StampSize);
+			const TArray<uint8> BaseB(ScratchB.GetData(), StampSize);
+
+			TArray<uint8> WrittenBits;
+			WrittenBits.SetNumUninitialized(StampSize);
+			for (uint32 Index = 0; Index < StampSize; ++Index)
+			{
+				const uint8 Written = (uint8)~(BaseA[Index] ^ BaseB[Index]);
+				if ((BaseA[Index] & ~Written) != (SentinelA & ~Written) || (BaseB[Index] & ~Written) != (SentinelB & ~Written))
+				{
+					// The encoder blends with the frame content
+					return false;
+				}
+				WrittenBits[Index] = Written;
+			}
+
+			// Bits that change with each field
+			TArray<uint8> FieldBits[NumFields];
+			TArray<TArray<uint32>> DiffOffsets[NumFields];
+			TArray<TArray<uint8>> DiffValues[NumFields];
+			for (int32 Field = 0; Field < NumFields; ++Field)
+			{
+				FieldBits[Field].SetNumZeroed(StampSize);
+				DiffOffsets[Field].SetNum(NumValues[Field]);
+				DiffValues[Field].SetNum(NumValues[Field]);
+
+				for (uint32 Value = 0; Value < NumValues[Field]; ++Value)
+				{
+					uint32 Timecode[NumFields] = { 0, 0, 0, 0 };
+					Timecode[Field] = Value;
+					RenderScratch(NumStampRows, Timecode);
+
+					for (uint32 Index = 0; Index < StampSize; ++Index)
+					{
+						const uint8 A = ScratchA[Index];
+						const uint8 B = ScratchB[Index];
+						if (A != BaseA[Index] || B != BaseB[Index])
+						{
+							const uint8 Diff = A ^ BaseA[Index];
+							if (Diff != (B ^ BaseB[Index]) || (Diff & ~WrittenBits[Index]) != 0)
+							{
+								// The encoder doesn't write the same bits for every timecode
+								return false;
+							}
+
+							FieldBits[Field][Index] |= Diff;
+							DiffOffsets[Field][Value].Add(Index);
+							DiffValues[Field][Value].Add(A);
+						}
+					}
+				}
+			}
+
+			TArray<uint8> BaseBits = WrittenBits;
+			for (uint32 Index = 0; Index < StampSize; ++Index)
+			{
+				uint8 AllFieldBits = 0;
+				for (int32 Field = 0; Field < NumFields; ++Field)
+				{
+					if ((AllFieldBits & FieldBits[Field][Index]) != 0)
+					{
+						// 2 fields share a bit
+						return false;
+					}
+					AllFieldBits |= FieldBits[Field][Index];
+				}
+				BaseBits[Index] &= ~AllFieldBits;
+			}
+
+			OutLayout.Base = BuildLayer(GetRowRanges(BaseBits), BaseBits.GetData(), BaseA.GetData());
+
+			TArray<uint8> Stamp = BaseA;
+			for (int32 Field = 0; Field < NumFields; ++Field)
+			{
+				const TArray<TArray<FRange>> RowRanges = GetRowRanges(FieldBits[Field]);
+				OutLayout.Fields[Field].Reset(NumValues[Field]);
+				for (uint32 Value = 0; Value < NumValues[Field]; ++Value)
+				{
+					const TArray<uint32>& Offsets = DiffOffsets[Field][Value];
+					for (int32 Index = 0; Index < Offsets.Num(); ++Index)
+					{
+						Stamp[Offsets[Index]] = DiffValues[Field][Value][Index];
+					}
+
+					OutLayout.Fields[Field].Add(BuildLayer(RowRanges, FieldBits[Field].GetData(), Stamp.GetData()));
+
+					for (uint32 Offset : Offsets)
+					{
+						Stamp[Offset] = BaseA[Offset];
+					}
+				}
+			}
+
+			// Bytes of a row written by the encoder
+			for (uint32 Index = 0; Index < StampSize; ++Index)
+			{
+				if (WrittenBits[Index] != 0)
+				{
+					OutLayout.RowSize = FMath::Max(OutLayout.RowSize, Index % Pitch + 1);
+				}
+			}
+
+			// The whole frame must match the encoder
+			static const uint32 VerifyProbes[][NumFields] = { { 23, 59, 59, 59 }, { 1, 23, 45, 12 }, { 10, 5, 30, 7 }, { 19, 48, 6, 29 } };
+			for (const uint32* Timecode : VerifyProbes)
+			{
+				FMemory::Memset(ScratchA.GetData(), SentinelA, FrameSize);
+				FMemory::Memset(ScratchB.GetData(), SentinelA, FrameSize);
+				FMediaIOCoreEncodeTime EncodeTime(Key.Format, ScratchA.GetData(), Pitch, Key.Width, Key.Height);
+				EncodeTime.Render(Timecode[Hours], Timecode[Minutes], Timecode[Seconds], Timecode[Frames]);
+				ApplyLayout(OutLayout, ScratchB.GetData(), Pitch, Timecode[Hours], Timecode[Minutes], Timecode[Seconds], Timecode[Frames]);
+				if (FMemory::Memcmp(ScratchA.GetData(), ScratchB.GetData(), FrameSize) != 0)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+	private:
+
+		struct FRange
+		{
+			uint32 Offset;
+			uint32 Size;
+
+			bool operator==(const FRange& Other) const
+			{
+				return Offset == Other.Offset && Size == Other.Size;
+			}
+		};
+
+		void RenderScratch(uint32 InNumRows, const uint32* InTimecode)
+		{
+			FMemory::Memset(ScratchA.GetData(), SentinelA, (uint64)InNumRows * Pitch);
+			FMemory::Memset(ScratchB.GetData(), SentinelB, (uint64)InNumRows * Pitch);
+
+			FMediaIOCoreEncodeTime EncodeTimeA(Key.Format, ScratchA.GetData(), Pitch, Key.Width, Key.Height);
+			EncodeTimeA.Render(InTimecode[Hours], InTimecode[Minutes], InTimecode[Seconds], InTimecode[Frames]);
+			FMediaIOCoreEncodeTime EncodeTimeB(Key.Format, ScratchB.GetData(), Pitch, Key.Width, Key.Height);
+			EncodeTimeB.Render(InTimecode[Hours], InTimecode[Minutes], InTimecode[Seconds], InTimecode[Frames]);
+		}
+
+		bool IsRowWritten(uint32 InRow) const
+		{
+			const uint8* RowA = ScratchA.GetData() + (uint64)InRow * Pitch;
+			const uint8* RowB = ScratchB.GetData() + (uint64)InRow * Pitch;
+			for (uint32 Index = 0; Index < Pitch; ++Index)
+			{
+				if (RowA[Index] != SentinelA || RowB[Index] != SentinelB)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/** @return the contiguous bytes of the mask that have a bit set, per row. */
+		TArray<TArray<FRange>> GetRowRanges(const TArray<uint8>& InMask) const
+		{
+			TArray<TArray<FRange>> RowRanges;
+			RowRanges.SetNum(NumStampRows);
+			for (uint32 Row = 0; Row < NumStampRows; ++Row)
+			{
+				const uint8* RowMask = InMask.GetData() + Row * Pitch;
+				for (uint32 Index = 0; Index < Pitch; ++Index)
+				{
+					if (RowMask[Index] != 0)
+					{
+						const uint32 First = Index;
+						while (Index < Pitch && RowMask[Index] != 0)
+						{
+							++Index;
+						}
+						RowRanges[Row].Add({ First, Index - First });
+					}
+				}
+			}
+			return RowRanges;
+		}
+
+		FLayer BuildLayer(const TArray<TArray<FRange>>& InRowRanges, const uint8* InMask, const uint8* InStamp) const
+		{
+			FLayer Layer;
+			int32 BandIndex = INDEX_NONE;
+			for (uint32 Row = 0; Row < NumStampRows; ++Row)
+			{
+				const TArray<FRange>& Ranges = InRowRanges[Row];
+				if (Ranges.Num() == 0)
+				{
+					BandIndex = INDEX_NONE;
+					continue;
+				}
+
+				const uint8* RowStamp = InStamp + Row * Pitch;
+				const uint8* RowMask = InMask + Row * Pitch;
+				if (BandIndex != INDEX_NONE && Ranges == InRowRanges[Row - 1])
+				{
+					bool bSameBits = true;
+					for (const FRange& Range : Ranges)
+					{
+						for (uint32 Index = Range.Offset; bSameBits && Index < Range.Offset + Range.Size; ++Index)
+						{
+							const uint8 Mask = RowMask[Index];
+							bSameBits = Mask == RowMask[Index - Pitch] && (RowStamp[Index] & Mask) == (RowStamp[Index - Pitch] & Mask);
+						}
+					}
+
+					if (bSameBits)
+					{
+						++Layer.Bands[BandIndex].NumRows;
+						continue;
+					}
+				}
+
+				BandIndex = Layer.Bands.AddUninitialized();
+				FBand& Band = Layer.Bands[BandIndex];
+				Band.FirstRow = Row;
+				Band.NumRows = 1;
+				Band.FirstSpan = Layer.Spans.Num();
+				Band.NumSpans = Ranges.Num();
+				for (const FRange& Range : Ranges)
+				{
+					bool bFullMask = true;
+					for (uint32 Index = Range.Offset; Index < Range.Offset + Range.Size; ++Index)
+					{
+						Layer.Data.Add(RowStamp[Index] & RowMask[Index]);
+						bFullMask = bFullMask && RowMask[Index] == 0xFF;
+					}
+
+					// The bytes that are written whole are stored without reading the frame
+					int32 MaskOffset = INDEX_NONE;
+					if (!bFullMask)
+					{
+						MaskOffset = Layer.Masks.Num();
+						Layer.Masks.Append(RowMask + Range.Offset, Range.Size);
+					}
+					Layer.Spans.Add({ Range.Offset, Range.Size, (uint32)(Layer.Data.Num() - Range.Size), MaskOffset });
+				}
+			}
+
+			Layer.Spans.Shrink();
+			Layer.Bands.Shrink();
+			Layer.Data.Shrink();
+			Layer.Masks.Shrink();
+			return Layer;
+		}
+
+	private:
+
+		FLayoutKey Key;
+		uint32 Pitch;
+		uint32 NumStampRows;
+		TArray<uint8> ScratchA;
+		TArray<uint8> ScratchB;
+	};
+
+	/** @return the layout if its stamps are ready. Otherwise start to build them in the background. */
+	TSharedPtr<FLayout, ESPMode::ThreadSafe> FindLayout(const FLayoutKey& InKey)
+	{
+		TSharedPtr<FLayout, ESPMode::ThreadSafe> Layout;
+		{
+			FScopeLock Lock(&LayoutsCriticalSection);
+			if (const TSharedPtr<FLayout, ESPMode::ThreadSafe>* Found = Layouts.Find(InKey))
+			{
+				Layout = *Found;
+			}
+			else
+			{
+				if (Layouts.Num() >= MaxLayouts)
+				{
+					// A frame that still applies the evicted stamps holds its own reference
+					const FLayoutKey* OldestKey = nullptr;
+					uint64 OldestUse = MAX_uint64;
+					for (const TPair<FLayoutKey, TSharedPtr<FLayout, ESPMode::ThreadSafe>>& Pair : Layouts)
+					{
+						if (Pair.Value->LastUse < OldestUse)
+						{
+							OldestKey = &Pair.Key;
+							OldestUse = Pair.Value->LastUse;
+						}
+					}
+					const FLayoutKey EvictedKey = *OldestKey;
+					Layouts.Remove(EvictedKey);
+				}
+
+				Layout = MakeShared<FLayout, ESPMode::ThreadSafe>();
+				Layouts.Add(InKey, Layout);
+
+				Async(EAsyncExecution::ThreadPool, [InKey, Layout]()
+				{
+					FLayoutBuilder Builder(InKey);
+					const bool bSupported = Builder.Build(*Layout);
+					if (!bSupported)
+					{
+						UE_LOG(LogAjaMedia, Verbose, TEXT("The timecode stamps of %s %ux%u can't be cached. The timecode will be burned with FMediaIOCoreEncodeTime."), GetFormatName(InKey.Format), InKey.Width, InKey.Height);
+					}
+					FPlatformAtomics::InterlockedExchange(&Layout->State, (int32)(bSupported ? ELayoutState::Ready : ELayoutState::Unsupported));
+				});
+			}
+
+			Layout->LastUse = ++UseCounter;
+		}
+
+		if (FPlatformAtomics::AtomicRead(&Layout->State) != (int32)ELayoutState::Ready)
+		{
+			Layout.Reset();
+		}
+		return Layout;
+	}
+
+	void Benchmark(int32 InNumFrames)
+	{
+		static const EMediaIOCoreEncodePixelFormat Formats[] = { EMediaIOCoreEncodePixelFormat::CharBGRA, EMediaIOCoreEncodePixelFormat::CharUYVY, EMediaIOCoreEncodePixelFormat::A2B10G10R10, EMediaIOCoreEncodePixelFormat::YUVv210 };
+		static const FIntPoint Resolutions[] = { FIntPoint(1920, 1080), FIntPoint(3840, 2160) };
+
+		for (const FIntPoint& Resolution : Resolutions)
+		{
+			for (EMediaIOCoreEncodePixelFormat Format : Formats)
+			{
+				const FLayoutKey Key = { Format, (uint32)Resolution.X, (uint32)Resolution.Y };
+				const uint32 Pitch = GetPitch(Format, Key.Width);
+				const uint64 FrameSize = (uint64)Pitch * Key.Height;
+
+				FLayout Layout;
+				const double BuildStartTime = FPlatformTime::Seconds();
+				const bool bSupported = FLayoutBuilder(Key).Build(Layout);
+				const double BuildTime = FPlatformTime::Seconds() - BuildStartTime;
+
+				TArray<uint8> EncoderFrame;
+				TArray<uint8> CachedFrame;
+				EncoderFrame.SetNumZeroed((int32)FrameSize);
+				CachedFrame.SetNumZeroed((int32)FrameSize);
+
+				// Walk through the timecodes, starting in the middle of the day
+				auto GetTimecode = [](int32 InFrame, uint32& OutHours, uint32& OutMinutes, uint32& OutSeconds, uint32& OutFrames)
+				{
+					const uint32 Frame = 12 * 60 * 60 * 60 + (uint32)InFrame;
+					OutFrames = Frame % 60;
+					OutSeconds = (Frame / 60) % 60;
+					OutMinutes = (Frame / (60 * 60)) % 60;
+					OutHours = (Frame / (60 * 60 * 60)) % 24;
+				};
+
+				uint32 H, M, S, F;
+				const double EncoderStartTime = FPlatformTime::Seconds();
+				for (int32 Frame = 0; Frame < InNumFrames; ++Frame)
+				{
+					GetTimecode(Frame, H, M, S, F);
+					FMediaIOCoreEncodeTime EncodeTime(Format, EncoderFrame.GetData(), Pitch, Key.Width, Key.Height);
+					EncodeTime.Render(H, M, S, F);
+				}
+				const double EncoderTime = FPlatformTime::Seconds() - EncoderStartTime;
+
+				double CachedTime = 0.0;
+				bool bIdentical = false;
+				if (bSupported)
+				{
+					const double CachedStartTime = FPlatformTime::Seconds();
+					for (int32 Frame = 0; Frame < InNumFrames; ++Frame)
+					{
+						GetTimecode(Frame, H, M, S, F);
+						ApplyLayout(Layout, CachedFrame.GetData(), Pitch, H, M, S, F);
+					}
+					CachedTime = FPlatformTime::Seconds() - CachedStartTime;
+					bIdentical = FMemory::Memcmp(EncoderFrame.GetData(), CachedFrame.GetData(), FrameSize) == 0;
+				}
+
+				if (bSupported)
+				{
+					UE_LOG(LogAjaMedia, Display, TEXT("%s %dx%d: FMediaIOCoreEncodeTime %.2f us, cached stamps %.2f us (x%.1f), built in %.1f ms, %s.")
+						, GetFormatName(Format), Resolution.X, Resolution.Y
+						, EncoderTime * 1000000.0 / InNumFrames
+						, CachedTime * 1000000.0 / InNumFrames
+						, CachedTime > 0.0 ? EncoderTime / CachedTime : 0.0
+						, BuildTime * 1000.0
+						, bIdentical ? TEXT("identical") : TEXT("DIFFERENT"));
+				}
+				else
+				{
+					UE_LOG(LogAjaMedia, Display, TEXT("%s %dx%d: FMediaIOCoreEncodeTime %.2f us, the stamps can't be cached.")
+						, GetFormatName(Format), Resolution.X, Resolution.Y
+						, EncoderTime * 1000000.0 / InNumFrames);
+				}
+			}
+		}
+	}
+
+	static FAutoConsoleCommand AjaBurnInBenchmarkCmd(
+		TEXT("Aja.BurnIn.Benchmark"),
+		TEXT("Compare the cached timecode stamps with FMediaIOCoreEncodeTime in every format, at 1080p and 2160p. Optional argument: the number of frames (default 1000)."),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const int32 NumFrames = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000;
+			Benchmark(NumFrames);
+		}));
+}
+
+/* FAjaMediaTimecodeBurnIn implementation
+*****************************************************************************/
+void FAjaMediaTimecodeBurnIn::Render(EMediaIOCoreEncodePixelFormat InFormat, void* InBuffer, uint32 InPitch, uint32 InWidth, uint32 InHeight, uint32 InHours, uint32 InMinutes, uint32 InSeconds, uint32 InFrames)
+{
+	using namespace AjaMediaTimecodeBurnIn;
+
+	const bool bCanUseStamps = CVarAjaBurnInFast.GetValueOnAnyThread() != 0
+		&& InHours < NumValues[Hours]
+		&& InMinutes < NumValues[Minutes]
+		&& InSeconds < NumValues[Seconds]
+		&& InFrames < NumValues[Frames];
+
+	if (bCanUseStamps)
+	{
+		const FLayoutKey Key = { InFormat, InWidth, InHeight };
+		TSharedPtr<FLayout, ESPMode::ThreadSafe> Layout = FindLayout(Key);
+		if (Layout.IsValid() && InPitch >= Layout->RowSize)
+		{
+			ApplyLayout(*Layout, static_cast<uint8*>(InBuffer), InPitch, InHours, InMinutes, InSeconds, InFrames);
+			return;
+		}
+	}
+
+	FMediaIOCoreEncodeTime EncodeTime(InFormat, InBuffer, InPitch, InWidth, InHeight);
+	EncodeTime.Render(InHours, InMinutes, InSeconds, InFrames);
+}
+
+void FAjaMediaTimecodeBurnIn::Prepare(EMediaIOCoreEncodePixelFormat InFormat, uint32 InWidth, uint32 InHeight)
+{
+	using namespace AjaMediaTimecodeBurnIn;
+
+	if (CVarAjaBurnInFast.GetValueOnAnyThread() != 0)
+	{
+		const FLayoutKey Key = { InFormat, InWidth, InHeight };
+		FindLayout(Key);
+	}
+}
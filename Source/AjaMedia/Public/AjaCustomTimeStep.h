@@ -12,6 +12,8 @@
 
 #include "AjaCustomTimeStep.generated.h"
 
+class FAjaSyncWatcher;
+class IAjaSyncChannel;
 class UEngine;
 
 /**
@@ -42,6 +44,7 @@ private:
 	friend FAJACallback;
 
 	void WaitForSync();
+	void WaitForPredictedSync();
 	void ReleaseResources();
 
 public:
@@ -74,11 +77,27 @@ public:
 	UPROPERTY(EditAnywhere, Category="Genlock options", meta=(DisplayName="Display Dropped Frames Warning"))
 	bool bEnableOverrunDetection;
 
+	/**
+	 * If true, the Engine will not block on the sync. The period of the sync is measured from the card,
+	 * and the Engine is woken up a margin before the predicted sync. The real sync only corrects the drift of the prediction.
+	 * The game thread gets the margin back from every frame.
+	 * @note Not used when waiting for the frame to be ready.
+	 */
+	UPROPERTY(EditAnywhere, Category="Genlock options", meta=(EditCondition="!bWaitForFrameToBeReady"))
+	bool bUsePredictiveWait;
+
+	/** How long before the predicted sync the Engine is woken up, in milliseconds. */
+	UPROPERTY(EditAnywhere, Category="Genlock options", meta=(EditCondition="bUsePredictiveWait", ClampMin="0.0", ClampMax="16.0"))
+	float PredictiveWakeMargin;
+
 private:
 	/** AJA Port to capture the Sync */
-	AJA::AJASyncChannel* SyncChannel;
+	IAjaSyncChannel* SyncChannel;
 	FAJACallback* SyncCallback;
 
+	/** Waits for the syncs on its own thread when the wait is predictive */
+	FAjaSyncWatcher* SyncWatcher;
+
 #if WITH_EDITORONLY_DATA
 	/** Engine used to initialize the CustomTimeStep */
 	UPROPERTY(Transient)
@@ -88,6 +107,9 @@ private:
 	double LastAutoSynchronizeInEditorAppTime;
 #endif
 
+	/** Registered to the device changes while initialized */
+	FDelegateHandle DevicesChangedHandle;
+
 	/** The current SynchronizationState of the CustomTimeStep */
 	ECustomTimeStepSynchronizationState State;
 	bool bDidAValidUpdateTimeStep;
@@ -98,4 +120,12 @@ private:
 	/** Remember if the last */
 	bool bIsPreviousSyncCountValid;
 	uint32 PreviousSyncCount;
+
+	/** The sync the last predictive wait woke up for */
+	bool bIsPredictedSyncCountValid;
+	uint32 PredictedSyncCount;
+
+	/** Syncs missed by the current frame, and the end of the previous wait, for the frame pacing */
+	uint32 NumMissedSyncs;
+	double LastWaitEndTime;
 };
@@ -0,0 +1,107 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AJALib.h"
+
+/**
+ * The AJA devices of the machine and the video formats they support.
+ *
+ * Scanning a device and enumerating its formats goes through the driver and takes a long time.
+ * The devices are scanned once, when the module starts, and the snapshot is shared by the whole process.
+ * The device provider and the assets answer their queries from it. Refresh scans again after a device was added or removed.
+ * The device monitor refreshes the catalog from its own thread when a card is plugged, removed or enumerated again,
+ * and the changes are broadcast on the game thread.
+ */
+class AJAMEDIA_API FAjaDeviceCatalog
+{
+public:
+
+	/** A device, as reported by the scanner. */
+	struct FDevice
+	{
+		int32 DeviceIndex;
+
+		/** Text id of the device, None if the scanner couldn't give one. */
+		FName DeviceName;
+
+		AJA::AJADeviceScanner::DeviceInfo Info;
+
+		/** Every format supported by the device, in the order of the SDK. */
+		TArray<AJA::AJAVideoFormats::VideoFormatDescriptor> Formats;
+
+		/** @return true if the device is supported by the SDK and has a name. */
+		bool IsUsable() const { return Info.bIsSupported && !DeviceName.IsNone(); }
+	};
+
+	/** The result of a scan. Never changes once it is built. */
+	struct FSnapshot
+	{
+		FSnapshot()
+			: Generation(0)
+		{ }
+
+		/** Incremented at every scan. */
+		uint32 Generation;
+
+		/** Every device the scanner found, indexed by device index. */
+		TArray<FDevice> Devices;
+
+		/** @return the device, nullptr if there's no such device. */
+		const FDevice* FindDevice(int32 InDeviceIndex) const
+		{
+			return Devices.IsValidIndex(InDeviceIndex) ? &Devices[InDeviceIndex] : nullptr;
+		}
+	};
+
+	using FSnapshotRef = TSharedRef<const FSnapshot, ESPMode::ThreadSafe>;
+
+	/** The devices that are not the same in two snapshots. */
+	struct FChange
+	{
+		FChange(const FSnapshotRef& InPrevious, const FSnapshotRef& InCurrent)
+			: Previous(InPrevious)
+			, Current(InCurrent)
+		{ }
+
+		FSnapshotRef Previous;
+		FSnapshotRef Current;
+
+		/** Index of the devices that were added, removed or changed. */
+		TArray<int32> DeviceIndices;
+
+		/** @return true if the device at this index was added, removed or changed. */
+		bool IsDeviceChanged(int32 InDeviceIndex) const { return DeviceIndices.Contains(InDeviceIndex); }
+	};
+
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnChanged, const FChange&);
+
+	/**
+	 * @return the current snapshot. The devices are scanned the first time. Can be called from any thread.
+	 * The snapshot is empty when the AJA library is not initialized or the cards can't be used.
+	 */
+	static FSnapshotRef Get();
+
+	/**
+	 * Scan the devices again and replace the current snapshot. The snapshots already returned are not changed.
+	 * @return the new snapshot.
+	 */
+	static FSnapshotRef Refresh();
+
+	/** Release the snapshot. Called when the module shuts down. */
+	static void Reset();
+
+	/**
+	 * @return true if the devices still match the snapshot. Only reads the device infos, the formats are not enumerated.
+	 * Called by the device monitor to know when to refresh.
+	 */
+	static bool IsUpToDate(const FSnapshot& InSnapshot);
+
+	/** Broadcast on the game thread when a refresh found devices that were added, removed or changed. */
+	static FOnChanged& OnChanged();
+
+	/** Broadcast the changes found since the last call. Called on the game thread. */
+	static void BroadcastChanges();
+};
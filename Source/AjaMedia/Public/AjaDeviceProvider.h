@@ -80,6 +80,23 @@ public:
 	FText ToText() const;
 };
 
+/**
+ * Filter of the indexed configuration queries of FAjaDeviceProvider.
+ * The members that are not set match every configuration.
+ */
+struct AJAMEDIA_API FAjaMediaConfigurationQuery
+{
+	TOptional<int32> DeviceIdentifier;
+	TOptional<bool> bIsInput;
+	TOptional<EMediaIOTransportType> TransportType;
+	TOptional<FIntPoint> Resolution;
+	TOptional<FFrameRate> FrameRate;
+	TOptional<EMediaIOStandardType> Standard;
+
+	/** @return true if the configuration passes the filter. */
+	bool Matches(const FMediaIOConfiguration& InConfiguration) const;
+};
+
 /**
  * Implementation of IMediaIOCoreDeviceProvider for AJA
  */
@@ -105,6 +122,19 @@ public:
 	TArray<FAjaMediaTimecodeConfiguration> GetTimecodeConfiguration() const;
 	TArray<FAjaMediaTimecodeReference> GetTimecodeReferences() const;
 
+	/**
+	 * Indexed queries, answered without building the list of every configuration.
+	 * The Find functions only build the key and reference combinations of the configurations that pass the filter.
+	 */
+	TArray<FMediaIOConfiguration> FindConfigurations(const FAjaMediaConfigurationQuery& InQuery) const;
+	TArray<FMediaIOInputConfiguration> FindInputConfigurations(const FAjaMediaConfigurationQuery& InQuery) const;
+	TArray<FMediaIOOutputConfiguration> FindOutputConfigurations(const FAjaMediaConfigurationQuery& InQuery) const;
+
+	/** @return true if the configuration is one the provider lists. */
+	bool IsConfigurationSupported(const FMediaIOConfiguration& InConfiguration) const;
+	bool IsInputConfigurationSupported(const FMediaIOInputConfiguration& InConfiguration) const;
+	bool IsOutputConfigurationSupported(const FMediaIOOutputConfiguration& InConfiguration) const;
+
 	virtual FMediaIOConfiguration GetDefaultConfiguration() const override;
 	virtual FMediaIOMode GetDefaultMode() const override;
 	virtual FMediaIOInputConfiguration GetDefaultInputConfiguration() const override;
@@ -0,0 +1,106 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * An ancillary data packet (SMPTE 291).
+ */
+struct FAjaMediaAncillaryPacket
+{
+	FAjaMediaAncillaryPacket()
+		: DID(0)
+		, SDID(0)
+		, Line(0)
+		, bField2(false)
+	{ }
+
+	/** Data identifier */
+	uint8 DID;
+
+	/** Secondary data identifier */
+	uint8 SDID;
+
+	/** Line of the packet, in the numbering of the frame. */
+	uint16 Line;
+
+	/** The packet is in the second field. Only for interlaced formats. */
+	bool bField2;
+
+	/** User data words. At most AjaMediaAncillary::MaxUserDataCount. */
+	TArrayView<const uint8> UserData;
+};
+
+/**
+ * Location of a packet in an ancillary buffer, see AjaMediaAncillary::ParsePackets.
+ */
+struct FAjaMediaAncillaryPacketIndex
+{
+	/** Offset of the user data words in the buffer */
+	uint32 Offset;
+
+	/** Number of user data words */
+	uint8 DataCount;
+
+	uint8 DID;
+	uint8 SDID;
+	bool bField2;
+	uint16 Line;
+};
+
+/**
+ * Layout of the ancillary buffers exchanged with the AJA channels.
+ * Packets are written one after the other, in this layout:
+ *   0xFF, Flags | Line[10:7], Line[6:0], Horizontal offset, DID, SDID, DC, UDW[DC]
+ * The buffer is zero-filled after the last packet.
+ */
+namespace AjaMediaAncillary
+{
+	static const uint8 StartCode = 0xFF;
+	static const uint32 HeaderSize = 7;
+	static const int32 MaxUserDataCount = 255;
+
+	namespace Flags
+	{
+		static const uint8 LocationValid = 0x80;
+		static const uint8 Field2 = 0x40;
+		static const uint8 LumaChannel = 0x20;
+	}
+
+	/** @return the size of the packet in an ancillary buffer. */
+	inline uint32 GetPacketSize(const FAjaMediaAncillaryPacket& InPacket)
+	{
+		return HeaderSize + InPacket.UserData.Num();
+	}
+
+	/**
+	 * Write a packet in an ancillary buffer.
+	 * @return the number of bytes written, 0 if the packet doesn't fit or is invalid.
+	 */
+	inline uint32 WritePacket(const FAjaMediaAncillaryPacket& InPacket, uint8* OutBuffer, uint32 InCapacity)
+	{
+		const uint32 PacketSize = GetPacketSize(InPacket);
+		if (PacketSize > InCapacity || InPacket.UserData.Num() > MaxUserDataCount || InPacket.Line >= 2048)
+		{
+			return 0;
+		}
+
+		OutBuffer[0] = StartCode;
+		OutBuffer[1] = Flags::LocationValid | Flags::LumaChannel | (InPacket.bField2 ? Flags::Field2 : 0) | (uint8)((InPacket.Line >> 7) & 0x0F);
+		OutBuffer[2] = (uint8)(InPacket.Line & 0x7F);
+		OutBuffer[3] = 0;
+		OutBuffer[4] = InPacket.DID;
+		OutBuffer[5] = InPacket.SDID;
+		OutBuffer[6] = (uint8)InPacket.UserData.Num();
+		FMemory::Memcpy(OutBuffer + HeaderSize, InPacket.UserData.GetData(), InPacket.UserData.Num());
+		return PacketSize;
+	}
+
+	/**
+	 * Index the packets of an ancillary buffer. Stops at the zero fill, or at the first packet that is truncated.
+	 * OutIndex is reset but keeps its allocation.
+	 * @return the number of packets.
+	 */
+	AJAMEDIA_API int32 ParsePackets(const uint8* InBuffer, uint32 InSize, TArray<FAjaMediaAncillaryPacketIndex>& OutIndex);
+}
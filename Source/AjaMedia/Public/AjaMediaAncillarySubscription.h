@@ -0,0 +1,96 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AjaMediaAncillary.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/Timecode.h"
+
+/**
+ * An ancillary packet received on an AJA input.
+ */
+struct FAjaMediaAncillaryReceivedPacket
+{
+	uint8 DID;
+	uint8 SDID;
+	uint16 Line;
+	bool bField2;
+
+	/** Time and timecode of the field the packet was received with, as in the media samples. */
+	FTimespan Time;
+	TOptional<FTimecode> Timecode;
+
+	/** User data words. */
+	TArray<uint8, TFixedAllocator<AjaMediaAncillary::MaxUserDataCount>> UserData;
+};
+
+/**
+ * The ancillary packets of an AJA input that match a DID and a SDID.
+ *
+ * The input thread parses the packets of every field once and copies the matching packets in the subscriptions.
+ * The consumers dequeue them from any thread, without parsing the ancillary buffers again.
+ * No allocation happens once the subscription is created.
+ */
+class AJAMEDIA_API FAjaMediaAncillarySubscription
+{
+public:
+
+	/** Matches every SDID of the DID. */
+	static const int32 AnySDID = INDEX_NONE;
+
+	/**
+	 * Subscribe to the ancillary packets of an AJA input. The input must capture the ancillary data.
+	 * The subscription can be made before the input is opened, and lasts until the returned object is destroyed.
+	 *
+	 * @param InUrl Url of the input, as given by the media source (aja://...).
+	 * @param InDID Data identifier of the packets.
+	 * @param InSDID Secondary data identifier of the packets, or AnySDID.
+	 * @param InMaxNumPackets Number of packets kept until they are dequeued. When full, the oldest packet is dropped.
+	 */
+	static TSharedRef<FAjaMediaAncillarySubscription, ESPMode::ThreadSafe> Subscribe(const FString& InUrl, uint8 InDID, int32 InSDID = AnySDID, int32 InMaxNumPackets = 64);
+
+	~FAjaMediaAncillarySubscription();
+
+	/**
+	 * Pop the oldest packet.
+	 * @return false if no packet is waiting.
+	 */
+	bool Dequeue(FAjaMediaAncillaryReceivedPacket& OutPacket);
+
+	/** @return the number of packets dropped because they were not dequeued in time. */
+	int32 GetNumDroppedPackets() const { return NumDroppedPackets; }
+
+	/** @return the url of the input. */
+	const FString& GetUrl() const { return Url; }
+
+	/** @return true if the packet is delivered to this subscription. */
+	bool Matches(uint8 InDID, uint8 InSDID) const
+	{
+		return InDID == DID && (SDID == AnySDID || InSDID == SDID);
+	}
+
+private:
+
+	friend class FAjaMediaAncillaryDemux;
+
+	FAjaMediaAncillarySubscription(const FString& InUrl, uint8 InDID, int32 InSDID, int32 InMaxNumPackets);
+
+	/** Copy a packet of an ancillary buffer. Called by the input thread. */
+	void Enqueue(const uint8* InBuffer, const FAjaMediaAncillaryPacketIndex& InIndex, FTimespan InTime, const TOptional<FTimecode>& InTimecode);
+
+private:
+
+	FString Url;
+	uint8 DID;
+	int32 SDID;
+
+	/** Ring of received packets, allocated once */
+	TArray<FAjaMediaAncillaryReceivedPacket> Packets;
+	int32 FirstPacket;
+	int32 NumPackets;
+	FCriticalSection PacketsCriticalSection;
+
+	volatile int32 NumDroppedPackets;
+};
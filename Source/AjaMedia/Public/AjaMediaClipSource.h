@@ -0,0 +1,121 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "TimeSynchronizableMediaSource.h"
+
+#include "Engine/EngineTypes.h"
+
+#include "AjaMediaClipSource.generated.h"
+
+/**
+ * Pace of the frames of a replayed clip.
+ */
+UENUM()
+enum class EAjaMediaClipPlaybackRate : uint8
+{
+	/** At the frame rate of the clip, like the input it was recorded from. */
+	Recorded UMETA(DisplayName="Recorded cadence"),
+	/** Every frame as soon as the previous one was received. */
+	AsFastAsPossible UMETA(DisplayName="As fast as possible"),
+};
+
+/**
+ * Media source that replays a clip recorded with Aja.Recorder.Start, as if it came from an AJA input.
+ * The frames go through the capture path of the AJA player, with their timecode, audio and ancillary data. No card is used,
+ * but the AJA library must be initialized. Launch with -AjaLoopback where the AJA SDK is not available.
+ */
+UCLASS(BlueprintType, hideCategories=(Platforms,Object))
+class AJAMEDIA_API UAjaMediaClipSource : public UTimeSynchronizableMediaSource
+{
+	GENERATED_BODY()
+
+	/** Default constructor. */
+	UAjaMediaClipSource();
+
+public:
+	/** Any file of the clip. The other files of the clip must be next to it. */
+	UPROPERTY(EditAnywhere, Category="Clip", meta=(FilePathFilter="index"))
+	FFilePath ClipPath;
+
+	/** Pace of the frames. */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category="Clip")
+	EAjaMediaClipPlaybackRate PlaybackRate;
+
+	/** Play the clip again from its first frame once it ends. */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category="Clip")
+	bool bLoop;
+
+	/** Use the timecode recorded with the frames. */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category="Clip")
+	bool bUseRecordedTimecode;
+
+public:
+	/** Play the recorded ancillary data. */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category="Ancillary")
+	bool bCaptureAncillary;
+
+	/** Maximum number of ancillary data frames to buffer. */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, AdvancedDisplay, Category="Ancillary", meta=(EditCondition="bCaptureAncillary", ClampMin="1", ClampMax="32"))
+	int32 MaxNumAncillaryFrameBuffer;
+
+public:
+	/** Play the recorded audio. */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category="Audio")
+	bool bCaptureAudio;
+
+	/** Maximum number of audio frames to buffer. */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, AdvancedDisplay, Category="Audio", meta=(EditCondition="bCaptureAudio", ClampMin="1", ClampMax="32"))
+	int32 MaxNumAudioFrameBuffer;
+
+public:
+	/** Play the recorded video. */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category="Video")
+	bool bCaptureVideo;
+
+	/** Whether the recorded video is in sRGB color space. */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category="Video")
+	bool bIsSRGBInput;
+
+	/** Maximum number of video frames to buffer. */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, AdvancedDisplay, Category="Video", meta=(EditCondition="bCaptureVideo", ClampMin="1", ClampMax="32"))
+	int32 MaxNumVideoFrameBuffer;
+
+public:
+	/** Log a warning when there's a drop frame. */
+	UPROPERTY(EditAnywhere, Category="Debug")
+	bool bLogDropFrame;
+
+	/**
+	 * Burn Frame Timecode in the input texture without any frame number clipping.
+	 * @Note Only supported with progressive format.
+	 */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category="Debug", meta=(DisplayName="Burn Frame Timecode"))
+	bool bEncodeTimecodeInTexel;
+
+public:
+	//~ IMediaOptions interface
+
+	virtual bool GetMediaOption(const FName& Key, bool DefaultValue) const override;
+	virtual int64 GetMediaOption(const FName& Key, int64 DefaultValue) const override;
+	virtual FString GetMediaOption(const FName& Key, const FString& DefaultValue) const override;
+	virtual bool HasMediaOption(const FName& Key) const override;
+
+public:
+	//~ UMediaSource interface
+
+	virtual FString GetUrl() const override;
+	virtual bool Validate() const override;
+
+public:
+	//~ UObject interface
+#if WITH_EDITOR
+	virtual bool CanEditChange(const UProperty* InProperty) const override;
+	virtual void PostEditChangeChainProperty(struct FPropertyChangedChainEvent& PropertyChangedEvent) override;
+#endif //WITH_EDITOR
+	//~ End UObject interface
+
+private:
+	/** @return the path of the files of the clip, without their extension. */
+	FString GetClipBaseName() const;
+};
@@ -0,0 +1,48 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Logging/LogCategory.h"
+
+/**
+ * Log of the AJA threads, written by a background thread.
+ *
+ * The SDK callbacks and the drop frame warnings are logged from the DMA and callback threads. A synchronous UE_LOG goes through
+ * every output device and can block those threads, which makes the frame drops worse during a signal loss.
+ * The messages are formatted into a bounded lock-free queue instead, and a background thread sends them to the log.
+ * Every call site, identified by its format string, is limited to a number of messages per second. The suppressed ones are
+ * coalesced into a single "N occurrences in the last second" line. When the queue is full, the message is dropped and counted.
+ * Before Startup and after Shutdown, the messages are logged synchronously.
+ */
+class AJAMEDIA_API FAjaMediaLog
+{
+public:
+
+	/** Start the log thread. Called when the module starts. */
+	static void Startup();
+
+	/** Stop the log thread and flush the queue. Called when the module shuts down. */
+	static void Shutdown();
+
+	/**
+	 * Queue a message. Can be called from any thread.
+	 * @param InFormat The format of the message. It identifies the call site for the rate limiting, it must be a literal.
+	 */
+	static void Log(const FLogCategoryBase& InCategory, ELogVerbosity::Type InVerbosity, const TCHAR* InFormat, ...);
+	static void LogV(const FLogCategoryBase& InCategory, ELogVerbosity::Type InVerbosity, const TCHAR* InFormat, va_list InArgs);
+};
+
+/** Like UE_LOG, but the message is queued and rate limited by FAjaMediaLog. */
+#if NO_LOGGING
+	#define AJA_LOG_ASYNC(CategoryName, Verbosity, Format, ...)
+#else
+	#define AJA_LOG_ASYNC(CategoryName, Verbosity, Format, ...) \
+		{ \
+			if (!CategoryName.IsSuppressed(ELogVerbosity::Verbosity)) \
+			{ \
+				FAjaMediaLog::Log(CategoryName, ELogVerbosity::Verbosity, Format, ##__VA_ARGS__); \
+			} \
+		}
+#endif
@@ -0,0 +1,78 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Matrix of the conversions between YCbCr and RGB. The YCbCr values are limited range (16-235 for the luma, 16-240 for the chroma).
+ */
+enum class EAjaMediaColorMatrix : uint8
+{
+	/** HD and UHD formats. */
+	Rec709,
+	/** SD formats. */
+	Rec601,
+};
+
+/**
+ * Planes of a 4:2:2 frame with 16-bit components. The 10-bit values are in the upper bits of the components, like P210.
+ * The chroma planes have half the width of the luma plane. The strides are in bytes.
+ */
+struct FAjaMediaYUV16Planes
+{
+	uint16* Y;
+	uint16* U;
+	uint16* V;
+	uint32 YStride;
+	uint32 UVStride;
+};
+
+/**
+ * Converts the frames of the AJA texture samples to the pixel formats used on the CPU, and back.
+ *
+ * The formats are the ones of the AJA player and capture:
+ *   v210      4:2:2 10-bit YCbCr, 6 pixels in 16 bytes. The rows are padded to a whole number of 6 pixel groups.
+ *   UYVY      4:2:2 8-bit YCbCr.
+ *   BGRA      8-bit RGB, B in the first byte.
+ *   BGR10A2   10-bit RGB in 32 bits, R in the low bits and A in the 2 high bits (A2B10G10R10).
+ *   YUV16     4:2:2 16-bit YCbCr, packed in the order of v210 (U Y V Y) or in planes, see FAjaMediaYUV16Planes.
+ *   RGBA16    16-bit RGB, 4 components per pixel.
+ *
+ * The 10-bit to 16-bit conversions are lossless in both directions. The 4:2:2 formats must have an even width.
+ * The rows are converted one at a time, so the strides and the alignment of the frames can be anything. The conversions use AVX2 or SSE4.1
+ * when the CPU has them, with the same result as the scalar code. Aja.PixelConversion.MaxInstructionSet limits the instruction set
+ * and Aja.PixelConversion.Benchmark checks every instruction set against the scalar code and reports their throughput.
+ * Can be called from any thread.
+ */
+class AJAMEDIA_API FAjaMediaPixelConversion
+{
+public:
+
+	/** v210 to packed YUV16: U0 Y0 V0 Y1, 4 bytes per pixel. */
+	static void V210ToYUV16(const void* InSource, uint32 InSourceStride, uint16* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight);
+
+	/** Packed YUV16 to v210. The lower 6 bits of the components are dropped. The padding of the last group of a row is zeroed. */
+	static void YUV16ToV210(const uint16* InSource, uint32 InSourceStride, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight);
+
+	/** v210 to planar YUV16. */
+	static void V210ToPlanarYUV16(const void* InSource, uint32 InSourceStride, const FAjaMediaYUV16Planes& OutDestination, uint32 InWidth, uint32 InHeight);
+
+	/** Planar YUV16 to v210. The planes are only read. */
+	static void PlanarYUV16ToV210(const FAjaMediaYUV16Planes& InSource, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight);
+
+	/** UYVY to BGRA. The alpha is opaque. */
+	static void UYVYToBGRA(const void* InSource, uint32 InSourceStride, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight, EAjaMediaColorMatrix InMatrix = EAjaMediaColorMatrix::Rec709);
+
+	/** BGRA to UYVY. The chroma of a pixel pair is the chroma of their average. The alpha is ignored. */
+	static void BGRAToUYVY(const void* InSource, uint32 InSourceStride, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight, EAjaMediaColorMatrix InMatrix = EAjaMediaColorMatrix::Rec709);
+
+	/** BGR10A2 to RGBA16. The bits of the components are replicated so 1023 becomes 65535. */
+	static void BGR10A2ToRGBA16(const void* InSource, uint32 InSourceStride, uint16* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight);
+
+	/** RGBA16 to BGR10A2. The lower bits of the components are dropped. */
+	static void RGBA16ToBGR10A2(const uint16* InSource, uint32 InSourceStride, void* OutDestination, uint32 InDestinationStride, uint32 InWidth, uint32 InHeight);
+
+	/** @return the instruction set the conversions use, "AVX2", "SSE4.1" or "Scalar". */
+	static const TCHAR* GetInstructionSetName();
+};
@@ -4,6 +4,7 @@
 
 #include "TimeSynchronizableMediaSource.h"
 
+#include "AjaMediaThreadSettings.h"
 #include "MediaIOCoreDefinitions.h"
 
 #include "AjaMediaSource.generated.h"
@@ -55,6 +56,13 @@ public:
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category="AJA")
 	bool bCaptureWithAutoCirculating;
 
+	/**
+	 * Detect the video format of the signal when the input is opened, instead of using the format of the configuration.
+	 * The input is opened again with the new format when the signal changes.
+	 */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category="AJA")
+	bool bAutoDetectFormat;
+
 public:
 	/**
 	 * Capture Ancillary from the AJA source.
@@ -101,6 +109,11 @@ public:
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, AdvancedDisplay, Category="Video", meta=(EditCondition="bCaptureVideo", ClampMin="1", ClampMax="32"))
 	int32 MaxNumVideoFrameBuffer;
 
+public:
+	/** Scheduling of the capture thread and placement of the frame buffers. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category="Performance")
+	FAjaMediaThreadSettings ThreadSettings;
+
 public:
 	/** Log a warning when there's a drop frame. */
 	UPROPERTY(EditAnywhere, Category="Debug")
@@ -0,0 +1,72 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AjaMediaThreadSettings.generated.h"
+
+/**
+ * Priority of the thread that services an AJA channel.
+ */
+UENUM()
+enum class EAjaMediaThreadPriority : uint8
+{
+	/** Keep the priority given by the driver. */
+	Default,
+	AboveNormal,
+	Highest,
+	TimeCritical,
+};
+
+/**
+ * Scheduling of the thread that services an AJA channel and placement of its frame buffers.
+ * A thread that also services other channels, like the capture thread of the loopback device, is left as it is.
+ */
+USTRUCT(BlueprintType)
+struct AJAMEDIA_API FAjaMediaThreadSettings
+{
+	GENERATED_BODY()
+
+	FAjaMediaThreadSettings();
+
+	/** Pin the channel thread to the cores of the affinity mask, instead of the cores of the card NUMA node. */
+	UPROPERTY(EditAnywhere, Category="Thread")
+	bool bOverrideAffinity;
+
+	/** Logical cores the channel thread can run on, one bit per core. */
+	UPROPERTY(EditAnywhere, Category="Thread", meta=(EditCondition="bOverrideAffinity"))
+	int64 AffinityMask;
+
+	/** Priority of the channel thread. */
+	UPROPERTY(EditAnywhere, Category="Thread")
+	EAjaMediaThreadPriority Priority;
+
+	/**
+	 * Allocate the frame buffers from the NUMA node of the card, so the DMA doesn't cross the socket interconnect.
+	 * Unless the affinity is overridden, the channel thread is also pinned to the cores of that node.
+	 */
+	UPROPERTY(EditAnywhere, Category="Thread")
+	bool bNumaLocalAllocation;
+
+	/** NUMA node of the card. -1 to detect it, which only works when all the AJA cards are on the same node. */
+	UPROPERTY(EditAnywhere, Category="Thread", meta=(EditCondition="bNumaLocalAllocation", ClampMin="-1", ClampMax="63"))
+	int32 NumaNode;
+
+public:
+
+	/** @return the NUMA node to allocate from, or INDEX_NONE if the allocations are not NUMA-local or the node is unknown. */
+	int32 ResolveNumaNode(int32 InDeviceIndex) const;
+
+	/**
+	 * Apply the affinity and the priority to the calling thread. Must be called from the channel thread.
+	 * @return the resolved NUMA node, see ResolveNumaNode.
+	 */
+	int32 ApplyToCurrentThread(int32 InDeviceIndex) const;
+
+	/**
+	 * Only apply the affinity to the calling thread, for a helper thread of the channel that allocates its buffers.
+	 * @return the resolved NUMA node, see ResolveNumaNode.
+	 */
+	int32 ApplyAffinityToCurrentThread(int32 InDeviceIndex) const;
+};
@@ -0,0 +1,40 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MediaIOCoreEncodeTime.h"
+
+/**
+ * Burns the timecode in the texels of a frame. The result is the same as FMediaIOCoreEncodeTime.
+ *
+ * The texels written by FMediaIOCoreEncodeTime only depend on the timecode and on the format and size of the frame.
+ * For each of them, the stamp of every hour, minute, second and frame value is rendered once, in the background,
+ * and kept as row spans. A frame is then stamped by storing the spans of its timecode with vector stores,
+ * and only the rows of the stamp are touched. The spans of the packed 10-bit formats, v210 and A2B10G10R10, are
+ * merged with the frame through a bit mask, since the components of two fields can share a byte.
+ *
+ * FMediaIOCoreEncodeTime is used
+ *  - until the stamps are ready, a few tens of milliseconds after Prepare or the first frame of that size,
+ *  - when the encoder output can't be split per field, or the frame is bigger than 512 MB,
+ *  - for hours, minutes, seconds or frames out of the 24:60:60:60 range.
+ * The stamps of the last 8 formats and sizes are kept.
+ * Aja.BurnIn.Fast 0 always uses FMediaIOCoreEncodeTime and Aja.BurnIn.Benchmark compares both.
+ */
+class AJAMEDIA_API FAjaMediaTimecodeBurnIn
+{
+public:
+
+	/**
+	 * Burn the timecode in the frame. The arguments are the same as FMediaIOCoreEncodeTime.
+	 * Can be called from any thread.
+	 */
+	static void Render(EMediaIOCoreEncodePixelFormat InFormat, void* InBuffer, uint32 InPitch, uint32 InWidth, uint32 InHeight, uint32 InHours, uint32 InMinutes, uint32 InSeconds, uint32 InFrames);
+
+	/**
+	 * Start to build the stamps of a format and size, so they are ready for the first frames.
+	 * Call it when an input or output opens with the timecode burn-in. Can be called from any thread.
+	 */
+	static void Prepare(EMediaIOCoreEncodePixelFormat InFormat, uint32 InWidth, uint32 InHeight);
+};
@@ -11,15 +11,13 @@
 
 #include "AjaTimecodeProvider.generated.h"
 
-namespace AJA
-{
-	class AJASyncChannel;
-}
-
+class FAjaSyncWatcher;
+class IAjaSyncChannel;
 class UEngine;
 
 /**
  * Class to fetch a timecode via an AJA card.
+ * The timecode is latched once per sync on a watcher thread, GetTimecode doesn't go through the driver.
  * When the signal is lost in the editor (not in PIE), the TimecodeProvider will try to re-synchronize every second.
  */
 UCLASS(Blueprintable, editinlinenew, meta=(DisplayName="AJA SDI Input", MediaIOCustomLayout="AJA"))
@@ -74,9 +72,12 @@ public:
 
 private:
 	/** AJA Port to capture the Sync */
-	AJA::AJASyncChannel* SyncChannel;
+	IAjaSyncChannel* SyncChannel;
 	FAJACallback* SyncCallback;
 
+	/** Latches the timecode of the channel at every sync */
+	FAjaSyncWatcher* SyncWatcher;
+
 #if WITH_EDITORONLY_DATA
 	/** Engine used to initialize the Provider */
 	UPROPERTY(Transient)
@@ -86,6 +87,9 @@ private:
 	double LastAutoSynchronizeInEditorAppTime;
 #endif
 
+	/** Registered to the device changes while initialized */
+	FDelegateHandle DevicesChangedHandle;
+
 	/** The current SynchronizationState of the TimecodeProvider*/
 	ETimecodeProviderSynchronizationState State;
 };
@@ -0,0 +1,141 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AJALib.h"
+
+/**
+ * Enumerate the AJA devices. Mirrors AJA::AJADeviceScanner.
+ * The list of devices is captured when the scanner is created.
+ */
+class IAjaDeviceScanner
+{
+public:
+	virtual ~IAjaDeviceScanner() {}
+
+	virtual int32 GetNumDevices() const = 0;
+	virtual bool GetDeviceTextId(int32 InDeviceIndex, AJA::AJADeviceScanner::FormatedTextType& OutTextId) const = 0;
+	virtual bool GetDeviceInfo(int32 InDeviceIndex, AJA::AJADeviceScanner::DeviceInfo& OutDeviceInfo) const = 0;
+};
+
+/**
+ * Enumerate the video formats supported by a device. Mirrors AJA::AJAVideoFormats.
+ */
+class IAjaVideoFormats
+{
+public:
+	virtual ~IAjaVideoFormats() {}
+
+	virtual int32 GetNumSupportedFormat() const = 0;
+	virtual AJA::AJAVideoFormats::VideoFormatDescriptor GetSupportedFormat(int32 InIndex) const = 0;
+};
+
+/**
+ * Genlock and timecode channel. Mirrors AJA::AJASyncChannel.
+ */
+class IAjaSyncChannel
+{
+public:
+	virtual ~IAjaSyncChannel() {}
+
+	virtual bool Initialize(const AJA::AJADeviceOptions& InDevice, const AJA::AJASyncChannelOptions& InOptions) = 0;
+	virtual void Uninitialize() = 0;
+
+	// Only available if the initialization succeeded
+	virtual bool WaitForSync() const = 0;
+	virtual bool GetTimecode(AJA::FTimecode& OutTimecode) const = 0;
+	virtual bool GetSyncCount(uint32& OutCount) const = 0;
+};
+
+/**
+ * Capture channel. Mirrors AJA::AJAInputChannel.
+ * The callback interface is invoked from a thread owned by the backend.
+ */
+class IAjaInputChannel
+{
+public:
+	virtual ~IAjaInputChannel() {}
+
+	virtual bool Initialize(const AJA::AJADeviceOptions& InDevice, const AJA::AJAInputOutputChannelOptions& InOptions) = 0;
+	/** This may block, until the completion of a callback from IAJAInputOutputChannelCallbackInterface. */
+	virtual void Uninitialize() = 0;
+
+	/**
+	 * Switch an initialized channel to other options (video format, pixel format, captured data) without releasing the device.
+	 * The frames delivered after the call returns use the new options. OnInitializationCompleted is not called again.
+	 * @return false if the backend can't apply the options in place. The channel is unchanged and must be initialized again.
+	 */
+	virtual bool Reconfigure(const AJA::AJAInputOutputChannelOptions& InOptions) = 0;
+
+	/** @return false if Reconfigure never succeeds with this backend. Such a channel isn't worth keeping once closed. */
+	virtual bool CanReconfigure() const = 0;
+
+	/** @return true if the callbacks come from a thread that also services other channels. The thread settings of the input are not applied to such a thread. */
+	virtual bool IsCallbackThreadShared() const = 0;
+
+	// Only available if the initialization succeeded
+	virtual uint32 GetFrameDropCount() const = 0;
+};
+
+/**
+ * Playout channel. Mirrors AJA::AJAOutputChannel.
+ * The callback interface is invoked from a thread owned by the backend.
+ */
+class IAjaOutputChannel
+{
+public:
+	virtual ~IAjaOutputChannel() {}
+
+	virtual bool Initialize(const AJA::AJADeviceOptions& InDevice, const AJA::AJAInputOutputChannelOptions& InOptions) = 0;
+	virtual void Uninitialize() = 0;
+
+	// Set a new buffer that will be copied to the device.
+	virtual bool SetAncillaryFrameData(const AJA::AJAOutputFrameBufferData& InFrameData, uint8* InAncillaryBuffer, uint32 InAncillaryBufferSize) = 0;
+	virtual bool SetAudioFrameData(const AJA::AJAOutputFrameBufferData& InFrameData, uint8* InAudioBuffer, uint32 InAudioBufferSize) = 0;
+	virtual bool SetVideoFrameData(const AJA::AJAOutputFrameBufferData& InFrameData, uint8* InVideoBuffer, uint32 InVideoBufferSize) = 0;
+
+	virtual bool GetOutputDimension(uint32& OutWidth, uint32& OutHeight) const = 0;
+};
+
+/**
+ * Detect the video format of every input. Mirrors AJA::AJAAutoDetectChannel.
+ */
+class IAjaAutoDetectChannel
+{
+public:
+	virtual ~IAjaAutoDetectChannel() {}
+
+	virtual bool Initialize(AJA::IAJAAutoDectectCallbackInterface* InCallbackInterface) = 0;
+	virtual void Uninitialize() = 0;
+
+	virtual int32 GetNumOfChannelData() const = 0;
+	virtual AJA::AJAAutoDetectChannel::AutoDetectChannelData GetChannelData(int32 InIndex) const = 0;
+};
+
+/**
+ * Factory for the objects used to talk to the AJA devices.
+ * The backend is selected when the AjaMedia module starts. It is either the AJA SDK or a software loopback.
+ * Channels are owned by the caller and must be uninitialized before being deleted.
+ */
+class IAjaDeviceBackend
+{
+public:
+	virtual ~IAjaDeviceBackend() {}
+
+	/** @return the name of the backend, i.e. "SDK" or "Loopback". */
+	virtual FName GetName() const = 0;
+
+	virtual TUniquePtr<IAjaDeviceScanner> CreateDeviceScanner() const = 0;
+	virtual TUniquePtr<IAjaVideoFormats> CreateVideoFormats(int32 InDeviceIndex) const = 0;
+	virtual AJA::AJAVideoFormats::VideoFormatDescriptor GetVideoFormat(AJA::FAJAVideoFormat InVideoFormatIndex) const = 0;
+
+	/** @return the NUMA node of the PCIe slot of the device, or INDEX_NONE if unknown. */
+	virtual int32 GetDeviceNumaNode(int32 InDeviceIndex) const = 0;
+
+	virtual IAjaSyncChannel* CreateSyncChannel() = 0;
+	virtual IAjaInputChannel* CreateInputChannel() = 0;
+	virtual IAjaOutputChannel* CreateOutputChannel() = 0;
+	virtual IAjaAutoDetectChannel* CreateAutoDetectChannel() = 0;
+};
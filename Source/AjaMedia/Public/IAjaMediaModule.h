@@ -5,6 +5,7 @@
 #include "Modules/ModuleInterface.h"
 #include "Templates/SharedPointer.h"
 
+class IAjaDeviceBackend;
 class IMediaEventSink;
 class IMediaPlayer;
 
@@ -27,5 +28,8 @@ public:
 
 	/** @return true if the Aja card can be used */
 	virtual bool CanBeUsed() const = 0;
+
+	/** @return the backend used to talk to the devices, either the AJA SDK or the software loopback. nullptr if the module is not initialized. */
+	virtual IAjaDeviceBackend* GetDeviceBackend() const = 0;
 };
 
@@ -84,6 +84,8 @@ private:
 
 		StyleInstance->Set("ClassThumbnail.AjaMediaSource", new IMAGE_BRUSH("AjaMediaSource_64x", Icon64x64));
 		StyleInstance->Set("ClassIcon.AjaMediaSource", new IMAGE_BRUSH("AjaMediaSource_20x", Icon20x20));
+		StyleInstance->Set("ClassThumbnail.AjaMediaClipSource", new IMAGE_BRUSH("AjaMediaSource_64x", Icon64x64));
+		StyleInstance->Set("ClassIcon.AjaMediaClipSource", new IMAGE_BRUSH("AjaMediaSource_20x", Icon20x20));
 		StyleInstance->Set("ClassThumbnail.AjaMediaOutput", new IMAGE_BRUSH("AjaMediaOutput_64x", Icon64x64));
 		StyleInstance->Set("ClassIcon.AjaMediaOutput", new IMAGE_BRUSH("AjaMediaOutput_20x", Icon20x20));
 
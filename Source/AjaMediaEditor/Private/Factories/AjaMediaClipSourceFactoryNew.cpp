@@ -0,0 +1,39 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaClipSourceFactoryNew.h"
+
+#include "AssetTypeCategories.h"
+#include "AjaMediaClipSource.h"
+
+
+/* UAjaMediaClipSourceFactoryNew structors
+ *****************************************************************************/
+
+UAjaMediaClipSourceFactoryNew::UAjaMediaClipSourceFactoryNew(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	SupportedClass = UAjaMediaClipSource::StaticClass();
+	bCreateNew = true;
+	bEditAfterNew = true;
+}
+
+
+/* UFactory overrides
+ *****************************************************************************/
+
+UObject* UAjaMediaClipSourceFactoryNew::FactoryCreateNew(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, UObject* Context, FFeedbackContext* Warn)
+{
+	return NewObject<UAjaMediaClipSource>(InParent, InClass, InName, Flags);
+}
+
+
+uint32 UAjaMediaClipSourceFactoryNew::GetMenuCategories() const
+{
+	return EAssetTypeCategories::Media;
+}
+
+
+bool UAjaMediaClipSourceFactoryNew::ShouldShowInNewMenu() const
+{
+	return true;
+}
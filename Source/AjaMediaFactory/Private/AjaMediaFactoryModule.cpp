@@ -96,9 +96,11 @@ public:
 	{
 		// supported platforms
 		SupportedPlatforms.Add(TEXT("Windows"));
+		SupportedPlatforms.Add(TEXT("Linux")); // loopback device backend only
 
 		// supported schemes
 		SupportedUriSchemes.Add(TEXT("aja")); // Also in AjaDeviceProvider.cpp
+		SupportedUriSchemes.Add(TEXT("ajaclip")); // Also in AjaMediaClip.h
 
 		// register player factory
 		auto MediaModule = FModuleManager::LoadModulePtr<IMediaModule>("Media");
@@ -3,11 +3,18 @@
 #include "AjaMediaCapture.h"
 
 #include "AJALib.h"
+#include "AjaDeviceCatalog.h"
 #include "AjaDeviceProvider.h"
+#include "AjaMediaLog.h"
 #include "AjaMediaOutput.h"
+#include "AjaMediaOutputAncillary.h"
+#include "AjaMediaOutputAudio.h"
+#include "AjaMediaOutputWorker.h"
+#include "AjaMediaTimecodeBurnIn.h"
 #include "Engine/RendererSettings.h"
 #include "HAL/Event.h"
 #include "HAL/IConsoleManager.h"
+#include "IAjaDeviceBackend.h"
 #include "IAjaMediaModule.h"
 #include "IAjaMediaOutputModule.h"
 #include "MediaIOCoreFileWriter.h"
@@ -31,6 +38,16 @@ namespace AjaMediaCaptureDevice
 		Timecode.Frames = int32(float(InTimecode.Frames) / Divider);
 		return Timecode;
 	}
+
+	/** Format of the readback buffer, as given to the timecode burn-in by OnFrameCaptured_RenderingThread. */
+	EMediaIOCoreEncodePixelFormat GetEncodePixelFormat(EAjaMediaOutputPixelFormat InPixelFormat, bool bInUseKey)
+	{
+		if (InPixelFormat == EAjaMediaOutputPixelFormat::PF_10BIT_YUV)
+		{
+			return bInUseKey ? EMediaIOCoreEncodePixelFormat::A2B10G10R10 : EMediaIOCoreEncodePixelFormat::YUVv210;
+		}
+		return bInUseKey ? EMediaIOCoreEncodePixelFormat::CharBGRA : EMediaIOCoreEncodePixelFormat::CharUYVY;
+	}
 }
 
 bool bAjaWritInputRawDataCmdEnable = false;
@@ -57,24 +74,20 @@ struct UAjaMediaCapture::FAjaOutputCallback : public AJA::IAJAInputOutputChannel
 	uint64 PreviousDroppedCount = 0;
 };
 
-///* FAjaOutputCallback definition
-//*****************************************************************************/
-struct UAjaMediaCapture::FAJAOutputChannel : public AJA::AJAOutputChannel
-{
-	FAJAOutputChannel() = default;
-};
-
 ///* UAjaMediaCapture implementation
 //*****************************************************************************/
 UAjaMediaCapture::UAjaMediaCapture(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 	, OutputChannel(nullptr)
 	, OutputCallback(nullptr)
+	, OutputWorker(nullptr)
+	, OutputAncillary(nullptr)
 	, bWaitForSyncEvent(false)
 	, bLogDropFrame(false)
 	, bEncodeTimecodeInTexel(false)
 	, PixelFormat(EAjaMediaOutputPixelFormat::PF_8BIT_YUV)
 	, UseKey(false)
+	, DeviceIndex(0)
 	, bSavedIgnoreTextureAlpha(false)
 	, bIgnoreTextureAlphaChanged(false)
 	, FrameRate(30, 1)
@@ -127,12 +140,35 @@ bool UAjaMediaCapture::UpdateRenderTargetImpl(UTextureRenderTarget2D* InRenderTa
 
 void UAjaMediaCapture::StopCaptureImpl(bool bAllowPendingFrameToBeProcess)
 {
+	FAjaDeviceCatalog::OnChanged().Remove(DevicesChangedHandle);
+	DevicesChangedHandle.Reset();
+
 	if (!bAllowPendingFrameToBeProcess)
 	{
 		{
 			// Prevent the rendering thread from copying while we are stopping the capture.
 			FScopeLock ScopeLock(&RenderThreadCriticalSection);
 
+			// The worker uses the channel, stop it first
+			if (OutputWorker)
+			{
+				delete OutputWorker;
+				OutputWorker = nullptr;
+			}
+
+			if (OutputAudio.IsValid())
+			{
+				// The audio thread may keep the listener a little longer
+				OutputAudio->Unregister();
+				OutputAudio.Reset();
+			}
+
+			{
+				FScopeLock AncillaryLock(&AncillaryCriticalSection);
+				delete OutputAncillary;
+				OutputAncillary = nullptr;
+			}
+
 			if (OutputChannel)
 			{
 				// Close the aja channel in the another thread.
@@ -193,9 +229,15 @@ void UAjaMediaCapture::RestoreViewportTextureAlpha(TSharedPtr<FSceneViewport> In
 	}
 }
 
+bool UAjaMediaCapture::QueueAncillaryPacket(const FAjaMediaAncillaryPacket& InPacket)
+{
+	FScopeLock AncillaryLock(&AncillaryCriticalSection);
+	return OutputAncillary && OutputAncillary->Queue(InPacket);
+}
+
 bool UAjaMediaCapture::HasFinishedProcessing() const
 {
-	return Super::HasFinishedProcessing() || OutputChannel == nullptr;
+	return (Super::HasFinishedProcessing() && (OutputWorker == nullptr || OutputWorker->IsIdle())) || OutputChannel == nullptr;
 }
 
 bool UAjaMediaCapture::InitAJA(UAjaMediaOutput* InAjaMediaOutput)
@@ -203,6 +245,12 @@ bool UAjaMediaCapture::InitAJA(UAjaMediaOutput* InAjaMediaOutput)
 	check(InAjaMediaOutput);
 
 	IAjaMediaModule& MediaModule = FModuleManager::LoadModuleChecked<IAjaMediaModule>(TEXT("AjaMedia"));
+	if (!MediaModule.IsInitialized())
+	{
+		UE_LOG(LogAjaMediaOutput, Warning, TEXT("The AjaMediaCapture can't open MediaOutput '%s' because the Aja library was not initialized."), *InAjaMediaOutput->GetName());
+		return false;
+	}
+
 	if (!MediaModule.CanBeUsed())
 	{
 		UE_LOG(LogAjaMediaOutput, Warning, TEXT("The AjaMediaCapture can't open MediaOutput '%s' because Aja card cannot be used. Are you in a Commandlet? You may override this behavior by launching with -ForceAjaUsage"), *InAjaMediaOutput->GetName());
@@ -214,29 +262,46 @@ bool UAjaMediaCapture::InitAJA(UAjaMediaOutput* InAjaMediaOutput)
 	bLogDropFrame = InAjaMediaOutput->bLogDropFrame;
 	bEncodeTimecodeInTexel = InAjaMediaOutput->bEncodeTimecodeInTexel;
 	FrameRate = InAjaMediaOutput->GetRequestedFrameRate();
+	DeviceIndex = InAjaMediaOutput->OutputConfiguration.MediaConfiguration.MediaConnection.Device.DeviceIdentifier;
+	ThreadSettings = InAjaMediaOutput->ThreadSettings;
 	PortName = FAjaDeviceProvider().ToText(InAjaMediaOutput->OutputConfiguration.MediaConfiguration.MediaConnection).ToString();
 
+	// Stop on error if the device is removed or enumerated again while capturing
+	if (!DevicesChangedHandle.IsValid())
+	{
+		TWeakObjectPtr<UAjaMediaCapture> WeakThis = this;
+		DevicesChangedHandle = FAjaDeviceCatalog::OnChanged().AddLambda([WeakThis](const FAjaDeviceCatalog::FChange& InChange)
+		{
+			UAjaMediaCapture* This = WeakThis.Get();
+			if (This && InChange.IsDeviceChanged(This->DeviceIndex) && This->GetState() != EMediaCaptureState::Stopped)
+			{
+				UE_LOG(LogAjaMediaOutput, Error, TEXT("The device of the AJA output '%s' was removed or changed."), *This->PortName);
+				This->SetState(EMediaCaptureState::Error);
+			}
+		});
+	}
+
 	// Init Device options
 	AJA::AJADeviceOptions DeviceOptions(InAjaMediaOutput->OutputConfiguration.MediaConfiguration.MediaConnection.Device.DeviceIdentifier);
 
 	OutputCallback = new UAjaMediaCapture::FAjaOutputCallback();
 	OutputCallback->Owner = this;
 
-	AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = AJA::AJAVideoFormats::GetVideoFormat(InAjaMediaOutput->OutputConfiguration.MediaConfiguration.MediaMode.DeviceModeIdentifier);
+	AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = MediaModule.GetDeviceBackend()->GetVideoFormat(InAjaMediaOutput->OutputConfiguration.MediaConfiguration.MediaMode.DeviceModeIdentifier);
 
 	// Init Channel options
 	AJA::AJAInputOutputChannelOptions ChannelOptions(TEXT("ViewportOutput"), InAjaMediaOutput->OutputConfiguration.MediaConfiguration.MediaConnection.PortIdentifier);
 	ChannelOptions.CallbackInterface = OutputCallback;
 	ChannelOptions.bOutput = true;
-	ChannelOptions.NumberOfAudioChannel = 0;
+	ChannelOptions.NumberOfAudioChannel = InAjaMediaOutput->bOutputAudio ? (InAjaMediaOutput->AudioChannel == EAjaMediaAudioChannel::Channel8 ? 8 : 6) : 0;
 	ChannelOptions.SynchronizeChannelIndex = InAjaMediaOutput->OutputConfiguration.ReferencePortIdentifier;
 	ChannelOptions.KeyChannelIndex = InAjaMediaOutput->OutputConfiguration.KeyPortIdentifier;
 	ChannelOptions.OutputNumberOfBuffers = InAjaMediaOutput->NumberOfAJABuffers;
 	ChannelOptions.VideoFormatIndex = InAjaMediaOutput->OutputConfiguration.MediaConfiguration.MediaMode.DeviceModeIdentifier;
 	ChannelOptions.bUseAutoCirculating = InAjaMediaOutput->bOutputWithAutoCirculating;
 	ChannelOptions.bUseKey = InAjaMediaOutput->OutputConfiguration.OutputType == EMediaIOOutputType::FillAndKey;  // must be RGBA to support Fill+Key
-	ChannelOptions.bUseAncillary = false;
-	ChannelOptions.bUseAudio = false;
+	ChannelOptions.bUseAncillary = InAjaMediaOutput->bOutputAncillary;
+	ChannelOptions.bUseAudio = InAjaMediaOutput->bOutputAudio;
 	ChannelOptions.bUseVideo = true;
 	ChannelOptions.bOutputInterlacedFieldsTimecodeNeedToMatch = InAjaMediaOutput->bInterlacedFieldsTimecodeNeedToMatch && Descriptor.bIsInterlacedStandard && InAjaMediaOutput->TimecodeFormat != EMediaIOTimecodeFormat::None;
 	ChannelOptions.bDisplayWarningIfDropFrames = bLogDropFrame;
@@ -320,7 +385,7 @@ bool UAjaMediaCapture::InitAJA(UAjaMediaOutput* InAjaMediaOutput)
 		break;
 	}
 
-	OutputChannel = new FAJAOutputChannel();
+	OutputChannel = MediaModule.GetDeviceBackend()->CreateOutputChannel();
 	if (!OutputChannel->Initialize(DeviceOptions, ChannelOptions))
 	{
 		UE_LOG(LogAjaMediaOutput, Warning, TEXT("The AJA output port for '%s' could not be opened."), *InAjaMediaOutput->GetName());
@@ -344,6 +409,30 @@ bool UAjaMediaCapture::InitAJA(UAjaMediaOutput* InAjaMediaOutput)
 		WakeUpEvent = FPlatformProcess::GetSynchEventFromPool(bIsManualReset);
 	}
 
+	if (InAjaMediaOutput->bOutputAudio)
+	{
+		// Without audio device, silence is still embedded so the card audio stays in step with the video
+		OutputAudio = MakeShared<FAjaMediaOutputAudio, ESPMode::ThreadSafe>(ChannelOptions.NumberOfAudioChannel, FrameRate, PortName);
+		OutputAudio->Register(InAjaMediaOutput->AudioSubmix);
+	}
+
+	if (InAjaMediaOutput->bOutputAncillary)
+	{
+		FScopeLock AncillaryLock(&AncillaryCriticalSection);
+		OutputAncillary = new FAjaMediaOutputAncillary(InAjaMediaOutput->AncillaryBufferSize, Descriptor.bIsInterlacedStandard, PortName);
+	}
+
+	OutputWorker = new FAjaMediaOutputWorker(FString::Printf(TEXT("AjaMediaOutputWorker %s"), *PortName)
+		, InAjaMediaOutput->NumberOfPendingFrames
+		, [this](FAjaMediaOutputFrame& InFrame) { ProcessFrame_WorkerThread(InFrame); }
+		, [this]() { if (WakeUpEvent) { WakeUpEvent->Trigger(); } });
+
+	if (bEncodeTimecodeInTexel)
+	{
+		// Build the timecode stamps while the capture starts, not on the first frames
+		FAjaMediaTimecodeBurnIn::Prepare(AjaMediaCaptureDevice::GetEncodePixelFormat(PixelFormat, UseKey), Descriptor.ResolutionWidth, Descriptor.ResolutionHeight);
+	}
+
 	return true;
 }
 
@@ -351,14 +440,12 @@ void UAjaMediaCapture::OnFrameCaptured_RenderingThread(const FCaptureBaseData& I
 {
 	// Prevent the rendering thread from copying while we are stopping the capture.
 	FScopeLock ScopeLock(&RenderThreadCriticalSection);
-	if (OutputChannel)
+	if (OutputChannel && OutputWorker)
 	{
-		AJA::FTimecode Timecode = AjaMediaCaptureDevice::ConvertToAJATimecode(InBaseData.SourceFrameTimecode, InBaseData.SourceFrameTimecodeFramerate.AsDecimal(), FrameRate.AsDecimal());
-
 		uint32 Stride = Width * 4;
 		uint32 TimeEncodeWidth = Width;
 		EMediaIOCoreEncodePixelFormat EncodePixelFormat = EMediaIOCoreEncodePixelFormat::CharBGRA;
-		FString OutputFilename;
+		const TCHAR* OutputFilename = TEXT("");
 
 		switch (PixelFormat)
 		{
@@ -398,24 +485,30 @@ void UAjaMediaCapture::OnFrameCaptured_RenderingThread(const FCaptureBaseData& I
 			}
 		}
 
-		if (bEncodeTimecodeInTexel)
+		// The readback buffer is only mapped during this call, the worker gets a copy
+		FAjaMediaOutputWorker::FFramePtr Frame = OutputWorker->AcquireFrame(Stride * Height);
+		FMemory::Memcpy(Frame->Buffer.GetData(), InBuffer, Stride * Height);
+		Frame->Stride = Stride;
+		Frame->TimeEncodeWidth = TimeEncodeWidth;
+		Frame->Height = Height;
+		Frame->EncodePixelFormat = EncodePixelFormat;
+		Frame->OutputFilename = OutputFilename;
+		Frame->Timecode = AjaMediaCaptureDevice::ConvertToAJATimecode(InBaseData.SourceFrameTimecode, InBaseData.SourceFrameTimecodeFramerate.AsDecimal(), FrameRate.AsDecimal());
+		Frame->FrameIdentifier = InBaseData.SourceFrameNumberRenderThread;
+
 		{
-			FMediaIOCoreEncodeTime EncodeTime(EncodePixelFormat, InBuffer, Stride, TimeEncodeWidth, Height);
-			EncodeTime.Render(Timecode.Hours, Timecode.Minutes, Timecode.Seconds, Timecode.Frames);
+			// The packets queued until now go with this frame
+			FScopeLock AncillaryLock(&AncillaryCriticalSection);
+			if (OutputAncillary)
+			{
+				OutputAncillary->MoveQueuedPackets(*Frame);
+			}
 		}
 
-		AJA::AJAOutputFrameBufferData FrameBuffer;
-		FrameBuffer.Timecode = Timecode;
-		FrameBuffer.FrameIdentifier = InBaseData.SourceFrameNumberRenderThread;
-		OutputChannel->SetVideoFrameData(FrameBuffer, reinterpret_cast<uint8_t*>(InBuffer), Stride * Height);
-
-		if (bAjaWritInputRawDataCmdEnable)
+		if (!OutputWorker->Submit(Frame) && bLogDropFrame)
 		{
-			MediaIOCoreFileWriter::WriteRawFile(OutputFilename, reinterpret_cast<uint8*>(InBuffer), Stride * Height);
-			bAjaWritInputRawDataCmdEnable = false;
+			UE_LOG(LogAjaMediaOutput, Verbose, TEXT("The AJA output %s is behind the rendering thread. The oldest pending frame was dropped."), *PortName);
 		}
-
-		WaitForSync_RenderingThread();
 	}
 	else if (GetState() != EMediaCaptureState::Stopped)
 	{
@@ -423,11 +516,45 @@ void UAjaMediaCapture::OnFrameCaptured_RenderingThread(const FCaptureBaseData& I
 	}
 }
 
-void UAjaMediaCapture::WaitForSync_RenderingThread() const
+void UAjaMediaCapture::ProcessFrame_WorkerThread(FAjaMediaOutputFrame& InFrame)
+{
+	if (bEncodeTimecodeInTexel)
+	{
+		FAjaMediaTimecodeBurnIn::Render(InFrame.EncodePixelFormat, InFrame.Buffer.GetData(), InFrame.Stride, InFrame.TimeEncodeWidth, InFrame.Height, InFrame.Timecode.Hours, InFrame.Timecode.Minutes, InFrame.Timecode.Seconds, InFrame.Timecode.Frames);
+	}
+
+	// The channel is only deleted after the worker is stopped
+	AJA::AJAOutputFrameBufferData FrameBuffer;
+	FrameBuffer.Timecode = InFrame.Timecode;
+	FrameBuffer.FrameIdentifier = InFrame.FrameIdentifier;
+	if (OutputAncillary)
+	{
+		// Only the worker packs, and the queue is deleted after the worker is stopped
+		TArrayView<uint8> AncillaryBuffer = OutputAncillary->Pack(InFrame);
+		OutputChannel->SetAncillaryFrameData(FrameBuffer, AncillaryBuffer.GetData(), AncillaryBuffer.Num());
+	}
+	if (OutputAudio.IsValid())
+	{
+		// The audio is selected by the frame identifier, the frames dropped before the worker skip theirs
+		TArrayView<int32> AudioSamples = OutputAudio->PopFrameSamples(InFrame.FrameIdentifier);
+		OutputChannel->SetAudioFrameData(FrameBuffer, reinterpret_cast<uint8*>(AudioSamples.GetData()), AudioSamples.Num() * sizeof(int32));
+	}
+	OutputChannel->SetVideoFrameData(FrameBuffer, InFrame.Buffer.GetData(), InFrame.Buffer.Num());
+
+	if (bAjaWritInputRawDataCmdEnable)
+	{
+		MediaIOCoreFileWriter::WriteRawFile(InFrame.OutputFilename, InFrame.Buffer.GetData(), InFrame.Buffer.Num());
+		bAjaWritInputRawDataCmdEnable = false;
+	}
+
+	WaitForSync_WorkerThread();
+}
+
+void UAjaMediaCapture::WaitForSync_WorkerThread() const
 {
 	if (bWaitForSyncEvent)
 	{
-		if (WakeUpEvent && GetState() != EMediaCaptureState::Error) // In render thread, could be shutdown in a middle of a frame
+		if (WakeUpEvent && GetState() != EMediaCaptureState::Error) // Could be shutdown in a middle of a frame, Stop triggers the event
 		{
 			WakeUpEvent->Wait();
 		}
@@ -440,6 +567,11 @@ void UAjaMediaCapture::WaitForSync_RenderingThread() const
 void UAjaMediaCapture::FAjaOutputCallback::OnInitializationCompleted(bool bSucceed)
 {
 	check(Owner);
+	if (bSucceed)
+	{
+		Owner->ThreadSettings.ApplyToCurrentThread(Owner->DeviceIndex);
+	}
+
 	if (Owner->GetState() != EMediaCaptureState::Stopped)
 	{
 		Owner->SetState(bSucceed ? EMediaCaptureState::Capturing : EMediaCaptureState::Error);
@@ -463,12 +595,12 @@ bool UAjaMediaCapture::FAjaOutputCallback::OnOutputFrameCopied(const AJA::AJAOut
 			static const int32 NumMaxFrameBeforeWarning = 50;
 			if (PreviousDroppedCount % NumMaxFrameBeforeWarning == 0)
 			{
-				UE_LOG(LogAjaMediaOutput, Warning, TEXT("Loosing frames on AJA output %s. The current count is %d."), *Owner->PortName, PreviousDroppedCount);
+				AJA_LOG_ASYNC(LogAjaMediaOutput, Warning, TEXT("Loosing frames on AJA output %s. The current count is %d."), *Owner->PortName, PreviousDroppedCount);
 			}
 		}
 		else if (PreviousDroppedCount > 0)
 		{
-			UE_LOG(LogAjaMediaOutput, Warning, TEXT("Lost %d frames on AJA output %s. Frame rate may be too slow."), PreviousDroppedCount, *Owner->PortName);
+			AJA_LOG_ASYNC(LogAjaMediaOutput, Warning, TEXT("Lost %d frames on AJA output %s. Frame rate may be too slow."), PreviousDroppedCount, *Owner->PortName);
 			PreviousDroppedCount = 0;
 		}
 	}
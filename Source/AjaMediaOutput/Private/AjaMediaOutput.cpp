@@ -3,8 +3,10 @@
 #include "AjaMediaOutput.h"
 
 #include "AJALib.h"
+#include "AjaDeviceCatalog.h"
 #include "AjaMediaCapture.h"
 #include "AjaMediaSettings.h"
+#include "IAjaDeviceBackend.h"
 #include "IAjaMediaModule.h"
 #include "Modules/ModuleManager.h"
 #include "UObject/EnterpriseObjectVersion.h"
@@ -13,6 +15,18 @@
 #define LOCTEXT_NAMESPACE "AjaMediaOutput"
 
 
+/* namespace AjaMediaOutputDevice
+*****************************************************************************/
+namespace AjaMediaOutputDevice
+{
+	AJA::AJAVideoFormats::VideoFormatDescriptor GetVideoFormat(AJA::FAJAVideoFormat InVideoFormatIndex)
+	{
+		IAjaMediaModule& MediaModule = FModuleManager::LoadModuleChecked<IAjaMediaModule>(TEXT("AjaMedia"));
+		IAjaDeviceBackend* DeviceBackend = MediaModule.GetDeviceBackend();
+		return DeviceBackend ? DeviceBackend->GetVideoFormat(InVideoFormatIndex) : AJA::AJAVideoFormats::VideoFormatDescriptor();
+	}
+}
+
 /* UAjaMediaOutput
 *****************************************************************************/
 
@@ -24,8 +38,14 @@ UAjaMediaOutput::UAjaMediaOutput(const FObjectInitializer& ObjectInitializer)
 	, bOutputIn3GLevelB(false)
 	, bInvertKeyOutput(false)
 	, NumberOfAJABuffers(2)
+	, NumberOfPendingFrames(2)
 	, bInterlacedFieldsTimecodeNeedToMatch(false)
 	, bWaitForSyncEvent(false)
+	, bOutputAudio(false)
+	, AudioChannel(EAjaMediaAudioChannel::Channel8)
+	, AudioSubmix(nullptr)
+	, bOutputAncillary(false)
+	, AncillaryBufferSize(8 * 1024)
 	, bLogDropFrame(true)
 	, bEncodeTimecodeInTexel(false)
 {
@@ -57,14 +77,15 @@ bool UAjaMediaOutput::Validate(FString& OutFailureReason) const
 		return false;
 	}
 
-	AJA::AJADeviceScanner Scanner;
-	AJA::AJADeviceScanner::DeviceInfo DeviceInfo;
-	if (!Scanner.GetDeviceInfo(OutputConfiguration.MediaConfiguration.MediaConnection.Device.DeviceIdentifier, DeviceInfo))
+	const FAjaDeviceCatalog::FSnapshotRef Devices = FAjaDeviceCatalog::Get();
+	const FAjaDeviceCatalog::FDevice* Device = Devices->FindDevice(OutputConfiguration.MediaConfiguration.MediaConnection.Device.DeviceIdentifier);
+	if (Device == nullptr)
 	{
 		OutFailureReason = FString::Printf(TEXT("The MediaOutput '%s' use the device '%s' that doesn't exist on this machine."), *GetName(), *OutputConfiguration.MediaConfiguration.MediaConnection.Device.DeviceName.ToString());
 		return false;
 	}
 
+	const AJA::AJADeviceScanner::DeviceInfo& DeviceInfo = Device->Info;
 	if (!DeviceInfo.bIsSupported)
 	{
 		OutFailureReason = FString::Printf(TEXT("The MediaOutput '%s' use the device '%s' that is not supported by the AJA SDK."), *GetName(), *OutputConfiguration.MediaConfiguration.MediaConnection.Device.DeviceName.ToString());
@@ -128,7 +149,7 @@ bool UAjaMediaOutput::Validate(FString& OutFailureReason) const
 			OutFailureReason = FString::Printf(TEXT("The MediaOutput '%s' use the device '%s' that doesn't support the 3G level conversion."), *GetName(), *OutputConfiguration.MediaConfiguration.MediaConnection.Device.DeviceName.ToString());
 			return false;
 		}
-		AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = AJA::AJAVideoFormats::GetVideoFormat(OutputConfiguration.MediaConfiguration.MediaMode.DeviceModeIdentifier);
+		AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = AjaMediaOutputDevice::GetVideoFormat(OutputConfiguration.MediaConfiguration.MediaMode.DeviceModeIdentifier);
 		if (!Descriptor.bIsVideoFormatA)
 		{
 			OutFailureReason = FString::Printf(TEXT("The MediaOutput '%s' wants level A to level B conversion but it's not supported by the format."), *GetName());
@@ -230,7 +251,7 @@ bool UAjaMediaOutput::CanEditChange(const UProperty* InProperty) const
 		bool bValid = false;
 		if (OutputConfiguration.IsValid())
 		{
-			AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = AJA::AJAVideoFormats::GetVideoFormat(OutputConfiguration.MediaConfiguration.MediaMode.DeviceModeIdentifier);
+			AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = AjaMediaOutputDevice::GetVideoFormat(OutputConfiguration.MediaConfiguration.MediaMode.DeviceModeIdentifier);
 			bValid = Descriptor.bIsVideoFormatA;
 		}
 		return bValid;
@@ -246,7 +267,7 @@ bool UAjaMediaOutput::CanEditChange(const UProperty* InProperty) const
 		bool bValid = false;
 		if (OutputConfiguration.IsValid() && TimecodeFormat != EMediaIOTimecodeFormat::None)
 		{
-			AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = AJA::AJAVideoFormats::GetVideoFormat(OutputConfiguration.MediaConfiguration.MediaMode.DeviceModeIdentifier);
+			AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = AjaMediaOutputDevice::GetVideoFormat(OutputConfiguration.MediaConfiguration.MediaMode.DeviceModeIdentifier);
 			bValid = Descriptor.bIsInterlacedStandard;
 		}
 		return bValid;
@@ -273,7 +294,7 @@ void UAjaMediaOutput::PostEditChangeChainProperty(struct FPropertyChangedChainEv
 			bOutputIn3GLevelB = false;
 			if (OutputConfiguration.IsValid())
 			{
-				AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = AJA::AJAVideoFormats::GetVideoFormat(OutputConfiguration.MediaConfiguration.MediaMode.DeviceModeIdentifier);
+				AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = AjaMediaOutputDevice::GetVideoFormat(OutputConfiguration.MediaConfiguration.MediaMode.DeviceModeIdentifier);
 				bOutputIn3GLevelB = Descriptor.bIsVideoFormatA;
 			}
 		}
@@ -288,7 +309,7 @@ void UAjaMediaOutput::PostEditChangeChainProperty(struct FPropertyChangedChainEv
 			bInterlacedFieldsTimecodeNeedToMatch = false;
 			if (OutputConfiguration.IsValid() && TimecodeFormat != EMediaIOTimecodeFormat::None)
 			{
-				AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = AJA::AJAVideoFormats::GetVideoFormat(OutputConfiguration.MediaConfiguration.MediaMode.DeviceModeIdentifier);
+				AJA::AJAVideoFormats::VideoFormatDescriptor Descriptor = AjaMediaOutputDevice::GetVideoFormat(OutputConfiguration.MediaConfiguration.MediaMode.DeviceModeIdentifier);
 				bInterlacedFieldsTimecodeNeedToMatch = Descriptor.bIsInterlacedStandard;
 			}
 		}
@@ -0,0 +1,78 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaOutputAncillary.h"
+
+#include "AjaMediaOutputWorker.h"
+#include "IAjaMediaOutputModule.h"
+
+/* FAjaMediaOutputAncillary implementation
+*****************************************************************************/
+FAjaMediaOutputAncillary::FAjaMediaOutputAncillary(uint32 InFieldBufferSize, bool bInIsInterlaced, const FString& InPortName)
+	: FieldBufferSize(InFieldBufferSize)
+	, bIsInterlaced(bInIsInterlaced)
+	, PortName(InPortName)
+	, LastPackedSize(0)
+	, NumDroppedPackets(0)
+{
+	QueuedField1.Reserve(FieldBufferSize);
+	QueuedField2.Reserve(bIsInterlaced ? FieldBufferSize : 0);
+	PackedBuffer.SetNumZeroed(bIsInterlaced ? FieldBufferSize * 2 : FieldBufferSize);
+}
+
+bool FAjaMediaOutputAncillary::Queue(const FAjaMediaAncillaryPacket& InPacket)
+{
+	TArray<uint8>& Queued = InPacket.bField2 ? QueuedField2 : QueuedField1;
+	const uint32 Offset = Queued.Num();
+
+	uint32 PacketSize = 0;
+	if ((!InPacket.bField2 || bIsInterlaced) && Offset + AjaMediaAncillary::GetPacketSize(InPacket) <= FieldBufferSize)
+	{
+		// Within the reserved size, this never allocates
+		Queued.AddUninitialized(AjaMediaAncillary::GetPacketSize(InPacket));
+		PacketSize = AjaMediaAncillary::WritePacket(InPacket, Queued.GetData() + Offset, Queued.Num() - Offset);
+		Queued.SetNum(Offset + PacketSize, false);
+	}
+
+	if (PacketSize == 0)
+	{
+		if (++NumDroppedPackets % 100 == 1)
+		{
+			UE_LOG(LogAjaMediaOutput, Warning, TEXT("The AJA output %s dropped an ancillary packet (DID 0x%02X, SDID 0x%02X). It is invalid or the ancillary buffer of the frame is full. %d packets were dropped.")
+				, *PortName, InPacket.DID, InPacket.SDID, NumDroppedPackets);
+		}
+		return false;
+	}
+
+	return true;
+}
+
+void FAjaMediaOutputAncillary::MoveQueuedPackets(FAjaMediaOutputFrame& OutFrame)
+{
+	// The frames come back from the pool with their buffers, so the swapped buffers are only sized once per pooled frame
+	OutFrame.AncillaryField1.Reset();
+	OutFrame.AncillaryField2.Reset();
+	Swap(OutFrame.AncillaryField1, QueuedField1);
+	Swap(OutFrame.AncillaryField2, QueuedField2);
+	QueuedField1.Reserve(FieldBufferSize);
+	QueuedField2.Reserve(bIsInterlaced ? FieldBufferSize : 0);
+}
+
+TArrayView<uint8> FAjaMediaOutputAncillary::Pack(const FAjaMediaOutputFrame& InFrame)
+{
+	const int32 Field1Size = InFrame.AncillaryField1.Num();
+	const int32 Field2Size = InFrame.AncillaryField2.Num();
+	check(Field1Size + Field2Size <= PackedBuffer.Num());
+
+	// Only clear what the previous frame wrote, the rest of the buffer is still zero
+	uint8* Buffer = PackedBuffer.GetData();
+	FMemory::Memcpy(Buffer, InFrame.AncillaryField1.GetData(), Field1Size);
+	FMemory::Memcpy(Buffer + Field1Size, InFrame.AncillaryField2.GetData(), Field2Size);
+	const int32 PackedSize = Field1Size + Field2Size;
+	if (LastPackedSize > PackedSize)
+	{
+		FMemory::Memzero(Buffer + PackedSize, LastPackedSize - PackedSize);
+	}
+	LastPackedSize = PackedSize;
+
+	return TArrayView<uint8>(PackedBuffer);
+}
@@ -0,0 +1,53 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AjaMediaAncillary.h"
+
+struct FAjaMediaOutputFrame;
+
+/**
+ * Ancillary packets embedded in the frames of an AJA output.
+ *
+ * Packets are queued by the game, moved to the next captured frame by the rendering thread,
+ * and packed in the ancillary buffer of the channel by the output worker, field 1 first.
+ * Every buffer is sized when the output opens and then reused, no allocation happens per frame.
+ *
+ * Not thread safe. Queue and MoveQueuedPackets must be serialized by the owner, Pack is only called by the worker.
+ */
+class FAjaMediaOutputAncillary
+{
+public:
+
+	FAjaMediaOutputAncillary(uint32 InFieldBufferSize, bool bInIsInterlaced, const FString& InPortName);
+
+	/**
+	 * Queue a packet for the next captured frame.
+	 * @return false if the packet is invalid or doesn't fit in what remains of the buffer of its field.
+	 */
+	bool Queue(const FAjaMediaAncillaryPacket& InPacket);
+
+	/** Give the queued packets to a captured frame. The queue is empty after the call. */
+	void MoveQueuedPackets(FAjaMediaOutputFrame& OutFrame);
+
+	/** Pack the packets of a frame in the ancillary buffer of the channel. The view is valid until the next call. */
+	TArrayView<uint8> Pack(const FAjaMediaOutputFrame& InFrame);
+
+private:
+
+	uint32 FieldBufferSize;
+	bool bIsInterlaced;
+	FString PortName;
+
+	/** Packets queued for the next frame, in the layout of the channel */
+	TArray<uint8> QueuedField1;
+	TArray<uint8> QueuedField2;
+
+	/** Buffer given to the channel, both fields */
+	TArray<uint8> PackedBuffer;
+	int32 LastPackedSize;
+
+	int32 NumDroppedPackets;
+};
@@ -0,0 +1,252 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaOutputAudio.h"
+
+#include "AudioDevice.h"
+#include "AudioThread.h"
+#include "Engine/Engine.h"
+#include "HAL/PlatformAtomics.h"
+#include "IAjaMediaOutputModule.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#endif
+
+namespace AjaMediaOutputAudio
+{
+	/** Audio that can be buffered in the ring, in video frames. */
+	static const uint32 MaxBufferedVideoFrames = 4;
+
+	/** Audio buffered ahead of the video frame when the streams are anchored, in video frames. Absorbs the size of the mixer buffers. */
+	static const uint32 AnchorLatencyVideoFrames = 2;
+
+	/** Scale of a float sample to a 24 bits sample. */
+	static const float Int24Scale = 8388607.0f;
+
+	/**
+	 * Convert float samples to 24 bits samples in the upper bits of 32 bits words.
+	 */
+	void ConvertFloatToInt24In32(const float* InSource, int32* OutDestination, int32 InNumSamples)
+	{
+		int32 Index = 0;
+#if PLATFORM_CPU_X86_FAMILY
+		const __m128 Min = _mm_set1_ps(-1.0f);
+		const __m128 Max = _mm_set1_ps(1.0f);
+		const __m128 Scale = _mm_set1_ps(Int24Scale);
+		for (; Index + 4 <= InNumSamples; Index += 4)
+		{
+			__m128 Samples = _mm_loadu_ps(InSource + Index);
+			Samples = _mm_mul_ps(_mm_min_ps(_mm_max_ps(Samples, Min), Max), Scale);
+			const __m128i Int24 = _mm_cvtps_epi32(Samples);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutDestination + Index), _mm_slli_epi32(Int24, 8));
+		}
+#endif
+		for (; Index < InNumSamples; ++Index)
+		{
+			// Shifting a negative value left is undefined, the multiplication gives the bits of the SSE shift
+			const float Sample = FMath::Clamp(InSource[Index], -1.0f, 1.0f);
+			OutDestination[Index] = FMath::RoundToInt(Sample * Int24Scale) * 256;
+		}
+	}
+}
+
+/* FAjaMediaOutputAudio implementation
+*****************************************************************************/
+FAjaMediaOutputAudio::FAjaMediaOutputAudio(int32 InNumChannels, const FFrameRate& InFrameRate, const FString& InPortName)
+	: NumChannels(InNumChannels)
+	, FrameRate(InFrameRate)
+	, PortName(InPortName)
+	, Submix(nullptr)
+	, bRegistered(false)
+	, RingNumFrames(0)
+	, RingReadPosition(0)
+	, RingWritePosition(0)
+	, ClockToRingPosition(0)
+	, bClockAnchored(false)
+	, bSampleRateWarningLogged(false)
+	, AnchorFrameIdentifier(0)
+	, AnchorPosition(0)
+	, bFrameAnchored(false)
+	, NumUnderrunFrames(0)
+	, NumAnchors(0)
+{
+	const uint32 MaxNumFrames = (uint32)GetAudioPositionOfVideoFrame(1) + 1;
+	RingNumFrames = FMath::RoundUpToPowerOfTwo(MaxNumFrames * AjaMediaOutputAudio::MaxBufferedVideoFrames);
+	Ring.SetNumZeroed(RingNumFrames * NumChannels);
+	FrameSamples.Reserve(MaxNumFrames * NumChannels);
+}
+
+FAjaMediaOutputAudio::~FAjaMediaOutputAudio()
+{
+	check(!bRegistered);
+}
+
+bool FAjaMediaOutputAudio::Register(USoundSubmix* InSubmix)
+{
+	FAudioDevice* AudioDevice = GEngine ? GEngine->GetMainAudioDevice() : nullptr;
+	if (AudioDevice == nullptr)
+	{
+		UE_LOG(LogAjaMediaOutput, Warning, TEXT("The AJA output %s can't embed audio, there is no audio device."), *PortName);
+		return false;
+	}
+
+	Submix = InSubmix;
+	AudioDevice->RegisterSubmixBufferListener(this, Submix);
+	bRegistered = true;
+	return true;
+}
+
+void FAjaMediaOutputAudio::Unregister()
+{
+	if (bRegistered)
+	{
+		if (FAudioDevice* AudioDevice = GEngine ? GEngine->GetMainAudioDevice() : nullptr)
+		{
+			AudioDevice->UnregisterSubmixBufferListener(this, Submix);
+
+			// The listener is removed by a command of the audio thread, the mixer can call it until then.
+			// This command runs after it and holds the last reference if the owner already released its own.
+			TSharedRef<FAjaMediaOutputAudio, ESPMode::ThreadSafe> KeepAlive = AsShared();
+			FAudioThread::RunCommandOnAudioThread([KeepAlive]() {});
+		}
+		bRegistered = false;
+		Submix = nullptr;
+	}
+}
+
+uint64 FAjaMediaOutputAudio::GetAudioPositionOfVideoFrame(uint64 InDistance) const
+{
+	const uint64 Numerator = FMath::Max<uint64>(FrameRate.Numerator, 1);
+	const uint64 Denominator = FrameRate.Denominator;
+	return InDistance * SampleRate * Denominator / Numerator;
+}
+
+void FAjaMediaOutputAudio::WriteAudioFrame(uint32 InWritePosition, const int32* InSamples, int32 InNumSourceChannels)
+{
+	int32* Destination = Ring.GetData() + (InWritePosition & (RingNumFrames - 1)) * NumChannels;
+	const int32 NumChannelsToCopy = InSamples ? FMath::Min(InNumSourceChannels, NumChannels) : 0;
+	for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+	{
+		Destination[Channel] = Channel < NumChannelsToCopy ? InSamples[Channel] : 0;
+	}
+}
+
+void FAjaMediaOutputAudio::OnNewSubmixBuffer(const USoundSubmix* OwningSubmix, float* AudioData, int32 NumSamples, int32 InNumChannels, const int32 InSampleRate, double AudioClock)
+{
+	if (InSampleRate != (int32)SampleRate || InNumChannels <= 0)
+	{
+		if (!bSampleRateWarningLogged)
+		{
+			UE_LOG(LogAjaMediaOutput, Warning, TEXT("The AJA output %s only embeds %d Hz audio. The audio mixer runs at %d Hz."), *PortName, SampleRate, InSampleRate);
+			bSampleRateWarningLogged = true;
+		}
+		return;
+	}
+
+	ConvertedSamples.SetNumUninitialized(NumSamples, false);
+	AjaMediaOutputAudio::ConvertFloatToInt24In32(AudioData, ConvertedSamples.GetData(), NumSamples);
+	const int32 NumFrames = NumSamples / InNumChannels;
+
+	// Single producer. The positions only grow and wrap around, the ring holds the frames from the read position to the write position.
+	const uint32 ReadPosition = (uint32)FPlatformAtomics::AtomicRead(&RingReadPosition);
+	uint32 WritePosition = (uint32)RingWritePosition;
+
+	// The output worker sent silence for the positions it went past, they can't be written anymore
+	if ((int32)(ReadPosition - WritePosition) > 0)
+	{
+		WritePosition = ReadPosition;
+	}
+
+	// Position of the first sample on the audio clock. A jump bigger than the ring starts a new stream at the write position.
+	const uint32 ClockPosition = (uint32)(int64)(AudioClock * SampleRate + 0.5);
+	uint32 Position = ClockPosition + ClockToRingPosition;
+	if (!bClockAnchored || FMath::Abs((int32)(Position - WritePosition)) > (int32)RingNumFrames)
+	{
+		ClockToRingPosition = WritePosition - ClockPosition;
+		Position = WritePosition;
+		bClockAnchored = true;
+	}
+
+	// When the ring is full, the newest samples are dropped. Their positions are filled with silence by the next buffer.
+	const uint32 EndPosition = ReadPosition + RingNumFrames;
+	while ((int32)(Position - WritePosition) > 0 && WritePosition != EndPosition)
+	{
+		WriteAudioFrame(WritePosition++, nullptr, 0);
+	}
+
+	// Skip the samples of the positions that were already written or sent
+	const int32* Source = ConvertedSamples.GetData();
+	for (int32 Frame = FMath::Max((int32)(WritePosition - Position), 0); Frame < NumFrames && WritePosition != EndPosition; ++Frame)
+	{
+		WriteAudioFrame(WritePosition++, Source + Frame * InNumChannels, InNumChannels);
+	}
+
+	FPlatformAtomics::AtomicStore(&RingWritePosition, (int32)WritePosition);
+}
+
+TArrayView<int32> FAjaMediaOutputAudio::PopFrameSamples(uint32 InFrameIdentifier)
+{
+	// Single consumer
+	const uint32 WritePosition = (uint32)FPlatformAtomics::AtomicRead(&RingWritePosition);
+	const uint32 ReadPosition = (uint32)RingReadPosition;
+
+	uint32 StartPosition = 0;
+	uint32 NumFrames = 0;
+	bool bAnchor = true;
+	if (bFrameAnchored && (int32)(InFrameIdentifier - AnchorFrameIdentifier) >= 0)
+	{
+		const uint64 Distance = InFrameIdentifier - AnchorFrameIdentifier;
+		const uint64 FramePosition = GetAudioPositionOfVideoFrame(Distance);
+		StartPosition = AnchorPosition + (uint32)FramePosition;
+		NumFrames = (uint32)(GetAudioPositionOfVideoFrame(Distance + 1) - FramePosition);
+
+		// Anchor again when no sample of the frame arrived or when the mixer is dropping samples, the audio drifted from the video
+		const int32 NumBufferedFrames = (int32)(WritePosition - StartPosition);
+		bAnchor = NumBufferedFrames <= 0 || NumBufferedFrames > (int32)(RingNumFrames - NumFrames) || (int32)(StartPosition - ReadPosition) < 0;
+	}
+
+	if (bAnchor)
+	{
+		NumFrames = (uint32)GetAudioPositionOfVideoFrame(1);
+		const uint32 AnchorLatency = NumFrames * AjaMediaOutputAudio::AnchorLatencyVideoFrames;
+
+		// Wait for the audio to get ahead of the video by the latency, the frame is silent until then
+		bFrameAnchored = (int32)(WritePosition - ReadPosition) >= (int32)AnchorLatency;
+		if (bFrameAnchored)
+		{
+			AnchorFrameIdentifier = InFrameIdentifier;
+			AnchorPosition = WritePosition - AnchorLatency;
+			StartPosition = AnchorPosition;
+			if (++NumAnchors > 1)
+			{
+				UE_LOG(LogAjaMediaOutput, Verbose, TEXT("The audio of AJA output %s drifted from the video, it was realigned %d times."), *PortName, NumAnchors - 1);
+			}
+		}
+	}
+
+	const int32 NumFrameSamples = NumFrames * NumChannels;
+	FrameSamples.SetNumUninitialized(NumFrameSamples, false);
+
+	const int32 NumAvailableFrames = bFrameAnchored ? FMath::Clamp((int32)(WritePosition - StartPosition), 0, (int32)NumFrames) : 0;
+	const int32* RingData = Ring.GetData();
+	for (int32 Frame = 0; Frame < NumAvailableFrames; ++Frame)
+	{
+		FMemory::Memcpy(FrameSamples.GetData() + Frame * NumChannels, RingData + ((StartPosition + Frame) & (RingNumFrames - 1)) * NumChannels, NumChannels * sizeof(int32));
+	}
+
+	if (NumAvailableFrames < (int32)NumFrames)
+	{
+		FMemory::Memzero(FrameSamples.GetData() + NumAvailableFrames * NumChannels, (NumFrames - NumAvailableFrames) * NumChannels * sizeof(int32));
+		if (++NumUnderrunFrames % 50 == 1)
+		{
+			UE_LOG(LogAjaMediaOutput, Verbose, TEXT("The audio of AJA output %s is late, %d frames were padded with silence."), *PortName, NumUnderrunFrames);
+		}
+	}
+
+	// The samples of the dropped frames are released with the ones of this frame
+	if (bFrameAnchored)
+	{
+		FPlatformAtomics::AtomicStore(&RingReadPosition, (int32)(StartPosition + NumFrames));
+	}
+	return TArrayView<int32>(FrameSamples);
+}
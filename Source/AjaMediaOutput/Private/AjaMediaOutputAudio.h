@@ -0,0 +1,96 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Misc/FrameRate.h"
+#include "Sound/SoundSubmix.h"
+#include "Templates/SharedPointer.h"
+
+/**
+ * Embeds the audio of an Engine submix in an AJA output.
+ *
+ * The audio mixer thread converts the submix buffers to the layout of the card, 24 bits in the upper bits of
+ * interleaved 32 bits samples, and pushes them in a lock-free ring. Each sample has a position in the ring taken
+ * from the audio clock, so a gap in the mixer output is filled with silence instead of shifting the later samples.
+ *
+ * The output worker pops the samples of each video frame by its frame identifier. The first frame is anchored a
+ * couple of frames behind the newest audio, then the position of a frame only depends on its distance to the
+ * anchor: the frames dropped before the worker still consume their audio and the two streams stay in step.
+ * They are anchored again when the audio drifts out of the ring.
+ *
+ * The audio mixer may call the listener until its unregistration ran on the audio thread, so it is owned by a
+ * thread-safe shared pointer and Unregister gives a reference to the audio thread.
+ */
+class FAjaMediaOutputAudio
+	: public ISubmixBufferListener
+	, public TSharedFromThis<FAjaMediaOutputAudio, ESPMode::ThreadSafe>
+{
+public:
+
+	/** Audio sample rate of the AJA outputs. */
+	static const uint32 SampleRate = 48000;
+
+	/**
+	 * @param InNumChannels Number of channels embedded in the output.
+	 * @param InFrameRate Frame rate of the output, to split the audio per video frame.
+	 * @param InPortName Name of the output, for the logs.
+	 */
+	FAjaMediaOutputAudio(int32 InNumChannels, const FFrameRate& InFrameRate, const FString& InPortName);
+	virtual ~FAjaMediaOutputAudio();
+
+	/** Listen to the submix of the main audio device. None listens to the master submix. Must be called from the game thread. */
+	bool Register(USoundSubmix* InSubmix);
+
+	/** Stop listening. Must be called from the game thread, before the last reference is released. */
+	void Unregister();
+
+	/**
+	 * Get the samples of a video frame. Called by the output worker, with increasing frame identifiers.
+	 * Missing samples are replaced by silence.
+	 *
+	 * @param InFrameIdentifier Frame number of the video frame. The frames between two calls were dropped.
+	 * @return the samples of the frame, valid until the next call.
+	 */
+	TArrayView<int32> PopFrameSamples(uint32 InFrameIdentifier);
+
+	//~ ISubmixBufferListener interface
+	virtual void OnNewSubmixBuffer(const USoundSubmix* OwningSubmix, float* AudioData, int32 NumSamples, int32 NumChannels, const int32 InSampleRate, double AudioClock) override;
+
+private:
+
+	/** @return the number of samples per channel from the anchor frame to the video frame at that distance. It alternates for fractional frame rates. */
+	uint64 GetAudioPositionOfVideoFrame(uint64 InDistance) const;
+
+	/** Write the samples of a frame at the write position. Audio thread only. */
+	void WriteAudioFrame(uint32 InWritePosition, const int32* InSamples, int32 InNumSourceChannels);
+
+private:
+
+	int32 NumChannels;
+	FFrameRate FrameRate;
+	FString PortName;
+	USoundSubmix* Submix;
+	bool bRegistered;
+
+	/** Interleaved samples, in the layout of the card. The positions count audio frames, the capacity is a power of 2. */
+	TArray<int32> Ring;
+	uint32 RingNumFrames;
+	volatile int32 RingReadPosition;
+	volatile int32 RingWritePosition;
+
+	/** Audio thread only. Conversion buffer, offset from the audio clock to the ring positions and whether the sample rate was reported. */
+	TArray<int32> ConvertedSamples;
+	uint32 ClockToRingPosition;
+	bool bClockAnchored;
+	bool bSampleRateWarningLogged;
+
+	/** Output worker only. Samples of the current frame, and the video frame whose audio starts at the anchor position. */
+	TArray<int32> FrameSamples;
+	uint32 AnchorFrameIdentifier;
+	uint32 AnchorPosition;
+	bool bFrameAnchored;
+	int32 NumUnderrunFrames;
+	int32 NumAnchors;
+};
@@ -0,0 +1,133 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AjaMediaOutputWorker.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformAtomics.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+
+/* FAjaMediaOutputWorker implementation
+*****************************************************************************/
+FAjaMediaOutputWorker::FAjaMediaOutputWorker(const FString& InThreadName, int32 InMaxNumPendingFrames, TFunction<void(FAjaMediaOutputFrame&)> InProcessFrame, TFunction<void()> InWakeUp)
+	: ProcessFrame(MoveTemp(InProcessFrame))
+	, WakeUp(MoveTemp(InWakeUp))
+	, MaxNumPendingFrames(FMath::Max(InMaxNumPendingFrames, 1))
+	, NumProcessingFrames(0)
+	, bStopping(false)
+	, FrameEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	, Thread(nullptr)
+{
+	PendingFrames.Reserve(MaxNumPendingFrames);
+	// The pending frames, the one being processed and the one being filled by the rendering thread
+	FreeFrames.Reserve(MaxNumPendingFrames + 2);
+
+	Thread = FRunnableThread::Create(this, *InThreadName, 0, TPri_AboveNormal);
+}
+
+FAjaMediaOutputWorker::~FAjaMediaOutputWorker()
+{
+	Stop();
+	FPlatformProcess::ReturnSynchEventToPool(FrameEvent);
+	FrameEvent = nullptr;
+}
+
+FAjaMediaOutputWorker::FFramePtr FAjaMediaOutputWorker::AcquireFrame(uint32 InBufferSize)
+{
+	FFramePtr Frame;
+	{
+		FScopeLock Lock(&FramesCriticalSection);
+		if (FreeFrames.Num() > 0)
+		{
+			Frame = FreeFrames.Pop(false);
+		}
+	}
+
+	if (!Frame.IsValid())
+	{
+		Frame = MakeShared<FAjaMediaOutputFrame, ESPMode::ThreadSafe>();
+	}
+	Frame->Buffer.SetNumUninitialized(InBufferSize, false);
+	return Frame;
+}
+
+bool FAjaMediaOutputWorker::Submit(const FFramePtr& InFrame)
+{
+	bool bDropped = false;
+	{
+		FScopeLock Lock(&FramesCriticalSection);
+		if (PendingFrames.Num() >= MaxNumPendingFrames)
+		{
+			FreeFrames.Add(PendingFrames[0]);
+			PendingFrames.RemoveAt(0, 1, false);
+			bDropped = true;
+		}
+		PendingFrames.Add(InFrame);
+	}
+
+	FrameEvent->Trigger();
+	return !bDropped;
+}
+
+bool FAjaMediaOutputWorker::IsIdle() const
+{
+	FScopeLock Lock(&FramesCriticalSection);
+	return PendingFrames.Num() == 0 && NumProcessingFrames == 0;
+}
+
+void FAjaMediaOutputWorker::Stop()
+{
+	if (Thread)
+	{
+		FPlatformAtomics::InterlockedExchange(&bStopping, true);
+		{
+			FScopeLock Lock(&FramesCriticalSection);
+			FreeFrames.Append(PendingFrames);
+			PendingFrames.Reset();
+		}
+
+		FrameEvent->Trigger();
+		if (WakeUp)
+		{
+			WakeUp();
+		}
+
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+}
+
+uint32 FAjaMediaOutputWorker::Run()
+{
+	while (!bStopping)
+	{
+		FFramePtr Frame;
+		{
+			FScopeLock Lock(&FramesCriticalSection);
+			if (PendingFrames.Num() > 0)
+			{
+				Frame = PendingFrames[0];
+				PendingFrames.RemoveAt(0, 1, false);
+				FPlatformAtomics::InterlockedIncrement(&NumProcessingFrames);
+			}
+		}
+
+		if (!Frame.IsValid())
+		{
+			FrameEvent->Wait();
+			continue;
+		}
+
+		ProcessFrame(*Frame);
+
+		{
+			FScopeLock Lock(&FramesCriticalSection);
+			FreeFrames.Add(Frame);
+			FPlatformAtomics::InterlockedDecrement(&NumProcessingFrames);
+		}
+	}
+
+	return 0;
+}
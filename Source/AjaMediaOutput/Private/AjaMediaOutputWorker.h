@@ -0,0 +1,102 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AJALib.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+#include "MediaIOCoreEncodeTime.h"
+
+class FEvent;
+class FRunnableThread;
+
+/**
+ * A frame read back from the GPU, waiting to be sent to the card.
+ */
+struct FAjaMediaOutputFrame
+{
+	/** Copy of the readback buffer. Kept when the frame goes back to the pool. */
+	TArray<uint8> Buffer;
+
+	uint32 Stride;
+	uint32 TimeEncodeWidth;
+	uint32 Height;
+	EMediaIOCoreEncodePixelFormat EncodePixelFormat;
+	const TCHAR* OutputFilename;
+
+	/** Ancillary packets of each field, in the layout of the channel. Kept when the frame goes back to the pool. */
+	TArray<uint8> AncillaryField1;
+	TArray<uint8> AncillaryField2;
+
+	AJA::FTimecode Timecode;
+	uint32 FrameIdentifier;
+};
+
+/**
+ * Sends the captured frames to an AJA output from a dedicated thread.
+ *
+ * The rendering thread copies the readback buffer in a pooled frame and returns.
+ * The worker does the timecode burn-in, the copy to the card and the wait for the sync.
+ * When the card falls behind, the oldest pending frame is dropped; the rendering thread never waits for the card.
+ */
+class FAjaMediaOutputWorker
+	: private FRunnable
+{
+public:
+
+	using FFramePtr = TSharedPtr<FAjaMediaOutputFrame, ESPMode::ThreadSafe>;
+
+	/**
+	 * Start the worker thread.
+	 *
+	 * @param InThreadName Name of the worker thread.
+	 * @param InMaxNumPendingFrames Number of frames that can wait for the card before the oldest is dropped.
+	 * @param InProcessFrame Called by the worker thread for every frame, in order.
+	 * @param InWakeUp Called from Stop to release the worker if it waits in InProcessFrame.
+	 */
+	FAjaMediaOutputWorker(const FString& InThreadName, int32 InMaxNumPendingFrames, TFunction<void(FAjaMediaOutputFrame&)> InProcessFrame, TFunction<void()> InWakeUp);
+	virtual ~FAjaMediaOutputWorker();
+
+	/**
+	 * Get a frame from the pool, with a buffer of the requested size.
+	 * The pool only allocates until it holds every frame that can be in flight.
+	 */
+	FFramePtr AcquireFrame(uint32 InBufferSize);
+
+	/**
+	 * Queue a frame for the worker. Returns right away.
+	 * @return false if the oldest pending frame was dropped to make room.
+	 */
+	bool Submit(const FFramePtr& InFrame);
+
+	/** @return true if no frame is pending or being processed. */
+	bool IsIdle() const;
+
+	/** Drop the pending frames and stop the thread. Waits for the frame being processed. */
+	void Stop();
+
+private:
+
+	//~ FRunnable interface
+	virtual uint32 Run() override;
+
+private:
+
+	TFunction<void(FAjaMediaOutputFrame&)> ProcessFrame;
+	TFunction<void()> WakeUp;
+	int32 MaxNumPendingFrames;
+
+	/** Frames waiting for the worker, oldest first, and frames ready to be reused. */
+	TArray<FFramePtr> PendingFrames;
+	TArray<FFramePtr> FreeFrames;
+	mutable FCriticalSection FramesCriticalSection;
+
+	/** Number of frames popped by the worker and not processed yet. */
+	volatile int32 NumProcessingFrames;
+	volatile int32 bStopping;
+
+	FEvent* FrameEvent;
+	FRunnableThread* Thread;
+};
@@ -3,13 +3,19 @@
 #pragma once
 
 #include "MediaCapture.h"
+#include "AjaMediaAncillary.h"
 #include "AjaMediaOutput.h"
 #include "HAL/CriticalSection.h"
 #include "MediaIOCoreEncodeTime.h"
 #include "Misc/FrameRate.h"
 #include "AjaMediaCapture.generated.h"
 
+class FAjaMediaOutputAncillary;
+class FAjaMediaOutputAudio;
+class FAjaMediaOutputWorker;
+struct FAjaMediaOutputFrame;
 class FEvent;
+class IAjaOutputChannel;
 class UAjaMediaOutput;
 
 /**
@@ -21,6 +27,14 @@ class AJAMEDIAOUTPUT_API UAjaMediaCapture : public UMediaCapture
 {
 	GENERATED_UCLASS_BODY()
 
+public:
+	/**
+	 * Queue an ancillary packet (SMPTE 291) to embed in the next captured frame. Can be called from any thread.
+	 * The output must have bOutputAncillary. The packet data is copied.
+	 * @return false if the packet was dropped: the output doesn't embed ancillary data, the packet is invalid, or the buffer of its field is full.
+	 */
+	bool QueueAncillaryPacket(const FAjaMediaAncillaryPacket& InPacket);
+
 	//~ UMediaCapture interface
 public:
 	virtual bool HasFinishedProcessing() const override;
@@ -37,19 +51,29 @@ protected:
 private:
 	struct FAjaOutputCallback;
 	friend FAjaOutputCallback;
-	struct FAJAOutputChannel;
 
 private:
 	bool InitAJA(UAjaMediaOutput* InMediaOutput);
-	void WaitForSync_RenderingThread() const;
+	void ProcessFrame_WorkerThread(FAjaMediaOutputFrame& InFrame);
+	void WaitForSync_WorkerThread() const;
 	void ApplyViewportTextureAlpha(TSharedPtr<FSceneViewport> InSceneViewport);
 	void RestoreViewportTextureAlpha(TSharedPtr<FSceneViewport> InSceneViewport);
 
 private:
 	/** AJA Port for outputting */
-	FAJAOutputChannel* OutputChannel;
+	IAjaOutputChannel* OutputChannel;
 	FAjaOutputCallback* OutputCallback;
 
+	/** Sends the frames to the output, so the rendering thread never waits for the card */
+	FAjaMediaOutputWorker* OutputWorker;
+
+	/** Engine audio embedded in the output, if enabled. Shared with the audio thread while it unregisters the listener. */
+	TSharedPtr<FAjaMediaOutputAudio, ESPMode::ThreadSafe> OutputAudio;
+
+	/** Ancillary packets embedded in the output, if enabled */
+	FAjaMediaOutputAncillary* OutputAncillary;
+	FCriticalSection AncillaryCriticalSection;
+
 	/** Name of this output port */
 	FString PortName;
 
@@ -60,6 +84,13 @@ private:
 	EAjaMediaOutputPixelFormat PixelFormat;
 	bool UseKey;
 
+	/** Device of the output, and scheduling of the thread that services it */
+	int32 DeviceIndex;
+	FAjaMediaThreadSettings ThreadSettings;
+
+	/** Registered to the device changes while capturing */
+	FDelegateHandle DevicesChangedHandle;
+
 	/** Saved IgnoreTextureAlpha flag from viewport */
 	bool bSavedIgnoreTextureAlpha;
 	bool bIgnoreTextureAlphaChanged;
@@ -67,7 +98,7 @@ private:
 	/** Selected FrameRate of this output */
 	FFrameRate FrameRate;
 
-	/** Critical section for synchronizing access to the OutputChannel */
+	/** Critical section for synchronizing the rendering thread submissions with the stop of the output */
 	FCriticalSection RenderThreadCriticalSection;
 
 	/** Event to wakeup When waiting for sync */
@@ -4,10 +4,14 @@
 
 #include "MediaOutput.h"
 
+#include "AjaMediaSource.h"
+#include "AjaMediaThreadSettings.h"
 #include "MediaIOCoreDefinitions.h"
 
 #include "AjaMediaOutput.generated.h"
 
+class USoundSubmix;
+
 /**
  * Native data format.
  */
@@ -66,6 +70,13 @@ public:
 	UPROPERTY(EditAnywhere, AdvancedDisplay, Category="Output", meta=(ClampMin=1, ClampMax=4))
 	int32 NumberOfAJABuffers;
 
+	/**
+	 * Number of captured frames that can wait for the card, when the output falls behind the rendering thread.
+	 * When the queue is full, the oldest frame is dropped. The rendering thread never waits for the card.
+	 */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category="Output", meta=(ClampMin=1, ClampMax=8))
+	int32 NumberOfPendingFrames;
+
 	/**
 	 * Only make sense in interlaced mode.
 	 * When creating a new Frame the 2 fields need to have the same timecode value.
@@ -78,6 +89,36 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Synchronization")
 	bool bWaitForSyncEvent;
 
+public:
+	/** Embed the audio of the Engine in the output, aligned with the video frames. The audio mixer must run at 48 kHz. */
+	UPROPERTY(EditAnywhere, Category="Audio")
+	bool bOutputAudio;
+
+	/** Number of embedded audio channels. The channels of the submix are embedded in order, the others are silent. */
+	UPROPERTY(EditAnywhere, Category="Audio", meta=(EditCondition="bOutputAudio"))
+	EAjaMediaAudioChannel AudioChannel;
+
+	/** Submix to embed. None embeds the master submix. */
+	UPROPERTY(EditAnywhere, Category="Audio", meta=(EditCondition="bOutputAudio"))
+	USoundSubmix* AudioSubmix;
+
+public:
+	/** Embed ancillary packets (SMPTE 291) queued with UAjaMediaCapture::QueueAncillaryPacket in the output. */
+	UPROPERTY(EditAnywhere, Category="Ancillary")
+	bool bOutputAncillary;
+
+	/** Size of the ancillary buffer of each field, in bytes. Packets that don't fit are dropped. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category="Ancillary", meta=(EditCondition="bOutputAncillary", ClampMin="256", ClampMax="65536"))
+	int32 AncillaryBufferSize;
+
+public:
+	/**
+	 * Scheduling of the output thread.
+	 * The output buffers are owned by the engine, so NUMA-local allocation only pins the thread to the node of the card.
+	 */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category="Performance")
+	FAjaMediaThreadSettings ThreadSettings;
+
 public:
 	/** Log a warning when there's a drop frame. */
 	UPROPERTY(EditAnywhere, Category="Debug")
@@ -9,6 +9,9 @@ public class AJA : ModuleRules
 	{
 		Type = ModuleType.External;
 
+		// The headers are needed on every platform. Without the dll, only the loopback device backend is available.
+		PublicIncludePaths.Add(Path.Combine(ModuleDirectory, "include"));
+
 		if (Target.Platform == UnrealTargetPlatform.Win64)
 		{
 			PublicDefinitions.Add("AJAMEDIA_DLL_PLATFORM=1");
@@ -27,7 +30,6 @@ public class AJA : ModuleRules
 				PublicDefinitions.Add("AJAMEDIA_DLL_DEBUG=0");
 			}
 
-			PublicIncludePaths.Add(Path.Combine(Path.Combine(ModuleDirectory, "include")));
 			PublicAdditionalLibraries.Add(Path.Combine(AjaLibDir, LibraryName + ".lib"));
 
 			PublicDelayLoadDLLs.Add(LibraryName + ".dll");
@@ -37,7 +39,7 @@ public class AJA : ModuleRules
 		{
 			PublicDefinitions.Add("AJAMEDIA_DLL_PLATFORM=0");
 			PublicDefinitions.Add("AJAMEDIA_DLL_DEBUG=0");
-			System.Console.WriteLine("AJA not supported on this platform");
+			System.Console.WriteLine("AJA SDK not supported on this platform. Only the loopback device backend will be available.");
 		}
 	}
 }
@@ -6,10 +6,15 @@
 #include <string>
 #include <vector>
 
-#ifdef AJA_EXPORTS
+#if defined(AJA_EXPORTS)
 #define AJA_API __declspec(dllexport)
-#else
+#elif AJAMEDIA_DLL_PLATFORM
 #define AJA_API __declspec(dllimport)
+#elif defined(__GNUC__) || defined(__clang__)
+// No AJA dll on this platform. The data types are implemented by the AjaMedia module (see AjaLoopbackDeviceBackend.cpp).
+#define AJA_API __attribute__((visibility("default")))
+#else
+#define AJA_API
 #endif
 
 namespace AJA